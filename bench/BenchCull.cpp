@@ -0,0 +1,108 @@
+// Culls a large surface of boxes against a perspective frustum with every compiled in implementation
+// and prints the results as JSON. No device is needed.
+//
+// Usage: bench_cull [--boxes N] [--iterations N] [--seed N]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "BenchScene.h"
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    uint32_t box_count = bench_arg_uint(argc, argv, "--boxes", 1000000);
+    uint32_t iterations = bench_arg_uint(argc, argv, "--iterations", 50);
+    uint32_t seed = bench_arg_uint(argc, argv, "--seed", 1);
+
+    // Boxes scattered over a 1000x1000 surface, the camera only sees a small part of it
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> height(0.0f, 2.0f);
+    std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+    CullingBounds bounds;
+    bounds.reserve(box_count);
+    for (uint32_t i = 0; i < box_count; i++)
+    {
+        glm::vec3 center(position(random), position(random), height(random));
+        glm::vec3 extent(size(random), size(random), size(random));
+        bounds.push_back(center - extent, center + extent);
+    }
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, -20.0f, 30.0f), glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+    proj[1][1] *= -1;
+    std::array<glm::vec4, 6> planes = vulkan_extract_frustum_planes(proj * view);
+
+    std::vector<FrustumCullingImplementation> implementations;
+    for (FrustumCullingImplementation implementation : { FRUSTUM_CULLING_SCALAR, FRUSTUM_CULLING_SSE, FRUSTUM_CULLING_AVX })
+    {
+        if (frustum_culling_is_available(implementation))
+        {
+            implementations.push_back(implementation);
+        }
+    }
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"cull\"," << std::endl;
+    std::cout << "  \"boxes\": " << box_count << "," << std::endl;
+    std::cout << "  \"iterations\": " << iterations << "," << std::endl;
+    std::cout << "  \"results\": [" << std::endl;
+
+    std::vector<uint32_t> reference_visible;
+    std::vector<uint32_t> visible;
+    visible.reserve(box_count);
+    double scalar_p50_ms = 0.0;
+    bool results_match = true;
+    for (size_t i = 0; i < implementations.size(); i++)
+    {
+        std::vector<double> cull_times_ms;
+        for (uint32_t iteration = 0; iteration < iterations; iteration++)
+        {
+            visible.clear();
+            auto old_timestamp = std::chrono::high_resolution_clock::now();
+            frustum_cull_aabbs(implementations[i], bounds, planes, visible);
+            auto new_timestamp = std::chrono::high_resolution_clock::now();
+
+            cull_times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+        }
+
+        if (i == 0)
+        {
+            reference_visible = visible;
+        }
+        else if (visible != reference_visible)
+        {
+            results_match = false;
+        }
+
+        double mean_ms = iterations > 0 ? std::accumulate(cull_times_ms.begin(), cull_times_ms.end(), 0.0) / iterations : 0.0;
+        std::sort(cull_times_ms.begin(), cull_times_ms.end());
+        double p50_ms = bench_percentile(cull_times_ms, 50.0);
+        if (implementations[i] == FRUSTUM_CULLING_SCALAR)
+        {
+            scalar_p50_ms = p50_ms;
+        }
+
+        std::cout << "    { \"implementation\": \"" << frustum_culling_implementation_name(implementations[i]) << "\""
+            << ", \"visible\": " << visible.size()
+            << ", \"mean_ms\": " << mean_ms
+            << ", \"p50_ms\": " << p50_ms
+            << ", \"ns_per_box\": " << (box_count > 0 ? p50_ms * 1000000.0 / box_count : 0.0)
+            << ", \"speedup\": " << (p50_ms > 0.0 ? scalar_p50_ms / p50_ms : 0.0)
+            << " }" << (i + 1 < implementations.size() ? "," : "") << std::endl;
+    }
+
+    std::cout << "  ]," << std::endl;
+    std::cout << "  \"results_match\": " << (results_match ? "true" : "false") << std::endl;
+    std::cout << "}" << std::endl;
+
+    return results_match ? 0 : 1;
+}
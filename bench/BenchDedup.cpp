@@ -0,0 +1,177 @@
+// Deduplicates the vertices of a large mesh with the old std::unordered_map path, then with
+// vulkan_build_mesh_data on one and on several threads, and prints the results as JSON. No device is needed.
+//
+// Usage: bench_dedup [--obj path] [--quads N] [--shapes N] [--threads N] [--iterations N]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "BenchScene.h"
+
+namespace
+{
+    // The hash vulkan_build_mesh_data used before it switched to ise::util::FlatHashMap
+    struct LegacyVertexHash
+    {
+        size_t operator()(const ise::rendering::Vertex& vertex) const
+        {
+            return ((std::hash<glm::vec3>()(vertex.pos) ^ (std::hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (std::hash<glm::vec2>()(vertex.tex_coord) << 1);
+        }
+    };
+
+    void legacy_build_mesh_data(const ise::rendering::RenderGeometry& geometry, std::vector<ise::rendering::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::unordered_map<ise::rendering::Vertex, uint32_t, LegacyVertexHash> unique_vertices{};
+
+        for (const auto& shape : geometry.shapes)
+        {
+            for (const auto& index : shape.mesh.indices)
+            {
+                ise::rendering::Vertex vertex{};
+
+                vertex.pos = {
+                    geometry.attrib.vertices[3 * index.vertex_index + 0],
+                    geometry.attrib.vertices[3 * index.vertex_index + 1],
+                    geometry.attrib.vertices[3 * index.vertex_index + 2]
+                };
+
+                vertex.tex_coord = {
+                    geometry.attrib.texcoords[2 * index.texcoord_index + 0],
+                    1.0f - geometry.attrib.texcoords[2 * index.texcoord_index + 1]
+                };
+
+                vertex.color = { 1.0f, 1.0f, 1.0f };
+
+                if (unique_vertices.count(vertex) == 0)
+                {
+                    unique_vertices[vertex] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(vertex);
+                }
+
+                indices.push_back(unique_vertices[vertex]);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    std::string obj_path = bench_arg_string(argc, argv, "--obj", "");
+    uint32_t quads_per_side = bench_arg_uint(argc, argv, "--quads", 1500);
+    uint32_t shape_count = bench_arg_uint(argc, argv, "--shapes", 8);
+    uint32_t thread_count = bench_arg_uint(argc, argv, "--threads", std::max(1u, std::thread::hardware_concurrency()));
+    uint32_t iterations = bench_arg_uint(argc, argv, "--iterations", 3);
+
+    RenderGeometry geometry;
+    if (obj_path.empty())
+    {
+        bench_generate_grid(geometry, quads_per_side, shape_count);
+    }
+    else
+    {
+        std::string warn, err;
+        if (!tinyobj::LoadObj(&geometry.attrib, &geometry.shapes, &geometry.materials, &warn, &err, obj_path.c_str()))
+        {
+            throw std::runtime_error(warn + err);
+        }
+    }
+
+    size_t index_count = 0;
+    for (const auto& shape : geometry.shapes)
+    {
+        index_count += shape.mesh.indices.size();
+    }
+
+    struct Variant
+    {
+        const char* name;
+        uint32_t threads; // 0 runs the legacy path
+    };
+    std::vector<Variant> variants = { { "unordered_map", 0 }, { "flat", 1 } };
+    if (thread_count > 1)
+    {
+        variants.push_back({ "flat_parallel", thread_count });
+    }
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"dedup\"," << std::endl;
+    std::cout << "  \"source\": \"" << bench_json_escape(obj_path.empty() ? "grid_" + std::to_string(quads_per_side) : obj_path) << "\"," << std::endl;
+    std::cout << "  \"shapes\": " << geometry.shapes.size() << "," << std::endl;
+    std::cout << "  \"triangles\": " << index_count / 3 << "," << std::endl;
+    std::cout << "  \"iterations\": " << iterations << "," << std::endl;
+    std::cout << "  \"results\": [" << std::endl;
+
+    std::vector<Vertex> reference_vertices;
+    std::vector<uint32_t> reference_indices;
+    double legacy_p50_ms = 0.0;
+    bool results_match = true;
+    for (size_t i = 0; i < variants.size(); i++)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<double> build_times_ms;
+        for (uint32_t iteration = 0; iteration < iterations; iteration++)
+        {
+            vertices.clear();
+            indices.clear();
+            glm::vec3 bounds_min, bounds_max;
+
+            auto old_timestamp = std::chrono::high_resolution_clock::now();
+            if (variants[i].threads == 0)
+            {
+                legacy_build_mesh_data(geometry, vertices, indices);
+            }
+            else
+            {
+                vulkan_build_mesh_data(geometry, glm::vec3(0.0f), vertices, indices, bounds_min, bounds_max, variants[i].threads);
+            }
+            auto new_timestamp = std::chrono::high_resolution_clock::now();
+
+            build_times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+        }
+
+        // Both hash maps deduplicate in first occurrence order, so the outputs must be identical
+        if (i == 0)
+        {
+            reference_vertices = vertices;
+            reference_indices = indices;
+        }
+        else if (vertices != reference_vertices || indices != reference_indices)
+        {
+            results_match = false;
+        }
+
+        double mean_ms = iterations > 0 ? std::accumulate(build_times_ms.begin(), build_times_ms.end(), 0.0) / iterations : 0.0;
+        std::sort(build_times_ms.begin(), build_times_ms.end());
+        double p50_ms = bench_percentile(build_times_ms, 50.0);
+        if (i == 0)
+        {
+            legacy_p50_ms = p50_ms;
+        }
+
+        std::cout << "    { \"implementation\": \"" << variants[i].name << "\""
+            << ", \"threads\": " << std::max(1u, variants[i].threads)
+            << ", \"vertices\": " << vertices.size()
+            << ", \"mean_ms\": " << mean_ms
+            << ", \"p50_ms\": " << p50_ms
+            << ", \"mtris_per_s\": " << (p50_ms > 0.0 ? index_count / 3 / (p50_ms * 1000.0) : 0.0)
+            << ", \"speedup\": " << (p50_ms > 0.0 ? legacy_p50_ms / p50_ms : 0.0)
+            << " }" << (i + 1 < variants.size() ? "," : "") << std::endl;
+    }
+
+    std::cout << "  ]," << std::endl;
+    std::cout << "  \"results_match\": " << (results_match ? "true" : "false") << std::endl;
+    std::cout << "}" << std::endl;
+
+    return results_match ? 0 : 1;
+}
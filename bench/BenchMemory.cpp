@@ -0,0 +1,206 @@
+// Replays the same random sequence of buffer sized allocations and frees through the suballocator and through one
+// vkAllocateMemory per allocation, and prints timings and allocator statistics as JSON
+//
+// Usage: bench_memory [--operations N] [--live N] [--min-size bytes] [--max-size bytes] [--transient-percent N] [--seed N]
+//
+// Sizes are log uniform between --min-size and --max-size, --live caps the number of allocations alive at once.
+// --transient-percent of the allocations are freed right after, like staging buffers.
+// The vkAllocateMemory path keeps below maxMemoryAllocationCount by freeing instead of allocating when it gets close.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BenchScene.h"
+
+namespace
+{
+    struct MemoryOperation
+    {
+        bool allocate;
+        uint32_t slot; // index into the live allocations when freeing
+        VkDeviceSize size;
+        bool transient; // freed right away
+    };
+}
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    uint32_t operation_count = bench_arg_uint(argc, argv, "--operations", 200000);
+    uint32_t live_limit = bench_arg_uint(argc, argv, "--live", 2000);
+    uint32_t min_size = bench_arg_uint(argc, argv, "--min-size", 256);
+    uint32_t max_size = bench_arg_uint(argc, argv, "--max-size", 4 * 1024 * 1024);
+    uint32_t transient_percent = bench_arg_uint(argc, argv, "--transient-percent", 20);
+    uint32_t seed = bench_arg_uint(argc, argv, "--seed", 1);
+
+    VulkanRendererData renderer;
+    bench_create_renderer(renderer);
+
+    const VkPhysicalDeviceProperties& properties = renderer.physical_device_properties;
+    uint32_t vulkan_live_limit = std::min(live_limit, properties.limits.maxMemoryAllocationCount > 64 ? properties.limits.maxMemoryAllocationCount - 64 : 0u);
+
+    // Memory type bits and alignment of a typical geometry buffer
+    VkBuffer probe_buffer;
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = 1024;
+    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    vulkan_handle_vk_result(vkCreateBuffer(renderer.device, &buffer_info, nullptr, &probe_buffer));
+    VkMemoryRequirements probe_requirements;
+    vkGetBufferMemoryRequirements(renderer.device, probe_buffer, &probe_requirements);
+    vkDestroyBuffer(renderer.device, probe_buffer, nullptr);
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> log_size(std::log(double(min_size)), std::log(double(std::max(min_size, max_size))));
+    std::uniform_int_distribution<uint32_t> percent(0, 99);
+
+    // Grows towards live_limit and then hovers around it, which is where fragmentation builds up
+    std::vector<MemoryOperation> operations;
+    operations.reserve(operation_count);
+    uint32_t live_count = 0;
+    for (uint32_t i = 0; i < operation_count; i++)
+    {
+        bool allocate = live_count == 0 || (live_count < live_limit && percent(random) < 60);
+        MemoryOperation operation{};
+        operation.allocate = allocate;
+        if (allocate)
+        {
+            operation.size = std::max<VkDeviceSize>(1, static_cast<VkDeviceSize>(std::exp(log_size(random))));
+            operation.transient = percent(random) < transient_percent;
+            live_count += operation.transient ? 0 : 1;
+        }
+        else
+        {
+            operation.slot = std::uniform_int_distribution<uint32_t>(0, live_count - 1)(random);
+            live_count--;
+        }
+        operations.push_back(operation);
+    }
+
+    MemoryAllocator allocator;
+    memory_allocator_create(allocator, renderer.physical_device, renderer.device);
+
+    MemoryStatistics peak_statistics;
+    bool peak_recorded = false;
+    std::vector<MemoryAllocation> allocations;
+    auto suballocator_start = std::chrono::high_resolution_clock::now();
+    for (const MemoryOperation& operation : operations)
+    {
+        if (operation.allocate)
+        {
+            VkMemoryRequirements requirements = probe_requirements;
+            requirements.size = operation.size;
+            MemoryAllocation allocation = memory_allocate(allocator, requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, operation.transient ? MEMORY_USAGE_TRANSIENT : MEMORY_USAGE_LONG_LIVED, MEMORY_RESOURCE_LINEAR);
+            if (operation.transient)
+            {
+                memory_free(allocator, allocation);
+            }
+            else
+            {
+                allocations.push_back(allocation);
+            }
+        }
+        else
+        {
+            memory_free(allocator, allocations[operation.slot]);
+            allocations[operation.slot] = allocations.back();
+            allocations.pop_back();
+        }
+
+        if (!peak_recorded && allocations.size() == live_limit)
+        {
+            peak_statistics = memory_get_statistics(allocator);
+            peak_recorded = true;
+        }
+    }
+    auto suballocator_end = std::chrono::high_resolution_clock::now();
+    MemoryStatistics final_statistics = memory_get_statistics(allocator);
+
+    for (MemoryAllocation& allocation : allocations)
+    {
+        memory_free(allocator, allocation);
+    }
+    allocations.clear();
+    memory_allocator_destroy(allocator);
+
+    uint32_t memory_type = memory_find_type(renderer.memory_allocator, probe_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    std::vector<VkDeviceMemory> memories;
+    uint32_t vulkan_operations = 0;
+    auto vulkan_start = std::chrono::high_resolution_clock::now();
+    for (const MemoryOperation& operation : operations)
+    {
+        if (operation.allocate && memories.size() < vulkan_live_limit)
+        {
+            VkMemoryAllocateInfo alloc_info{};
+            alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            alloc_info.allocationSize = operation.size;
+            alloc_info.memoryTypeIndex = memory_type;
+
+            VkDeviceMemory memory;
+            vulkan_handle_vk_result(vkAllocateMemory(renderer.device, &alloc_info, nullptr, &memory));
+            vulkan_operations++;
+            if (operation.transient)
+            {
+                vkFreeMemory(renderer.device, memory, nullptr);
+            }
+            else
+            {
+                memories.push_back(memory);
+            }
+        }
+        else if (!memories.empty())
+        {
+            uint32_t slot = operation.allocate ? 0 : std::min<uint32_t>(operation.slot, static_cast<uint32_t>(memories.size() - 1));
+            vkFreeMemory(renderer.device, memories[slot], nullptr);
+            memories[slot] = memories.back();
+            memories.pop_back();
+            vulkan_operations++;
+        }
+    }
+    auto vulkan_end = std::chrono::high_resolution_clock::now();
+
+    for (VkDeviceMemory memory : memories)
+    {
+        vkFreeMemory(renderer.device, memory, nullptr);
+    }
+
+    double suballocator_ms = std::chrono::duration<double, std::milli>(suballocator_end - suballocator_start).count();
+    double vulkan_ms = std::chrono::duration<double, std::milli>(vulkan_end - vulkan_start).count();
+
+    auto print_statistics = [](const char* name, const MemoryStatistics& statistics, bool last)
+    {
+        std::cout << "  \"" << name << "\": { \"blocks\": " << statistics.block_count << ", \"dedicated_blocks\": " << statistics.dedicated_block_count
+            << ", \"allocations\": " << statistics.allocation_count << ", \"bytes_reserved\": " << statistics.bytes_reserved
+            << ", \"bytes_used\": " << statistics.bytes_used << ", \"free_ranges\": " << statistics.free_range_count
+            << ", \"largest_free_range\": " << statistics.largest_free_range << ", \"fragmentation\": " << statistics.fragmentation << " }"
+            << (last ? "" : ",") << std::endl;
+    };
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"memory\"," << std::endl;
+    std::cout << "  \"device\": \"" << bench_json_escape(properties.deviceName) << "\"," << std::endl;
+    std::cout << "  \"operations\": " << operation_count << "," << std::endl;
+    std::cout << "  \"live\": " << live_limit << "," << std::endl;
+    std::cout << "  \"min_size\": " << min_size << "," << std::endl;
+    std::cout << "  \"max_size\": " << max_size << "," << std::endl;
+    std::cout << "  \"transient_percent\": " << transient_percent << "," << std::endl;
+    std::cout << "  \"suballocator_ms\": " << suballocator_ms << "," << std::endl;
+    std::cout << "  \"suballocator_ns_per_operation\": " << (operation_count > 0 ? suballocator_ms * 1e6 / operation_count : 0.0) << "," << std::endl;
+    std::cout << "  \"vk_allocate_memory_operations\": " << vulkan_operations << "," << std::endl;
+    std::cout << "  \"vk_allocate_memory_ms\": " << vulkan_ms << "," << std::endl;
+    std::cout << "  \"vk_allocate_memory_ns_per_operation\": " << (vulkan_operations > 0 ? vulkan_ms * 1e6 / vulkan_operations : 0.0) << "," << std::endl;
+    print_statistics("peak", peak_statistics, false);
+    print_statistics("final", final_statistics, true);
+    std::cout << "}" << std::endl;
+
+    vulkan_cleanup(renderer);
+
+    return 0;
+}
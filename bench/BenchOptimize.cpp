@@ -0,0 +1,104 @@
+// Runs the mesh optimizer passes one after another on a deduplicated mesh and prints the vertex cache statistics
+// after every pass as JSON. No device is needed.
+//
+// Usage: bench_optimize [--obj path] [--quads N] [--shuffle] [--seed N] [--cache-size N]
+//
+// --shuffle randomizes the triangle order of the input first, a generated grid is already close to cache friendly
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "BenchScene.h"
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    std::string obj_path = bench_arg_string(argc, argv, "--obj", "");
+    uint32_t quads_per_side = bench_arg_uint(argc, argv, "--quads", 1000);
+    bool shuffle = bench_arg_flag(argc, argv, "--shuffle");
+    uint32_t seed = bench_arg_uint(argc, argv, "--seed", 1);
+    uint32_t cache_size = bench_arg_uint(argc, argv, "--cache-size", MESH_OPTIMIZER_CACHE_SIZE);
+
+    RenderGeometry geometry;
+    if (obj_path.empty())
+    {
+        bench_generate_grid(geometry, quads_per_side);
+    }
+    else
+    {
+        std::string warn, err;
+        if (!tinyobj::LoadObj(&geometry.attrib, &geometry.shapes, &geometry.materials, &warn, &err, obj_path.c_str()))
+        {
+            throw std::runtime_error(warn + err);
+        }
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    glm::vec3 bounds_min, bounds_max;
+    vulkan_build_mesh_data(geometry, glm::vec3(0.0f), vertices, indices, bounds_min, bounds_max, 0);
+
+    if (shuffle)
+    {
+        std::vector<uint32_t> triangles(indices.size() / 3);
+        for (size_t i = 0; i < triangles.size(); i++)
+        {
+            triangles[i] = static_cast<uint32_t>(i);
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+
+        std::vector<uint32_t> shuffled_indices;
+        shuffled_indices.reserve(indices.size());
+        for (uint32_t triangle : triangles)
+        {
+            shuffled_indices.insert(shuffled_indices.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+        }
+        indices.swap(shuffled_indices);
+    }
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"optimize\"," << std::endl;
+    std::cout << "  \"source\": \"" << bench_json_escape(obj_path.empty() ? "grid_" + std::to_string(quads_per_side) : obj_path) << "\"," << std::endl;
+    std::cout << "  \"shuffled\": " << (shuffle ? "true" : "false") << "," << std::endl;
+    std::cout << "  \"cache_size\": " << cache_size << "," << std::endl;
+    std::cout << "  \"vertices\": " << vertices.size() << "," << std::endl;
+    std::cout << "  \"triangles\": " << indices.size() / 3 << "," << std::endl;
+    std::cout << "  \"passes\": [" << std::endl;
+
+    auto print_pass = [&](const char* name, double pass_ms, bool last)
+    {
+        VertexCacheStatistics statistics = mesh_analyze_vertex_cache(indices.data(), indices.size(), vertices.size(), cache_size);
+        std::cout << "    { \"pass\": \"" << name << "\""
+            << ", \"ms\": " << pass_ms
+            << ", \"acmr\": " << statistics.acmr
+            << ", \"atvr\": " << statistics.atvr
+            << " }" << (last ? "" : ",") << std::endl;
+    };
+
+    auto time_pass = [](const auto& pass)
+    {
+        auto old_timestamp = std::chrono::high_resolution_clock::now();
+        pass();
+        auto new_timestamp = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count();
+    };
+
+    MeshOptimizerOptions options;
+    options.cache_size = cache_size;
+
+    print_pass("input", 0.0, false);
+    print_pass("vertex_cache", time_pass([&] { mesh_optimize_vertex_cache(indices, vertices.size(), options.cache_size); }), false);
+    print_pass("overdraw", time_pass([&] { mesh_optimize_overdraw(indices, reinterpret_cast<const float*>(vertices.data()), vertices.size(), sizeof(Vertex), options.cache_size, options.overdraw_threshold); }), false);
+    print_pass("vertex_fetch", time_pass([&] { vertices.resize(mesh_optimize_vertex_fetch(indices, vertices.data(), vertices.size(), sizeof(Vertex))); }), true);
+
+    std::cout << "  ]" << std::endl;
+    std::cout << "}" << std::endl;
+
+    return 0;
+}
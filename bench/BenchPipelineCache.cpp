@@ -0,0 +1,119 @@
+// Measures renderer startup and pipeline creation without a pipeline cache, with a warm one in memory and with the one
+// written to disk by the previous renderer, and prints the results as JSON
+//
+// Usage: bench_pipeline_cache [--iterations N] [--cache path]
+//
+// The cache file is deleted first. Drivers keeping a cache of their own make the cold numbers look better than a first launch.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+#include "BenchScene.h"
+
+namespace
+{
+    // Median of iterations creations of the main graphics pipeline through the renderer's current cache
+    double bench_time_pipeline_creation(ise::rendering::VulkanRendererData& renderer, uint32_t iterations)
+    {
+        using namespace ise::rendering;
+
+        std::vector<double> times_ms;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            auto old_timestamp = std::chrono::high_resolution_clock::now();
+            VkPipeline pipeline = vulkan_create_graphics_pipeline_from_shaders(renderer, vulkan_get_vertex_shader_file(renderer.custom_config.vertex_format, "vert"), "frag.spv", renderer.pipeline_layout, true);
+            auto new_timestamp = std::chrono::high_resolution_clock::now();
+            times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+
+            vkDestroyPipeline(renderer.device, pipeline, nullptr);
+        }
+
+        std::sort(times_ms.begin(), times_ms.end());
+        return ise::bench::bench_percentile(times_ms, 50.0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    uint32_t iterations = bench_arg_uint(argc, argv, "--iterations", 10);
+    std::string cache_path = bench_arg_string(argc, argv, "--cache", "bench_pipeline_cache.bin");
+
+    std::error_code error;
+    std::filesystem::remove(cache_path, error);
+
+    double startup_cold_ms;
+    double pipeline_cold_ms;
+    double pipeline_warm_ms;
+    {
+        VulkanRendererData renderer;
+        renderer.custom_config.pipeline_cache_path = cache_path;
+
+        auto old_timestamp = std::chrono::high_resolution_clock::now();
+        bench_create_renderer(renderer);
+        auto new_timestamp = std::chrono::high_resolution_clock::now();
+        startup_cold_ms = std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count();
+
+        // Startup already filled the renderer's cache, so every cold creation gets an empty one of its own
+        VkPipelineCache warm_cache = renderer.pipeline_cache;
+        VkPipelineCacheCreateInfo cache_info{};
+        cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+        std::vector<double> cold_times_ms;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            vulkan_handle_vk_result(vkCreatePipelineCache(renderer.device, &cache_info, nullptr, &renderer.pipeline_cache));
+            cold_times_ms.push_back(bench_time_pipeline_creation(renderer, 1));
+            vkDestroyPipelineCache(renderer.device, renderer.pipeline_cache, nullptr);
+        }
+        std::sort(cold_times_ms.begin(), cold_times_ms.end());
+        pipeline_cold_ms = bench_percentile(cold_times_ms, 50.0);
+
+        renderer.pipeline_cache = warm_cache;
+        pipeline_warm_ms = bench_time_pipeline_creation(renderer, iterations);
+
+        // Writes the cache the next renderer starts from
+        vulkan_cleanup(renderer);
+    }
+
+    uintmax_t cache_bytes = std::filesystem::file_size(cache_path, error);
+    if (error)
+    {
+        cache_bytes = 0;
+    }
+
+    double startup_warm_ms;
+    double pipeline_disk_ms;
+    {
+        VulkanRendererData renderer;
+        renderer.custom_config.pipeline_cache_path = cache_path;
+
+        auto old_timestamp = std::chrono::high_resolution_clock::now();
+        bench_create_renderer(renderer);
+        auto new_timestamp = std::chrono::high_resolution_clock::now();
+        startup_warm_ms = std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count();
+
+        pipeline_disk_ms = bench_time_pipeline_creation(renderer, iterations);
+
+        vulkan_cleanup(renderer);
+    }
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"pipeline_cache\"," << std::endl;
+    std::cout << "  \"iterations\": " << iterations << "," << std::endl;
+    std::cout << "  \"cache_bytes\": " << cache_bytes << "," << std::endl;
+    std::cout << "  \"startup_cold_ms\": " << startup_cold_ms << "," << std::endl;
+    std::cout << "  \"startup_warm_ms\": " << startup_warm_ms << "," << std::endl;
+    std::cout << "  \"pipeline_cold_ms\": " << pipeline_cold_ms << "," << std::endl;
+    std::cout << "  \"pipeline_warm_ms\": " << pipeline_warm_ms << "," << std::endl;
+    std::cout << "  \"pipeline_from_disk_ms\": " << pipeline_disk_ms << std::endl;
+    std::cout << "}" << std::endl;
+
+    return 0;
+}
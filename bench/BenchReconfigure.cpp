@@ -0,0 +1,122 @@
+// Times vulkan_reconfigure for settings changes against tearing the renderer down and creating it again with the scene,
+// and prints the medians as JSON
+//
+// Usage: bench_reconfigure [--iterations N] [--objects N] [--quads N] [--obj path] [--texture path]
+//
+// Headless has no present mode, so the swapchain path is timed with a resolution change instead of v_sync.
+// Every change is followed by one frame, so a broken renderer does not go unnoticed.
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "BenchScene.h"
+
+namespace
+{
+    // Median of iterations calls of change, which gets the iteration to alternate between two setups
+    double bench_time_change(ise::rendering::VulkanRendererData& renderer, uint32_t iterations, const std::function<void(uint32_t iteration)>& change)
+    {
+        std::vector<double> times_ms;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            auto old_timestamp = std::chrono::high_resolution_clock::now();
+            change(i);
+            auto new_timestamp = std::chrono::high_resolution_clock::now();
+            times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+
+            ise::rendering::vulkan_draw_frame(renderer);
+        }
+
+        std::sort(times_ms.begin(), times_ms.end());
+        return ise::bench::bench_percentile(times_ms, 50.0);
+    }
+
+    void bench_reconfigure(ise::rendering::VulkanRendererData& renderer, const ise::rendering::VulkanRendererConfig& config)
+    {
+        if (!ise::rendering::vulkan_reconfigure(renderer, config))
+        {
+            throw std::runtime_error("failed to reconfigure the renderer without a new device!");
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    uint32_t iterations = bench_arg_uint(argc, argv, "--iterations", 20);
+
+    BenchSceneOptions scene_options;
+    scene_options.object_count = bench_arg_uint(argc, argv, "--objects", scene_options.object_count);
+    scene_options.quads_per_side = bench_arg_uint(argc, argv, "--quads", scene_options.quads_per_side);
+    scene_options.obj_path = bench_arg_string(argc, argv, "--obj", "");
+    scene_options.texture_path = bench_arg_string(argc, argv, "--texture", "");
+
+    VulkanRendererData renderer;
+    bench_create_renderer(renderer);
+    bench_load_scene(renderer, scene_options);
+    vulkan_draw_frame(renderer);
+
+    const VulkanRendererConfig base_config = renderer.custom_config;
+
+    double resolution_ms = bench_time_change(renderer, iterations, [&](uint32_t iteration)
+    {
+        VulkanRendererConfig config = base_config;
+        if (iteration % 2 == 0)
+        {
+            config.headless_width = base_config.headless_width / 2;
+            config.headless_height = base_config.headless_height / 2;
+        }
+        bench_reconfigure(renderer, config);
+    });
+
+    double msaa_ms = bench_time_change(renderer, iterations, [&](uint32_t iteration)
+    {
+        VulkanRendererConfig config = base_config;
+        config.msaa_sample_target = iteration % 2 == 0 ? VK_SAMPLE_COUNT_4_BIT : VK_SAMPLE_COUNT_1_BIT;
+        bench_reconfigure(renderer, config);
+    });
+
+    double filtering_ms = bench_time_change(renderer, iterations, [&](uint32_t iteration)
+    {
+        VulkanRendererConfig config = base_config;
+        config.texture_filtering = iteration % 2 == 0 ? NEAREST : TRILINEAR;
+        bench_reconfigure(renderer, config);
+    });
+
+    double recording_threads_ms = bench_time_change(renderer, iterations, [&](uint32_t iteration)
+    {
+        VulkanRendererConfig config = base_config;
+        config.recording_threads = iteration % 2 == 0 ? 1 : base_config.recording_threads;
+        bench_reconfigure(renderer, config);
+    });
+
+    // What every settings change cost before, the scene has to be loaded again
+    double recreate_ms = bench_time_change(renderer, iterations, [&](uint32_t iteration)
+    {
+        vulkan_cleanup(renderer);
+        renderer.custom_config = base_config;
+        bench_create_renderer(renderer);
+        bench_load_scene(renderer, scene_options);
+    });
+
+    vulkan_cleanup(renderer);
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"reconfigure\"," << std::endl;
+    std::cout << "  \"iterations\": " << iterations << "," << std::endl;
+    std::cout << "  \"objects\": " << scene_options.object_count << "," << std::endl;
+    std::cout << "  \"resolution_ms\": " << resolution_ms << "," << std::endl;
+    std::cout << "  \"msaa_ms\": " << msaa_ms << "," << std::endl;
+    std::cout << "  \"filtering_ms\": " << filtering_ms << "," << std::endl;
+    std::cout << "  \"recording_threads_ms\": " << recording_threads_ms << "," << std::endl;
+    std::cout << "  \"recreate_ms\": " << recreate_ms << std::endl;
+    std::cout << "}" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Measures vulkan_record_command_buffer against the number of recording threads and prints the results as JSON
+//
+// Usage: bench_record [--iterations N] [--objects N] [--quads N] [--max-threads N]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "BenchScene.h"
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    uint32_t iterations = bench_arg_uint(argc, argv, "--iterations", 50);
+    uint32_t max_threads = bench_arg_uint(argc, argv, "--max-threads", std::max(1u, std::thread::hardware_concurrency()));
+
+    BenchSceneOptions scene_options;
+    scene_options.object_count = bench_arg_uint(argc, argv, "--objects", 2048);
+    scene_options.quads_per_side = bench_arg_uint(argc, argv, "--quads", 2);
+
+    VulkanRendererData renderer;
+    // Every object should be recorded, culling is measured by bench_cull
+    renderer.custom_config.cpu_frustum_culling = false;
+    bench_create_renderer(renderer);
+    bench_load_scene(renderer, scene_options);
+
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t thread_count = 1; thread_count < max_threads; thread_count *= 2)
+    {
+        thread_counts.push_back(thread_count);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"record\"," << std::endl;
+    std::cout << "  \"objects\": " << renderer.render_objects.size() << "," << std::endl;
+    std::cout << "  \"iterations\": " << iterations << "," << std::endl;
+    std::cout << "  \"results\": [" << std::endl;
+
+    double single_thread_p50_ms = 0.0;
+    for (size_t i = 0; i < thread_counts.size(); i++)
+    {
+        // Rebuild the workers so exactly thread_counts[i] pools and threads exist
+        vulkan_handle_vk_result(vkDeviceWaitIdle(renderer.device));
+        vulkan_free_command_buffers(renderer);
+        vulkan_destroy_recording_workers(renderer);
+        renderer.custom_config.recording_threads = thread_counts[i];
+        vulkan_create_recording_workers(renderer);
+        vulkan_create_command_buffers(renderer);
+
+        std::vector<double> record_times_ms;
+        for (uint32_t iteration = 0; iteration < iterations; iteration++)
+        {
+            auto old_timestamp = std::chrono::high_resolution_clock::now();
+            vulkan_handle_vk_result(vkResetCommandBuffer(renderer.command_buffers[0], 0));
+            vulkan_record_command_buffer(renderer, 0, 0);
+            auto new_timestamp = std::chrono::high_resolution_clock::now();
+
+            record_times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+        }
+
+        double mean_ms = iterations > 0 ? std::accumulate(record_times_ms.begin(), record_times_ms.end(), 0.0) / iterations : 0.0;
+        std::sort(record_times_ms.begin(), record_times_ms.end());
+        double p50_ms = bench_percentile(record_times_ms, 50.0);
+        if (i == 0)
+        {
+            single_thread_p50_ms = p50_ms;
+        }
+
+        std::cout << "    { \"threads\": " << thread_counts[i]
+            << ", \"draws\": " << renderer.draw_commands.size()
+            << ", \"mean_ms\": " << mean_ms
+            << ", \"p50_ms\": " << p50_ms
+            << ", \"p90_ms\": " << bench_percentile(record_times_ms, 90.0)
+            << ", \"speedup\": " << (p50_ms > 0.0 ? single_thread_p50_ms / p50_ms : 0.0)
+            << " }" << (i + 1 < thread_counts.size() ? "," : "") << std::endl;
+    }
+
+    std::cout << "  ]" << std::endl;
+    std::cout << "}" << std::endl;
+
+    vulkan_cleanup(renderer);
+
+    return 0;
+}
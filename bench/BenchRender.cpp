@@ -0,0 +1,140 @@
+// Drives vulkan_draw_frame headless and prints frame time percentiles as JSON
+//
+// Usage: bench_render [--frames N] [--warmup N] [--width W] [--height H] [--objects N] [--quads N] [--obj path] [--texture path] [--rerecord] [--resize-every N] [--min-scale-percent N] [--gpu-budget-us N] [--gpu-culling] [--no-cpu-culling] [--no-mesh-optimizer] [--float-vertices] [--32-bit-indices]
+//
+// --rerecord invalidates the recorded command buffers every frame, to compare against the cached path
+// --resize-every recreates the swapchain every N frames at an alternating size, the way dragging a window edge does
+// --min-scale-percent lets dynamic resolution lower the render scale down to N percent to hold --gpu-budget-us per frame
+// --gpu-culling culls and draws through the compute pass and vkCmdDrawIndexedIndirectCount when the device supports it
+// --no-cpu-culling records every object instead of only those inside the view frustum
+// --no-mesh-optimizer keeps loaded meshes in face order, to compare against the vertex cache and overdraw ordering
+// --float-vertices and --32-bit-indices upload geometry uncompressed, to compare against PackedVertex and 16 bit indices
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "BenchScene.h"
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    uint32_t frames = bench_arg_uint(argc, argv, "--frames", 1000);
+    uint32_t warmup_frames = bench_arg_uint(argc, argv, "--warmup", 50);
+    bool rerecord = bench_arg_flag(argc, argv, "--rerecord");
+    uint32_t resize_every = bench_arg_uint(argc, argv, "--resize-every", 0);
+
+    BenchSceneOptions scene_options;
+    scene_options.object_count = bench_arg_uint(argc, argv, "--objects", scene_options.object_count);
+    scene_options.quads_per_side = bench_arg_uint(argc, argv, "--quads", scene_options.quads_per_side);
+    scene_options.obj_path = bench_arg_string(argc, argv, "--obj", "");
+    scene_options.texture_path = bench_arg_string(argc, argv, "--texture", "");
+
+    VulkanRendererData renderer;
+    renderer.custom_config.headless_width = bench_arg_uint(argc, argv, "--width", renderer.custom_config.headless_width);
+    renderer.custom_config.headless_height = bench_arg_uint(argc, argv, "--height", renderer.custom_config.headless_height);
+    renderer.custom_config.min_render_scale = bench_arg_uint(argc, argv, "--min-scale-percent", 100) / 100.0f;
+    renderer.custom_config.target_gpu_frame_time_ms = bench_arg_uint(argc, argv, "--gpu-budget-us", 16667) / 1000.0f;
+    renderer.custom_config.gpu_driven_culling = bench_arg_flag(argc, argv, "--gpu-culling");
+    renderer.custom_config.cpu_frustum_culling = !bench_arg_flag(argc, argv, "--no-cpu-culling");
+    renderer.custom_config.optimize_meshes = !bench_arg_flag(argc, argv, "--no-mesh-optimizer");
+    renderer.custom_config.vertex_format = bench_arg_flag(argc, argv, "--float-vertices") ? VERTEX_FORMAT_FLOAT : VERTEX_FORMAT_PACKED;
+    renderer.custom_config.compact_indices = !bench_arg_flag(argc, argv, "--32-bit-indices");
+
+    bench_create_renderer(renderer);
+    bench_load_scene(renderer, scene_options);
+
+    const uint32_t base_width = renderer.custom_config.headless_width;
+
+    for (uint32_t i = 0; i < warmup_frames; i++)
+    {
+        vulkan_draw_frame(renderer);
+    }
+
+    std::vector<double> frame_times_ms;
+    frame_times_ms.reserve(frames);
+
+    auto benchmark_start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        auto old_timestamp = std::chrono::high_resolution_clock::now();
+        if (rerecord)
+        {
+            vulkan_invalidate_recorded_command_buffers(renderer);
+        }
+        if (resize_every > 0 && i % resize_every == resize_every - 1)
+        {
+            renderer.custom_config.headless_width = renderer.custom_config.headless_width == base_width ? base_width - 16 : base_width;
+            vulkan_recreate_swap_chain(renderer);
+        }
+        vulkan_draw_frame(renderer);
+        auto new_timestamp = std::chrono::high_resolution_clock::now();
+
+        frame_times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+    }
+    vulkan_handle_vk_result(vkDeviceWaitIdle(renderer.device));
+    auto benchmark_end = std::chrono::high_resolution_clock::now();
+
+    double total_ms = std::chrono::duration<double, std::milli>(benchmark_end - benchmark_start).count();
+    double mean_ms = frames > 0 ? std::accumulate(frame_times_ms.begin(), frame_times_ms.end(), 0.0) / frames : 0.0;
+    std::sort(frame_times_ms.begin(), frame_times_ms.end());
+
+    // Triangle weighted over all meshes
+    double vertices_transformed = 0.0;
+    double triangles = 0.0;
+    double vertices_referenced = 0.0;
+    for (const auto& [key, mesh] : renderer.meshes)
+    {
+        vertices_transformed += mesh->vertex_cache_statistics.vertices_transformed;
+        triangles += mesh->index_count / 3;
+        vertices_referenced += mesh->vertex_count;
+    }
+
+    const VkPhysicalDeviceProperties& properties = renderer.physical_device_properties;
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"render\"," << std::endl;
+    std::cout << "  \"device\": \"" << bench_json_escape(properties.deviceName) << "\"," << std::endl;
+    std::cout << "  \"width\": " << renderer.swap_chain_extent.width << "," << std::endl;
+    std::cout << "  \"height\": " << renderer.swap_chain_extent.height << "," << std::endl;
+    std::cout << "  \"dynamic_resolution\": " << (renderer.dynamic_resolution.enabled ? "true" : "false") << "," << std::endl;
+    std::cout << "  \"render_scale\": " << (renderer.dynamic_resolution.enabled ? renderer.dynamic_resolution.scale : 1.0f) << "," << std::endl;
+    std::cout << "  \"render_width\": " << vulkan_get_render_extent(renderer).width << "," << std::endl;
+    std::cout << "  \"render_height\": " << vulkan_get_render_extent(renderer).height << "," << std::endl;
+    std::cout << "  \"gpu_frame_time_ms\": " << renderer.dynamic_resolution.gpu_frame_time_ms << "," << std::endl;
+    std::cout << "  \"objects\": " << renderer.render_objects.size() << "," << std::endl;
+    std::cout << "  \"draws\": " << renderer.draw_commands.size() << "," << std::endl;
+    std::cout << "  \"instances\": " << renderer.draw_instances.size() << "," << std::endl;
+    std::cout << "  \"meshes\": " << renderer.meshes.size() << "," << std::endl;
+    std::cout << "  \"vertices\": " << renderer.vertex_allocator.used() / vulkan_get_vertex_stride(renderer.custom_config.vertex_format) << "," << std::endl;
+    std::cout << "  \"vertex_format\": \"" << (renderer.custom_config.vertex_format == VERTEX_FORMAT_PACKED ? "packed" : "float") << "\"," << std::endl;
+    std::cout << "  \"vertex_bytes\": " << renderer.vertex_allocator.used() << "," << std::endl;
+    std::cout << "  \"vertex_capacity_bytes\": " << renderer.vertex_buffer_capacity << "," << std::endl;
+    std::cout << "  \"index_bytes\": " << renderer.index_allocator.used() << "," << std::endl;
+    std::cout << "  \"index_capacity_bytes\": " << renderer.index_buffer_capacity << "," << std::endl;
+    std::cout << "  \"mesh_optimizer\": " << (renderer.custom_config.optimize_meshes ? "true" : "false") << "," << std::endl;
+    std::cout << "  \"acmr\": " << (triangles > 0.0 ? vertices_transformed / triangles : 0.0) << "," << std::endl;
+    std::cout << "  \"atvr\": " << (vertices_referenced > 0.0 ? vertices_transformed / vertices_referenced : 0.0) << "," << std::endl;
+    std::cout << "  \"rerecord\": " << (rerecord ? "true" : "false") << "," << std::endl;
+    std::cout << "  \"resize_every\": " << resize_every << "," << std::endl;
+    std::cout << "  \"cpu_culling\": " << (renderer.custom_config.cpu_frustum_culling && !renderer.gpu_culling.enabled ? "true" : "false") << "," << std::endl;
+    std::cout << "  \"gpu_culling\": " << (renderer.gpu_culling.enabled ? "true" : "false") << "," << std::endl;
+    std::cout << "  \"frames\": " << frames << "," << std::endl;
+    std::cout << "  \"total_ms\": " << total_ms << "," << std::endl;
+    std::cout << "  \"fps\": " << (total_ms > 0.0 ? frames * 1000.0 / total_ms : 0.0) << "," << std::endl;
+    std::cout << "  \"mean_ms\": " << mean_ms << "," << std::endl;
+    std::cout << "  \"min_ms\": " << (frame_times_ms.empty() ? 0.0 : frame_times_ms.front()) << "," << std::endl;
+    std::cout << "  \"p50_ms\": " << bench_percentile(frame_times_ms, 50.0) << "," << std::endl;
+    std::cout << "  \"p90_ms\": " << bench_percentile(frame_times_ms, 90.0) << "," << std::endl;
+    std::cout << "  \"p99_ms\": " << bench_percentile(frame_times_ms, 99.0) << "," << std::endl;
+    std::cout << "  \"max_ms\": " << (frame_times_ms.empty() ? 0.0 : frame_times_ms.back()) << std::endl;
+    std::cout << "}" << std::endl;
+
+    vulkan_cleanup(renderer);
+
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include "BenchScene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+void ise::bench::bench_create_renderer(ise::rendering::VulkanRendererData& renderer)
+{
+    using namespace ise::rendering;
+
+    renderer.custom_config.headless = true;
+
+    vulkan_create_instance(renderer);
+    vulkan_setup_debug_messenger(renderer);
+    vulkan_pick_physical_device(renderer);
+    vulkan_create_logical_device(renderer);
+    vulkan_create_swap_chain(renderer);
+    vulkan_create_image_views(renderer);
+    vulkan_create_render_pass(renderer);
+    vulkan_create_descriptor_set_layout(renderer);
+    vulkan_create_graphics_pipeline(renderer);
+    vulkan_create_command_pool(renderer);
+    vulkan_create_upload_queue(renderer);
+    vulkan_create_staging_ring(renderer);
+    vulkan_create_recording_workers(renderer);
+    vulkan_create_render_target(renderer);
+    vulkan_create_color_resources(renderer);
+    vulkan_create_depth_resources(renderer);
+    vulkan_create_framebuffers(renderer);
+    vulkan_create_uniform_buffers(renderer);
+    vulkan_create_descriptor_pool(renderer);
+    vulkan_create_uniform_buffers_descriptor_sets(renderer);
+    vulkan_create_bindless_textures(renderer);
+    vulkan_create_command_buffers(renderer);
+    vulkan_create_sync_objects(renderer);
+    vulkan_create_gpu_culling_resources(renderer);
+    vulkan_create_virtual_texturing_resources(renderer);
+    vulkan_create_dynamic_resolution_resources(renderer);
+}
+
+void ise::bench::bench_generate_grid(ise::rendering::RenderGeometry& geometry, uint32_t quads_per_side, uint32_t shape_count)
+{
+    float step = 1.0f / static_cast<float>(quads_per_side);
+    uint32_t vertices_per_side = quads_per_side + 1;
+    shape_count = std::clamp(shape_count, 1u, std::max(1u, quads_per_side));
+
+    for (uint32_t y = 0; y < vertices_per_side; y++)
+    {
+        for (uint32_t x = 0; x < vertices_per_side; x++)
+        {
+            geometry.attrib.vertices.push_back(x * step - 0.5f);
+            geometry.attrib.vertices.push_back(y * step - 0.5f);
+            geometry.attrib.vertices.push_back(0.0f);
+
+            geometry.attrib.texcoords.push_back(x * step);
+            geometry.attrib.texcoords.push_back(y * step);
+        }
+    }
+
+    // Rows are split evenly over the shapes, neighbouring shapes share the vertices along their seam
+    for (uint32_t shape_index = 0; shape_index < shape_count; shape_index++)
+    {
+        tinyobj::shape_t shape;
+        shape.name = "bench_grid_" + std::to_string(shape_index);
+        uint32_t first_row = quads_per_side * shape_index / shape_count;
+        uint32_t end_row = quads_per_side * (shape_index + 1) / shape_count;
+        for (uint32_t y = first_row; y < end_row; y++)
+        {
+            for (uint32_t x = 0; x < quads_per_side; x++)
+            {
+                int corner = static_cast<int>(y * vertices_per_side + x);
+                int quad[6] = {
+                    corner, corner + 1, corner + static_cast<int>(vertices_per_side) + 1,
+                    corner, corner + static_cast<int>(vertices_per_side) + 1, corner + static_cast<int>(vertices_per_side)
+                };
+
+                for (int vertex_index : quad)
+                {
+                    tinyobj::index_t index;
+                    index.vertex_index = vertex_index;
+                    index.normal_index = -1;
+                    index.texcoord_index = vertex_index;
+                    shape.mesh.indices.push_back(index);
+                }
+            }
+        }
+        shape.mesh.num_face_vertices.resize(shape.mesh.indices.size() / 3, 3);
+
+        geometry.shapes.push_back(shape);
+    }
+}
+
+void ise::bench::bench_load_scene(ise::rendering::VulkanRendererData& renderer, const BenchSceneOptions& options)
+{
+    using namespace ise::rendering;
+
+    RenderTexture* render_texture = vulkan_create_render_texture("bench_texture", renderer);
+
+    std::vector<stbi_uc> generated_pixels;
+    if (options.texture_path.empty())
+    {
+        const int size = 256;
+        generated_pixels.resize(size * size * 4);
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                stbi_uc value = ((x / 32) + (y / 32)) % 2 == 0 ? 255 : 64;
+                stbi_uc* pixel = &generated_pixels[(y * size + x) * 4];
+                pixel[0] = value;
+                pixel[1] = value;
+                pixel[2] = value;
+                pixel[3] = 255;
+            }
+        }
+
+        render_texture->raw_texture.width = size;
+        render_texture->raw_texture.height = size;
+        render_texture->raw_texture.channels = 4;
+        render_texture->raw_texture.pixels = generated_pixels.data();
+    }
+    else
+    {
+        render_texture->raw_texture.pixels = stbi_load(
+            options.texture_path.c_str(),
+            &render_texture->raw_texture.width,
+            &render_texture->raw_texture.height,
+            &render_texture->raw_texture.channels,
+            STBI_rgb_alpha);
+
+        if (!render_texture->raw_texture.pixels)
+        {
+            throw std::runtime_error("failed to load texture image!");
+        }
+    }
+
+    vulkan_create_texture_image(renderer, *render_texture);
+    vulkan_create_texture_sampler(renderer, *render_texture);
+
+    // Every object is an instance of the same mesh
+    const Mesh* mesh;
+    if (options.obj_path.empty())
+    {
+        RenderGeometry geometry;
+        bench_generate_grid(geometry, options.quads_per_side);
+        mesh = vulkan_get_or_create_mesh(renderer, "bench_grid_" + std::to_string(options.quads_per_side), geometry);
+    }
+    else
+    {
+        mesh = vulkan_load_mesh(renderer, options.obj_path);
+    }
+
+    // Objects are laid out on a square grid that fits inside the default orthographic view
+    uint32_t objects_per_side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(options.object_count))));
+    float spacing = 1.5f / static_cast<float>(objects_per_side);
+
+    for (uint32_t i = 0; i < options.object_count; i++)
+    {
+        RenderObject* render_object = vulkan_create_render_object(renderer);
+        render_object->type = OBJ_WITH_STATIC_TEXTURE;
+
+        render_object->textures.push_back("bench_texture");
+        vulkan_create_textures_description_set(renderer, *render_object);
+
+        float x = (static_cast<float>(i % objects_per_side) + 0.5f) * spacing - 0.75f;
+        float y = (static_cast<float>(i / objects_per_side) + 0.5f) * spacing - 0.75f;
+        vulkan_set_render_object_mesh(renderer, *render_object, mesh);
+        vulkan_set_render_object_transform(renderer, *render_object, glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f)));
+    }
+
+    if (!options.texture_path.empty())
+    {
+        stbi_image_free(render_texture->raw_texture.pixels);
+    }
+    render_texture->raw_texture.pixels = nullptr;
+}
+
+uint32_t ise::bench::bench_arg_uint(int argc, char** argv, const std::string& name, uint32_t default_value)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (name == argv[i])
+        {
+            return static_cast<uint32_t>(std::stoul(argv[i + 1]));
+        }
+    }
+
+    return default_value;
+}
+
+std::string ise::bench::bench_arg_string(int argc, char** argv, const std::string& name, const std::string& default_value)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (name == argv[i])
+        {
+            return argv[i + 1];
+        }
+    }
+
+    return default_value;
+}
+
+bool ise::bench::bench_arg_flag(int argc, char** argv, const std::string& name)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (name == argv[i])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+double ise::bench::bench_percentile(const std::vector<double>& sorted_samples, double percentile)
+{
+    if (sorted_samples.empty())
+    {
+        return 0.0;
+    }
+
+    size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted_samples.size())));
+    rank = std::clamp<size_t>(rank, 1, sorted_samples.size());
+    return sorted_samples[rank - 1];
+}
+
+std::string ise::bench::bench_json_escape(const std::string& value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char code[7];
+            std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+            escaped += code;
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+
+    return escaped;
+}
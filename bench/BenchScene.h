@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "rendering/VulkanRendererUgly.h"
+
+namespace ise
+{
+    namespace bench
+    {
+        struct BenchSceneOptions
+        {
+            // When obj_path is empty a procedural grid of quads is generated instead
+            std::string obj_path;
+            std::string texture_path;
+
+            uint32_t object_count = 16;
+            uint32_t quads_per_side = 32;
+        };
+
+        // Runs the whole vulkan_create_* sequence with custom_config.headless forced on
+        void bench_create_renderer(ise::rendering::VulkanRendererData& renderer);
+        void bench_load_scene(ise::rendering::VulkanRendererData& renderer, const BenchSceneOptions& options);
+
+        // Flat grid of quads_per_side^2 quads in the unit square, its rows split over shape_count shapes
+        void bench_generate_grid(ise::rendering::RenderGeometry& geometry, uint32_t quads_per_side, uint32_t shape_count = 1);
+
+        uint32_t bench_arg_uint(int argc, char** argv, const std::string& name, uint32_t default_value);
+        std::string bench_arg_string(int argc, char** argv, const std::string& name, const std::string& default_value);
+        bool bench_arg_flag(int argc, char** argv, const std::string& name);
+
+        // Nearest rank percentile, samples must already be sorted
+        double bench_percentile(const std::vector<double>& sorted_samples, double percentile);
+
+        // value escaped for use between the quotes of a JSON string, device names and paths may contain quotes or backslashes
+        std::string bench_json_escape(const std::string& value);
+    }
+}
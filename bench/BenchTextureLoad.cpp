@@ -0,0 +1,129 @@
+// Loads every image in a folder through vulkan_load_texture_async while drawing the bench scene headless, and prints
+// frame time percentiles during the load and the time until every texture was resident as JSON
+//
+// Usage: bench_texture_load --folder path [--objects N] [--quads N] [--decode-threads N] [--upload-budget-kib N] [--compression none|bc1|bc7]
+//
+// A frame time close to the idle one with many images in flight means decoding and uploading stay off the frame.
+// --decode-threads 0 uses every core. The first run with compression builds the texture caches, later runs read them.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include "BenchScene.h"
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    std::string folder = bench_arg_string(argc, argv, "--folder", "");
+    if (folder.empty())
+    {
+        std::cerr << "bench_texture_load needs --folder" << std::endl;
+        return 1;
+    }
+
+    BenchSceneOptions scene_options;
+    scene_options.object_count = bench_arg_uint(argc, argv, "--objects", scene_options.object_count);
+    scene_options.quads_per_side = bench_arg_uint(argc, argv, "--quads", scene_options.quads_per_side);
+
+    VulkanRendererData renderer;
+    renderer.custom_config.texture_decode_threads = bench_arg_uint(argc, argv, "--decode-threads", renderer.custom_config.texture_decode_threads);
+    renderer.custom_config.texture_upload_budget = bench_arg_uint(argc, argv, "--upload-budget-kib", static_cast<uint32_t>(renderer.custom_config.texture_upload_budget / 1024)) * 1024ull;
+    std::string compression = bench_arg_string(argc, argv, "--compression", "bc7");
+    renderer.custom_config.texture_compression = compression == "none" ? TEXTURE_COMPRESSION_NONE : compression == "bc1" ? TEXTURE_COMPRESSION_BC1 : TEXTURE_COMPRESSION_BC7;
+
+    bench_create_renderer(renderer);
+    bench_load_scene(renderer, scene_options);
+
+    // Idle frames first, as the baseline
+    std::vector<double> idle_frame_times_ms;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        auto old_timestamp = std::chrono::high_resolution_clock::now();
+        vulkan_draw_frame(renderer);
+        auto new_timestamp = std::chrono::high_resolution_clock::now();
+        idle_frame_times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+    }
+    std::sort(idle_frame_times_ms.begin(), idle_frame_times_ms.end());
+
+    auto load_start = std::chrono::high_resolution_clock::now();
+    std::vector<TextureLoadHandle> loads;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(folder))
+    {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (entry.is_regular_file() && (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp"))
+        {
+            std::string path = entry.path().string();
+            loads.push_back(vulkan_load_texture_async(renderer, path, path));
+        }
+    }
+    auto submit_end = std::chrono::high_resolution_clock::now();
+
+    std::vector<double> frame_times_ms;
+    auto all_finished = [&loads]()
+    {
+        return std::all_of(loads.begin(), loads.end(), [](const TextureLoadHandle& load)
+        {
+            return load->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+    };
+    while (!all_finished())
+    {
+        auto old_timestamp = std::chrono::high_resolution_clock::now();
+        vulkan_draw_frame(renderer);
+        auto new_timestamp = std::chrono::high_resolution_clock::now();
+        frame_times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+    }
+    auto load_end = std::chrono::high_resolution_clock::now();
+    vulkan_handle_vk_result(vkDeviceWaitIdle(renderer.device));
+    std::sort(frame_times_ms.begin(), frame_times_ms.end());
+
+    uint32_t resident_count = 0;
+    uint32_t failed_count = 0;
+    VkDeviceSize image_bytes = 0;
+    for (const TextureLoadHandle& load : loads)
+    {
+        if (load->future.get() == TEXTURE_LOAD_RESIDENT)
+        {
+            resident_count++;
+            image_bytes += renderer.render_textures[load->key]->image_memory.size;
+        }
+        else
+        {
+            failed_count++;
+        }
+    }
+
+    double submit_ms = std::chrono::duration<double, std::milli>(submit_end - load_start).count();
+    double load_ms = std::chrono::duration<double, std::milli>(load_end - load_start).count();
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"texture_load\"," << std::endl;
+    std::cout << "  \"images\": " << loads.size() << "," << std::endl;
+    std::cout << "  \"resident\": " << resident_count << "," << std::endl;
+    std::cout << "  \"failed\": " << failed_count << "," << std::endl;
+    std::cout << "  \"samplers\": " << renderer.texture_samplers.size() << "," << std::endl;
+    std::cout << "  \"decode_threads\": " << (renderer.texture_decode_queue ? renderer.texture_decode_queue->size() : 0) << "," << std::endl;
+    std::cout << "  \"upload_budget_bytes\": " << renderer.custom_config.texture_upload_budget << "," << std::endl;
+    std::cout << "  \"format\": " << renderer.compressed_texture_format << "," << std::endl;
+    std::cout << "  \"image_bytes\": " << image_bytes << "," << std::endl;
+    std::cout << "  \"submit_ms\": " << submit_ms << "," << std::endl;
+    std::cout << "  \"load_ms\": " << load_ms << "," << std::endl;
+    std::cout << "  \"frames_during_load\": " << frame_times_ms.size() << "," << std::endl;
+    std::cout << "  \"idle_p50_ms\": " << bench_percentile(idle_frame_times_ms, 50.0) << "," << std::endl;
+    std::cout << "  \"idle_p99_ms\": " << bench_percentile(idle_frame_times_ms, 99.0) << "," << std::endl;
+    std::cout << "  \"load_p50_ms\": " << bench_percentile(frame_times_ms, 50.0) << "," << std::endl;
+    std::cout << "  \"load_p99_ms\": " << bench_percentile(frame_times_ms, 99.0) << "," << std::endl;
+    std::cout << "  \"load_max_ms\": " << (frame_times_ms.empty() ? 0.0 : frame_times_ms.back()) << std::endl;
+    std::cout << "}" << std::endl;
+
+    vulkan_cleanup(renderer);
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Draws the bench scene headless with every object sampling one image as a virtual texture, and prints frame time
+// percentiles while pages stream in and the memory the atlas needs against a full mip chain of the image as JSON
+//
+// Usage: bench_virtual_texture --image path [--objects N] [--quads N] [--frames N] [--atlas-pages N] [--uploads-per-frame N] [--compression none|bc1|bc7]
+//
+// The first run builds the tile file next to the image, later runs open it. Frames keep being drawn after the build
+// until --frames frames ran with no read in flight.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "BenchScene.h"
+
+int main(int argc, char** argv)
+{
+    using namespace ise::rendering;
+    using namespace ise::bench;
+
+    std::string image = bench_arg_string(argc, argv, "--image", "");
+    if (image.empty())
+    {
+        std::cerr << "bench_virtual_texture needs --image" << std::endl;
+        return 1;
+    }
+
+    BenchSceneOptions scene_options;
+    scene_options.object_count = bench_arg_uint(argc, argv, "--objects", scene_options.object_count);
+    scene_options.quads_per_side = bench_arg_uint(argc, argv, "--quads", scene_options.quads_per_side);
+    uint32_t settle_frames = bench_arg_uint(argc, argv, "--frames", 100);
+
+    VulkanRendererData renderer;
+    renderer.custom_config.virtual_texture_atlas_pages = bench_arg_uint(argc, argv, "--atlas-pages", renderer.custom_config.virtual_texture_atlas_pages);
+    renderer.custom_config.virtual_texture_uploads_per_frame = bench_arg_uint(argc, argv, "--uploads-per-frame", renderer.custom_config.virtual_texture_uploads_per_frame);
+    std::string compression = bench_arg_string(argc, argv, "--compression", "bc7");
+    renderer.custom_config.texture_compression = compression == "none" ? TEXTURE_COMPRESSION_NONE : compression == "bc1" ? TEXTURE_COMPRESSION_BC1 : TEXTURE_COMPRESSION_BC7;
+
+    bench_create_renderer(renderer);
+    bench_load_scene(renderer, scene_options);
+
+    if (!renderer.virtual_texturing.supported)
+    {
+        std::cerr << "bench_virtual_texture needs fragmentStoresAndAtomics" << std::endl;
+        vulkan_cleanup(renderer);
+        return 1;
+    }
+
+    auto build_start = std::chrono::high_resolution_clock::now();
+    VirtualTexture* virtual_texture = vulkan_create_virtual_texture(renderer, "bench_virtual_texture", image);
+    for (RenderObject* render_object : renderer.render_objects)
+    {
+        vulkan_set_render_object_virtual_texture(renderer, *render_object, "bench_virtual_texture");
+    }
+
+    std::vector<double> build_frame_times_ms;
+    std::shared_ptr<VirtualTextureBuild> build = virtual_texture->build;
+    while (build->future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        auto old_timestamp = std::chrono::high_resolution_clock::now();
+        vulkan_draw_frame(renderer);
+        auto new_timestamp = std::chrono::high_resolution_clock::now();
+        build_frame_times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+    }
+    auto build_end = std::chrono::high_resolution_clock::now();
+
+    if (build->future.get() == VIRTUAL_TEXTURE_FAILED)
+    {
+        std::cerr << build->error << std::endl;
+        vulkan_cleanup(renderer);
+        return 1;
+    }
+
+    std::vector<double> stream_frame_times_ms;
+    uint32_t idle_frames = 0;
+    while (idle_frames < settle_frames)
+    {
+        auto old_timestamp = std::chrono::high_resolution_clock::now();
+        vulkan_draw_frame(renderer);
+        auto new_timestamp = std::chrono::high_resolution_clock::now();
+        stream_frame_times_ms.push_back(std::chrono::duration<double, std::milli>(new_timestamp - old_timestamp).count());
+
+        bool streaming = !virtual_texture->reads.empty() || !renderer.virtual_texturing.uploading_pages.empty();
+        idle_frames = streaming ? 0 : idle_frames + 1;
+    }
+    auto stream_end = std::chrono::high_resolution_clock::now();
+    vulkan_handle_vk_result(vkDeviceWaitIdle(renderer.device));
+    std::sort(build_frame_times_ms.begin(), build_frame_times_ms.end());
+    std::sort(stream_frame_times_ms.begin(), stream_frame_times_ms.end());
+
+    uint32_t resident_count = 0;
+    for (const VirtualTextureTile& tile : virtual_texture->tiles)
+    {
+        resident_count += tile.state == VIRTUAL_TEXTURE_TILE_RESIDENT ? 1 : 0;
+    }
+
+    // What a regular RenderTexture would have needed, every level of the chain as one image
+    VkDeviceSize image_bytes = 0;
+    for (const VirtualTextureLevel& level : virtual_texture->levels)
+    {
+        image_bytes += static_cast<VkDeviceSize>(level.width) * level.height * texture_format_get_block_size(renderer.virtual_texturing.page_format) /
+            (texture_format_get_block_extent(renderer.virtual_texturing.page_format) * texture_format_get_block_extent(renderer.virtual_texturing.page_format));
+    }
+
+    double build_ms = std::chrono::duration<double, std::milli>(build_end - build_start).count();
+    double stream_ms = std::chrono::duration<double, std::milli>(stream_end - build_end).count();
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"benchmark\": \"virtual_texture\"," << std::endl;
+    std::cout << "  \"width\": " << virtual_texture->levels[0].width << "," << std::endl;
+    std::cout << "  \"height\": " << virtual_texture->levels[0].height << "," << std::endl;
+    std::cout << "  \"levels\": " << virtual_texture->levels.size() << "," << std::endl;
+    std::cout << "  \"tiles\": " << virtual_texture->tile_count << "," << std::endl;
+    std::cout << "  \"resident_tiles\": " << resident_count << "," << std::endl;
+    std::cout << "  \"atlas_pages\": " << renderer.virtual_texturing.pages.size() << "," << std::endl;
+    std::cout << "  \"format\": " << renderer.virtual_texturing.page_format << "," << std::endl;
+    std::cout << "  \"atlas_bytes\": " << renderer.virtual_texturing.atlas_memory.size << "," << std::endl;
+    std::cout << "  \"full_image_bytes\": " << image_bytes << "," << std::endl;
+    std::cout << "  \"build_ms\": " << build_ms << "," << std::endl;
+    std::cout << "  \"stream_ms\": " << stream_ms << "," << std::endl;
+    std::cout << "  \"build_p50_ms\": " << bench_percentile(build_frame_times_ms, 50.0) << "," << std::endl;
+    std::cout << "  \"build_p99_ms\": " << bench_percentile(build_frame_times_ms, 99.0) << "," << std::endl;
+    std::cout << "  \"stream_p50_ms\": " << bench_percentile(stream_frame_times_ms, 50.0) << "," << std::endl;
+    std::cout << "  \"stream_p99_ms\": " << bench_percentile(stream_frame_times_ms, 99.0) << "," << std::endl;
+    std::cout << "  \"stream_max_ms\": " << (stream_frame_times_ms.empty() ? 0.0 : stream_frame_times_ms.back()) << std::endl;
+    std::cout << "}" << std::endl;
+
+    vulkan_cleanup(renderer);
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+# Writes the SPIR-V binaries into one header of constexpr arrays, see vulkan_create_shader_module
+#
+# Usage: cmake -DSHADER_BINARIES=a.spv|b.spv -DOUTPUT=EmbeddedShaders.h -P EmbedShaders.cmake
+#
+# The list is separated by | since a ; would be split by the shell running the custom command.
+
+string(REPLACE "|" ";" SHADER_BINARIES "${SHADER_BINARIES}")
+
+set(SHADER_ARRAYS "")
+set(SHADER_TABLE "")
+foreach(SHADER_BINARY ${SHADER_BINARIES})
+    get_filename_component(SHADER_FILE ${SHADER_BINARY} NAME)
+    string(MAKE_C_IDENTIFIER ${SHADER_FILE} SHADER_IDENTIFIER)
+
+    # SPIR-V is a stream of little endian words
+    file(READ ${SHADER_BINARY} SHADER_HEX HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1u, " SHADER_WORDS "${SHADER_HEX}")
+
+    string(APPEND SHADER_ARRAYS "        constexpr uint32_t ${SHADER_IDENTIFIER}[] = { ${SHADER_WORDS}};\n")
+    string(APPEND SHADER_TABLE "            { \"${SHADER_FILE}\", ${SHADER_IDENTIFIER}, sizeof(${SHADER_IDENTIFIER}) },\n")
+endforeach()
+
+set(CONTENT "// Generated by cmake/EmbedShaders.cmake, do not edit\n")
+string(APPEND CONTENT "#pragma once\n\n#include <cstddef>\n#include <cstdint>\n\n")
+string(APPEND CONTENT "namespace ise\n{\n    namespace rendering\n    {\n")
+string(APPEND CONTENT "        struct EmbeddedShader\n        {\n            const char* name;\n            const uint32_t* code;\n            size_t size; // bytes\n        };\n\n")
+string(APPEND CONTENT "${SHADER_ARRAYS}\n")
+string(APPEND CONTENT "        constexpr EmbeddedShader EMBEDDED_SHADERS[] = {\n${SHADER_TABLE}        };\n")
+string(APPEND CONTENT "    }\n}\n")
+
+# Only touched when a shader changed, so the renderer is not rebuilt for nothing
+file(WRITE "${OUTPUT}.tmp" "${CONTENT}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
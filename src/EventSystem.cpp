@@ -38,6 +38,16 @@ void ise::EventSystem::wait_until_quit()
             this->m_event_data_injection.renderer->recreate_renderer();
         }
 
+        // Falls back to recreating the renderer when the change needs a new device, so it runs here as well
+        if (this->m_event_data_injection.trigger_toggle_v_sync)
+        {
+            this->m_event_data_injection.trigger_toggle_v_sync = false;
+
+            ise::rendering::VulkanRendererConfig config = this->m_event_data_injection.renderer->get_config();
+            config.v_sync = !config.v_sync;
+            this->m_event_data_injection.renderer->reconfigure(config);
+        }
+
         // This is needed to stop the main thread after SDL_Quit event
         if (this->m_event_data_injection.trigger_quit)
         {
@@ -82,12 +92,10 @@ int ise::EventSystem::sdl_event_watcher(void* data, SDL_Event* event)
         //renderer.m_data.force_refresh = true;
     }
 
-    /*if (event->type == SDL_KEYDOWN && event->key.keysym.scancode == SDL_SCANCODE_S)
+    if (event->type == SDL_KEYDOWN && event->key.keysym.scancode == SDL_SCANCODE_S)
     {
-        //SDL_SetWindowSize(renderer->m_data.window, 400, 400);
-        renderer.m_data.v_sync = false;
-        renderer.m_data.force_refresh = true;
-    }*/
+        injected_data->trigger_toggle_v_sync = true;
+    }
 
     return 0;
 }
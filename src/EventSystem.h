@@ -14,6 +14,7 @@ namespace ise
         bool processing_events = true;
         bool trigger_quit = false;
         bool trigger_recreate_renderer = false;
+        bool trigger_toggle_v_sync = false;
         bool trigger_window_event = false;
         ise::util::SafeQueue<SDL_Event*> window_event_queue;
         ise::rendering::VulkanRenderer* renderer;
@@ -0,0 +1,249 @@
+#include "FrustumCulling.h"
+
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__AVX__)
+    #define ISE_FRUSTUM_CULLING_AVX
+    #include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ISE_FRUSTUM_CULLING_SSE
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    using ise::rendering::CullingBounds;
+
+    // A box is outside when it lies entirely behind one plane, i.e. the plane distance of its center
+    // is below minus its extent projected on the plane normal
+    void frustum_cull_aabbs_scalar(const CullingBounds& bounds, const std::array<glm::vec4, 6>& planes, size_t first, std::vector<uint32_t>& visible)
+    {
+        for (size_t i = first; i < bounds.size(); i++)
+        {
+            bool inside = true;
+            for (const glm::vec4& plane : planes)
+            {
+                float distance = plane.x * bounds.center_x[i] + plane.y * bounds.center_y[i] + plane.z * bounds.center_z[i] + plane.w;
+                float radius = std::abs(plane.x) * bounds.extent_x[i] + std::abs(plane.y) * bounds.extent_y[i] + std::abs(plane.z) * bounds.extent_z[i];
+                if (distance + radius < 0.0f)
+                {
+                    inside = false;
+                    break;
+                }
+            }
+
+            if (inside)
+            {
+                visible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    void append_visible(uint32_t visible_mask, size_t first, std::vector<uint32_t>& visible)
+    {
+        while (visible_mask != 0)
+        {
+            visible.push_back(static_cast<uint32_t>(first + std::countr_zero(visible_mask)));
+            visible_mask &= visible_mask - 1;
+        }
+    }
+
+#ifdef ISE_FRUSTUM_CULLING_SSE
+    void frustum_cull_aabbs_sse(const CullingBounds& bounds, const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible)
+    {
+        __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+        __m128 abs_x[6], abs_y[6], abs_z[6];
+        for (size_t p = 0; p < 6; p++)
+        {
+            plane_x[p] = _mm_set1_ps(planes[p].x);
+            plane_y[p] = _mm_set1_ps(planes[p].y);
+            plane_z[p] = _mm_set1_ps(planes[p].z);
+            plane_w[p] = _mm_set1_ps(planes[p].w);
+            abs_x[p] = _mm_set1_ps(std::abs(planes[p].x));
+            abs_y[p] = _mm_set1_ps(std::abs(planes[p].y));
+            abs_z[p] = _mm_set1_ps(std::abs(planes[p].z));
+        }
+        const __m128 zero = _mm_setzero_ps();
+
+        size_t batch_end = bounds.size() & ~size_t(3);
+        for (size_t i = 0; i < batch_end; i += 4)
+        {
+            __m128 center_x = _mm_loadu_ps(&bounds.center_x[i]);
+            __m128 center_y = _mm_loadu_ps(&bounds.center_y[i]);
+            __m128 center_z = _mm_loadu_ps(&bounds.center_z[i]);
+            __m128 extent_x = _mm_loadu_ps(&bounds.extent_x[i]);
+            __m128 extent_y = _mm_loadu_ps(&bounds.extent_y[i]);
+            __m128 extent_z = _mm_loadu_ps(&bounds.extent_z[i]);
+
+            __m128 outside = zero;
+            for (size_t p = 0; p < 6; p++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], center_x), _mm_mul_ps(plane_y[p], center_y)), _mm_add_ps(_mm_mul_ps(plane_z[p], center_z), plane_w[p]));
+                __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs_x[p], extent_x), _mm_mul_ps(abs_y[p], extent_y)), _mm_mul_ps(abs_z[p], extent_z));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+            }
+
+            append_visible(~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF, i, visible);
+        }
+
+        frustum_cull_aabbs_scalar(bounds, planes, batch_end, visible);
+    }
+#endif
+
+#ifdef ISE_FRUSTUM_CULLING_AVX
+    void frustum_cull_aabbs_avx(const CullingBounds& bounds, const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible)
+    {
+        __m256 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+        __m256 abs_x[6], abs_y[6], abs_z[6];
+        for (size_t p = 0; p < 6; p++)
+        {
+            plane_x[p] = _mm256_set1_ps(planes[p].x);
+            plane_y[p] = _mm256_set1_ps(planes[p].y);
+            plane_z[p] = _mm256_set1_ps(planes[p].z);
+            plane_w[p] = _mm256_set1_ps(planes[p].w);
+            abs_x[p] = _mm256_set1_ps(std::abs(planes[p].x));
+            abs_y[p] = _mm256_set1_ps(std::abs(planes[p].y));
+            abs_z[p] = _mm256_set1_ps(std::abs(planes[p].z));
+        }
+        const __m256 zero = _mm256_setzero_ps();
+
+        size_t batch_end = bounds.size() & ~size_t(7);
+        for (size_t i = 0; i < batch_end; i += 8)
+        {
+            __m256 center_x = _mm256_loadu_ps(&bounds.center_x[i]);
+            __m256 center_y = _mm256_loadu_ps(&bounds.center_y[i]);
+            __m256 center_z = _mm256_loadu_ps(&bounds.center_z[i]);
+            __m256 extent_x = _mm256_loadu_ps(&bounds.extent_x[i]);
+            __m256 extent_y = _mm256_loadu_ps(&bounds.extent_y[i]);
+            __m256 extent_z = _mm256_loadu_ps(&bounds.extent_z[i]);
+
+            __m256 outside = zero;
+            for (size_t p = 0; p < 6; p++)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_x[p], center_x), _mm256_mul_ps(plane_y[p], center_y)), _mm256_add_ps(_mm256_mul_ps(plane_z[p], center_z), plane_w[p]));
+                __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(abs_x[p], extent_x), _mm256_mul_ps(abs_y[p], extent_y)), _mm256_mul_ps(abs_z[p], extent_z));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+            }
+
+            append_visible(~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFF, i, visible);
+        }
+
+        frustum_cull_aabbs_scalar(bounds, planes, batch_end, visible);
+    }
+#endif
+}
+
+void ise::rendering::CullingBounds::clear()
+{
+    center_x.clear();
+    center_y.clear();
+    center_z.clear();
+    extent_x.clear();
+    extent_y.clear();
+    extent_z.clear();
+}
+
+void ise::rendering::CullingBounds::reserve(size_t count)
+{
+    center_x.reserve(count);
+    center_y.reserve(count);
+    center_z.reserve(count);
+    extent_x.reserve(count);
+    extent_y.reserve(count);
+    extent_z.reserve(count);
+}
+
+void ise::rendering::CullingBounds::push_back(const glm::vec3& bounds_min, const glm::vec3& bounds_max)
+{
+    glm::vec3 center = (bounds_min + bounds_max) * 0.5f;
+    glm::vec3 extent = (bounds_max - bounds_min) * 0.5f;
+
+    center_x.push_back(center.x);
+    center_y.push_back(center.y);
+    center_z.push_back(center.z);
+    extent_x.push_back(extent.x);
+    extent_y.push_back(extent.y);
+    extent_z.push_back(extent.z);
+}
+
+bool ise::rendering::frustum_culling_is_available(FrustumCullingImplementation implementation)
+{
+    switch (implementation)
+    {
+        case FRUSTUM_CULLING_SCALAR:
+            return true;
+        case FRUSTUM_CULLING_SSE:
+#ifdef ISE_FRUSTUM_CULLING_SSE
+            return true;
+#else
+            return false;
+#endif
+        case FRUSTUM_CULLING_AVX:
+#ifdef ISE_FRUSTUM_CULLING_AVX
+            return true;
+#else
+            return false;
+#endif
+    }
+
+    return false;
+}
+
+ise::rendering::FrustumCullingImplementation ise::rendering::frustum_culling_best_implementation()
+{
+    if (frustum_culling_is_available(FRUSTUM_CULLING_AVX))
+    {
+        return FRUSTUM_CULLING_AVX;
+    }
+    if (frustum_culling_is_available(FRUSTUM_CULLING_SSE))
+    {
+        return FRUSTUM_CULLING_SSE;
+    }
+    return FRUSTUM_CULLING_SCALAR;
+}
+
+const char* ise::rendering::frustum_culling_implementation_name(FrustumCullingImplementation implementation)
+{
+    switch (implementation)
+    {
+        case FRUSTUM_CULLING_SCALAR:
+            return "scalar";
+        case FRUSTUM_CULLING_SSE:
+            return "sse";
+        case FRUSTUM_CULLING_AVX:
+            return "avx";
+    }
+
+    return "unknown";
+}
+
+void ise::rendering::frustum_cull_aabbs(const CullingBounds& bounds, const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible)
+{
+    frustum_cull_aabbs(frustum_culling_best_implementation(), bounds, planes, visible);
+}
+
+void ise::rendering::frustum_cull_aabbs(FrustumCullingImplementation implementation, const CullingBounds& bounds, const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible)
+{
+    switch (implementation)
+    {
+        case FRUSTUM_CULLING_SCALAR:
+            frustum_cull_aabbs_scalar(bounds, planes, 0, visible);
+            return;
+#ifdef ISE_FRUSTUM_CULLING_SSE
+        case FRUSTUM_CULLING_SSE:
+            frustum_cull_aabbs_sse(bounds, planes, visible);
+            return;
+#endif
+#ifdef ISE_FRUSTUM_CULLING_AVX
+        case FRUSTUM_CULLING_AVX:
+            frustum_cull_aabbs_avx(bounds, planes, visible);
+            return;
+#endif
+        default:
+            throw std::runtime_error("frustum culling implementation not compiled in!");
+    }
+}
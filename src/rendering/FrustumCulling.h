@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace ise
+{
+    namespace rendering
+    {
+        // Axis aligned boxes stored as center and half extent, one array per component,
+        // so a batch of 4 or 8 boxes is a single SIMD load per component
+        struct CullingBounds
+        {
+            std::vector<float> center_x;
+            std::vector<float> center_y;
+            std::vector<float> center_z;
+            std::vector<float> extent_x;
+            std::vector<float> extent_y;
+            std::vector<float> extent_z;
+
+            size_t size() const { return center_x.size(); }
+            void clear();
+            void reserve(size_t count);
+            void push_back(const glm::vec3& bounds_min, const glm::vec3& bounds_max);
+        };
+
+        typedef enum FrustumCullingImplementation
+        {
+            FRUSTUM_CULLING_SCALAR = 0,
+            FRUSTUM_CULLING_SSE = 1,
+            FRUSTUM_CULLING_AVX = 2
+        } FrustumCullingImplementation;
+
+        // SSE is used whenever the target has SSE2, AVX only when the library is built with ISE_ENABLE_AVX
+        bool frustum_culling_is_available(FrustumCullingImplementation implementation);
+        FrustumCullingImplementation frustum_culling_best_implementation();
+        const char* frustum_culling_implementation_name(FrustumCullingImplementation implementation);
+
+        // Appends the index of every box touching the frustum to visible, in ascending order.
+        // Planes point inwards, see vulkan_extract_frustum_planes.
+        void frustum_cull_aabbs(const CullingBounds& bounds, const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible);
+        void frustum_cull_aabbs(FrustumCullingImplementation implementation, const CullingBounds& bounds, const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible);
+    }
+}
@@ -0,0 +1,111 @@
+#include "MeshCache.h"
+
+#include <cstring>
+
+#include "../util/FileReader.h"
+
+namespace
+{
+    void mesh_cache_get_optimizer_options(const ise::rendering::MeshOptimizerOptions* optimizer_options, uint32_t& cache_size, float& overdraw_threshold)
+    {
+        cache_size = optimizer_options != nullptr ? optimizer_options->cache_size : 0;
+        overdraw_threshold = optimizer_options != nullptr ? optimizer_options->overdraw_threshold : 0.0f;
+    }
+}
+
+std::string ise::rendering::mesh_cache_get_path(const std::string& source_path)
+{
+    return source_path + MESH_CACHE_EXTENSION;
+}
+
+bool ise::rendering::mesh_cache_open(const std::string& source_path, const MeshOptimizerOptions* optimizer_options, MeshCacheView& view)
+{
+    uint32_t optimizer_cache_size;
+    float optimizer_overdraw_threshold;
+    mesh_cache_get_optimizer_options(optimizer_options, optimizer_cache_size, optimizer_overdraw_threshold);
+
+    uint64_t source_size;
+    int64_t source_mtime;
+    if (!ise::util::get_file_stat(source_path, source_size, source_mtime))
+    {
+        return false;
+    }
+
+    if (!view.file.open(mesh_cache_get_path(source_path)) || view.file.size() < sizeof(MeshCacheHeader))
+    {
+        view.file.close();
+        return false;
+    }
+
+    const MeshCacheHeader* header = static_cast<const MeshCacheHeader*>(view.file.data());
+    size_t expected_size = sizeof(MeshCacheHeader) + sizeof(Vertex) * size_t(header->vertex_count) + sizeof(uint32_t) * size_t(header->index_count);
+    if (memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 ||
+        header->version != MESH_CACHE_VERSION ||
+        header->vertex_stride != sizeof(Vertex) ||
+        header->index_stride != sizeof(uint32_t) ||
+        header->source_size != source_size ||
+        header->optimizer_cache_size != optimizer_cache_size ||
+        header->optimizer_overdraw_threshold != optimizer_overdraw_threshold ||
+        view.file.size() != expected_size)
+    {
+        view.file.close();
+        return false;
+    }
+
+    if (header->source_mtime != source_mtime)
+    {
+        std::vector<char> source_data = ise::util::readFile(source_path);
+        if (vulkan_hash_bytes(source_data.data(), source_data.size()) != header->source_hash)
+        {
+            view.file.close();
+            return false;
+        }
+    }
+
+    const char* data = static_cast<const char*>(view.file.data());
+    view.header = header;
+    view.vertices = reinterpret_cast<const Vertex*>(data + sizeof(MeshCacheHeader));
+    view.indices = reinterpret_cast<const uint32_t*>(data + sizeof(MeshCacheHeader) + sizeof(Vertex) * header->vertex_count);
+
+    // A damaged index would read past the vertex buffer on the device
+    for (uint32_t i = 0; i < header->index_count; i++)
+    {
+        if (view.indices[i] >= header->vertex_count)
+        {
+            view.file.close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ise::rendering::mesh_cache_write(const std::string& source_path, uint64_t source_hash, const MeshOptimizerOptions* optimizer_options, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const glm::vec3& bounds_min, const glm::vec3& bounds_max)
+{
+    MeshCacheHeader header{};
+    memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.vertex_stride = sizeof(Vertex);
+    header.index_stride = sizeof(uint32_t);
+    header.source_hash = source_hash;
+    mesh_cache_get_optimizer_options(optimizer_options, header.optimizer_cache_size, header.optimizer_overdraw_threshold);
+    header.vertex_count = static_cast<uint32_t>(vertices.size());
+    header.index_count = static_cast<uint32_t>(indices.size());
+    for (int i = 0; i < 3; i++)
+    {
+        header.bounds_min[i] = bounds_min[i];
+        header.bounds_max[i] = bounds_max[i];
+    }
+
+    if (!ise::util::get_file_stat(source_path, header.source_size, header.source_mtime))
+    {
+        return false;
+    }
+
+    return ise::util::write_file_replacing(mesh_cache_get_path(source_path), [&](std::ostream& file)
+    {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(sizeof(Vertex) * vertices.size()));
+        file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(sizeof(uint32_t) * indices.size()));
+    });
+}
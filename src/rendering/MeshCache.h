@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "VulkanRendererUgly.h"
+#include "MeshOptimizer.h"
+#include "../util/MappedFile.h"
+
+namespace ise
+{
+    namespace rendering
+    {
+        // Bump whenever the layout below or Vertex changes, older caches are then rebuilt
+        const uint32_t MESH_CACHE_VERSION = 4; // 3: mesh optimizer options, 4: overdraw clusters actually cut
+        const char MESH_CACHE_MAGIC[4] = { 'I', 'S', 'E', 'M' };
+        const char MESH_CACHE_EXTENSION[] = ".isemesh";
+
+        // Followed by vertex_count Vertex and index_count uint32_t, both already deduplicated and optimized.
+        // Indices are relative to the first vertex of the mesh.
+        struct MeshCacheHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t vertex_stride;
+            uint32_t index_stride;
+
+            // Identify the source the cache was built from
+            uint64_t source_size;
+            int64_t source_mtime;
+            uint64_t source_hash;
+
+            // Options the mesh was optimized with, a cache size of 0 means it was not optimized
+            uint32_t optimizer_cache_size;
+            float optimizer_overdraw_threshold;
+
+            uint32_t vertex_count;
+            uint32_t index_count;
+            float bounds_min[3];
+            float bounds_max[3];
+        };
+
+        // The vertex and index pointers point straight into the mapping
+        struct MeshCacheView
+        {
+            ise::util::MappedFile file;
+            const MeshCacheHeader* header = nullptr;
+            const Vertex* vertices = nullptr;
+            const uint32_t* indices = nullptr;
+        };
+
+        std::string mesh_cache_get_path(const std::string& source_path);
+
+        // Size and mtime matching the source is enough to trust the cache. When only the mtime changed
+        // the source is hashed, so a touched but unchanged asset does not need parsing again.
+        // optimizer_options is null for meshes that are not optimized, a cache built with other options is rejected.
+        bool mesh_cache_open(const std::string& source_path, const MeshOptimizerOptions* optimizer_options, MeshCacheView& view);
+
+        // Best effort, see write_file_replacing
+        bool mesh_cache_write(const std::string& source_path, uint64_t source_hash, const MeshOptimizerOptions* optimizer_options, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const glm::vec3& bounds_min, const glm::vec3& bounds_max);
+    }
+}
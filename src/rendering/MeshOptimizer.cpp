@@ -0,0 +1,340 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+    const uint32_t NO_VERTEX = ~0u;
+
+    // FIFO cache through timestamps: a vertex is cached while fewer than cache_size vertices were inserted after it.
+    // Advancing timestamp by cache_size + 1 flushes the whole cache.
+    uint32_t mesh_optimizer_update_cache(uint32_t vertex, uint32_t cache_size, std::vector<uint32_t>& timestamps, uint32_t& timestamp)
+    {
+        if (timestamp - timestamps[vertex] > cache_size)
+        {
+            timestamps[vertex] = timestamp++;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    uint32_t mesh_optimizer_update_cache(const uint32_t* triangle, uint32_t cache_size, std::vector<uint32_t>& timestamps, uint32_t& timestamp)
+    {
+        return mesh_optimizer_update_cache(triangle[0], cache_size, timestamps, timestamp) +
+            mesh_optimizer_update_cache(triangle[1], cache_size, timestamps, timestamp) +
+            mesh_optimizer_update_cache(triangle[2], cache_size, timestamps, timestamp);
+    }
+
+    glm::vec3 mesh_optimizer_position(const float* positions, size_t vertex_stride, uint32_t vertex)
+    {
+        const float* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex_stride * vertex);
+        return glm::vec3(position[0], position[1], position[2]);
+    }
+}
+
+ise::rendering::VertexCacheStatistics ise::rendering::mesh_analyze_vertex_cache(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size)
+{
+    VertexCacheStatistics statistics{};
+
+    std::vector<uint32_t> timestamps(vertex_count, 0);
+    std::vector<uint8_t> referenced(vertex_count, 0);
+    uint32_t timestamp = cache_size + 1;
+    size_t referenced_count = 0;
+    for (size_t i = 0; i < index_count; i++)
+    {
+        uint32_t vertex = indices[i];
+        statistics.vertices_transformed += mesh_optimizer_update_cache(vertex, cache_size, timestamps, timestamp);
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = 1;
+            referenced_count++;
+        }
+    }
+
+    size_t triangle_count = index_count / 3;
+    statistics.acmr = triangle_count > 0 ? float(statistics.vertices_transformed) / float(triangle_count) : 0.0f;
+    statistics.atvr = referenced_count > 0 ? float(statistics.vertices_transformed) / float(referenced_count) : 0.0f;
+    return statistics;
+}
+
+void ise::rendering::mesh_optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size)
+{
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+    {
+        return;
+    }
+
+    // Triangles around every vertex, live_triangles counts the ones not emitted yet
+    std::vector<uint32_t> live_triangles(vertex_count, 0);
+    for (uint32_t vertex : indices)
+    {
+        live_triangles[vertex]++;
+    }
+
+    std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+    for (size_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + live_triangles[vertex];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> adjacency_fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        adjacency[adjacency_fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<uint32_t> timestamps(vertex_count, 0);
+    std::vector<uint8_t> emitted(triangle_count, 0);
+    std::vector<uint32_t> dead_end;
+    dead_end.reserve(indices.size());
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    uint32_t timestamp = cache_size + 1;
+    uint32_t input_cursor = 0;
+    uint32_t fanning_vertex = 0;
+    while (fanning_vertex != NO_VERTEX)
+    {
+        // Emit every remaining triangle around the fanning vertex, their vertices are the next candidates
+        size_t candidates_begin = dead_end.size();
+        for (uint32_t k = adjacency_offsets[fanning_vertex]; k < adjacency_offsets[fanning_vertex + 1]; k++)
+        {
+            uint32_t triangle = adjacency[k];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = 1;
+
+            for (int corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                dead_end.push_back(vertex);
+                live_triangles[vertex]--;
+                mesh_optimizer_update_cache(vertex, cache_size, timestamps, timestamp);
+            }
+        }
+        size_t candidates_end = dead_end.size();
+
+        // Prefer the candidate that entered the cache earliest but will still be cached after its remaining triangles are emitted
+        fanning_vertex = NO_VERTEX;
+        int best_priority = -1;
+        for (size_t i = candidates_begin; i < candidates_end; i++)
+        {
+            uint32_t vertex = dead_end[i];
+            if (live_triangles[vertex] == 0)
+            {
+                continue;
+            }
+
+            int priority = 0;
+            uint32_t cache_position = timestamp - timestamps[vertex];
+            if (cache_position + 2 * live_triangles[vertex] <= cache_size)
+            {
+                priority = static_cast<int>(cache_position);
+            }
+
+            if (priority > best_priority)
+            {
+                best_priority = priority;
+                fanning_vertex = vertex;
+            }
+        }
+
+        // Dead end: fall back to recently used vertices, then to the input order
+        while (fanning_vertex == NO_VERTEX && !dead_end.empty())
+        {
+            uint32_t vertex = dead_end.back();
+            dead_end.pop_back();
+            if (live_triangles[vertex] > 0)
+            {
+                fanning_vertex = vertex;
+            }
+        }
+
+        while (fanning_vertex == NO_VERTEX && input_cursor < vertex_count)
+        {
+            if (live_triangles[input_cursor] > 0)
+            {
+                fanning_vertex = input_cursor;
+            }
+            input_cursor++;
+        }
+    }
+
+    indices.swap(output);
+}
+
+std::vector<uint32_t> ise::rendering::mesh_find_overdraw_clusters(const std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size, float threshold)
+{
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+    {
+        return {};
+    }
+
+    std::vector<uint32_t> timestamps(vertex_count, 0);
+    uint32_t timestamp = cache_size + 1;
+
+    // Hard boundaries: a triangle missing the cache with all three vertices starts a disjoint patch
+    std::vector<uint32_t> hard_clusters;
+    for (size_t triangle = 0; triangle < triangle_count; triangle++)
+    {
+        uint32_t misses = mesh_optimizer_update_cache(&indices[triangle * 3], cache_size, timestamps, timestamp);
+        if (triangle == 0 || misses == 3)
+        {
+            hard_clusters.push_back(static_cast<uint32_t>(triangle));
+        }
+    }
+
+    // Soft boundaries: a cluster is cut as soon as the part since the last cut is within threshold of the cluster's ACMR,
+    // so the cut costs at most that much vertex cache efficiency
+    std::vector<uint32_t> clusters;
+    for (size_t cluster = 0; cluster < hard_clusters.size(); cluster++)
+    {
+        size_t start = hard_clusters[cluster];
+        size_t end = cluster + 1 < hard_clusters.size() ? hard_clusters[cluster + 1] : triangle_count;
+
+        timestamp += cache_size + 1;
+        uint32_t cluster_misses = 0;
+        for (size_t triangle = start; triangle < end; triangle++)
+        {
+            cluster_misses += mesh_optimizer_update_cache(&indices[triangle * 3], cache_size, timestamps, timestamp);
+        }
+        float cluster_threshold = threshold * float(cluster_misses) / float(end - start);
+
+        clusters.push_back(static_cast<uint32_t>(start));
+
+        timestamp += cache_size + 1;
+        uint32_t running_misses = 0;
+        uint32_t running_triangles = 0;
+        for (size_t triangle = start; triangle < end; triangle++)
+        {
+            running_misses += mesh_optimizer_update_cache(&indices[triangle * 3], cache_size, timestamps, timestamp);
+            running_triangles++;
+
+            if (float(running_misses) <= cluster_threshold * float(running_triangles))
+            {
+                clusters.push_back(static_cast<uint32_t>(triangle + 1));
+                timestamp += cache_size + 1;
+                running_misses = 0;
+                running_triangles = 0;
+            }
+        }
+
+        // A cut after the last triangle leaves an empty cluster behind
+        if (clusters.back() == end)
+        {
+            clusters.pop_back();
+        }
+    }
+
+    return clusters;
+}
+
+void ise::rendering::mesh_optimize_overdraw(std::vector<uint32_t>& indices, const float* positions, size_t vertex_count, size_t vertex_stride, uint32_t cache_size, float threshold)
+{
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+    {
+        return;
+    }
+
+    std::vector<uint32_t> clusters = mesh_find_overdraw_clusters(indices, vertex_count, cache_size, threshold);
+
+    glm::vec3 mesh_centroid(0.0f);
+    for (uint32_t vertex : indices)
+    {
+        mesh_centroid += mesh_optimizer_position(positions, vertex_stride, vertex);
+    }
+    mesh_centroid /= float(indices.size());
+
+    // Area weighted centroid and average normal of every cluster
+    std::vector<float> sort_keys(clusters.size());
+    for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+    {
+        size_t start = clusters[cluster];
+        size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangle_count;
+
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+        for (size_t triangle = start; triangle < end; triangle++)
+        {
+            glm::vec3 p0 = mesh_optimizer_position(positions, vertex_stride, indices[triangle * 3 + 0]);
+            glm::vec3 p1 = mesh_optimizer_position(positions, vertex_stride, indices[triangle * 3 + 1]);
+            glm::vec3 p2 = mesh_optimizer_position(positions, vertex_stride, indices[triangle * 3 + 2]);
+
+            glm::vec3 triangle_normal = glm::cross(p1 - p0, p2 - p0);
+            float triangle_area = glm::length(triangle_normal);
+
+            centroid += (p0 + p1 + p2) * (triangle_area / 3.0f);
+            normal += triangle_normal;
+            area += triangle_area;
+        }
+
+        if (area > 0.0f)
+        {
+            centroid /= area;
+        }
+
+        float normal_length = glm::length(normal);
+        if (normal_length > 0.0f)
+        {
+            normal /= normal_length;
+        }
+
+        sort_keys[cluster] = glm::dot(centroid - mesh_centroid, normal);
+    }
+
+    // Stable, so equal keys keep the vertex cache order and the result stays deterministic
+    std::vector<uint32_t> cluster_order(clusters.size());
+    for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+    {
+        cluster_order[cluster] = static_cast<uint32_t>(cluster);
+    }
+    std::stable_sort(cluster_order.begin(), cluster_order.end(), [&](uint32_t a, uint32_t b) { return sort_keys[a] > sort_keys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t cluster : cluster_order)
+    {
+        size_t start = clusters[cluster];
+        size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangle_count;
+        output.insert(output.end(), indices.begin() + start * 3, indices.begin() + end * 3);
+    }
+
+    indices.swap(output);
+}
+
+size_t ise::rendering::mesh_optimize_vertex_fetch(std::vector<uint32_t>& indices, void* vertices, size_t vertex_count, size_t vertex_size)
+{
+    std::vector<uint32_t> remap(vertex_count, NO_VERTEX);
+    uint32_t next_vertex = 0;
+    for (uint32_t& vertex : indices)
+    {
+        if (remap[vertex] == NO_VERTEX)
+        {
+            remap[vertex] = next_vertex++;
+        }
+        vertex = remap[vertex];
+    }
+
+    std::vector<unsigned char> source(static_cast<unsigned char*>(vertices), static_cast<unsigned char*>(vertices) + vertex_count * vertex_size);
+    for (size_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        if (remap[vertex] != NO_VERTEX)
+        {
+            memcpy(static_cast<unsigned char*>(vertices) + remap[vertex] * vertex_size, source.data() + vertex * vertex_size, vertex_size);
+        }
+    }
+
+    return next_vertex;
+}
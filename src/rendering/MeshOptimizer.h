@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ise
+{
+    namespace rendering
+    {
+        // Roughly what post transform caches behave like on current GPUs
+        const uint32_t MESH_OPTIMIZER_CACHE_SIZE = 16;
+
+        struct VertexCacheStatistics
+        {
+            uint32_t vertices_transformed = 0;
+            // Average cache miss ratio, transformed vertices per triangle. About 0.5 is the limit for a regular grid, 3 means no reuse at all.
+            float acmr = 0.0f;
+            // Average transform to vertex ratio, transformed vertices per referenced vertex. 1 is optimal.
+            float atvr = 0.0f;
+        };
+
+        struct MeshOptimizerOptions
+        {
+            uint32_t cache_size = MESH_OPTIMIZER_CACHE_SIZE;
+            // How much worse than its cluster's ACMR a split cluster may be during overdraw ordering, below 1 skips that pass
+            float overdraw_threshold = 1.05f;
+        };
+
+        // Simulates a FIFO cache of cache_size entries over the triangle list
+        VertexCacheStatistics mesh_analyze_vertex_cache(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size = MESH_OPTIMIZER_CACHE_SIZE);
+
+        // Tipsify (Sander et al. 2007): reorders triangles so consecutive ones share cached vertices, linear in the index count
+        void mesh_optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size = MESH_OPTIMIZER_CACHE_SIZE);
+
+        // Triangle every cluster starts at. A cluster starts where the cache is cold anyway, a triangle missing it with all three
+        // vertices, or where the cache miss ratio since the last cut stays within threshold of the cluster's. A threshold of 0
+        // keeps only the cold starts.
+        std::vector<uint32_t> mesh_find_overdraw_clusters(const std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size = MESH_OPTIMIZER_CACHE_SIZE, float threshold = 1.05f);
+
+        // Expects vertex cache optimized indices. Draws the clusters of mesh_find_overdraw_clusters facing away from the mesh
+        // center first since they tend to occlude the rest. positions are the first 3 floats of every vertex_stride bytes.
+        void mesh_optimize_overdraw(std::vector<uint32_t>& indices, const float* positions, size_t vertex_count, size_t vertex_stride, uint32_t cache_size = MESH_OPTIMIZER_CACHE_SIZE, float threshold = 1.05f);
+
+        // Reorders vertices in the order the triangles first use them and drops unused ones, so vertex fetches walk memory
+        // forward. Returns the new vertex count, the first that many vertices are valid afterwards.
+        size_t mesh_optimize_vertex_fetch(std::vector<uint32_t>& indices, void* vertices, size_t vertex_count, size_t vertex_size);
+
+        // Vertex cache, overdraw and vertex fetch passes in that order. T must start with its position as 3 floats.
+        // Deterministic, the same input always gives the same output, so the result can be cached.
+        template<typename T>
+        void mesh_optimize(std::vector<T>& vertices, std::vector<uint32_t>& indices, const MeshOptimizerOptions& options = {})
+        {
+            mesh_optimize_vertex_cache(indices, vertices.size(), options.cache_size);
+            if (options.overdraw_threshold >= 1.0f)
+            {
+                mesh_optimize_overdraw(indices, reinterpret_cast<const float*>(vertices.data()), vertices.size(), sizeof(T), options.cache_size, options.overdraw_threshold);
+            }
+            vertices.resize(mesh_optimize_vertex_fetch(indices, vertices.data(), vertices.size(), sizeof(T)));
+        }
+    }
+}
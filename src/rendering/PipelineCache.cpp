@@ -0,0 +1,71 @@
+#include "PipelineCache.h"
+
+#include <cstring>
+
+#include "../util/FileReader.h"
+#include "../util/Hash.hpp"
+
+namespace
+{
+    void pipeline_cache_get_device(const VkPhysicalDeviceProperties& properties, ise::rendering::PipelineCacheHeader& header)
+    {
+        header.vendor_id = properties.vendorID;
+        header.device_id = properties.deviceID;
+        header.driver_version = properties.driverVersion;
+        memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    }
+}
+
+bool ise::rendering::pipeline_cache_open(const std::string& path, const VkPhysicalDeviceProperties& properties, PipelineCacheView& view)
+{
+    if (!view.file.open(path) || view.file.size() < sizeof(PipelineCacheHeader))
+    {
+        view.file.close();
+        return false;
+    }
+
+    PipelineCacheHeader device{};
+    pipeline_cache_get_device(properties, device);
+
+    const PipelineCacheHeader* header = static_cast<const PipelineCacheHeader*>(view.file.data());
+    if (memcmp(header->magic, PIPELINE_CACHE_MAGIC, sizeof(PIPELINE_CACHE_MAGIC)) != 0 ||
+        header->version != PIPELINE_CACHE_VERSION ||
+        header->vendor_id != device.vendor_id ||
+        header->device_id != device.device_id ||
+        header->driver_version != device.driver_version ||
+        memcmp(header->pipeline_cache_uuid, device.pipeline_cache_uuid, VK_UUID_SIZE) != 0 ||
+        view.file.size() != sizeof(PipelineCacheHeader) + header->data_size)
+    {
+        view.file.close();
+        return false;
+    }
+
+    // Drivers do not all survive a corrupted blob, so it is only handed over when it is exactly what was written
+    const char* data = static_cast<const char*>(view.file.data()) + sizeof(PipelineCacheHeader);
+    if (ise::util::hash_bytes(data, static_cast<size_t>(header->data_size)) != header->data_hash)
+    {
+        view.file.close();
+        return false;
+    }
+
+    view.header = header;
+    view.data = data;
+    view.data_size = static_cast<size_t>(header->data_size);
+    return true;
+}
+
+bool ise::rendering::pipeline_cache_write(const std::string& path, const VkPhysicalDeviceProperties& properties, const std::vector<char>& data)
+{
+    PipelineCacheHeader header{};
+    memcpy(header.magic, PIPELINE_CACHE_MAGIC, sizeof(PIPELINE_CACHE_MAGIC));
+    header.version = PIPELINE_CACHE_VERSION;
+    pipeline_cache_get_device(properties, header);
+    header.data_size = data.size();
+    header.data_hash = ise::util::hash_bytes(data.data(), data.size());
+
+    return ise::util::write_file_replacing(path, [&](std::ostream& file)
+    {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    });
+}
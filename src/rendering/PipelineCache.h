@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "../util/MappedFile.h"
+
+namespace ise
+{
+    namespace rendering
+    {
+        // Bump whenever the layout below changes, older caches are then dropped
+        const uint32_t PIPELINE_CACHE_VERSION = 1;
+        const char PIPELINE_CACHE_MAGIC[4] = { 'I', 'S', 'E', 'P' };
+
+        // Followed by data_size bytes of vkGetPipelineCacheData. The driver checks its own header as well, but a driver
+        // update keeps the pipeline cache UUID on some implementations, so the driver version is checked here too.
+        struct PipelineCacheHeader
+        {
+            char magic[4];
+            uint32_t version;
+
+            // Identify the device and driver the cache was written by
+            uint32_t vendor_id;
+            uint32_t device_id;
+            uint32_t driver_version;
+            uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+
+            uint64_t data_size;
+            uint64_t data_hash;
+        };
+
+        // The data pointer points straight into the mapping
+        struct PipelineCacheView
+        {
+            ise::util::MappedFile file;
+            const PipelineCacheHeader* header = nullptr;
+            const void* data = nullptr;
+            size_t data_size = 0;
+        };
+
+        // Rejects caches of another device or driver and truncated or corrupted files
+        bool pipeline_cache_open(const std::string& path, const VkPhysicalDeviceProperties& properties, PipelineCacheView& view);
+
+        // Best effort, see write_file_replacing
+        bool pipeline_cache_write(const std::string& path, const VkPhysicalDeviceProperties& properties, const std::vector<char>& data);
+    }
+}
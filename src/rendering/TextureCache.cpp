@@ -0,0 +1,140 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "../util/FileReader.h"
+#include "../util/MappedFile.h"
+
+namespace
+{
+    uint32_t texture_cache_get_mip_count(uint32_t width, uint32_t height)
+    {
+        uint32_t count = 1;
+        for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+        {
+            count++;
+        }
+        return count;
+    }
+}
+
+std::string ise::rendering::texture_cache_get_path(const std::string& source_path)
+{
+    return source_path + TEXTURE_CACHE_EXTENSION;
+}
+
+bool ise::rendering::texture_cache_read(const std::string& source_path, VkFormat format, CompressedTexture& texture)
+{
+    uint64_t source_size;
+    int64_t source_mtime;
+    if (!ise::util::get_file_stat(source_path, source_size, source_mtime))
+    {
+        return false;
+    }
+
+    ise::util::MappedFile file;
+    if (!file.open(texture_cache_get_path(source_path)) || file.size() < sizeof(TextureCacheHeader))
+    {
+        return false;
+    }
+
+    const TextureCacheHeader* header = static_cast<const TextureCacheHeader*>(file.data());
+    size_t index_size = sizeof(TextureCacheHeader) + sizeof(TextureCacheLevel) * size_t(header->level_count);
+    if (memcmp(header->magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC)) != 0 ||
+        header->version != TEXTURE_CACHE_VERSION ||
+        header->format != static_cast<uint32_t>(format) ||
+        header->source_size != source_size ||
+        header->width == 0 ||
+        header->height == 0 ||
+        header->level_count == 0 ||
+        header->level_count > texture_cache_get_mip_count(header->width, header->height) ||
+        file.size() < index_size)
+    {
+        return false;
+    }
+
+    // Every level must hold exactly the blocks of its mip, the upload copies that many bytes whatever the index says
+    uint32_t block_size = texture_format_get_block_size(format);
+    uint32_t block_extent = texture_format_get_block_extent(format);
+    const char* data = static_cast<const char*>(file.data());
+    const TextureCacheLevel* levels = reinterpret_cast<const TextureCacheLevel*>(data + sizeof(TextureCacheHeader));
+    uint32_t level_width = header->width;
+    uint32_t level_height = header->height;
+    for (uint32_t i = 0; i < header->level_count; i++)
+    {
+        uint64_t level_size = uint64_t((level_width + block_extent - 1) / block_extent) * ((level_height + block_extent - 1) / block_extent) * block_size;
+        if (levels[i].size != level_size || levels[i].offset < index_size || levels[i].offset > file.size() || levels[i].size > file.size() - levels[i].offset)
+        {
+            return false;
+        }
+
+        level_width = std::max(level_width / 2, 1u);
+        level_height = std::max(level_height / 2, 1u);
+    }
+
+    if (header->source_mtime != source_mtime)
+    {
+        std::vector<char> source_data = ise::util::readFile(source_path);
+        if (vulkan_hash_bytes(source_data.data(), source_data.size()) != header->source_hash)
+        {
+            return false;
+        }
+    }
+
+    texture.format = format;
+    texture.width = header->width;
+    texture.height = header->height;
+    texture.levels.clear();
+    texture.data.clear();
+
+    level_width = header->width;
+    level_height = header->height;
+    for (uint32_t i = 0; i < header->level_count; i++)
+    {
+        CompressedTextureLevel level;
+        level.width = level_width;
+        level.height = level_height;
+        level.offset = texture.data.size();
+        level.size = static_cast<size_t>(levels[i].size);
+        texture.data.insert(texture.data.end(), data + levels[i].offset, data + levels[i].offset + levels[i].size);
+        texture.levels.push_back(level);
+
+        level_width = std::max(level_width / 2, 1u);
+        level_height = std::max(level_height / 2, 1u);
+    }
+
+    return true;
+}
+
+bool ise::rendering::texture_cache_write(const std::string& source_path, uint64_t source_hash, const CompressedTexture& texture)
+{
+    TextureCacheHeader header{};
+    memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC));
+    header.version = TEXTURE_CACHE_VERSION;
+    header.format = static_cast<uint32_t>(texture.format);
+    header.width = texture.width;
+    header.height = texture.height;
+    header.level_count = static_cast<uint32_t>(texture.levels.size());
+    header.source_hash = source_hash;
+
+    if (!ise::util::get_file_stat(source_path, header.source_size, header.source_mtime))
+    {
+        return false;
+    }
+
+    std::vector<TextureCacheLevel> levels;
+    uint64_t offset = sizeof(TextureCacheHeader) + sizeof(TextureCacheLevel) * texture.levels.size();
+    for (const CompressedTextureLevel& level : texture.levels)
+    {
+        levels.push_back({ offset + level.offset, level.size });
+    }
+
+    return ise::util::write_file_replacing(texture_cache_get_path(source_path), [&](std::ostream& file)
+    {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(levels.data()), static_cast<std::streamsize>(sizeof(TextureCacheLevel) * levels.size()));
+        file.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+    });
+}
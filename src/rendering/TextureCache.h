@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "VulkanRendererUgly.h"
+#include "TextureCompression.h"
+
+namespace ise
+{
+    namespace rendering
+    {
+        // Bump whenever the layout below or the encoders change, older caches are then rebuilt
+        const uint32_t TEXTURE_CACHE_VERSION = 1;
+        const char TEXTURE_CACHE_MAGIC[4] = { 'I', 'S', 'E', 'T' };
+        const char TEXTURE_CACHE_EXTENSION[] = ".isetex";
+
+        // Laid out like KTX2: the header, a level index of level_count TextureCacheLevel, then the levels largest first,
+        // each one tightly packed rows of blocks ready for vkCmdCopyBufferToImage
+        struct TextureCacheHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t format; // VkFormat
+            uint32_t width;
+            uint32_t height;
+            uint32_t level_count;
+
+            // Identify the source the cache was built from
+            uint64_t source_size;
+            int64_t source_mtime;
+            uint64_t source_hash;
+        };
+
+        struct TextureCacheLevel
+        {
+            uint64_t offset; // from the start of the file
+            uint64_t size;
+        };
+
+        std::string texture_cache_get_path(const std::string& source_path);
+
+        // Same rules as mesh_cache_open, a cache encoded to another format is rejected. The levels are copied out of
+        // the mapping, so nothing stays mapped until the upload.
+        bool texture_cache_read(const std::string& source_path, VkFormat format, CompressedTexture& texture);
+
+        // Best effort, see write_file_replacing
+        bool texture_cache_write(const std::string& source_path, uint64_t source_hash, const CompressedTexture& texture);
+    }
+}
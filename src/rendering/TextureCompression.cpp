@@ -0,0 +1,522 @@
+#include "TextureCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ISE_TEXTURE_COMPRESSION_SSE
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // One array per channel, so 4 texels are a single SIMD load per channel
+    struct BlockTexels
+    {
+        alignas(16) float channels[4][16];
+    };
+
+    void texture_load_block(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y, BlockTexels& texels)
+    {
+        for (uint32_t y = 0; y < 4; y++)
+        {
+            uint32_t source_y = std::min(block_y * 4 + y, height - 1);
+            for (uint32_t x = 0; x < 4; x++)
+            {
+                uint32_t source_x = std::min(block_x * 4 + x, width - 1);
+                const uint8_t* texel = rgba + (size_t(source_y) * width + source_x) * 4;
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    texels.channels[c][y * 4 + x] = static_cast<float>(texel[c]);
+                }
+            }
+        }
+    }
+
+    // Endpoints spanning the texels along the principal axis of their covariance, found by power iteration.
+    // Only the first channel_count channels are considered, the others are left at 0.
+    void texture_fit_endpoints(const BlockTexels& texels, uint32_t channel_count, float endpoint0[4], float endpoint1[4])
+    {
+        float mean[4] = {};
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                mean[c] += texels.channels[c][i];
+            }
+            mean[c] /= 16.0f;
+        }
+
+        float covariance[4][4] = {};
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t a = 0; a < channel_count; a++)
+            {
+                for (uint32_t b = a; b < channel_count; b++)
+                {
+                    covariance[a][b] += (texels.channels[a][i] - mean[a]) * (texels.channels[b][i] - mean[b]);
+                }
+            }
+        }
+        for (uint32_t a = 0; a < channel_count; a++)
+        {
+            for (uint32_t b = 0; b < a; b++)
+            {
+                covariance[a][b] = covariance[b][a];
+            }
+        }
+
+        // Seeded from the covariance row of the channel that varies most. The bounding box diagonal is not a safe
+        // seed, anti-correlated channels (a red/green checker) make it orthogonal to the principal axis.
+        uint32_t seed_channel = 0;
+        for (uint32_t c = 1; c < channel_count; c++)
+        {
+            if (covariance[c][c] > covariance[seed_channel][seed_channel])
+            {
+                seed_channel = c;
+            }
+        }
+
+        float axis[4] = {};
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+            axis[c] = covariance[seed_channel][c];
+        }
+
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {};
+            float length = 0.0f;
+            for (uint32_t a = 0; a < channel_count; a++)
+            {
+                for (uint32_t b = 0; b < channel_count; b++)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length += next[a] * next[a];
+            }
+
+            // A flat block has no axis, both endpoints are the mean
+            if (length < 1e-8f)
+            {
+                break;
+            }
+
+            length = 1.0f / std::sqrt(length);
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                axis[c] = next[c] * length;
+            }
+        }
+
+        float axis_length = 0.0f;
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+            axis_length += axis[c] * axis[c];
+        }
+        if (axis_length > 0.0f)
+        {
+            axis_length = 1.0f / std::sqrt(axis_length);
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                axis[c] *= axis_length;
+            }
+        }
+
+        float t_min = 0.0f;
+        float t_max = 0.0f;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                t += (texels.channels[c][i] - mean[c]) * axis[c];
+            }
+            t_min = std::min(t_min, t);
+            t_max = std::max(t_max, t);
+        }
+
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            endpoint0[c] = c < channel_count ? std::clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f) : 0.0f;
+            endpoint1[c] = c < channel_count ? std::clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f) : 0.0f;
+        }
+    }
+
+    // Position of every texel projected on endpoint0 -> endpoint1, rounded to one of step_count evenly spaced steps
+    void texture_project_texels(const BlockTexels& texels, uint32_t channel_count, const float endpoint0[4], const float endpoint1[4], uint32_t step_count, uint8_t steps[16])
+    {
+        float direction[4] = {};
+        float length = 0.0f;
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+            direction[c] = endpoint1[c] - endpoint0[c];
+            length += direction[c] * direction[c];
+        }
+
+        if (length < 1e-6f)
+        {
+            memset(steps, 0, 16);
+            return;
+        }
+
+        float scale = static_cast<float>(step_count - 1) / length;
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+            direction[c] *= scale;
+        }
+
+#ifdef ISE_TEXTURE_COMPRESSION_SSE
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 last_step = _mm_set1_ps(static_cast<float>(step_count - 1));
+        for (uint32_t i = 0; i < 16; i += 4)
+        {
+            __m128 t = half;
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                __m128 offset = _mm_sub_ps(_mm_load_ps(&texels.channels[c][i]), _mm_set1_ps(endpoint0[c]));
+                t = _mm_add_ps(t, _mm_mul_ps(offset, _mm_set1_ps(direction[c])));
+            }
+            // Truncating after adding a half rounds, the clamp keeps texels beyond the endpoints on the last step
+            __m128i rounded = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(t, zero), last_step));
+
+            alignas(16) int32_t values[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(values), rounded);
+            for (uint32_t j = 0; j < 4; j++)
+            {
+                steps[i + j] = static_cast<uint8_t>(values[j]);
+            }
+        }
+#else
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            float t = 0.5f;
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                t += (texels.channels[c][i] - endpoint0[c]) * direction[c];
+            }
+            steps[i] = static_cast<uint8_t>(std::clamp(t, 0.0f, static_cast<float>(step_count - 1)));
+        }
+#endif
+    }
+
+    uint16_t texture_pack_565(const float color[4])
+    {
+        uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+        uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+        uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void texture_unpack_565(uint16_t packed, float color[4])
+    {
+        uint32_t r = (packed >> 11) & 31;
+        uint32_t g = (packed >> 5) & 63;
+        uint32_t b = packed & 31;
+        color[0] = static_cast<float>((r << 3) | (r >> 2));
+        color[1] = static_cast<float>((g << 2) | (g >> 4));
+        color[2] = static_cast<float>((b << 3) | (b >> 2));
+        color[3] = 0.0f;
+    }
+
+    // BC7 mode 6 stores 7 bit endpoints plus a p-bit shared by all channels of the endpoint, picks the better p-bit
+    void texture_quantize_bc7_endpoint(const float endpoint[4], uint32_t quantized[4], uint32_t& p_bit)
+    {
+        float best_error = std::numeric_limits<float>::max();
+        for (uint32_t p = 0; p < 2; p++)
+        {
+            uint32_t candidate[4];
+            float error = 0.0f;
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                candidate[c] = static_cast<uint32_t>(std::clamp<long>(std::lround((endpoint[c] - static_cast<float>(p)) / 2.0f), 0, 127));
+                float difference = static_cast<float>((candidate[c] << 1) | p) - endpoint[c];
+                error += difference * difference;
+            }
+
+            if (error < best_error)
+            {
+                best_error = error;
+                p_bit = p;
+                std::copy(candidate, candidate + 4, quantized);
+            }
+        }
+    }
+
+    void texture_write_bits(uint64_t words[2], uint32_t& position, uint64_t value, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++, position++)
+        {
+            words[position / 64] |= ((value >> i) & 1) << (position % 64);
+        }
+    }
+
+    // sRGB to linear light, 8 bit in
+    const std::array<float, 256>& texture_get_srgb_to_linear()
+    {
+        static const std::array<float, 256> table = []()
+        {
+            std::array<float, 256> values;
+            for (int i = 0; i < 256; i++)
+            {
+                float srgb = static_cast<float>(i) / 255.0f;
+                values[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    // Linear light to sRGB, 12 bit in, which keeps every 8 bit output reachable
+    const std::array<uint8_t, 4096>& texture_get_linear_to_srgb()
+    {
+        static const std::array<uint8_t, 4096> table = []()
+        {
+            std::array<uint8_t, 4096> values;
+            for (int i = 0; i < 4096; i++)
+            {
+                float linear = static_cast<float>(i) / 4095.0f;
+                float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+                values[i] = static_cast<uint8_t>(std::lround(std::clamp(srgb, 0.0f, 1.0f) * 255.0f));
+            }
+            return values;
+        }();
+        return table;
+    }
+}
+
+VkFormat ise::rendering::texture_compression_get_format(TextureCompression compression)
+{
+    switch (compression)
+    {
+        case TEXTURE_COMPRESSION_BC1:
+            return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+        case TEXTURE_COMPRESSION_BC7:
+            return VK_FORMAT_BC7_SRGB_BLOCK;
+        case TEXTURE_COMPRESSION_NONE:
+            break;
+    }
+
+    return VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+uint32_t ise::rendering::texture_format_get_block_size(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            return 8;
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+            return 16;
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+            return 4;
+        default:
+            throw std::runtime_error("unsupported texture format!");
+    }
+}
+
+uint32_t ise::rendering::texture_format_get_block_extent(VkFormat format)
+{
+    return texture_format_get_block_size(format) == 4 ? 1 : 4;
+}
+
+void ise::rendering::texture_downsample_srgb(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& downsampled)
+{
+    const std::array<float, 256>& srgb_to_linear = texture_get_srgb_to_linear();
+    const std::array<uint8_t, 4096>& linear_to_srgb = texture_get_linear_to_srgb();
+
+    uint32_t downsampled_width = std::max(width / 2, 1u);
+    uint32_t downsampled_height = std::max(height / 2, 1u);
+    downsampled.resize(size_t(downsampled_width) * downsampled_height * 4);
+
+    for (uint32_t y = 0; y < downsampled_height; y++)
+    {
+        uint32_t y0 = std::min(y * 2, height - 1);
+        uint32_t y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < downsampled_width; x++)
+        {
+            uint32_t x0 = std::min(x * 2, width - 1);
+            uint32_t x1 = std::min(x * 2 + 1, width - 1);
+            const uint8_t* texels[4] = {
+                rgba + (size_t(y0) * width + x0) * 4,
+                rgba + (size_t(y0) * width + x1) * 4,
+                rgba + (size_t(y1) * width + x0) * 4,
+                rgba + (size_t(y1) * width + x1) * 4
+            };
+
+            uint8_t* destination = downsampled.data() + (size_t(y) * downsampled_width + x) * 4;
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                float linear = (srgb_to_linear[texels[0][c]] + srgb_to_linear[texels[1][c]] + srgb_to_linear[texels[2][c]] + srgb_to_linear[texels[3][c]]) * 0.25f;
+                destination[c] = linear_to_srgb[static_cast<size_t>(linear * 4095.0f + 0.5f)];
+            }
+            // Alpha is linear already
+            destination[3] = static_cast<uint8_t>((uint32_t(texels[0][3]) + texels[1][3] + texels[2][3] + texels[3][3] + 2) / 4);
+        }
+    }
+}
+
+void ise::rendering::texture_encode_bc1_block(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y, uint8_t* block)
+{
+    BlockTexels texels;
+    texture_load_block(rgba, width, height, block_x, block_y, texels);
+
+    float endpoint0[4];
+    float endpoint1[4];
+    texture_fit_endpoints(texels, 3, endpoint0, endpoint1);
+
+    // color0 > color1 selects the four color mode, the one without transparency
+    uint16_t color0 = texture_pack_565(endpoint1);
+    uint16_t color1 = texture_pack_565(endpoint0);
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1)
+    {
+        float palette0[4];
+        float palette1[4];
+        texture_unpack_565(color0, palette0);
+        texture_unpack_565(color1, palette1);
+
+        // Steps from color0 to color1 are the palette entries 0, 2, 3, 1
+        const uint32_t step_to_index[4] = { 0, 2, 3, 1 };
+        uint8_t steps[16];
+        texture_project_texels(texels, 3, palette0, palette1, 4, steps);
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            indices |= step_to_index[steps[i]] << (i * 2);
+        }
+    }
+
+    memcpy(block, &color0, 2);
+    memcpy(block + 2, &color1, 2);
+    memcpy(block + 4, &indices, 4);
+}
+
+void ise::rendering::texture_encode_bc7_block(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y, uint8_t* block)
+{
+    BlockTexels texels;
+    texture_load_block(rgba, width, height, block_x, block_y, texels);
+
+    float endpoints[2][4];
+    texture_fit_endpoints(texels, 4, endpoints[0], endpoints[1]);
+
+    uint32_t quantized[2][4];
+    uint32_t p_bits[2];
+    float expanded[2][4];
+    for (uint32_t e = 0; e < 2; e++)
+    {
+        texture_quantize_bc7_endpoint(endpoints[e], quantized[e], p_bits[e]);
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            expanded[e][c] = static_cast<float>((quantized[e][c] << 1) | p_bits[e]);
+        }
+    }
+
+    // The 4 bit weights are within half a step of i * 64 / 15, so evenly spaced steps pick the same index
+    uint8_t indices[16];
+    texture_project_texels(texels, 4, expanded[0], expanded[1], 16, indices);
+
+    // The first index is stored without its top bit, which must therefore be 0
+    if (indices[0] & 8)
+    {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(p_bits[0], p_bits[1]);
+        for (uint8_t& index : indices)
+        {
+            index = static_cast<uint8_t>(15 - index);
+        }
+    }
+
+    uint64_t words[2] = {};
+    uint32_t position = 0;
+    texture_write_bits(words, position, 1 << 6, 7); // mode 6
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        texture_write_bits(words, position, quantized[0][c], 7);
+        texture_write_bits(words, position, quantized[1][c], 7);
+    }
+    texture_write_bits(words, position, p_bits[0], 1);
+    texture_write_bits(words, position, p_bits[1], 1);
+    texture_write_bits(words, position, indices[0], 3);
+    for (uint32_t i = 1; i < 16; i++)
+    {
+        texture_write_bits(words, position, indices[i], 4);
+    }
+
+    // Blocks are little endian, as is every host this builds for
+    memcpy(block, words, 16);
+}
+
+void ise::rendering::texture_compress(const uint8_t* rgba, uint32_t width, uint32_t height, VkFormat format, CompressedTexture& texture)
+{
+    uint32_t block_size = texture_format_get_block_size(format);
+    if (texture_format_get_block_extent(format) != 4)
+    {
+        throw std::runtime_error("texture compression needs a block compressed format!");
+    }
+
+    texture.format = format;
+    texture.width = width;
+    texture.height = height;
+    texture.levels.clear();
+    texture.data.clear();
+
+    const uint8_t* level_texels = rgba;
+    std::vector<uint8_t> current_level;
+    std::vector<uint8_t> next_level;
+    uint32_t level_width = width;
+    uint32_t level_height = height;
+    while (true)
+    {
+        uint32_t blocks_x = (level_width + 3) / 4;
+        uint32_t blocks_y = (level_height + 3) / 4;
+
+        CompressedTextureLevel level;
+        level.width = level_width;
+        level.height = level_height;
+        level.offset = texture.data.size();
+        level.size = size_t(blocks_x) * blocks_y * block_size;
+        texture.data.resize(level.offset + level.size);
+        texture.levels.push_back(level);
+
+        uint8_t* blocks = texture.data.data() + level.offset;
+        for (uint32_t block_y = 0; block_y < blocks_y; block_y++)
+        {
+            for (uint32_t block_x = 0; block_x < blocks_x; block_x++)
+            {
+                uint8_t* block = blocks + (size_t(block_y) * blocks_x + block_x) * block_size;
+                if (block_size == 8)
+                {
+                    texture_encode_bc1_block(level_texels, level_width, level_height, block_x, block_y, block);
+                }
+                else
+                {
+                    texture_encode_bc7_block(level_texels, level_width, level_height, block_x, block_y, block);
+                }
+            }
+        }
+
+        if (level_width == 1 && level_height == 1)
+        {
+            break;
+        }
+
+        texture_downsample_srgb(level_texels, level_width, level_height, next_level);
+        std::swap(current_level, next_level);
+        level_texels = current_level.data();
+        level_width = std::max(level_width / 2, 1u);
+        level_height = std::max(level_height / 2, 1u);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace ise
+{
+    namespace rendering
+    {
+        typedef enum TextureCompression
+        {
+            TEXTURE_COMPRESSION_NONE = 0, // RGBA8, mipmaps blitted on the GPU
+            TEXTURE_COMPRESSION_BC1 = 1, // 4 bits per texel, alpha is dropped
+            TEXTURE_COMPRESSION_BC7 = 2 // 8 bits per texel with alpha, encoded as mode 6 blocks only
+        } TextureCompression;
+
+        struct CompressedTextureLevel
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            size_t offset = 0; // into CompressedTexture::data
+            size_t size = 0;
+        };
+
+        // A complete mip chain down to 1x1, largest level first, every level tightly packed rows of blocks
+        struct CompressedTexture
+        {
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<CompressedTextureLevel> levels;
+            std::vector<uint8_t> data;
+        };
+
+        VkFormat texture_compression_get_format(TextureCompression compression);
+
+        // Bytes per block of block_extent x block_extent texels, uncompressed formats have one texel blocks
+        uint32_t texture_format_get_block_size(VkFormat format);
+        uint32_t texture_format_get_block_extent(VkFormat format);
+
+        // Halves with a box filter in linear light, odd edges repeat their last texel. rgba is sRGB encoded.
+        void texture_downsample_srgb(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& downsampled);
+
+        // Blocks are 4x4 texels of RGBA8 in row order, blocks on the right and bottom edges repeat the last texel.
+        // Endpoints are fit along the principal axis of the block, see TextureCompression.cpp.
+        void texture_encode_bc1_block(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y, uint8_t* block);
+        void texture_encode_bc7_block(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y, uint8_t* block);
+
+        // Builds the whole mip chain of an sRGB RGBA8 image and encodes every level to format, one of the formats
+        // texture_compression_get_format returns
+        void texture_compress(const uint8_t* rgba, uint32_t width, uint32_t height, VkFormat format, CompressedTexture& texture);
+    }
+}
@@ -0,0 +1,299 @@
+#include "VirtualTextureFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "VulkanRendererUgly.h"
+#include "../util/FileReader.h"
+#include "../util/ThreadPool.hpp"
+
+namespace
+{
+    // Copies the page of tile (tile_x, tile_y) out of a level, texels outside the level repeat its edge
+    void virtual_texture_extract_page(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t tile_x, uint32_t tile_y, uint8_t* page)
+    {
+        using namespace ise::rendering;
+
+        int64_t origin_x = int64_t(tile_x) * VIRTUAL_TEXTURE_TILE_SIZE - VIRTUAL_TEXTURE_PAGE_BORDER;
+        int64_t origin_y = int64_t(tile_y) * VIRTUAL_TEXTURE_TILE_SIZE - VIRTUAL_TEXTURE_PAGE_BORDER;
+        for (uint32_t y = 0; y < VIRTUAL_TEXTURE_PAGE_SIZE; y++)
+        {
+            int64_t source_y = std::clamp<int64_t>(origin_y + y, 0, int64_t(height) - 1);
+            const uint8_t* source_row = rgba + size_t(source_y) * width * 4;
+            uint8_t* row = page + size_t(y) * VIRTUAL_TEXTURE_PAGE_SIZE * 4;
+            for (uint32_t x = 0; x < VIRTUAL_TEXTURE_PAGE_SIZE; x++)
+            {
+                int64_t source_x = std::clamp<int64_t>(origin_x + x, 0, int64_t(width) - 1);
+                memcpy(row + size_t(x) * 4, source_row + size_t(source_x) * 4, 4);
+            }
+        }
+    }
+
+    void virtual_texture_encode_page(const uint8_t* page_texels, VkFormat format, uint8_t* page)
+    {
+        using namespace ise::rendering;
+
+        uint32_t block_size = texture_format_get_block_size(format);
+        if (texture_format_get_block_extent(format) != 4)
+        {
+            memcpy(page, page_texels, size_t(VIRTUAL_TEXTURE_PAGE_SIZE) * VIRTUAL_TEXTURE_PAGE_SIZE * 4);
+            return;
+        }
+
+        const uint32_t blocks = VIRTUAL_TEXTURE_PAGE_SIZE / 4;
+        for (uint32_t block_y = 0; block_y < blocks; block_y++)
+        {
+            for (uint32_t block_x = 0; block_x < blocks; block_x++)
+            {
+                uint8_t* block = page + (size_t(block_y) * blocks + block_x) * block_size;
+                if (block_size == 8)
+                {
+                    texture_encode_bc1_block(page_texels, VIRTUAL_TEXTURE_PAGE_SIZE, VIRTUAL_TEXTURE_PAGE_SIZE, block_x, block_y, block);
+                }
+                else
+                {
+                    texture_encode_bc7_block(page_texels, VIRTUAL_TEXTURE_PAGE_SIZE, VIRTUAL_TEXTURE_PAGE_SIZE, block_x, block_y, block);
+                }
+            }
+        }
+    }
+}
+
+uint32_t ise::rendering::virtual_texture_get_levels(uint32_t width, uint32_t height, std::vector<VirtualTextureLevel>& levels)
+{
+    levels.clear();
+    if (width > VIRTUAL_TEXTURE_MAX_SOURCE_SIZE || height > VIRTUAL_TEXTURE_MAX_SOURCE_SIZE)
+    {
+        return 0;
+    }
+
+    uint32_t tile_count = 0;
+    uint32_t level_width = std::max(width, 1u);
+    uint32_t level_height = std::max(height, 1u);
+    while (true)
+    {
+        if (levels.size() == VIRTUAL_TEXTURE_MAX_LEVELS)
+        {
+            levels.clear();
+            return 0;
+        }
+
+        VirtualTextureLevel level;
+        level.width = level_width;
+        level.height = level_height;
+        level.tiles_x = (level_width + VIRTUAL_TEXTURE_TILE_SIZE - 1) / VIRTUAL_TEXTURE_TILE_SIZE;
+        level.tiles_y = (level_height + VIRTUAL_TEXTURE_TILE_SIZE - 1) / VIRTUAL_TEXTURE_TILE_SIZE;
+        level.first_tile = tile_count;
+        levels.push_back(level);
+        tile_count += level.tiles_x * level.tiles_y;
+
+        if (level.tiles_x == 1 && level.tiles_y == 1)
+        {
+            return tile_count;
+        }
+
+        level_width = std::max(level_width / 2, 1u);
+        level_height = std::max(level_height / 2, 1u);
+    }
+}
+
+size_t ise::rendering::virtual_texture_get_page_size(VkFormat format)
+{
+    size_t blocks = VIRTUAL_TEXTURE_PAGE_SIZE / texture_format_get_block_extent(format);
+    return blocks * blocks * texture_format_get_block_size(format);
+}
+
+std::string ise::rendering::virtual_texture_file_get_path(const std::string& source_path)
+{
+    return source_path + VIRTUAL_TEXTURE_FILE_EXTENSION;
+}
+
+bool ise::rendering::virtual_texture_file_open(const std::string& source_path, VkFormat format, VirtualTextureFile& file)
+{
+    uint64_t source_size;
+    int64_t source_mtime;
+    if (!ise::util::get_file_stat(source_path, source_size, source_mtime))
+    {
+        return false;
+    }
+
+    ise::util::MappedFile& mapping = file.mapping;
+    if (!mapping.open(virtual_texture_file_get_path(source_path)) || mapping.size() < sizeof(VirtualTextureFileHeader))
+    {
+        return false;
+    }
+
+    const VirtualTextureFileHeader* header = static_cast<const VirtualTextureFileHeader*>(mapping.data());
+    size_t index_size = sizeof(VirtualTextureFileHeader) + sizeof(VirtualTextureFileTile) * size_t(header->tile_count);
+    if (memcmp(header->magic, VIRTUAL_TEXTURE_FILE_MAGIC, sizeof(VIRTUAL_TEXTURE_FILE_MAGIC)) != 0 ||
+        header->version != VIRTUAL_TEXTURE_FILE_VERSION ||
+        header->format != static_cast<uint32_t>(format) ||
+        header->source_size != source_size ||
+        mapping.size() < index_size)
+    {
+        mapping.close();
+        return false;
+    }
+
+    std::vector<VirtualTextureLevel> levels;
+    uint32_t tile_count = virtual_texture_get_levels(header->width, header->height, levels);
+    if (tile_count == 0 || tile_count != header->tile_count || levels.size() != header->level_count)
+    {
+        mapping.close();
+        return false;
+    }
+
+    const char* data = static_cast<const char*>(mapping.data());
+    const VirtualTextureFileTile* tiles = reinterpret_cast<const VirtualTextureFileTile*>(data + sizeof(VirtualTextureFileHeader));
+    size_t page_size = virtual_texture_get_page_size(format);
+    for (uint32_t i = 0; i < tile_count; i++)
+    {
+        if (tiles[i].offset < index_size || tiles[i].size != page_size || tiles[i].offset + tiles[i].size > mapping.size())
+        {
+            mapping.close();
+            return false;
+        }
+    }
+
+    if (header->source_mtime != source_mtime)
+    {
+        std::vector<char> source_data = ise::util::readFile(source_path);
+        if (vulkan_hash_bytes(source_data.data(), source_data.size()) != header->source_hash)
+        {
+            mapping.close();
+            return false;
+        }
+    }
+
+    file.format = format;
+    file.width = header->width;
+    file.height = header->height;
+    file.levels = std::move(levels);
+    file.tiles = tiles;
+    file.tile_count = tile_count;
+    return true;
+}
+
+bool ise::rendering::virtual_texture_file_build(const std::string& source_path, VkFormat format, uint32_t thread_count, std::string& error)
+{
+    VirtualTextureFileHeader header{};
+    if (!ise::util::get_file_stat(source_path, header.source_size, header.source_mtime))
+    {
+        error = std::format("failed to build virtual texture {0}: cannot read the size and modification time of the image", source_path);
+        return false;
+    }
+
+    std::vector<char> source_data = ise::util::readFile(source_path);
+
+    // Rejected from the header, before decoding the pixels
+    int width, height, channels;
+    if (!stbi_info_from_memory(reinterpret_cast<const stbi_uc*>(source_data.data()), static_cast<int>(source_data.size()), &width, &height, &channels))
+    {
+        const char* reason = stbi_failure_reason();
+        error = std::format("failed to load virtual texture image {0}: {1}", source_path, reason != nullptr ? reason : "unknown error");
+        return false;
+    }
+
+    std::vector<VirtualTextureLevel> levels;
+    header.tile_count = virtual_texture_get_levels(static_cast<uint32_t>(width), static_cast<uint32_t>(height), levels);
+    header.level_count = static_cast<uint32_t>(levels.size());
+    if (header.tile_count == 0)
+    {
+        error = std::format("failed to build virtual texture {0}: the image is {1}x{2}, larger than {3}x{3}", source_path, width, height, VIRTUAL_TEXTURE_MAX_SOURCE_SIZE);
+        return false;
+    }
+
+    stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(source_data.data()), static_cast<int>(source_data.size()), &width, &height, &channels, STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        const char* reason = stbi_failure_reason();
+        error = std::format("failed to load virtual texture image {0}: {1}", source_path, reason != nullptr ? reason : "unknown error");
+        return false;
+    }
+
+    memcpy(header.magic, VIRTUAL_TEXTURE_FILE_MAGIC, sizeof(VIRTUAL_TEXTURE_FILE_MAGIC));
+    header.version = VIRTUAL_TEXTURE_FILE_VERSION;
+    header.format = static_cast<uint32_t>(format);
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.source_hash = vulkan_hash_bytes(source_data.data(), source_data.size());
+    source_data = std::vector<char>();
+
+    // Every page has the same size, so the index is known before a single tile is encoded
+    size_t page_size = virtual_texture_get_page_size(format);
+    std::vector<VirtualTextureFileTile> tiles(header.tile_count);
+    uint64_t offset = sizeof(VirtualTextureFileHeader) + sizeof(VirtualTextureFileTile) * tiles.size();
+    for (VirtualTextureFileTile& tile : tiles)
+    {
+        tile = { offset, page_size };
+        offset += page_size;
+    }
+
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    ise::util::ThreadPool thread_pool(thread_count);
+
+    std::string file_path = virtual_texture_file_get_path(source_path);
+    bool written = ise::util::write_file_replacing(file_path, [&](std::ostream& file)
+    {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(tiles.data()), static_cast<std::streamsize>(sizeof(VirtualTextureFileTile) * tiles.size()));
+
+        // One row of pages is encoded at a time, so only the current level and the next one are ever held in memory
+        const uint8_t* level_texels = pixels;
+        std::vector<uint8_t> current_level;
+        std::vector<uint8_t> next_level;
+        std::vector<uint8_t> row_pages;
+        for (size_t level_index = 0; level_index < levels.size() && file.good(); level_index++)
+        {
+            const VirtualTextureLevel& level = levels[level_index];
+            row_pages.resize(page_size * level.tiles_x);
+
+            for (uint32_t tile_y = 0; tile_y < level.tiles_y && file.good(); tile_y++)
+            {
+                size_t worker_count = std::min<size_t>(thread_pool.size(), level.tiles_x);
+                thread_pool.run_on_workers(worker_count, [&](size_t worker_index)
+                {
+                    std::vector<uint8_t> page_texels(size_t(VIRTUAL_TEXTURE_PAGE_SIZE) * VIRTUAL_TEXTURE_PAGE_SIZE * 4);
+                    for (uint32_t tile_x = static_cast<uint32_t>(worker_index); tile_x < level.tiles_x; tile_x += static_cast<uint32_t>(worker_count))
+                    {
+                        virtual_texture_extract_page(level_texels, level.width, level.height, tile_x, tile_y, page_texels.data());
+                        virtual_texture_encode_page(page_texels.data(), format, row_pages.data() + page_size * tile_x);
+                    }
+                });
+
+                file.write(reinterpret_cast<const char*>(row_pages.data()), static_cast<std::streamsize>(row_pages.size()));
+            }
+
+            if (level_index + 1 < levels.size())
+            {
+                texture_downsample_srgb(level_texels, level.width, level.height, next_level);
+                current_level.swap(next_level);
+                level_texels = current_level.data();
+
+                if (level_index == 0)
+                {
+                    stbi_image_free(pixels);
+                    pixels = nullptr;
+                }
+            }
+        }
+    });
+
+    if (pixels != nullptr)
+    {
+        stbi_image_free(pixels);
+    }
+
+    if (!written)
+    {
+        error = std::format("failed to write virtual texture tiles {0}", file_path);
+        return false;
+    }
+
+    return true;
+}
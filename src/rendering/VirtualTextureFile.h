@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "TextureCompression.h"
+#include "../util/MappedFile.h"
+
+namespace ise
+{
+    namespace rendering
+    {
+        // Bump whenever the layout below or the encoders change, older tile files are then rebuilt
+        const uint32_t VIRTUAL_TEXTURE_FILE_VERSION = 1;
+        const char VIRTUAL_TEXTURE_FILE_MAGIC[4] = { 'I', 'S', 'E', 'V' };
+        const char VIRTUAL_TEXTURE_FILE_EXTENSION[] = ".isevt";
+
+        // Mirrored by frag_virtual.glsl. A page is one tile plus a border repeated from its neighbours on every side, so bilinear
+        // filtering never reads the page next to it in the atlas. The border is a multiple of 4 to keep tiles block aligned.
+        const uint32_t VIRTUAL_TEXTURE_PAGE_SIZE = 128;
+        const uint32_t VIRTUAL_TEXTURE_PAGE_BORDER = 4;
+        const uint32_t VIRTUAL_TEXTURE_TILE_SIZE = VIRTUAL_TEXTURE_PAGE_SIZE - 2 * VIRTUAL_TEXTURE_PAGE_BORDER;
+        const uint32_t VIRTUAL_TEXTURE_MAX_LEVELS = 16;
+        // stb_image decodes the whole source into one RGBA8 allocation sized with an int, so a larger source would fail
+        // after reading the file. 16384 square is 1 GiB decoded.
+        const uint32_t VIRTUAL_TEXTURE_MAX_SOURCE_SIZE = 16384;
+
+        // Levels halve like texture_downsample_srgb until one tile covers the whole level
+        struct VirtualTextureLevel
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t tiles_x = 0;
+            uint32_t tiles_y = 0;
+            uint32_t first_tile = 0; // tiles are numbered level by level, row by row
+        };
+
+        // The header, a tile index of tile_count VirtualTextureFileTile, then the pages in tile order, each one
+        // VIRTUAL_TEXTURE_PAGE_SIZE texels square in tightly packed rows of blocks of format
+        struct VirtualTextureFileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t format; // VkFormat
+            uint32_t width;
+            uint32_t height;
+            uint32_t level_count;
+            uint32_t tile_count;
+            uint32_t padding;
+
+            // Identify the source the tiles were built from
+            uint64_t source_size;
+            int64_t source_mtime;
+            uint64_t source_hash;
+        };
+
+        struct VirtualTextureFileTile
+        {
+            uint64_t offset; // from the start of the file
+            uint64_t size;
+        };
+
+        // The mapping stays open while the virtual texture lives, pages are copied out of it one at a time
+        struct VirtualTextureFile
+        {
+            ise::util::MappedFile mapping;
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<VirtualTextureLevel> levels;
+            const VirtualTextureFileTile* tiles = nullptr;
+            uint32_t tile_count = 0;
+        };
+
+        // Returns the tile count, 0 when a side is larger than VIRTUAL_TEXTURE_MAX_SOURCE_SIZE or the image needs more than
+        // VIRTUAL_TEXTURE_MAX_LEVELS levels
+        uint32_t virtual_texture_get_levels(uint32_t width, uint32_t height, std::vector<VirtualTextureLevel>& levels);
+        // Bytes of one page of format, see texture_format_get_block_size
+        size_t virtual_texture_get_page_size(VkFormat format);
+
+        std::string virtual_texture_file_get_path(const std::string& source_path);
+
+        // Same rules as texture_cache_read, a file built for another format is rejected
+        bool virtual_texture_file_open(const std::string& source_path, VkFormat format, VirtualTextureFile& file);
+
+        // Decodes the source once and writes every level as pages of format, block compressed ones encoded over thread_count
+        // threads (0 uses every core). The whole source is decoded in memory, its size is checked against
+        // VIRTUAL_TEXTURE_MAX_SOURCE_SIZE from the header first.
+        // Unlike the texture cache a failure is an error, the tiles cannot be streamed from anywhere else.
+        bool virtual_texture_file_build(const std::string& source_path, VkFormat format, uint32_t thread_count, std::string& error);
+    }
+}
@@ -0,0 +1,181 @@
+#include "VulkanRendererUgly.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// Every texture is one slot of a single update after bind array bound once per frame, objects pick theirs through
+// InstanceData::texture_index or GpuObjectData::texture_index. A slot is only written while no submitted frame can read it:
+// new textures get a slot nobody used since max_frames_in_flight frames, a texture that finished loading gets a new slot
+// instead of overwriting the placeholder's. Slot 0 is always the placeholder texture.
+
+bool ise::rendering::vulkan_check_bindless_texture_support(const VkPhysicalDeviceVulkan12Features& features)
+{
+    return features.descriptorIndexing &&
+        features.runtimeDescriptorArray &&
+        features.descriptorBindingPartiallyBound &&
+        features.descriptorBindingSampledImageUpdateAfterBind &&
+        features.descriptorBindingUpdateUnusedWhilePending &&
+        features.shaderSampledImageArrayNonUniformIndexing;
+}
+
+uint32_t ise::rendering::vulkan_get_bindless_texture_capacity(VulkanRendererData& renderer)
+{
+    VkPhysicalDeviceVulkan12Properties vulkan12_properties{};
+    vulkan12_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &vulkan12_properties;
+    vkGetPhysicalDeviceProperties2(renderer.physical_device, &properties);
+
+    // A combined image sampler counts as both a sampler and a sampled image
+    uint32_t capacity = renderer.custom_config.max_bindless_textures;
+    capacity = std::min(capacity, vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSamplers);
+    capacity = std::min(capacity, vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+    capacity = std::min(capacity, vulkan12_properties.maxDescriptorSetUpdateAfterBindSamplers);
+    capacity = std::min(capacity, vulkan12_properties.maxDescriptorSetUpdateAfterBindSampledImages);
+
+    return std::max(capacity, 1u);
+}
+
+void ise::rendering::vulkan_create_bindless_textures(VulkanRendererData& renderer)
+{
+    BindlessTextureData& bindless_textures = renderer.bindless_textures;
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_size.descriptorCount = bindless_textures.capacity;
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = 1;
+
+    if (vkCreateDescriptorPool(renderer.device, &pool_info, nullptr, &bindless_textures.descriptor_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor pool for bindless textures!");
+    }
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = bindless_textures.descriptor_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &renderer.descriptor_set_layout_textures;
+
+    if (vkAllocateDescriptorSets(renderer.device, &alloc_info, &bindless_textures.descriptor_set) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate bindless texture descriptor set!");
+    }
+
+    bindless_textures.next_slot = 0;
+    bindless_textures.free_slots.clear();
+
+    // Slot 0, what objects without a usable texture sample
+    vulkan_register_bindless_texture(renderer, *vulkan_get_placeholder_texture(renderer));
+}
+
+uint32_t ise::rendering::vulkan_register_bindless_texture(VulkanRendererData& renderer, RenderTexture& render_texture)
+{
+    if (render_texture.bindless_index != BINDLESS_TEXTURE_NONE)
+    {
+        return render_texture.bindless_index;
+    }
+
+    BindlessTextureData& bindless_textures = renderer.bindless_textures;
+    uint32_t slot;
+    if (!bindless_textures.free_slots.empty())
+    {
+        slot = bindless_textures.free_slots.back();
+        bindless_textures.free_slots.pop_back();
+    }
+    else if (bindless_textures.next_slot < bindless_textures.capacity)
+    {
+        slot = bindless_textures.next_slot++;
+    }
+    else
+    {
+        throw std::runtime_error(std::format("failed to register bindless texture, all {0} slots are in use!", bindless_textures.capacity));
+    }
+
+    render_texture.bindless_index = slot;
+    vulkan_write_bindless_texture(renderer, render_texture);
+    return slot;
+}
+
+void ise::rendering::vulkan_write_bindless_texture(VulkanRendererData& renderer, const RenderTexture& render_texture)
+{
+    VkDescriptorImageInfo image_info{};
+    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    image_info.imageView = render_texture.image_view;
+    image_info.sampler = render_texture.sampler;
+
+    VkWriteDescriptorSet descriptor_write{};
+    descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptor_write.dstSet = renderer.bindless_textures.descriptor_set;
+    descriptor_write.dstBinding = 0;
+    descriptor_write.dstArrayElement = render_texture.bindless_index;
+    descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptor_write.descriptorCount = 1;
+    descriptor_write.pImageInfo = &image_info;
+
+    vkUpdateDescriptorSets(renderer.device, 1, &descriptor_write, 0, nullptr);
+}
+
+void ise::rendering::vulkan_release_bindless_texture(VulkanRendererData& renderer, RenderTexture& render_texture)
+{
+    // A placeholder borrows slot 0
+    if (render_texture.placeholder || render_texture.bindless_index == BINDLESS_TEXTURE_NONE)
+    {
+        render_texture.bindless_index = BINDLESS_TEXTURE_NONE;
+        return;
+    }
+
+    // Frames already submitted may still sample it
+    uint32_t slot = render_texture.bindless_index;
+    vulkan_defer_destroy(renderer, [slot](VulkanRendererData& renderer) { renderer.bindless_textures.free_slots.push_back(slot); });
+    render_texture.bindless_index = BINDLESS_TEXTURE_NONE;
+}
+
+void ise::rendering::vulkan_update_texture_users(VulkanRendererData& renderer, const std::string& key)
+{
+    uint32_t texture_index = 0;
+    auto it = renderer.render_textures.find(key);
+    if (it != renderer.render_textures.end() && it->second->bindless_index != BINDLESS_TEXTURE_NONE)
+    {
+        texture_index = it->second->bindless_index;
+    }
+
+    bool changed = false;
+    for (RenderObject* render_object : renderer.render_objects)
+    {
+        if (render_object->virtual_texture != nullptr ||
+            render_object->texture_description_set == VK_NULL_HANDLE ||
+            render_object->textures.empty() ||
+            render_object->textures[0] != key ||
+            render_object->texture_index == texture_index)
+        {
+            continue;
+        }
+
+        render_object->texture_index = texture_index;
+        changed = true;
+    }
+
+    // The index is part of the instances the command buffers were recorded with
+    if (changed)
+    {
+        vulkan_invalidate_recorded_command_buffers(renderer);
+    }
+}
+
+void ise::rendering::vulkan_destroy_bindless_textures(VulkanRendererData& renderer)
+{
+    // Frees the set as well
+    vkDestroyDescriptorPool(renderer.device, renderer.bindless_textures.descriptor_pool, nullptr);
+    renderer.bindless_textures = BindlessTextureData{};
+}
@@ -0,0 +1,41 @@
+#include "VulkanRendererUgly.h"
+
+#include <utility>
+
+void ise::rendering::vulkan_defer_destroy(VulkanRendererData& renderer, std::function<void(VulkanRendererData& renderer)> destroy)
+{
+    DeletionQueueEntry entry{};
+    // Every frame submitted so far may still use it, the last of them is waited for max_frames_in_flight frames later
+    entry.frame_number = renderer.frame_number + renderer.custom_config.max_frames_in_flight;
+    // So may the open upload batch, which goes out with the next frame
+    entry.upload_value = renderer.uploads.recording ? renderer.upload_submitted_value + 1 : renderer.upload_submitted_value;
+    entry.destroy = std::move(destroy);
+    renderer.deletion_queue.push_back(std::move(entry));
+}
+
+void ise::rendering::vulkan_retire_deletion_queue(VulkanRendererData& renderer)
+{
+    // Both points only grow along the queue, so the first entry still in use ends the scan
+    while (!renderer.deletion_queue.empty())
+    {
+        const DeletionQueueEntry& entry = renderer.deletion_queue.front();
+        if (entry.frame_number > renderer.frame_number || entry.upload_value > renderer.upload_completed_value)
+        {
+            break;
+        }
+
+        std::function<void(VulkanRendererData& renderer)> destroy = std::move(renderer.deletion_queue.front().destroy);
+        renderer.deletion_queue.pop_front();
+        destroy(renderer);
+    }
+}
+
+void ise::rendering::vulkan_flush_deletion_queue(VulkanRendererData& renderer)
+{
+    while (!renderer.deletion_queue.empty())
+    {
+        std::function<void(VulkanRendererData& renderer)> destroy = std::move(renderer.deletion_queue.front().destroy);
+        renderer.deletion_queue.pop_front();
+        destroy(renderer);
+    }
+}
@@ -0,0 +1,323 @@
+#include "VulkanRendererUgly.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace
+{
+    const float MIN_RENDER_SCALE = 0.25f;
+
+    // Weight of the newest frame in the moving average, a single slow frame does not move the scale
+    const double GPU_FRAME_TIME_SMOOTHING = 0.1;
+    // Hysteresis: below the budget but above HEADROOM of it nothing changes. Dropping reacts within a few frames,
+    // coming back needs a second of headroom, so the scale does not bounce at the edge of the budget.
+    const double HEADROOM = 0.8;
+    const uint32_t OVER_BUDGET_FRAMES = 8;
+    const double UNDER_BUDGET_MS = 1000.0;
+    // Aimed below the budget, so the new scale does not land right at its edge
+    const double AIMED_BUDGET = 0.9;
+    const float MAX_SCALE_INCREASE = 0.05f;
+    const float MIN_SCALE_CHANGE = 0.01f;
+}
+
+float ise::rendering::vulkan_get_min_render_scale(const VulkanRendererConfig& config)
+{
+    return std::clamp(config.min_render_scale, MIN_RENDER_SCALE, 1.0f);
+}
+
+float ise::rendering::vulkan_get_max_render_scale(const VulkanRendererConfig& config)
+{
+    return std::clamp(config.max_render_scale, vulkan_get_min_render_scale(config), 1.0f);
+}
+
+bool ise::rendering::vulkan_check_dynamic_resolution_support(VulkanRendererData& renderer)
+{
+    if (vulkan_get_min_render_scale(renderer.custom_config) >= 1.0f)
+    {
+        return false;
+    }
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(renderer.physical_device, renderer.swap_chain_image_format, &properties);
+    VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    if ((properties.optimalTilingFeatures & required_features) != required_features)
+    {
+        return false;
+    }
+
+    if (renderer.custom_config.headless)
+    {
+        return true;
+    }
+
+    // vulkan_create_swap_chain only asks for transfer dst when the surface supports it
+    SwapChainSupportDetails swap_chain_support = vulkan_query_swap_chain_support(renderer.physical_device, renderer);
+    return swap_chain_support.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+}
+
+void ise::rendering::vulkan_create_dynamic_resolution_resources(VulkanRendererData& renderer)
+{
+    DynamicResolutionData& dynamic_resolution = renderer.dynamic_resolution;
+    dynamic_resolution.queries_submitted.assign(renderer.custom_config.max_frames_in_flight, false);
+
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(renderer.physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(renderer.physical_device, &queue_family_count, queue_families.data());
+
+    // Without timestamps the scale stays where it is
+    uint32_t valid_bits = queue_families[vulkan_find_queue_families(renderer.physical_device, renderer).graphics_family.value()].timestampValidBits;
+    if (valid_bits == 0)
+    {
+        return;
+    }
+    dynamic_resolution.timestamp_mask = valid_bits >= 64 ? UINT64_MAX : (1ull << valid_bits) - 1;
+    dynamic_resolution.timestamp_period_ms = renderer.physical_device_properties.limits.timestampPeriod / 1000000.0;
+
+    VkQueryPoolCreateInfo query_pool_info{};
+    query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    query_pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_pool_info.queryCount = 2 * renderer.custom_config.max_frames_in_flight;
+
+    if (vkCreateQueryPool(renderer.device, &query_pool_info, nullptr, &dynamic_resolution.query_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+}
+
+void ise::rendering::vulkan_create_render_target(VulkanRendererData& renderer)
+{
+    DynamicResolutionData& dynamic_resolution = renderer.dynamic_resolution;
+    if (!dynamic_resolution.enabled)
+    {
+        return;
+    }
+
+    float max_scale = vulkan_get_max_render_scale(renderer.custom_config);
+    dynamic_resolution.target_extent.width = std::max(1u, static_cast<uint32_t>(std::ceil(renderer.swap_chain_extent.width * max_scale)));
+    dynamic_resolution.target_extent.height = std::max(1u, static_cast<uint32_t>(std::ceil(renderer.swap_chain_extent.height * max_scale)));
+
+    // Same format as the swapchain, so the blit only scales
+    vulkan_create_image(
+        renderer,
+        dynamic_resolution.target_extent.width,
+        dynamic_resolution.target_extent.height,
+        1,
+        VK_SAMPLE_COUNT_1_BIT,
+        renderer.swap_chain_image_format,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        dynamic_resolution.image,
+        dynamic_resolution.image_memory);
+
+    dynamic_resolution.image_view = vulkan_create_image_view(
+        renderer,
+        dynamic_resolution.image,
+        renderer.swap_chain_image_format,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        1);
+
+    // Keeps the scale over swapchain recreations, within the bounds of the current config
+    vulkan_set_render_scale(renderer, dynamic_resolution.scale);
+}
+
+VkExtent2D ise::rendering::vulkan_get_framebuffer_extent(VulkanRendererData& renderer)
+{
+    return renderer.dynamic_resolution.enabled ? renderer.dynamic_resolution.target_extent : renderer.swap_chain_extent;
+}
+
+VkExtent2D ise::rendering::vulkan_get_render_extent(VulkanRendererData& renderer)
+{
+    return renderer.dynamic_resolution.enabled ? renderer.dynamic_resolution.render_extent : renderer.swap_chain_extent;
+}
+
+void ise::rendering::vulkan_set_render_scale(VulkanRendererData& renderer, float scale)
+{
+    DynamicResolutionData& dynamic_resolution = renderer.dynamic_resolution;
+    dynamic_resolution.scale = std::clamp(scale, vulkan_get_min_render_scale(renderer.custom_config), vulkan_get_max_render_scale(renderer.custom_config));
+
+    VkExtent2D render_extent;
+    render_extent.width = std::clamp(static_cast<uint32_t>(std::lround(renderer.swap_chain_extent.width * dynamic_resolution.scale)), 1u, dynamic_resolution.target_extent.width);
+    render_extent.height = std::clamp(static_cast<uint32_t>(std::lround(renderer.swap_chain_extent.height * dynamic_resolution.scale)), 1u, dynamic_resolution.target_extent.height);
+
+    // Times measured so far belong to the old extent
+    dynamic_resolution.gpu_frame_time_ms = 0.0;
+    dynamic_resolution.over_budget_frames = 0;
+    dynamic_resolution.under_budget_ms = 0.0;
+    dynamic_resolution.last_measured_time = {};
+    dynamic_resolution.settle_frame_number = renderer.frame_number + renderer.custom_config.max_frames_in_flight;
+
+    if (render_extent.width != dynamic_resolution.render_extent.width || render_extent.height != dynamic_resolution.render_extent.height)
+    {
+        dynamic_resolution.render_extent = render_extent;
+        vulkan_invalidate_recorded_command_buffers(renderer);
+    }
+}
+
+void ise::rendering::vulkan_update_dynamic_resolution(VulkanRendererData& renderer)
+{
+    DynamicResolutionData& dynamic_resolution = renderer.dynamic_resolution;
+    if (dynamic_resolution.query_pool == VK_NULL_HANDLE || !dynamic_resolution.queries_submitted[renderer.current_frame])
+    {
+        return;
+    }
+
+    // The fence of the frame that wrote them was just waited for, so this never blocks
+    std::array<uint64_t, 2> timestamps{};
+    VkResult result = vkGetQueryPoolResults(renderer.device, dynamic_resolution.query_pool, 2 * renderer.current_frame, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_NOT_READY)
+    {
+        return;
+    }
+    vulkan_handle_vk_result(result);
+
+    // The frame may have been recorded before the last scale change
+    if (renderer.frame_number < dynamic_resolution.settle_frame_number)
+    {
+        return;
+    }
+
+    double frame_time_ms = ((timestamps[1] - timestamps[0]) & dynamic_resolution.timestamp_mask) * dynamic_resolution.timestamp_period_ms;
+
+    // Headroom is counted in wall time, frames come at whatever rate v-sync or the frame cap allow
+    auto measured_time = std::chrono::steady_clock::now();
+    double elapsed_ms = 0.0;
+    if (dynamic_resolution.last_measured_time != std::chrono::steady_clock::time_point{})
+    {
+        elapsed_ms = std::chrono::duration<double, std::milli>(measured_time - dynamic_resolution.last_measured_time).count();
+    }
+    dynamic_resolution.last_measured_time = measured_time;
+    if (dynamic_resolution.gpu_frame_time_ms == 0.0)
+    {
+        dynamic_resolution.gpu_frame_time_ms = frame_time_ms;
+    }
+    else
+    {
+        dynamic_resolution.gpu_frame_time_ms += (frame_time_ms - dynamic_resolution.gpu_frame_time_ms) * GPU_FRAME_TIME_SMOOTHING;
+    }
+
+    if (!dynamic_resolution.enabled)
+    {
+        return;
+    }
+
+    double budget_ms = renderer.custom_config.target_gpu_frame_time_ms;
+    if (dynamic_resolution.gpu_frame_time_ms > budget_ms)
+    {
+        dynamic_resolution.over_budget_frames++;
+        dynamic_resolution.under_budget_ms = 0.0;
+    }
+    else if (dynamic_resolution.gpu_frame_time_ms < budget_ms * HEADROOM)
+    {
+        dynamic_resolution.under_budget_ms += elapsed_ms;
+        dynamic_resolution.over_budget_frames = 0;
+    }
+    else
+    {
+        dynamic_resolution.over_budget_frames = 0;
+        dynamic_resolution.under_budget_ms = 0.0;
+    }
+
+    if (dynamic_resolution.over_budget_frames < OVER_BUDGET_FRAMES && dynamic_resolution.under_budget_ms < UNDER_BUDGET_MS)
+    {
+        return;
+    }
+
+    // GPU time mostly follows the pixel count, the square of the scale
+    float scale = dynamic_resolution.scale * static_cast<float>(std::sqrt(budget_ms * AIMED_BUDGET / std::max(dynamic_resolution.gpu_frame_time_ms, 0.001)));
+    scale = std::min(scale, dynamic_resolution.scale + MAX_SCALE_INCREASE);
+    scale = std::clamp(scale, vulkan_get_min_render_scale(renderer.custom_config), vulkan_get_max_render_scale(renderer.custom_config));
+
+    if (std::abs(scale - dynamic_resolution.scale) < MIN_SCALE_CHANGE)
+    {
+        // Already at a bound, counting on would only retry every frame
+        dynamic_resolution.over_budget_frames = 0;
+        dynamic_resolution.under_budget_ms = 0.0;
+        return;
+    }
+
+    vulkan_set_render_scale(renderer, scale);
+}
+
+void ise::rendering::vulkan_record_frame_timestamp(VulkanRendererData& renderer, VkCommandBuffer command_buffer, bool end)
+{
+    DynamicResolutionData& dynamic_resolution = renderer.dynamic_resolution;
+    if (dynamic_resolution.query_pool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // Recorded command buffers are replayed by the same frame in flight, so its queries stay the same
+    uint32_t first_query = 2 * renderer.current_frame;
+    if (!end)
+    {
+        vkCmdResetQueryPool(command_buffer, dynamic_resolution.query_pool, first_query, 2);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dynamic_resolution.query_pool, first_query);
+    }
+    else
+    {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, dynamic_resolution.query_pool, first_query + 1);
+    }
+}
+
+void ise::rendering::vulkan_record_render_target_blit(VulkanRendererData& renderer, VkCommandBuffer command_buffer, uint32_t image_index)
+{
+    DynamicResolutionData& dynamic_resolution = renderer.dynamic_resolution;
+    if (!dynamic_resolution.enabled)
+    {
+        return;
+    }
+
+    // The render pass left the render target in TRANSFER_SRC_OPTIMAL, its outgoing dependency covers the read below
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = renderer.swap_chain_images[image_index];
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    // The acquire semaphore is waited for at the color attachment output stage, chaining from it orders the blit after it
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkImageBlit blit{};
+    blit.srcOffsets[1] = { static_cast<int32_t>(dynamic_resolution.render_extent.width), static_cast<int32_t>(dynamic_resolution.render_extent.height), 1 };
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.mipLevel = 0;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount = 1;
+    blit.dstOffsets[1] = { static_cast<int32_t>(renderer.swap_chain_extent.width), static_cast<int32_t>(renderer.swap_chain_extent.height), 1 };
+    blit.dstSubresource = blit.srcSubresource;
+    vkCmdBlitImage(command_buffer, dynamic_resolution.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, barrier.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = vulkan_get_presentable_image_layout(renderer);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void ise::rendering::vulkan_destroy_dynamic_resolution_resources(VulkanRendererData& renderer)
+{
+    DynamicResolutionData& dynamic_resolution = renderer.dynamic_resolution;
+    if (dynamic_resolution.query_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(renderer.device, dynamic_resolution.query_pool, nullptr);
+        dynamic_resolution.query_pool = VK_NULL_HANDLE;
+    }
+    dynamic_resolution.queries_submitted.clear();
+}
@@ -0,0 +1,434 @@
+#include "VulkanRendererUgly.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace
+{
+    const uint32_t CULL_WORKGROUP_SIZE = 64;
+}
+
+bool ise::rendering::vulkan_check_gpu_driven_culling_support(VkPhysicalDevice device)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan12Features vulkan12_features{};
+    vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &vulkan12_features;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    return vulkan12_features.drawIndirectCount && features.features.multiDrawIndirect && features.features.drawIndirectFirstInstance;
+}
+
+void ise::rendering::vulkan_create_gpu_culling_resources(VulkanRendererData& renderer)
+{
+    GpuCullingData& gpu_culling = renderer.gpu_culling;
+    if (!gpu_culling.enabled)
+    {
+        return;
+    }
+
+    // binding 0: objects, binding 1: indirect commands, binding 2: per draw group counts
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); i++)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    bindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(renderer.device, &layout_info, nullptr, &gpu_culling.descriptor_set_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set layout for gpu culling!");
+    }
+
+    uint32_t frame_count = renderer.custom_config.max_frames_in_flight;
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = static_cast<uint32_t>(bindings.size()) * frame_count;
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = frame_count;
+
+    if (vkCreateDescriptorPool(renderer.device, &pool_info, nullptr, &gpu_culling.descriptor_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor pool for gpu culling!");
+    }
+
+    std::vector<VkDescriptorSetLayout> layouts(frame_count, gpu_culling.descriptor_set_layout);
+    std::vector<VkDescriptorSet> descriptor_sets(frame_count);
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = gpu_culling.descriptor_pool;
+    alloc_info.descriptorSetCount = frame_count;
+    alloc_info.pSetLayouts = layouts.data();
+
+    if (vkAllocateDescriptorSets(renderer.device, &alloc_info, descriptor_sets.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate descriptor sets for gpu culling!");
+    }
+
+    gpu_culling.frames.resize(frame_count);
+    for (uint32_t i = 0; i < frame_count; i++)
+    {
+        gpu_culling.frames[i].descriptor_set = descriptor_sets[i];
+    }
+
+    // Compute: set 0 is the regular uniform buffer for the frustum planes, set 1 the culling buffers
+    std::array<VkDescriptorSetLayout, 2> compute_set_layouts = { renderer.descriptor_set_layout_uniform_buffers, gpu_culling.descriptor_set_layout };
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(uint32_t);
+
+    VkPipelineLayoutCreateInfo compute_layout_info{};
+    compute_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    compute_layout_info.setLayoutCount = static_cast<uint32_t>(compute_set_layouts.size());
+    compute_layout_info.pSetLayouts = compute_set_layouts.data();
+    compute_layout_info.pushConstantRangeCount = 1;
+    compute_layout_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(renderer.device, &compute_layout_info, nullptr, &gpu_culling.compute_pipeline_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create pipeline layout for gpu culling!");
+    }
+
+    VkShaderModule cull_shader_module = vulkan_create_shader_module(renderer, "cull.spv");
+
+    VkComputePipelineCreateInfo compute_pipeline_info{};
+    compute_pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    compute_pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    compute_pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    compute_pipeline_info.stage.module = cull_shader_module;
+    compute_pipeline_info.stage.pName = "main";
+    compute_pipeline_info.layout = gpu_culling.compute_pipeline_layout;
+
+    if (vkCreateComputePipelines(renderer.device, renderer.pipeline_cache, 1, &compute_pipeline_info, nullptr, &gpu_culling.compute_pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create compute pipeline for gpu culling!");
+    }
+
+    vkDestroyShaderModule(renderer.device, cull_shader_module, nullptr);
+
+    // Graphics: same as the regular pipeline plus set 2, the vertex shader reads its transform from the object buffer
+    std::array<VkDescriptorSetLayout, 3> graphics_set_layouts = { renderer.descriptor_set_layout_uniform_buffers, renderer.descriptor_set_layout_textures, gpu_culling.descriptor_set_layout };
+
+    VkPipelineLayoutCreateInfo graphics_layout_info{};
+    graphics_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    graphics_layout_info.setLayoutCount = static_cast<uint32_t>(graphics_set_layouts.size());
+    graphics_layout_info.pSetLayouts = graphics_set_layouts.data();
+
+    if (vkCreatePipelineLayout(renderer.device, &graphics_layout_info, nullptr, &gpu_culling.graphics_pipeline_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create pipeline layout for gpu culled draws!");
+    }
+
+    gpu_culling.graphics_pipeline = vulkan_create_graphics_pipeline_from_shaders(renderer, vulkan_get_vertex_shader_file(renderer.custom_config.vertex_format, "vert_indirect"), "frag.spv", gpu_culling.graphics_pipeline_layout, false);
+}
+
+void ise::rendering::vulkan_recreate_gpu_culling_graphics_pipeline(VulkanRendererData& renderer)
+{
+    GpuCullingData& gpu_culling = renderer.gpu_culling;
+    if (!gpu_culling.enabled)
+    {
+        return;
+    }
+
+    // The compute pipeline does not depend on the render pass
+    vkDestroyPipeline(renderer.device, gpu_culling.graphics_pipeline, nullptr);
+    gpu_culling.graphics_pipeline = vulkan_create_graphics_pipeline_from_shaders(renderer, vulkan_get_vertex_shader_file(renderer.custom_config.vertex_format, "vert_indirect"), "frag.spv", gpu_culling.graphics_pipeline_layout, false);
+}
+
+void ise::rendering::vulkan_build_gpu_culling_objects(VulkanRendererData& renderer)
+{
+    GpuCullingData& gpu_culling = renderer.gpu_culling;
+    gpu_culling.objects.clear();
+    gpu_culling.draw_groups.clear();
+
+    // One draw group per texture description set and index type, each gets a contiguous slice of the indirect buffer.
+    // Indexed by 16 bit indices or not.
+    std::array<std::unordered_map<VkDescriptorSet, uint32_t>, 2> draw_group_indices;
+    for (const RenderObject* render_object : renderer.render_objects)
+    {
+        if (render_object->index_count == 0 || render_object->texture_description_set == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        auto& index_type_groups = draw_group_indices[render_object->index_type == VK_INDEX_TYPE_UINT16 ? 1 : 0];
+        auto [it, inserted] = index_type_groups.try_emplace(render_object->texture_description_set, static_cast<uint32_t>(gpu_culling.draw_groups.size()));
+        if (inserted)
+        {
+            gpu_culling.draw_groups.push_back({ render_object->texture_description_set, render_object->virtual_texture, render_object->index_type, 0, 0 });
+        }
+        gpu_culling.draw_groups[it->second].capacity++;
+    }
+
+    uint32_t command_offset = 0;
+    for (GpuDrawGroup& draw_group : gpu_culling.draw_groups)
+    {
+        draw_group.command_offset = command_offset;
+        command_offset += draw_group.capacity;
+    }
+
+    gpu_culling.objects.reserve(command_offset);
+    for (const RenderObject* render_object : renderer.render_objects)
+    {
+        if (render_object->index_count == 0 || render_object->texture_description_set == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        glm::vec3 center = (render_object->bounds_min + render_object->bounds_max) * 0.5f;
+        float radius = glm::length(render_object->bounds_max - center);
+
+        uint32_t draw_group = draw_group_indices[render_object->index_type == VK_INDEX_TYPE_UINT16 ? 1 : 0][render_object->texture_description_set];
+
+        GpuObjectData object{};
+        object.transform = render_object->transform;
+        object.bounding_sphere = glm::vec4(center, radius);
+        object.position_offset = glm::vec4(render_object->position_offset, 0.0f);
+        object.position_scale = glm::vec4(render_object->position_scale, 0.0f);
+        object.first_index = render_object->first_index;
+        object.index_count = render_object->index_count;
+        object.vertex_offset = render_object->vertex_offset;
+        object.draw_group = draw_group;
+        object.command_offset = gpu_culling.draw_groups[draw_group].command_offset;
+        object.texture_index = render_object->texture_index;
+        gpu_culling.objects.push_back(object);
+    }
+
+    gpu_culling.scene_generation = renderer.scene_generation;
+}
+
+void ise::rendering::vulkan_update_gpu_culling_frame(VulkanRendererData& renderer, GpuCullingFrame& frame)
+{
+    GpuCullingData& gpu_culling = renderer.gpu_culling;
+    uint32_t object_count = static_cast<uint32_t>(gpu_culling.objects.size());
+    uint32_t group_count = static_cast<uint32_t>(gpu_culling.draw_groups.size());
+
+    if (object_count > frame.object_capacity || group_count > frame.group_capacity)
+    {
+        if (frame.object_capacity > 0)
+        {
+            vkDestroyBuffer(renderer.device, frame.object_buffer, nullptr);
+            vulkan_free_memory(renderer, frame.object_buffer_memory);
+            vkDestroyBuffer(renderer.device, frame.indirect_buffer, nullptr);
+            vulkan_free_memory(renderer, frame.indirect_buffer_memory);
+            vkDestroyBuffer(renderer.device, frame.count_buffer, nullptr);
+            vulkan_free_memory(renderer, frame.count_buffer_memory);
+        }
+
+        // Grow geometrically so adding objects one by one does not reallocate every frame
+        frame.object_capacity = std::max({ object_count, frame.object_capacity * 2, CULL_WORKGROUP_SIZE });
+        frame.group_capacity = std::max({ group_count, frame.group_capacity * 2, 16u });
+
+        VkDeviceSize object_buffer_size = sizeof(GpuObjectData) * frame.object_capacity;
+        VkDeviceSize indirect_buffer_size = sizeof(VkDrawIndexedIndirectCommand) * frame.object_capacity;
+        VkDeviceSize count_buffer_size = sizeof(uint32_t) * frame.group_capacity;
+
+        vulkan_create_buffer(renderer, object_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.object_buffer, frame.object_buffer_memory);
+        frame.object_buffer_mapped = frame.object_buffer_memory.mapped;
+
+        vulkan_create_buffer(renderer, indirect_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.indirect_buffer, frame.indirect_buffer_memory);
+        vulkan_create_buffer(renderer, count_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.count_buffer, frame.count_buffer_memory);
+
+        std::array<VkDescriptorBufferInfo, 3> buffer_infos{};
+        buffer_infos[0] = { frame.object_buffer, 0, VK_WHOLE_SIZE };
+        buffer_infos[1] = { frame.indirect_buffer, 0, VK_WHOLE_SIZE };
+        buffer_infos[2] = { frame.count_buffer, 0, VK_WHOLE_SIZE };
+
+        std::array<VkWriteDescriptorSet, 3> descriptor_writes{};
+        for (uint32_t i = 0; i < descriptor_writes.size(); i++)
+        {
+            descriptor_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptor_writes[i].dstSet = frame.descriptor_set;
+            descriptor_writes[i].dstBinding = i;
+            descriptor_writes[i].dstArrayElement = 0;
+            descriptor_writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptor_writes[i].descriptorCount = 1;
+            descriptor_writes[i].pBufferInfo = &buffer_infos[i];
+        }
+
+        vkUpdateDescriptorSets(renderer.device, static_cast<uint32_t>(descriptor_writes.size()), descriptor_writes.data(), 0, nullptr);
+    }
+
+    if (object_count > 0)
+    {
+        memcpy(frame.object_buffer_mapped, gpu_culling.objects.data(), sizeof(GpuObjectData) * object_count);
+    }
+
+    frame.scene_generation = gpu_culling.scene_generation;
+}
+
+void ise::rendering::vulkan_record_gpu_culling(VulkanRendererData& renderer, VkCommandBuffer command_buffer)
+{
+    GpuCullingData& gpu_culling = renderer.gpu_culling;
+    if (gpu_culling.scene_generation != renderer.scene_generation)
+    {
+        vulkan_build_gpu_culling_objects(renderer);
+    }
+
+    // The command buffer of this frame is only re-recorded once its previous submission finished,
+    // so the buffers can be rewritten from the host here
+    GpuCullingFrame& frame = gpu_culling.frames[renderer.current_frame];
+    if (frame.scene_generation != gpu_culling.scene_generation)
+    {
+        vulkan_update_gpu_culling_frame(renderer, frame);
+    }
+
+    uint32_t object_count = static_cast<uint32_t>(gpu_culling.objects.size());
+    if (object_count == 0)
+    {
+        return;
+    }
+
+    vkCmdFillBuffer(command_buffer, frame.count_buffer, 0, VK_WHOLE_SIZE, 0);
+
+    VkMemoryBarrier clear_barrier{};
+    clear_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clear_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clear_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clear_barrier, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, gpu_culling.compute_pipeline);
+
+    std::array<VkDescriptorSet, 2> descriptor_sets = { renderer.uniform_buffers_descriptor_sets[renderer.current_frame], frame.descriptor_set };
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, gpu_culling.compute_pipeline_layout, 0, static_cast<uint32_t>(descriptor_sets.size()), descriptor_sets.data(), 0, nullptr);
+    vkCmdPushConstants(command_buffer, gpu_culling.compute_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &object_count);
+
+    vkCmdDispatch(command_buffer, (object_count + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+    VkMemoryBarrier cull_barrier{};
+    cull_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cull_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cull_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &cull_barrier, 0, nullptr, 0, nullptr);
+}
+
+void ise::rendering::vulkan_record_gpu_culled_draws(VulkanRendererData& renderer, VkCommandBuffer command_buffer)
+{
+    GpuCullingData& gpu_culling = renderer.gpu_culling;
+    if (gpu_culling.objects.empty())
+    {
+        return;
+    }
+
+    GpuCullingFrame& frame = gpu_culling.frames[renderer.current_frame];
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gpu_culling.graphics_pipeline);
+
+    VkExtent2D render_extent = vulkan_get_render_extent(renderer);
+
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)render_extent.width;
+    viewport.height = (float)render_extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+    VkRect2D scissor{};
+    scissor.offset = { 0, 0 };
+    scissor.extent = render_extent;
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    VkBuffer vertex_buffers[] = { renderer.vertex_buffer };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
+
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gpu_culling.graphics_pipeline_layout, 0, 1, &renderer.uniform_buffers_descriptor_sets[renderer.current_frame], 0, nullptr);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gpu_culling.graphics_pipeline_layout, 2, 1, &frame.descriptor_set, 0, nullptr);
+
+    // One multi draw per texture set and index type, the compute pass decided how many of its commands survive
+    VkIndexType bound_index_type = VK_INDEX_TYPE_MAX_ENUM;
+    VkPipelineLayout bound_pipeline_layout = gpu_culling.graphics_pipeline_layout;
+    for (uint32_t i = 0; i < gpu_culling.draw_groups.size(); i++)
+    {
+        const GpuDrawGroup& draw_group = gpu_culling.draw_groups[i];
+
+        if (draw_group.index_type != bound_index_type)
+        {
+            vkCmdBindIndexBuffer(command_buffer, renderer.index_buffer, 0, draw_group.index_type);
+            bound_index_type = draw_group.index_type;
+        }
+
+        // Groups are not sorted, virtual textures switch pipelines in both directions. The layouts only differ in set 1.
+        VkPipelineLayout pipeline_layout = draw_group.virtual_texture != nullptr ? renderer.virtual_texturing.indirect_pipeline_layout : gpu_culling.graphics_pipeline_layout;
+        if (pipeline_layout != bound_pipeline_layout)
+        {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw_group.virtual_texture != nullptr ? renderer.virtual_texturing.indirect_graphics_pipeline : gpu_culling.graphics_pipeline);
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &renderer.uniform_buffers_descriptor_sets[renderer.current_frame], 0, nullptr);
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 2, 1, &frame.descriptor_set, 0, nullptr);
+            bound_pipeline_layout = pipeline_layout;
+        }
+
+        VkDescriptorSet texture_description_set = draw_group.virtual_texture != nullptr ? draw_group.virtual_texture->frames[renderer.current_frame].descriptor_set : draw_group.texture_description_set;
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 1, 1, &texture_description_set, 0, nullptr);
+        vkCmdDrawIndexedIndirectCount(command_buffer,
+            frame.indirect_buffer, sizeof(VkDrawIndexedIndirectCommand) * draw_group.command_offset,
+            frame.count_buffer, sizeof(uint32_t) * i,
+            draw_group.capacity, sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+void ise::rendering::vulkan_destroy_gpu_culling_resources(VulkanRendererData& renderer)
+{
+    GpuCullingData& gpu_culling = renderer.gpu_culling;
+    if (!gpu_culling.enabled)
+    {
+        return;
+    }
+
+    for (GpuCullingFrame& frame : gpu_culling.frames)
+    {
+        if (frame.object_capacity > 0)
+        {
+            vkDestroyBuffer(renderer.device, frame.object_buffer, nullptr);
+            vulkan_free_memory(renderer, frame.object_buffer_memory);
+            vkDestroyBuffer(renderer.device, frame.indirect_buffer, nullptr);
+            vulkan_free_memory(renderer, frame.indirect_buffer_memory);
+            vkDestroyBuffer(renderer.device, frame.count_buffer, nullptr);
+            vulkan_free_memory(renderer, frame.count_buffer_memory);
+        }
+    }
+    gpu_culling.frames.clear();
+    gpu_culling.objects.clear();
+    gpu_culling.draw_groups.clear();
+    gpu_culling.scene_generation = 0;
+
+    vkDestroyPipeline(renderer.device, gpu_culling.graphics_pipeline, nullptr);
+    vkDestroyPipelineLayout(renderer.device, gpu_culling.graphics_pipeline_layout, nullptr);
+    vkDestroyPipeline(renderer.device, gpu_culling.compute_pipeline, nullptr);
+    vkDestroyPipelineLayout(renderer.device, gpu_culling.compute_pipeline_layout, nullptr);
+    vkDestroyDescriptorPool(renderer.device, gpu_culling.descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(renderer.device, gpu_culling.descriptor_set_layout, nullptr);
+}
@@ -0,0 +1,239 @@
+#include "VulkanMemory.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    bool memory_block_matches(const ise::rendering::MemoryBlock& block, uint32_t memory_type, ise::rendering::MemoryUsage usage, ise::rendering::MemoryResourceKind resource_kind)
+    {
+        return !block.dedicated && block.memory_type == memory_type && block.usage == usage && block.resource_kind == resource_kind;
+    }
+
+    // Returns the offset inside block or INVALID_OFFSET when it has no room
+    VkDeviceSize memory_block_allocate(ise::rendering::MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment)
+    {
+        if (block.usage == ise::rendering::MEMORY_USAGE_LONG_LIVED)
+        {
+            return block.ranges.allocate(size, alignment);
+        }
+
+        VkDeviceSize offset = (block.linear_offset + alignment - 1) / alignment * alignment;
+        if (offset + size > block.size)
+        {
+            return ise::util::RangeAllocator::INVALID_OFFSET;
+        }
+
+        block.linear_offset = offset + size;
+        return offset;
+    }
+
+    ise::rendering::MemoryBlock* memory_create_block(ise::rendering::MemoryAllocator& allocator, VkDeviceSize size, uint32_t memory_type, ise::rendering::MemoryUsage usage, ise::rendering::MemoryResourceKind resource_kind, bool dedicated)
+    {
+        auto block = std::make_unique<ise::rendering::MemoryBlock>();
+        block->size = size;
+        block->memory_type = memory_type;
+        block->usage = usage;
+        block->resource_kind = resource_kind;
+        block->dedicated = dedicated;
+        block->ranges.grow(size);
+
+        VkMemoryAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = size;
+        alloc_info.memoryTypeIndex = memory_type;
+
+        if (vkAllocateMemory(allocator.device, &alloc_info, nullptr, &block->memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate device memory block!");
+        }
+
+        if (allocator.memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(allocator.device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS)
+            {
+                vkFreeMemory(allocator.device, block->memory, nullptr);
+                throw std::runtime_error("failed to map device memory block!");
+            }
+        }
+
+        allocator.blocks.push_back(std::move(block));
+        return allocator.blocks.back().get();
+    }
+
+    void memory_destroy_block(ise::rendering::MemoryAllocator& allocator, ise::rendering::MemoryBlock* block)
+    {
+        if (block->mapped != nullptr)
+        {
+            vkUnmapMemory(allocator.device, block->memory);
+        }
+        vkFreeMemory(allocator.device, block->memory, nullptr);
+
+        std::erase_if(allocator.blocks, [block](const std::unique_ptr<ise::rendering::MemoryBlock>& other) { return other.get() == block; });
+    }
+}
+
+void ise::rendering::memory_allocator_create(MemoryAllocator& allocator, VkPhysicalDevice physical_device, VkDevice device, VkDeviceSize block_size)
+{
+    allocator.device = device;
+    allocator.block_size = block_size;
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &allocator.memory_properties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    allocator.buffer_image_granularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+}
+
+void ise::rendering::memory_allocator_destroy(MemoryAllocator& allocator)
+{
+    std::lock_guard<std::mutex> lock(allocator.mutex);
+
+    for (const std::unique_ptr<MemoryBlock>& block : allocator.blocks)
+    {
+        if (block->mapped != nullptr)
+        {
+            vkUnmapMemory(allocator.device, block->memory);
+        }
+        vkFreeMemory(allocator.device, block->memory, nullptr);
+    }
+    allocator.blocks.clear();
+}
+
+uint32_t ise::rendering::memory_find_type(const MemoryAllocator& allocator, uint32_t type_filter, VkMemoryPropertyFlags properties)
+{
+    for (uint32_t i = 0; i < allocator.memory_properties.memoryTypeCount; i++)
+    {
+        if ((type_filter & (1 << i)) && (allocator.memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+ise::rendering::MemoryAllocation ise::rendering::memory_allocate(MemoryAllocator& allocator, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, MemoryUsage usage, MemoryResourceKind resource_kind)
+{
+    std::lock_guard<std::mutex> lock(allocator.mutex);
+
+    uint32_t memory_type = memory_find_type(allocator, requirements.memoryTypeBits, properties);
+    if (allocator.buffer_image_granularity <= 1)
+    {
+        resource_kind = MEMORY_RESOURCE_LINEAR;
+    }
+
+    // Small heaps, e.g. the host visible device local one, should not be taken up by a single block
+    uint32_t heap_index = allocator.memory_properties.memoryTypes[memory_type].heapIndex;
+    VkDeviceSize block_size = std::min(allocator.block_size, allocator.memory_properties.memoryHeaps[heap_index].size / 8);
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+    MemoryBlock* block = nullptr;
+    VkDeviceSize offset = ise::util::RangeAllocator::INVALID_OFFSET;
+    if (requirements.size > block_size / 2)
+    {
+        block = memory_create_block(allocator, requirements.size, memory_type, usage, resource_kind, true);
+        offset = memory_block_allocate(*block, requirements.size, alignment);
+    }
+    else
+    {
+        for (const std::unique_ptr<MemoryBlock>& candidate : allocator.blocks)
+        {
+            if (memory_block_matches(*candidate, memory_type, usage, resource_kind))
+            {
+                offset = memory_block_allocate(*candidate, requirements.size, alignment);
+                if (offset != ise::util::RangeAllocator::INVALID_OFFSET)
+                {
+                    block = candidate.get();
+                    break;
+                }
+            }
+        }
+
+        if (block == nullptr)
+        {
+            block = memory_create_block(allocator, block_size, memory_type, usage, resource_kind, false);
+            offset = memory_block_allocate(*block, requirements.size, alignment);
+        }
+    }
+
+    block->allocation_count++;
+
+    MemoryAllocation allocation;
+    allocation.block = block;
+    allocation.memory = block->memory;
+    allocation.offset = offset;
+    allocation.size = requirements.size;
+    allocation.mapped = block->mapped != nullptr ? static_cast<char*>(block->mapped) + offset : nullptr;
+    return allocation;
+}
+
+void ise::rendering::memory_free(MemoryAllocator& allocator, MemoryAllocation& allocation)
+{
+    if (allocation.block == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(allocator.mutex);
+
+    MemoryBlock* block = allocation.block;
+    block->allocation_count--;
+    if (block->usage == MEMORY_USAGE_LONG_LIVED)
+    {
+        block->ranges.free(allocation.offset, allocation.size);
+    }
+    else if (block->allocation_count == 0)
+    {
+        block->linear_offset = 0;
+    }
+
+    allocation = MemoryAllocation{};
+
+    if (block->allocation_count > 0)
+    {
+        return;
+    }
+
+    bool keep_block = !block->dedicated && std::none_of(allocator.blocks.begin(), allocator.blocks.end(), [block](const std::unique_ptr<MemoryBlock>& other)
+    {
+        return other.get() != block && memory_block_matches(*other, block->memory_type, block->usage, block->resource_kind) && other->allocation_count == 0;
+    });
+
+    if (!keep_block)
+    {
+        memory_destroy_block(allocator, block);
+    }
+}
+
+ise::rendering::MemoryStatistics ise::rendering::memory_get_statistics(MemoryAllocator& allocator)
+{
+    std::lock_guard<std::mutex> lock(allocator.mutex);
+
+    MemoryStatistics statistics;
+    VkDeviceSize free_bytes = 0;
+    for (const std::unique_ptr<MemoryBlock>& block : allocator.blocks)
+    {
+        statistics.block_count++;
+        statistics.dedicated_block_count += block->dedicated ? 1 : 0;
+        statistics.allocation_count += block->allocation_count;
+        statistics.bytes_reserved += block->size;
+
+        if (block->usage == MEMORY_USAGE_LONG_LIVED)
+        {
+            statistics.bytes_used += block->ranges.used();
+            if (!block->dedicated)
+            {
+                free_bytes += block->size - block->ranges.used();
+                statistics.free_range_count += static_cast<uint32_t>(block->ranges.free_range_count());
+                statistics.largest_free_range = std::max(statistics.largest_free_range, block->ranges.largest_free_range());
+            }
+        }
+        else
+        {
+            statistics.bytes_used += block->linear_offset;
+        }
+    }
+
+    statistics.fragmentation = free_bytes > 0 ? 1.0f - float(statistics.largest_free_range) / float(free_bytes) : 0.0f;
+    return statistics;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "../util/RangeAllocator.hpp"
+
+namespace ise
+{
+    namespace rendering
+    {
+        // Size of the VkDeviceMemory blocks resources are suballocated from, capped at an eighth of small heaps
+        const VkDeviceSize MEMORY_DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+        typedef enum MemoryUsage
+        {
+            // Best fit over a free list, for buffers and images living across frames
+            MEMORY_USAGE_LONG_LIVED = 0,
+            // Bump allocated, a block starts over once everything in it was freed. For staging buffers freed right after their copy.
+            MEMORY_USAGE_TRANSIENT = 1
+        } MemoryUsage;
+
+        // Linear resources and optimally tiled images may not share a bufferImageGranularity page,
+        // so when the device has a granularity above 1 they are kept in separate blocks
+        typedef enum MemoryResourceKind
+        {
+            MEMORY_RESOURCE_LINEAR = 0, // buffers and linearly tiled images
+            MEMORY_RESOURCE_OPTIMAL = 1
+        } MemoryResourceKind;
+
+        struct MemoryBlock
+        {
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkDeviceSize size = 0;
+            void* mapped = nullptr; // whole block, persistently mapped when host visible
+            uint32_t memory_type = 0;
+            MemoryUsage usage = MEMORY_USAGE_LONG_LIVED;
+            MemoryResourceKind resource_kind = MEMORY_RESOURCE_LINEAR;
+            bool dedicated = false; // holds a single allocation too large to share a block
+            uint32_t allocation_count = 0;
+
+            ise::util::RangeAllocator ranges; // MEMORY_USAGE_LONG_LIVED
+            VkDeviceSize linear_offset = 0; // MEMORY_USAGE_TRANSIENT
+        };
+
+        struct MemoryAllocation
+        {
+            MemoryBlock* block = nullptr;
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;
+            // Points at offset inside the block's mapping, nullptr unless host visible. Only host coherent memory is
+            // ever requested, so writes need no flush.
+            void* mapped = nullptr;
+        };
+
+        struct MemoryStatistics
+        {
+            uint32_t block_count = 0; // every block is one vkAllocateMemory
+            uint32_t dedicated_block_count = 0;
+            uint32_t allocation_count = 0;
+            VkDeviceSize bytes_reserved = 0; // sum of the block sizes
+            VkDeviceSize bytes_used = 0;
+            uint32_t free_range_count = 0;
+            VkDeviceSize largest_free_range = 0;
+            // 1 - largest free range / free bytes over the long lived blocks, 0 when all free space is one range
+            float fragmentation = 0.0f;
+        };
+
+        struct MemoryAllocator
+        {
+            VkDevice device = VK_NULL_HANDLE;
+            VkPhysicalDeviceMemoryProperties memory_properties{};
+            VkDeviceSize buffer_image_granularity = 1;
+            VkDeviceSize block_size = MEMORY_DEFAULT_BLOCK_SIZE;
+
+            std::vector<std::unique_ptr<MemoryBlock>> blocks;
+            // Resources are created from loader threads as well
+            std::mutex mutex;
+        };
+
+        void memory_allocator_create(MemoryAllocator& allocator, VkPhysicalDevice physical_device, VkDevice device, VkDeviceSize block_size = MEMORY_DEFAULT_BLOCK_SIZE);
+        // Every allocation must have been freed already
+        void memory_allocator_destroy(MemoryAllocator& allocator);
+
+        uint32_t memory_find_type(const MemoryAllocator& allocator, uint32_t type_filter, VkMemoryPropertyFlags properties);
+
+        // Allocations above half a block get a dedicated VkDeviceMemory, everything else shares blocks of the same
+        // memory type, usage and resource kind. A new block is only allocated when none of those has room.
+        MemoryAllocation memory_allocate(MemoryAllocator& allocator, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, MemoryUsage usage, MemoryResourceKind resource_kind);
+        // Empty blocks are released, except the last one of their kind, so a steady stream of staging buffers does not
+        // allocate and free a block every time
+        void memory_free(MemoryAllocator& allocator, MemoryAllocation& allocation);
+
+        MemoryStatistics memory_get_statistics(MemoryAllocator& allocator);
+    }
+}
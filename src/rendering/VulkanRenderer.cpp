@@ -1,6 +1,8 @@
 #include "VulkanRenderer.h"
 
+#include <cctype>
 #include <chrono>
+#include <filesystem>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_Vulkan.h>
 
@@ -14,6 +16,10 @@ ise::rendering::VulkanRenderer::VulkanRenderer()
     this->m_finished = SDL_CreateCond();
     this->m_render_thread = NULL;
 
+    // Heavy scenes lower the resolution instead of the frame rate
+    this->m_data.custom_config.min_render_scale = 0.5f;
+    this->m_data.custom_config.target_gpu_frame_time_ms = 1000.0f / this->m_max_frames_per_second;
+
     this->sdl_create_window();
     this->sdl_get_instance_extensions();
 
@@ -28,14 +34,22 @@ ise::rendering::VulkanRenderer::VulkanRenderer()
     vulkan_create_descriptor_set_layout(this->m_data);
     vulkan_create_graphics_pipeline(this->m_data);
     vulkan_create_command_pool(this->m_data);
+    vulkan_create_upload_queue(this->m_data);
+    vulkan_create_staging_ring(this->m_data);
+    vulkan_create_recording_workers(this->m_data);
+    vulkan_create_render_target(this->m_data);
     vulkan_create_color_resources(this->m_data);
     vulkan_create_depth_resources(this->m_data);
     vulkan_create_framebuffers(this->m_data);
     vulkan_create_uniform_buffers(this->m_data);
     vulkan_create_descriptor_pool(this->m_data);
     vulkan_create_uniform_buffers_descriptor_sets(this->m_data);
+    vulkan_create_bindless_textures(this->m_data);
     vulkan_create_command_buffers(this->m_data);
     vulkan_create_sync_objects(this->m_data);
+    vulkan_create_gpu_culling_resources(this->m_data);
+    vulkan_create_virtual_texturing_resources(this->m_data);
+    vulkan_create_dynamic_resolution_resources(this->m_data);
 
     const std::string MODEL_PATH = "C:/Users/caous/Downloads/viking_room.obj";
     const std::string TEXTURE_PATH = "C:/Users/caous/Downloads/viking_room.png";
@@ -76,12 +90,19 @@ void ise::rendering::VulkanRenderer::stop()
 }
 
 void ise::rendering::VulkanRenderer::recreate_renderer()
+{
+    this->recreate_renderer(this->get_config());
+}
+
+void ise::rendering::VulkanRenderer::recreate_renderer(const VulkanRendererConfig& config)
 {
     this->stop();
     SDL_WaitThread(this->m_render_thread, NULL);
 
     SDL_DestroyWindow(this->m_window);
 
+    this->m_data.custom_config = config;
+
     this->m_already_started = false;
     this->m_accepting_new_draw_call = false;
 
@@ -99,14 +120,22 @@ void ise::rendering::VulkanRenderer::recreate_renderer()
     vulkan_create_descriptor_set_layout(this->m_data);
     vulkan_create_graphics_pipeline(this->m_data);
     vulkan_create_command_pool(this->m_data);
+    vulkan_create_upload_queue(this->m_data);
+    vulkan_create_staging_ring(this->m_data);
+    vulkan_create_recording_workers(this->m_data);
+    vulkan_create_render_target(this->m_data);
     vulkan_create_color_resources(this->m_data);
     vulkan_create_depth_resources(this->m_data);
     vulkan_create_framebuffers(this->m_data);
     vulkan_create_uniform_buffers(this->m_data);
     vulkan_create_descriptor_pool(this->m_data);
     vulkan_create_uniform_buffers_descriptor_sets(this->m_data);
+    vulkan_create_bindless_textures(this->m_data);
     vulkan_create_command_buffers(this->m_data);
     vulkan_create_sync_objects(this->m_data);
+    vulkan_create_gpu_culling_resources(this->m_data);
+    vulkan_create_virtual_texturing_resources(this->m_data);
+    vulkan_create_dynamic_resolution_resources(this->m_data);
 
     const std::string MODEL_PATH = "C:/Users/caous/Downloads/viking_room.obj";
     const std::string TEXTURE_PATH = "C:/Users/caous/Downloads/viking_room.png";
@@ -116,6 +145,20 @@ void ise::rendering::VulkanRenderer::recreate_renderer()
     this->start();
 }
 
+void ise::rendering::VulkanRenderer::reconfigure(const VulkanRendererConfig& config)
+{
+    if (!vulkan_reconfigure(this->m_data, config))
+    {
+        this->recreate_renderer(config);
+    }
+}
+
+ise::rendering::VulkanRendererConfig ise::rendering::VulkanRenderer::get_config()
+{
+    std::lock_guard<std::mutex> lock(this->m_data.mutex);
+    return this->m_data.custom_config;
+}
+
 bool ise::rendering::VulkanRenderer::windows_match(SDL_Window* window)
 {
     return window == this->m_window;
@@ -128,47 +171,45 @@ void ise::rendering::VulkanRenderer::load_obj_with_texture(std::string obj_path,
     render_object->type = OBJ_WITH_STATIC_TEXTURE;
     render_object2->type = OBJ_WITH_STATIC_TEXTURE;
 
-    std::string warn, err;
-    if (!tinyobj::LoadObj(&render_object->geometry.attrib, &render_object->geometry.shapes, &render_object->geometry.materials, &warn, &err, obj_path.c_str()))
-    {
-        throw std::runtime_error(warn + err);
-    }
-
-    if (!tinyobj::LoadObj(&render_object2->geometry.attrib, &render_object2->geometry.shapes, &render_object2->geometry.materials, &warn, &err, obj_path.c_str()))
-    {
-        throw std::runtime_error(warn + err);
-    }
-
-    RenderTexture* render_texture = vulkan_create_render_texture("test_texture", this->m_data);
-
-    render_texture->raw_texture.pixels = stbi_load(
-        texture_path.c_str(),
-        &render_texture->raw_texture.width,
-        &render_texture->raw_texture.height,
-        &render_texture->raw_texture.channels,
-        STBI_rgb_alpha);
+    // Both objects share one copy of the geometry and only differ by their transform
+    const Mesh* mesh = vulkan_load_mesh(this->m_data, obj_path);
 
-    if (!render_texture->raw_texture.pixels)
-    {
-        throw std::runtime_error("failed to load texture image!");
-    }
-
-    vulkan_create_texture_image(this->m_data, *render_texture);
-    vulkan_create_texture_sampler(this->m_data, *render_texture);
+    // Decoded on a worker thread and uploaded by the render loop, both objects show the placeholder until then
+    vulkan_load_texture_async(this->m_data, "test_texture", texture_path);
 
     render_object->textures.push_back("test_texture");
     render_object2->textures.push_back("test_texture");
 
     vulkan_create_textures_description_set(this->m_data, *render_object);
     vulkan_create_textures_description_set(this->m_data, *render_object2);
-    vulkan_load_model_geometry(this->m_data, *render_object, { 0.0f, 0.0f, 0.0f });
-    vulkan_load_model_geometry(this->m_data, *render_object2, { 0.1f, 1.0f, -0.1f });
+    vulkan_set_render_object_mesh(this->m_data, *render_object, mesh);
+    vulkan_set_render_object_mesh(this->m_data, *render_object2, mesh);
+    vulkan_set_render_object_transform(this->m_data, *render_object2, glm::translate(glm::mat4(1.0f), glm::vec3(0.1f, 1.0f, -0.1f)));
+}
 
-    stbi_image_free(render_texture->raw_texture.pixels);
+std::vector<ise::rendering::TextureLoadHandle> ise::rendering::VulkanRenderer::load_texture_folder(std::string folder_path)
+{
+    std::vector<TextureLoadHandle> loads;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(folder_path))
+    {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (!entry.is_regular_file() || (extension != ".png" && extension != ".jpg" && extension != ".jpeg" && extension != ".tga" && extension != ".bmp"))
+        {
+            continue;
+        }
+
+        // Returns right away, decoding is spread over custom_config.texture_decode_threads
+        std::string path = entry.path().string();
+        loads.push_back(vulkan_load_texture_async(this->m_data, path, path));
+    }
+
+    return loads;
 }
 
 void ise::rendering::VulkanRenderer::handle_window_resize()
 {
+    this->sdl_update_window_size();
     this->m_data.force_recreate_swapchain = true;
 }
 
@@ -199,6 +240,15 @@ void ise::rendering::VulkanRenderer::sdl_get_instance_extensions()
 void ise::rendering::VulkanRenderer::sdl_create_surface()
 {
     handle_sdl_bool(SDL_Vulkan_CreateSurface(this->m_window, this->m_data.instance, &this->m_data.surface));
+    this->sdl_update_window_size();
+}
+
+void ise::rendering::VulkanRenderer::sdl_update_window_size()
+{
+    int width, height;
+    SDL_Vulkan_GetDrawableSize(this->m_window, &width, &height);
+    this->m_data.window_width = static_cast<uint32_t>(std::max(width, 0));
+    this->m_data.window_height = static_cast<uint32_t>(std::max(height, 0));
 }
 
 void ise::rendering::VulkanRenderer::handle_sdl_bool(SDL_bool sdl_bool)
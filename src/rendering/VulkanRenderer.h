@@ -17,11 +17,17 @@ namespace ise
             void start();
             void stop();
             void recreate_renderer();
+            void recreate_renderer(const VulkanRendererConfig& config);
+            // Keeps the device and every asset when vulkan_reconfigure can apply config, recreates the renderer otherwise
+            void reconfigure(const VulkanRendererConfig& config);
+            VulkanRendererConfig get_config();
 
             bool windows_match(SDL_Window* window);
             void handle_window_resize();
 
             void load_obj_with_texture(std::string obj_path, std::string texture_path);
+            // Every image in the folder is registered under its path right away and becomes resident in the background
+            std::vector<TextureLoadHandle> load_texture_folder(std::string folder_path);
         private:
             int m_max_frames_per_second = 90;
             std::atomic<bool> m_accepting_new_draw_call = false;
@@ -35,6 +41,7 @@ namespace ise
             void sdl_create_window();
             void sdl_get_instance_extensions();
             void sdl_create_surface();
+            void sdl_update_window_size();
             void handle_sdl_bool(SDL_bool sdl_bool);
             void handle_sdl_int(int result);
 
@@ -16,6 +16,9 @@
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
+#include <sstream>
+#include <filesystem>
+#include <atomic>
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -28,16 +31,144 @@
 #endif
 
 #include <vulkan/vulkan.h>
+#include <glm/gtc/packing.hpp>
 #define VKRH vulkan_handle_vk_result;
 
 #include "../util/FileReader.h"
+#include "../util/FlatHashMap.hpp"
+#include "../util/Hash.hpp"
+#include "MeshCache.h"
+#include "PipelineCache.h"
+#include "EmbeddedShaders.h"
 
-namespace std {
-    template<> struct hash<ise::rendering::Vertex> {
-        size_t operator()(ise::rendering::Vertex const& vertex) const {
-            return ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.tex_coord) << 1);
+namespace
+{
+    // Vertices are deduplicated by their exact bytes. Unlike operator== this keeps 0.0 and -0.0 apart and lets
+    // identical NaNs match, either way the result is a valid, if slightly less deduplicated, mesh.
+    struct VertexBytesHash
+    {
+        size_t operator()(const ise::rendering::Vertex& vertex) const
+        {
+            return static_cast<size_t>(ise::util::hash_bytes(&vertex, sizeof(vertex)));
+        }
+    };
+
+    struct VertexBytesEqual
+    {
+        bool operator()(const ise::rendering::Vertex& a, const ise::rendering::Vertex& b) const
+        {
+            return memcmp(&a, &b, sizeof(a)) == 0;
         }
     };
+
+    static_assert(sizeof(ise::rendering::Vertex) == 8 * sizeof(float), "Vertex must not contain padding, it is hashed bytewise");
+
+    typedef ise::util::FlatHashMap<ise::rendering::Vertex, uint32_t, VertexBytesHash, VertexBytesEqual> VertexIndexMap;
+
+    // A run of consecutive shape indices, deduplicated on its own before the ordered merge
+    struct MeshBuildChunk
+    {
+        size_t shape;
+        size_t first;
+        size_t count;
+        size_t first_output_index;
+        std::vector<ise::rendering::Vertex> unique_vertices;
+        std::vector<uint32_t> local_indices;
+        std::vector<uint32_t> remap;
+        glm::vec3 bounds_min;
+        glm::vec3 bounds_max;
+    };
+
+    // Multiple of 3 so a chunk never splits a triangle, large enough that the per chunk maps stay worth it
+    constexpr size_t MESH_BUILD_CHUNK_INDICES = 3 * 32768;
+
+    // What a swapchain recreation replaced while frames in flight still use it
+    struct SwapChainRelease
+    {
+        VkSwapchainKHR swap_chain = VK_NULL_HANDLE; // owns its images
+        std::vector<VkImage> offscreen_images; // headless only
+        std::vector<ise::rendering::MemoryAllocation> offscreen_images_memory;
+        std::vector<VkImageView> image_views;
+        std::vector<VkFramebuffer> framebuffers;
+        VkImage color_image = VK_NULL_HANDLE; // only with msaa
+        VkImageView color_image_view = VK_NULL_HANDLE;
+        ise::rendering::MemoryAllocation color_image_memory{};
+        VkImage depth_image = VK_NULL_HANDLE;
+        VkImageView depth_image_view = VK_NULL_HANDLE;
+        ise::rendering::MemoryAllocation depth_image_memory{};
+        std::vector<VkCommandBuffer> command_buffers;
+        std::vector<std::vector<VkCommandBuffer>> secondary_command_buffers; // one list per recording worker
+        std::vector<ise::rendering::InstanceBuffer> instance_buffers;
+        VkImage render_target = VK_NULL_HANDLE; // only with dynamic resolution
+        VkImageView render_target_view = VK_NULL_HANDLE;
+        ise::rendering::MemoryAllocation render_target_memory{};
+    };
+
+    void swap_chain_release_destroy(ise::rendering::VulkanRendererData& renderer, SwapChainRelease& release)
+    {
+        if (!release.command_buffers.empty())
+        {
+            vkFreeCommandBuffers(renderer.device, renderer.command_pool, static_cast<uint32_t>(release.command_buffers.size()), release.command_buffers.data());
+        }
+
+        // Recording workers are only replaced with the device idle, after the deletion queue was flushed
+        for (size_t i = 0; i < release.secondary_command_buffers.size(); i++)
+        {
+            const std::vector<VkCommandBuffer>& secondary_command_buffers = release.secondary_command_buffers[i];
+            if (!secondary_command_buffers.empty())
+            {
+                vkFreeCommandBuffers(renderer.device, renderer.recording_workers[i].command_pool, static_cast<uint32_t>(secondary_command_buffers.size()), secondary_command_buffers.data());
+            }
+        }
+
+        for (ise::rendering::InstanceBuffer& instance_buffer : release.instance_buffers)
+        {
+            if (instance_buffer.capacity > 0)
+            {
+                vkDestroyBuffer(renderer.device, instance_buffer.buffer, nullptr);
+                ise::rendering::vulkan_free_memory(renderer, instance_buffer.memory);
+            }
+        }
+
+        for (VkFramebuffer framebuffer : release.framebuffers)
+        {
+            vkDestroyFramebuffer(renderer.device, framebuffer, nullptr);
+        }
+
+        for (VkImageView image_view : release.image_views)
+        {
+            vkDestroyImageView(renderer.device, image_view, nullptr);
+        }
+
+        if (release.color_image != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(renderer.device, release.color_image_view, nullptr);
+            vkDestroyImage(renderer.device, release.color_image, nullptr);
+            ise::rendering::vulkan_free_memory(renderer, release.color_image_memory);
+        }
+
+        if (release.render_target != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(renderer.device, release.render_target_view, nullptr);
+            vkDestroyImage(renderer.device, release.render_target, nullptr);
+            ise::rendering::vulkan_free_memory(renderer, release.render_target_memory);
+        }
+
+        vkDestroyImageView(renderer.device, release.depth_image_view, nullptr);
+        vkDestroyImage(renderer.device, release.depth_image, nullptr);
+        ise::rendering::vulkan_free_memory(renderer, release.depth_image_memory);
+
+        for (size_t i = 0; i < release.offscreen_images.size(); i++)
+        {
+            vkDestroyImage(renderer.device, release.offscreen_images[i], nullptr);
+            ise::rendering::vulkan_free_memory(renderer, release.offscreen_images_memory[i]);
+        }
+
+        if (release.swap_chain != VK_NULL_HANDLE)
+        {
+            vkDestroySwapchainKHR(renderer.device, release.swap_chain, nullptr);
+        }
+    }
 }
 
 void ise::rendering::vulkan_create_instance(VulkanRendererData& renderer)
@@ -53,7 +184,8 @@ void ise::rendering::vulkan_create_instance(VulkanRendererData& renderer)
     app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.pEngineName = "No Engine";
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_API_VERSION_1_0;
+    // 1.2 for timeline semaphores, which uploads rely on, and drawIndirectCount
+    app_info.apiVersion = VK_API_VERSION_1_2;
 
     VkInstanceCreateInfo create_info{};
     create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -133,6 +265,7 @@ void ise::rendering::vulkan_pick_physical_device(VulkanRendererData& renderer)
         if (vulkan_is_device_suitable(device, renderer))
         {
             renderer.physical_device = device;
+            vkGetPhysicalDeviceProperties(device, &renderer.physical_device_properties);
             renderer.msaa_samples = vulkan_get_max_usable_sample_count(renderer);
             break;
         }
@@ -149,7 +282,7 @@ void ise::rendering::vulkan_create_logical_device(VulkanRendererData& renderer)
     QueueFamilyIndices indices = vulkan_find_queue_families(renderer.physical_device, renderer);
 
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-    std::set<uint32_t> unique_queue_families = { indices.graphics_family.value(), indices.present_family.value() };
+    std::set<uint32_t> unique_queue_families = { indices.graphics_family.value(), indices.present_family.value(), indices.transfer_family.value() };
 
     float queue_priority = 1.0f;
     for (uint32_t queue_family : unique_queue_families)
@@ -176,13 +309,41 @@ void ise::rendering::vulkan_create_logical_device(VulkanRendererData& renderer)
     VkDeviceCreateInfo create_info{};
     create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
+    VkPhysicalDeviceVulkan12Features vulkan12_features{};
+    vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12_features.timelineSemaphore = VK_TRUE;
+    // Every texture is sampled from one update after bind array, see VulkanBindlessTextures.cpp
+    vulkan12_features.descriptorIndexing = VK_TRUE;
+    vulkan12_features.runtimeDescriptorArray = VK_TRUE;
+    vulkan12_features.descriptorBindingPartiallyBound = VK_TRUE;
+    vulkan12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    vulkan12_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    vulkan12_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    create_info.pNext = &vulkan12_features;
+
+    renderer.compressed_texture_format = vulkan_pick_compressed_texture_format(renderer);
+    device_features.textureCompressionBC = renderer.compressed_texture_format != VK_FORMAT_UNDEFINED ? VK_TRUE : VK_FALSE;
+
+    // Virtual textures write their feedback from the fragment shader
+    renderer.virtual_texturing.supported = vulkan_check_virtual_texturing_support(renderer);
+    device_features.fragmentStoresAndAtomics = renderer.virtual_texturing.supported ? VK_TRUE : VK_FALSE;
+
+    renderer.gpu_culling.enabled = renderer.custom_config.gpu_driven_culling && vulkan_check_gpu_driven_culling_support(renderer.physical_device);
+    if (renderer.gpu_culling.enabled)
+    {
+        device_features.multiDrawIndirect = VK_TRUE;
+        device_features.drawIndirectFirstInstance = VK_TRUE;
+        vulkan12_features.drawIndirectCount = VK_TRUE;
+    }
+
     create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
     create_info.pQueueCreateInfos = queue_create_infos.data();
 
     create_info.pEnabledFeatures = &device_features;
 
-    create_info.enabledExtensionCount = static_cast<uint32_t>(renderer.device_extensions.size());
-    create_info.ppEnabledExtensionNames = renderer.device_extensions.data();
+    std::vector<const char*> device_extensions = vulkan_get_required_device_extensions(renderer);
+    create_info.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
+    create_info.ppEnabledExtensionNames = device_extensions.data();
 
     if (renderer.custom_config.enable_validation_layers)
     {
@@ -201,15 +362,25 @@ void ise::rendering::vulkan_create_logical_device(VulkanRendererData& renderer)
 
     vkGetDeviceQueue(renderer.device, indices.graphics_family.value(), 0, &renderer.graphics_queue);
     vkGetDeviceQueue(renderer.device, indices.present_family.value(), 0, &renderer.present_queue);
+    vkGetDeviceQueue(renderer.device, indices.transfer_family.value(), 0, &renderer.transfer_queue);
+
+    memory_allocator_create(renderer.memory_allocator, renderer.physical_device, renderer.device);
+    vulkan_create_pipeline_cache(renderer);
 }
 
 void ise::rendering::vulkan_create_swap_chain(VulkanRendererData& renderer)
 {
+    if (renderer.custom_config.headless)
+    {
+        vulkan_create_offscreen_images(renderer);
+        return;
+    }
+
     SwapChainSupportDetails swap_chain_support = vulkan_query_swap_chain_support(renderer.physical_device, renderer);
 
     VkSurfaceFormatKHR surface_format = vulkan_choose_swap_surface_format(swap_chain_support.formats);
     VkPresentModeKHR present_mode = vulkan_choose_swap_present_mode(swap_chain_support.present_modes, renderer);
-    VkExtent2D extent = swap_chain_support.capabilities.currentExtent;
+    VkExtent2D extent = vulkan_choose_swap_extent(swap_chain_support.capabilities, renderer);
 
     uint32_t image_count = swap_chain_support.capabilities.minImageCount + 1;
     if (swap_chain_support.capabilities.maxImageCount > 0 && image_count > swap_chain_support.capabilities.maxImageCount)
@@ -227,6 +398,11 @@ void ise::rendering::vulkan_create_swap_chain(VulkanRendererData& renderer)
     create_info.imageExtent = extent;
     create_info.imageArrayLayers = 1;
     create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // Blit target of the render target, see vulkan_check_dynamic_resolution_support
+    if (vulkan_get_min_render_scale(renderer.custom_config) < 1.0f && (swap_chain_support.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+    {
+        create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
 
     QueueFamilyIndices indices = vulkan_find_queue_families(renderer.physical_device, renderer);
     uint32_t queue_family_indices[] = { indices.graphics_family.value(), indices.present_family.value() };
@@ -246,6 +422,8 @@ void ise::rendering::vulkan_create_swap_chain(VulkanRendererData& renderer)
     create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     create_info.presentMode = present_mode;
     create_info.clipped = VK_TRUE;
+    // Lets the presentation engine hand resources over, the old one is destroyed once its frames finished
+    create_info.oldSwapchain = renderer.swap_chain;
 
     if (vkCreateSwapchainKHR(renderer.device, &create_info, nullptr, &renderer.swap_chain) != VK_SUCCESS)
     {
@@ -272,6 +450,10 @@ void ise::rendering::vulkan_create_image_views(VulkanRendererData& renderer)
 
 void ise::rendering::vulkan_create_render_pass(VulkanRendererData& renderer)
 {
+    // The pass ends in the render target instead of the swapchain image, which is blitted to afterwards
+    renderer.dynamic_resolution.enabled = vulkan_check_dynamic_resolution_support(renderer);
+    VkImageLayout output_layout = renderer.dynamic_resolution.enabled ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : vulkan_get_presentable_image_layout(renderer);
+
     VkAttachmentDescription color_attachment{};
     color_attachment.format = renderer.swap_chain_image_format;
     color_attachment.samples = renderer.msaa_samples;
@@ -282,7 +464,7 @@ void ise::rendering::vulkan_create_render_pass(VulkanRendererData& renderer)
     color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     if (renderer.msaa_samples & VK_SAMPLE_COUNT_1_BIT)
     {
-        color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        color_attachment.finalLayout = output_layout;
     }
     else
     {
@@ -312,7 +494,7 @@ void ise::rendering::vulkan_create_render_pass(VulkanRendererData& renderer)
     color_attachment_resolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color_attachment_resolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     color_attachment_resolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment_resolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    color_attachment_resolve.finalLayout = output_layout;
 
     VkAttachmentReference color_attachment_ref{};
     color_attachment_ref.attachment = 0;
@@ -344,6 +526,27 @@ void ise::rendering::vulkan_create_render_pass(VulkanRendererData& renderer)
     dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
     dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+    std::vector<VkSubpassDependency> dependencies;
+    if (renderer.dynamic_resolution.enabled)
+    {
+        // The render target is overwritten only after the blit of the previous frame read it
+        dependency.srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies.push_back(dependency);
+
+        VkSubpassDependency blit_dependency{};
+        blit_dependency.srcSubpass = 0;
+        blit_dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+        blit_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        blit_dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        blit_dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        blit_dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        dependencies.push_back(blit_dependency);
+    }
+    else
+    {
+        dependencies.push_back(dependency);
+    }
+
     std::vector<VkAttachmentDescription> attachments;
     attachments.push_back(color_attachment);
     attachments.push_back(depth_attachment);
@@ -358,8 +561,8 @@ void ise::rendering::vulkan_create_render_pass(VulkanRendererData& renderer)
     render_pass_info.pAttachments = attachments.data();
     render_pass_info.subpassCount = 1;
     render_pass_info.pSubpasses = &subpass;
-    render_pass_info.dependencyCount = 1;
-    render_pass_info.pDependencies = &dependency;
+    render_pass_info.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    render_pass_info.pDependencies = dependencies.data();
 
     if (vkCreateRenderPass(renderer.device, &render_pass_info, nullptr, &renderer.render_pass) != VK_SUCCESS)
     {
@@ -369,16 +572,13 @@ void ise::rendering::vulkan_create_render_pass(VulkanRendererData& renderer)
 
 void ise::rendering::vulkan_create_descriptor_set_layout(VulkanRendererData& renderer)
 {
-    VkPhysicalDeviceProperties physical_device_properties;
-    vkGetPhysicalDeviceProperties(renderer.physical_device, &physical_device_properties);
-
     std::vector<VkDescriptorSetLayoutBinding> bindings;
     VkDescriptorSetLayoutBinding ubo_layout_binding{};
     ubo_layout_binding.binding = 0;
     ubo_layout_binding.descriptorCount = 1;
     ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     ubo_layout_binding.pImmutableSamplers = nullptr;
-    ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
     bindings.push_back(ubo_layout_binding);
 
     VkDescriptorSetLayoutCreateInfo layout_info_uniform_buffers{};
@@ -391,33 +591,60 @@ void ise::rendering::vulkan_create_descriptor_set_layout(VulkanRendererData& ren
         throw std::runtime_error("failed to create descriptor set layout for uniform buffers!");
     }
 
+    // Every texture in one array. Slots are written while frames using other slots are in flight, and most are never written.
+    renderer.bindless_textures.capacity = vulkan_get_bindless_texture_capacity(renderer);
+
     bindings.clear();
     VkDescriptorSetLayoutBinding sampler_layout_binding{};
     sampler_layout_binding.binding = 0;
-    sampler_layout_binding.descriptorCount = 1;
+    sampler_layout_binding.descriptorCount = renderer.bindless_textures.capacity;
     sampler_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     sampler_layout_binding.pImmutableSamplers = nullptr;
     sampler_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
     bindings.push_back(sampler_layout_binding);
 
+    VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+    binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    binding_flags_info.bindingCount = 1;
+    binding_flags_info.pBindingFlags = &binding_flags;
+
     VkDescriptorSetLayoutCreateInfo layout_info_textures{};
     layout_info_textures.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info_textures.pNext = &binding_flags_info;
+    layout_info_textures.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
     layout_info_textures.bindingCount = static_cast<uint32_t>(bindings.size());
     layout_info_textures.pBindings = bindings.data();
 
     if (vkCreateDescriptorSetLayout(renderer.device, &layout_info_textures, nullptr, &renderer.descriptor_set_layout_textures) != VK_SUCCESS)
     {
-        throw std::runtime_error("failed to create descriptor set layout for uniform buffers!");
+        throw std::runtime_error("failed to create descriptor set layout for textures!");
     }
 }
 
 void ise::rendering::vulkan_create_graphics_pipeline(VulkanRendererData& renderer)
 {
-    auto vert_code = ise::util::readFile(std::string(STRINGIFY(VULKAN_SHADER_DIR)) + "/vert.spv");
-    auto frag_code = ise::util::readFile(std::string(STRINGIFY(VULKAN_SHADER_DIR)) + "/frag.spv");
+    std::vector<VkDescriptorSetLayout> descriptor_set_layouts;
+    descriptor_set_layouts.push_back(renderer.descriptor_set_layout_uniform_buffers);
+    descriptor_set_layouts.push_back(renderer.descriptor_set_layout_textures);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = descriptor_set_layouts.size();
+    pipeline_layout_info.pSetLayouts = descriptor_set_layouts.data();
+
+    if (vkCreatePipelineLayout(renderer.device, &pipeline_layout_info, nullptr, &renderer.pipeline_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    renderer.graphics_pipeline = vulkan_create_graphics_pipeline_from_shaders(renderer, vulkan_get_vertex_shader_file(renderer.custom_config.vertex_format, "vert"), "frag.spv", renderer.pipeline_layout, true);
+}
 
-    VkShaderModule vert_shader_module = vulkan_create_shader_module(renderer, vert_code);
-    VkShaderModule frag_shader_module = vulkan_create_shader_module(renderer, frag_code);
+VkPipeline ise::rendering::vulkan_create_graphics_pipeline_from_shaders(VulkanRendererData& renderer, const std::string& vertex_shader, const std::string& fragment_shader, VkPipelineLayout pipeline_layout, bool instance_binding)
+{
+    VkShaderModule vert_shader_module = vulkan_create_shader_module(renderer, vertex_shader);
+    VkShaderModule frag_shader_module = vulkan_create_shader_module(renderer, fragment_shader);
 
     VkPipelineShaderStageCreateInfo vert_shader_stage_info{};
     vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -436,12 +663,20 @@ void ise::rendering::vulkan_create_graphics_pipeline(VulkanRendererData& rendere
     VkPipelineVertexInputStateCreateInfo vertex_input_info{};
     vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-    auto binding_description = Vertex::get_binding_description();
-    auto attribute_descriptions = Vertex::get_attribute_descriptions();
+    std::vector<VkVertexInputBindingDescription> binding_descriptions = { vulkan_get_vertex_binding_description(renderer.custom_config.vertex_format) };
+    std::vector<VkVertexInputAttributeDescription> attribute_descriptions = vulkan_get_vertex_attribute_descriptions(renderer.custom_config.vertex_format);
+
+    // Instance transforms come in through a second binding, see InstanceData
+    if (instance_binding)
+    {
+        binding_descriptions.push_back(InstanceData::get_binding_description());
+        auto instance_attribute_descriptions = InstanceData::get_attribute_descriptions();
+        attribute_descriptions.insert(attribute_descriptions.end(), instance_attribute_descriptions.begin(), instance_attribute_descriptions.end());
+    }
 
-    vertex_input_info.vertexBindingDescriptionCount = 1;
+    vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(binding_descriptions.size());
     vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
-    vertex_input_info.pVertexBindingDescriptions = &binding_description;
+    vertex_input_info.pVertexBindingDescriptions = binding_descriptions.data();
     vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
 
     VkPipelineInputAssemblyStateCreateInfo input_assembly{};
@@ -501,20 +736,6 @@ void ise::rendering::vulkan_create_graphics_pipeline(VulkanRendererData& rendere
     dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
     dynamic_state.pDynamicStates = dynamic_states.data();
 
-    std::vector<VkDescriptorSetLayout> descriptor_set_layouts;
-    descriptor_set_layouts.push_back(renderer.descriptor_set_layout_uniform_buffers);
-    descriptor_set_layouts.push_back(renderer.descriptor_set_layout_textures);
-
-    VkPipelineLayoutCreateInfo pipeline_layout_info{};
-    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_info.setLayoutCount = descriptor_set_layouts.size();
-    pipeline_layout_info.pSetLayouts = descriptor_set_layouts.data();
-
-    if (vkCreatePipelineLayout(renderer.device, &pipeline_layout_info, nullptr, &renderer.pipeline_layout) != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
-
     VkGraphicsPipelineCreateInfo pipeline_info{};
     pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipeline_info.stageCount = 2;
@@ -527,18 +748,72 @@ void ise::rendering::vulkan_create_graphics_pipeline(VulkanRendererData& rendere
     pipeline_info.pDepthStencilState = &depth_stencil;
     pipeline_info.pColorBlendState = &color_blending;
     pipeline_info.pDynamicState = &dynamic_state;
-    pipeline_info.layout = renderer.pipeline_layout;
+    pipeline_info.layout = pipeline_layout;
     pipeline_info.renderPass = renderer.render_pass;
     pipeline_info.subpass = 0;
     pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(renderer.device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &renderer.graphics_pipeline) != VK_SUCCESS)
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(renderer.device, renderer.pipeline_cache, 1, &pipeline_info, nullptr, &pipeline) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
     vkDestroyShaderModule(renderer.device, frag_shader_module, nullptr);
     vkDestroyShaderModule(renderer.device, vert_shader_module, nullptr);
+
+    return pipeline;
+}
+
+void ise::rendering::vulkan_create_pipeline_cache(VulkanRendererData& renderer)
+{
+    // A cache of another device or driver, or a damaged one, is dropped and the pipelines are compiled from scratch
+    PipelineCacheView view;
+    bool cached = !renderer.custom_config.pipeline_cache_path.empty() &&
+        pipeline_cache_open(renderer.custom_config.pipeline_cache_path, renderer.physical_device_properties, view);
+
+    VkPipelineCacheCreateInfo cache_info{};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.initialDataSize = cached ? view.data_size : 0;
+    cache_info.pInitialData = cached ? view.data : nullptr;
+
+    if (vkCreatePipelineCache(renderer.device, &cache_info, nullptr, &renderer.pipeline_cache) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+bool ise::rendering::vulkan_save_pipeline_cache(VulkanRendererData& renderer)
+{
+    if (renderer.custom_config.pipeline_cache_path.empty() || renderer.pipeline_cache == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    // Returns false rather than throwing, vulkan_destroy_pipeline_cache still has to destroy the cache
+    size_t data_size = 0;
+    if (vkGetPipelineCacheData(renderer.device, renderer.pipeline_cache, &data_size, nullptr) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    std::vector<char> data(data_size);
+    if (vkGetPipelineCacheData(renderer.device, renderer.pipeline_cache, &data_size, data.data()) != VK_SUCCESS)
+    {
+        return false;
+    }
+    data.resize(data_size);
+
+    return pipeline_cache_write(renderer.custom_config.pipeline_cache_path, renderer.physical_device_properties, data);
+}
+
+void ise::rendering::vulkan_destroy_pipeline_cache(VulkanRendererData& renderer)
+{
+    // Best effort, the next launch just compiles again
+    vulkan_save_pipeline_cache(renderer);
+
+    vkDestroyPipelineCache(renderer.device, renderer.pipeline_cache, nullptr);
+    renderer.pipeline_cache = VK_NULL_HANDLE;
 }
 
 void ise::rendering::vulkan_create_command_pool(VulkanRendererData& renderer)
@@ -556,6 +831,34 @@ void ise::rendering::vulkan_create_command_pool(VulkanRendererData& renderer)
     }
 }
 
+void ise::rendering::vulkan_create_recording_workers(VulkanRendererData& renderer)
+{
+    uint32_t thread_count = renderer.custom_config.recording_threads;
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    QueueFamilyIndices queue_family_indices = vulkan_find_queue_families(renderer.physical_device, renderer);
+
+    // Command pools are externally synchronized, so every worker thread gets its own
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_info.queueFamilyIndex = queue_family_indices.graphics_family.value();
+
+    renderer.recording_workers.resize(thread_count);
+    for (RecordingWorker& worker : renderer.recording_workers)
+    {
+        if (vkCreateCommandPool(renderer.device, &pool_info, nullptr, &worker.command_pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create recording command pool!");
+        }
+    }
+
+    renderer.recording_thread_pool = std::make_unique<ise::util::ThreadPool>(thread_count);
+}
+
 void ise::rendering::vulkan_create_color_resources(VulkanRendererData& renderer)
 {
     if (renderer.msaa_samples & VK_SAMPLE_COUNT_1_BIT)
@@ -564,11 +867,12 @@ void ise::rendering::vulkan_create_color_resources(VulkanRendererData& renderer)
     }
 
     VkFormat color_format = renderer.swap_chain_image_format;
+    VkExtent2D extent = vulkan_get_framebuffer_extent(renderer);
 
     vulkan_create_image(
         renderer,
-        renderer.swap_chain_extent.width,
-        renderer.swap_chain_extent.height,
+        extent.width,
+        extent.height,
         1,
         renderer.msaa_samples,
         color_format,
@@ -594,11 +898,12 @@ void ise::rendering::vulkan_create_depth_resources(VulkanRendererData& renderer)
         VK_IMAGE_TILING_OPTIMAL,
         VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
     );
+    VkExtent2D extent = vulkan_get_framebuffer_extent(renderer);
 
     vulkan_create_image(
         renderer,
-        renderer.swap_chain_extent.width,
-        renderer.swap_chain_extent.height,
+        extent.width,
+        extent.height,
         1,
         renderer.msaa_samples,
         depth_format,
@@ -619,21 +924,24 @@ void ise::rendering::vulkan_create_depth_resources(VulkanRendererData& renderer)
 void ise::rendering::vulkan_create_framebuffers(VulkanRendererData& renderer)
 {
     renderer.swap_chain_framebuffers.resize(renderer.swap_chain_image_views.size());
+    VkExtent2D extent = vulkan_get_framebuffer_extent(renderer);
 
     for (size_t i = 0; i < renderer.swap_chain_image_views.size(); i++)
     {
         std::vector<VkImageView> attachments;
+        // With dynamic resolution every framebuffer renders into the same render target
+        VkImageView output_view = renderer.dynamic_resolution.enabled ? renderer.dynamic_resolution.image_view : renderer.swap_chain_image_views[i];
 
         if (renderer.msaa_samples & VK_SAMPLE_COUNT_1_BIT)
         {
-            attachments.push_back(renderer.swap_chain_image_views[i]);
+            attachments.push_back(output_view);
             attachments.push_back(renderer.depth_image_view);
         }
         else
         {
             attachments.push_back(renderer.color_image_view);
             attachments.push_back(renderer.depth_image_view);
-            attachments.push_back(renderer.swap_chain_image_views[i]);
+            attachments.push_back(output_view);
         }
         
 
@@ -642,8 +950,8 @@ void ise::rendering::vulkan_create_framebuffers(VulkanRendererData& renderer)
         framebuffer_info.renderPass = renderer.render_pass;
         framebuffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
         framebuffer_info.pAttachments = attachments.data();
-        framebuffer_info.width = renderer.swap_chain_extent.width;
-        framebuffer_info.height = renderer.swap_chain_extent.height;
+        framebuffer_info.width = extent.width;
+        framebuffer_info.height = extent.height;
         framebuffer_info.layers = 1;
 
         if (vkCreateFramebuffer(renderer.device, &framebuffer_info, nullptr, &renderer.swap_chain_framebuffers[i]) != VK_SUCCESS)
@@ -664,24 +972,22 @@ void ise::rendering::vulkan_create_uniform_buffers(VulkanRendererData& renderer)
     for (size_t i = 0; i < renderer.custom_config.max_frames_in_flight; i++)
     {
         vulkan_create_buffer(renderer, buffer_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, renderer.uniform_buffers[i], renderer.uniform_buffers_memory[i]);
-
-        VKRH(vkMapMemory(renderer.device, renderer.uniform_buffers_memory[i], 0, buffer_size, 0, &renderer.uniform_buffers_mapped[i]));
+        renderer.uniform_buffers_mapped[i] = renderer.uniform_buffers_memory[i].mapped;
     }
 }
 
 void ise::rendering::vulkan_create_descriptor_pool(VulkanRendererData& renderer)
 {
-    std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+    // Only the uniform buffer sets, textures have their own pool, see vulkan_create_bindless_textures
+    std::array<VkDescriptorPoolSize, 1> pool_sizes{};
     pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     pool_sizes[0].descriptorCount = static_cast<uint32_t>(renderer.custom_config.max_frames_in_flight);
-    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    pool_sizes[1].descriptorCount = 65536;
 
     VkDescriptorPoolCreateInfo pool_info{};
     pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
     pool_info.pPoolSizes = pool_sizes.data();
-    pool_info.maxSets = 65536;
+    pool_info.maxSets = static_cast<uint32_t>(renderer.custom_config.max_frames_in_flight);
 
     if (vkCreateDescriptorPool(renderer.device, &pool_info, nullptr, &renderer.descriptor_pool) != VK_SUCCESS)
     {
@@ -727,7 +1033,11 @@ void ise::rendering::vulkan_create_uniform_buffers_descriptor_sets(VulkanRendere
 
 void ise::rendering::vulkan_create_command_buffers(VulkanRendererData& renderer)
 {
-    renderer.command_buffers.resize(renderer.custom_config.max_frames_in_flight);
+    // The UBO descriptor set depends on the frame in flight and the framebuffer on the image, so both are part of the key
+    renderer.command_buffers.resize(renderer.custom_config.max_frames_in_flight * renderer.swap_chain_images.size());
+    renderer.command_buffers_scene_generation.assign(renderer.command_buffers.size(), 0);
+    renderer.command_buffers_visibility_generation.assign(renderer.command_buffers.size(), 0);
+    renderer.instance_buffers.resize(renderer.command_buffers.size());
 
     VkCommandBufferAllocateInfo alloc_info{};
     alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -739,6 +1049,22 @@ void ise::rendering::vulkan_create_command_buffers(VulkanRendererData& renderer)
     {
         throw std::runtime_error("failed to allocate command buffers!");
     }
+
+    for (RecordingWorker& worker : renderer.recording_workers)
+    {
+        worker.secondary_command_buffers.resize(renderer.command_buffers.size());
+
+        VkCommandBufferAllocateInfo secondary_alloc_info{};
+        secondary_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        secondary_alloc_info.commandPool = worker.command_pool;
+        secondary_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        secondary_alloc_info.commandBufferCount = (uint32_t)worker.secondary_command_buffers.size();
+
+        if (vkAllocateCommandBuffers(renderer.device, &secondary_alloc_info, worker.secondary_command_buffers.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate secondary command buffers!");
+        }
+    }
 }
 
 ise::rendering::RenderTexture* ise::rendering::vulkan_create_render_texture(std::string key, VulkanRendererData& renderer)
@@ -765,64 +1091,120 @@ bool ise::rendering::vulkan_destroy_render_texture_unsafe(std::string key, Vulka
 
     RenderTexture* render_texture = renderer.render_textures[key];
     renderer.render_textures.erase(key);
+    vulkan_invalidate_recorded_command_buffers(renderer);
 
-    vkDestroySampler(renderer.device, render_texture->sampler, nullptr);
-    vkDestroyImageView(renderer.device, render_texture->image_view, nullptr);
+    vulkan_cancel_texture_loads(renderer, key);
 
-    vkDestroyImage(renderer.device, render_texture->image, nullptr);
-    vkFreeMemory(renderer.device, render_texture->image_memory, nullptr);
+    // Objects sampling it fall back to the placeholder, its slot is reused once the frames in flight finished
+    vulkan_release_bindless_texture(renderer, *render_texture);
+    vulkan_update_texture_users(renderer, key);
+
+    // A placeholder has nothing of its own, the pending image belongs to the cancelled load.
+    // Frames in flight and its upload, which may not even be submitted yet, still use the image.
+    if (!render_texture->placeholder)
+    {
+        vulkan_defer_destroy(renderer, [texture = *render_texture](VulkanRendererData& renderer) mutable { vulkan_destroy_render_texture_image_unsafe(renderer, texture); });
+    }
 
     delete render_texture;
 
     return true;
 }
 
+void ise::rendering::vulkan_destroy_render_texture_image_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture)
+{
+    vulkan_destroy_texture_sampler_unsafe(renderer, render_texture);
+    vkDestroyImageView(renderer.device, render_texture.image_view, nullptr);
+
+    vkDestroyImage(renderer.device, render_texture.image, nullptr);
+    vulkan_free_memory(renderer, render_texture.image_memory);
+
+    render_texture = RenderTexture{};
+}
+
 ise::rendering::RenderObject* ise::rendering::vulkan_create_render_object(VulkanRendererData& renderer)
 {
     std::lock_guard<std::mutex> lock(renderer.mutex);
 
     RenderObject* render_object = new RenderObject;
     renderer.render_objects.push_back(render_object);
+    vulkan_invalidate_recorded_command_buffers(renderer);
     return render_object;
 }
 
 void ise::rendering::vulkan_create_texture_image(VulkanRendererData& renderer, RenderTexture& render_texture)
 {
     std::lock_guard<std::mutex> lock(renderer.mutex);
+    vulkan_create_texture_image_unsafe(renderer, render_texture);
+}
 
-    VkDeviceSize image_size = render_texture.raw_texture.width * render_texture.raw_texture.height * 4;
+void ise::rendering::vulkan_create_texture_image_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture)
+{
     render_texture.mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(render_texture.raw_texture.width, render_texture.raw_texture.height)))) + 1;
 
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-    vulkan_create_buffer(renderer, image_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
-
-    void* data;
-    VKRH(vkMapMemory(renderer.device, staging_buffer_memory, 0, image_size, 0, &data));
-    memcpy(data, render_texture.raw_texture.pixels, static_cast<size_t>(image_size));
-    vkUnmapMemory(renderer.device, staging_buffer_memory);
-
     vulkan_create_image(renderer, render_texture.raw_texture.width, render_texture.raw_texture.height, render_texture.mip_levels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, render_texture.image, render_texture.image_memory);
 
-    vulkan_transition_image_layout(renderer, render_texture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, render_texture.mip_levels);
-    vulkan_copy_buffer_to_image(renderer, staging_buffer, render_texture.image, static_cast<uint32_t>(render_texture.raw_texture.width), static_cast<uint32_t>(render_texture.raw_texture.height));
+    // Copied on the transfer queue, the blits generating the mipmaps need the graphics queue
+    vulkan_transition_image_layout(renderer, vulkan_get_upload_transfer_commands(renderer), render_texture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, render_texture.mip_levels);
+    vulkan_upload_image_data(renderer, render_texture.image, 0, static_cast<uint32_t>(render_texture.raw_texture.width), static_cast<uint32_t>(render_texture.raw_texture.height), VK_FORMAT_R8G8B8A8_SRGB, render_texture.raw_texture.pixels);
+    vulkan_transfer_image_ownership(renderer, render_texture.image, render_texture.mip_levels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
     //transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
 
-    vkDestroyBuffer(renderer.device, staging_buffer, nullptr);
-    vkFreeMemory(renderer.device, staging_buffer_memory, nullptr);
-
-    vulkan_generate_mipmaps(renderer, render_texture.image, VK_FORMAT_R8G8B8A8_SRGB, render_texture.raw_texture.width, render_texture.raw_texture.height, render_texture.mip_levels);
+    vulkan_generate_mipmaps(renderer, vulkan_get_upload_graphics_commands(renderer), render_texture.image, VK_FORMAT_R8G8B8A8_SRGB, render_texture.raw_texture.width, render_texture.raw_texture.height, render_texture.mip_levels);
 
     render_texture.image_view = vulkan_create_image_view(renderer, render_texture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, render_texture.mip_levels);
 }
 
+void ise::rendering::vulkan_create_compressed_texture_image_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture, const CompressedTexture& texture)
+{
+    render_texture.mip_levels = static_cast<uint32_t>(texture.levels.size());
+    render_texture.raw_texture.width = static_cast<int>(texture.width);
+    render_texture.raw_texture.height = static_cast<int>(texture.height);
+    render_texture.raw_texture.channels = 4;
+    render_texture.raw_texture.pixels = nullptr;
+
+    vulkan_create_image(renderer, texture.width, texture.height, render_texture.mip_levels, VK_SAMPLE_COUNT_1_BIT, texture.format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, render_texture.image, render_texture.image_memory);
+
+    // Everything happens on the transfer queue, the graphics queue only acquires the finished image
+    vulkan_transition_image_layout(renderer, vulkan_get_upload_transfer_commands(renderer), render_texture.image, texture.format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, render_texture.mip_levels);
+    for (uint32_t i = 0; i < render_texture.mip_levels; i++)
+    {
+        const CompressedTextureLevel& level = texture.levels[i];
+        vulkan_upload_image_data(renderer, render_texture.image, i, level.width, level.height, texture.format, texture.data.data() + level.offset);
+    }
+    vulkan_transfer_image_ownership(renderer, render_texture.image, render_texture.mip_levels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    render_texture.image_view = vulkan_create_image_view(renderer, render_texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, render_texture.mip_levels);
+}
+
 void ise::rendering::vulkan_create_texture_sampler(VulkanRendererData& renderer, RenderTexture& render_texture)
 {
     std::lock_guard<std::mutex> lock(renderer.mutex);
+    vulkan_create_texture_sampler_unsafe(renderer, render_texture);
+}
+
+void ise::rendering::vulkan_create_texture_sampler_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture)
+{
+    VkSamplerCreateInfo sampler_info = vulkan_get_texture_sampler_info(renderer);
+    uint64_t key = vulkan_get_texture_sampler_key(sampler_info);
 
-    VkPhysicalDeviceProperties properties{};
-    vkGetPhysicalDeviceProperties(renderer.physical_device, &properties);
+    auto it = renderer.texture_samplers.find(key);
+    if (it == renderer.texture_samplers.end())
+    {
+        TextureSampler texture_sampler{};
+        if (vkCreateSampler(renderer.device, &sampler_info, nullptr, &texture_sampler.sampler) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create texture sampler!");
+        }
+        it = renderer.texture_samplers.emplace(key, texture_sampler).first;
+    }
 
+    it->second.reference_count++;
+    render_texture.sampler = it->second.sampler;
+}
+
+VkSamplerCreateInfo ise::rendering::vulkan_get_texture_sampler_info(VulkanRendererData& renderer)
+{
     VkSamplerCreateInfo sampler_info{};
     sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
     switch (renderer.custom_config.texture_filtering)
@@ -855,7 +1237,7 @@ void ise::rendering::vulkan_create_texture_sampler(VulkanRendererData& renderer,
         sampler_info.maxAnisotropy = std::clamp(
             renderer.custom_config.max_anisotropy,
             1.0f,
-            properties.limits.maxSamplerAnisotropy);
+            renderer.physical_device_properties.limits.maxSamplerAnisotropy);
     }
     sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     sampler_info.unnormalizedCoordinates = VK_FALSE;
@@ -870,113 +1252,339 @@ void ise::rendering::vulkan_create_texture_sampler(VulkanRendererData& renderer,
     {
         sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
     }
+    // The image view already ends at the last level, so one sampler serves every mip count
     sampler_info.minLod = 0.0f;
-    sampler_info.maxLod = static_cast<float>(render_texture.mip_levels);
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
     sampler_info.mipLodBias = 0.0f;
 
-    if (vkCreateSampler(renderer.device, &sampler_info, nullptr, &render_texture.sampler) != VK_SUCCESS)
+    return sampler_info;
+}
+
+uint64_t ise::rendering::vulkan_get_texture_sampler_key(const VkSamplerCreateInfo& sampler_info)
+{
+    // Only what vulkan_get_texture_sampler_info varies, the key is exact so the map never mixes two states up
+    uint32_t max_anisotropy = 0;
+    if (sampler_info.anisotropyEnable)
     {
-        throw std::runtime_error("failed to create texture sampler!");
+        std::memcpy(&max_anisotropy, &sampler_info.maxAnisotropy, sizeof(max_anisotropy));
     }
+
+    return (static_cast<uint64_t>(sampler_info.magFilter) & 0xFF) |
+        ((static_cast<uint64_t>(sampler_info.minFilter) & 0xFF) << 8) |
+        ((static_cast<uint64_t>(sampler_info.mipmapMode) & 0xFF) << 16) |
+        (static_cast<uint64_t>(max_anisotropy) << 32);
 }
 
-void ise::rendering::vulkan_create_textures_description_set(VulkanRendererData& renderer, RenderObject& render_object)
+void ise::rendering::vulkan_destroy_texture_sampler_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture)
 {
-    std::lock_guard<std::mutex> lock(renderer.mutex);
+    // Few entries, one per filtering setup in use
+    for (auto it = renderer.texture_samplers.begin(); it != renderer.texture_samplers.end(); ++it)
+    {
+        if (it->second.sampler != render_texture.sampler)
+        {
+            continue;
+        }
 
-    VkPhysicalDeviceProperties physical_device_properties;
-    vkGetPhysicalDeviceProperties(renderer.physical_device, &physical_device_properties);
+        if (--it->second.reference_count == 0)
+        {
+            vkDestroySampler(renderer.device, it->second.sampler, nullptr);
+            renderer.texture_samplers.erase(it);
+        }
+        break;
+    }
 
-    if (render_object.textures.size() > physical_device_properties.limits.maxPerStageDescriptorSamplers)
+    render_texture.sampler = VK_NULL_HANDLE;
+}
+
+void ise::rendering::vulkan_destroy_texture_samplers(VulkanRendererData& renderer)
+{
+    for (auto& entry : renderer.texture_samplers)
     {
-        throw std::runtime_error(std::format("Too many textures. Textures: {0} Limit: {1}", render_object.textures.size(), physical_device_properties.limits.maxPerStageDescriptorSamplers));
+        vkDestroySampler(renderer.device, entry.second.sampler, nullptr);
     }
+    renderer.texture_samplers.clear();
+}
 
-    VkDescriptorSetAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    alloc_info.descriptorPool = renderer.descriptor_pool;
-    alloc_info.descriptorSetCount = 1;
-    alloc_info.pSetLayouts = &renderer.descriptor_set_layout_textures;
+void ise::rendering::vulkan_recreate_texture_samplers_unsafe(VulkanRendererData& renderer)
+{
+    // Takes the new sampler before dropping the old one, so a sampler both setups share is never destroyed in between
+    auto replace_sampler = [&renderer](RenderTexture& render_texture)
+    {
+        RenderTexture old_texture{};
+        old_texture.sampler = render_texture.sampler;
+        vulkan_create_texture_sampler_unsafe(renderer, render_texture);
+        vulkan_destroy_texture_sampler_unsafe(renderer, old_texture);
+    };
 
-    if (vkAllocateDescriptorSets(renderer.device, &alloc_info, &render_object.texture_description_set) != VK_SUCCESS)
+    auto update_texture = [&renderer, &replace_sampler](RenderTexture& render_texture)
     {
-        throw std::runtime_error("failed to allocate descriptor sets!");
-    }
+        replace_sampler(render_texture);
+        if (render_texture.bindless_index != BINDLESS_TEXTURE_NONE)
+        {
+            vulkan_write_bindless_texture(renderer, render_texture);
+        }
+    };
 
-    std::vector<VkWriteDescriptorSet> descriptor_writes;
-    for (size_t i = 0; i < render_object.textures.size(); i++)
+    RenderTexture* placeholder_texture = renderer.placeholder_texture;
+    if (placeholder_texture != nullptr)
     {
-        VkDescriptorImageInfo image_info{};
-        image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        image_info.imageView = renderer.render_textures[render_object.textures[i]]->image_view;
-        image_info.sampler = renderer.render_textures[render_object.textures[i]]->sampler;
+        update_texture(*placeholder_texture);
+    }
 
-        VkWriteDescriptorSet descriptor_write;
-        descriptor_write.pNext = nullptr;
-        descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptor_write.dstSet = render_object.texture_description_set;
-        descriptor_write.dstBinding = i;
-        descriptor_write.dstArrayElement = 0;
-        descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptor_write.descriptorCount = 1;
-        descriptor_write.pImageInfo = &image_info;
+    for (auto& entry : renderer.render_textures)
+    {
+        RenderTexture& render_texture = *entry.second;
+        if (render_texture.placeholder)
+        {
+            // Shares the placeholder's slot, which was just written
+            render_texture.sampler = placeholder_texture->sampler;
+            continue;
+        }
 
-        descriptor_writes.push_back(descriptor_write);
+        update_texture(render_texture);
     }
 
-    vkUpdateDescriptorSets(renderer.device, static_cast<uint32_t>(descriptor_writes.size()), descriptor_writes.data(), 0, nullptr);
+    // Uploading loads own a sampler already, their slot is written once they are resident
+    for (const TextureLoadHandle& load : renderer.texture_loads)
+    {
+        if (load->state == TEXTURE_LOAD_UPLOADING)
+        {
+            replace_sampler(load->texture);
+        }
+    }
 }
 
-void ise::rendering::vulkan_load_model_geometry(VulkanRendererData& renderer, RenderObject& render_object, std::vector<float> offset)
+void ise::rendering::vulkan_create_textures_description_set(VulkanRendererData& renderer, RenderObject& render_object)
 {
     std::lock_guard<std::mutex> lock(renderer.mutex);
 
-    std::unordered_map<Vertex, uint32_t> unique_vertices{};
+    // Back to the texture list, the type is left to the caller
+    render_object.virtual_texture = nullptr;
 
-    for (const auto& shape : render_object.geometry.shapes)
+    // Every object shares the bindless set, draws with different textures can be batched and instanced together
+    render_object.texture_description_set = renderer.bindless_textures.descriptor_set;
+    render_object.texture_description_set_id = 0;
+    render_object.texture_index = 0;
+
+    if (!render_object.textures.empty())
     {
-        for (const auto& index : shape.mesh.indices)
+        auto render_texture = renderer.render_textures.find(render_object.textures[0]);
+        if (render_texture != renderer.render_textures.end())
         {
-            Vertex vertex{};
-
-            vertex.pos = {
-                render_object.geometry.attrib.vertices[3 * index.vertex_index + 0] + offset[0],
-                render_object.geometry.attrib.vertices[3 * index.vertex_index + 1] + offset[1],
-                render_object.geometry.attrib.vertices[3 * index.vertex_index + 2] + offset[2]
-            };
-
-            vertex.tex_coord = {
-                render_object.geometry.attrib.texcoords[2 * index.texcoord_index + 0],
-                1.0f - render_object.geometry.attrib.texcoords[2 * index.texcoord_index + 1]
-            };
-
-            vertex.color = { 1.0f, 1.0f, 1.0f };
-
-            if (unique_vertices.count(vertex) == 0)
-            {
-                unique_vertices[vertex] = static_cast<uint32_t>(renderer.vertices.size());
-                renderer.vertices.push_back(vertex);
-            }
-
-            renderer.indices.push_back(unique_vertices[vertex]);
+            render_object.texture_index = vulkan_register_bindless_texture(renderer, *render_texture->second);
         }
     }
 
-    vulkan_update_index_buffer(renderer);
-    vulkan_update_vertex_buffer(renderer);
+    vulkan_invalidate_recorded_command_buffers(renderer);
 }
 
-void ise::rendering::vulkan_draw_frame(VulkanRendererData& renderer)
+void ise::rendering::vulkan_load_model_geometry(VulkanRendererData& renderer, RenderObject& render_object, std::vector<float> offset)
 {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    glm::vec3 bounds_min, bounds_max;
+    vulkan_build_mesh_data(render_object.geometry, glm::vec3(offset[0], offset[1], offset[2]), vertices, indices, bounds_min, bounds_max, renderer.custom_config.mesh_build_threads);
+    vulkan_optimize_mesh_data(renderer, vertices, indices);
+
     std::lock_guard<std::mutex> lock(renderer.mutex);
 
-    VKRH(vkWaitForFences(renderer.device, 1, &renderer.in_flight_fences[renderer.current_frame], VK_TRUE, UINT64_MAX));
+    // Reloading replaces the ranges the object owns, shared mesh ranges are left alone
+    if (render_object.mesh == nullptr)
+    {
+        vulkan_release_geometry(renderer, render_object.first_vertex, render_object.vertex_count, render_object.first_index, render_object.index_count, render_object.index_type);
+    }
 
-    uint32_t image_index;
-    VkResult result = vkAcquireNextImageKHR(renderer.device, renderer.swap_chain, UINT64_MAX, renderer.image_available_semaphores[renderer.current_frame], VK_NULL_HANDLE, &image_index);
+    Mesh geometry_range{};
+    vulkan_upload_mesh_data(renderer, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()), geometry_range);
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR)
-    {
+    render_object.mesh = nullptr;
+    render_object.first_index = geometry_range.first_index;
+    render_object.index_count = geometry_range.index_count;
+    render_object.first_vertex = geometry_range.first_vertex;
+    render_object.vertex_count = geometry_range.vertex_count;
+    render_object.index_type = geometry_range.index_type;
+    render_object.vertex_offset = geometry_range.vertex_offset;
+    render_object.position_offset = geometry_range.position_offset;
+    render_object.position_scale = geometry_range.position_scale;
+    render_object.bounds_min = bounds_min;
+    render_object.bounds_max = bounds_max;
+
+    vulkan_invalidate_recorded_command_buffers(renderer);
+}
+
+const ise::rendering::Mesh* ise::rendering::vulkan_load_mesh(VulkanRendererData& renderer, const std::string& obj_path)
+{
+    // A valid cache is uploaded straight from its mapping, no parsing and no deduplication
+    const MeshOptimizerOptions* optimizer_options = renderer.custom_config.optimize_meshes ? &renderer.custom_config.mesh_optimizer_options : nullptr;
+    MeshCacheView cache;
+    if (mesh_cache_open(obj_path, optimizer_options, cache))
+    {
+        std::lock_guard<std::mutex> lock(renderer.mutex);
+        return vulkan_create_mesh(renderer, obj_path, cache.header->source_hash,
+            cache.vertices, cache.header->vertex_count, cache.indices, cache.header->index_count,
+            glm::vec3(cache.header->bounds_min[0], cache.header->bounds_min[1], cache.header->bounds_min[2]),
+            glm::vec3(cache.header->bounds_max[0], cache.header->bounds_max[1], cache.header->bounds_max[2]));
+    }
+
+    // Hashing the file is far cheaper than parsing it, so repeated loads of the same asset stop here
+    std::vector<char> obj_data = ise::util::readFile(obj_path);
+    uint64_t content_hash = vulkan_hash_bytes(obj_data.data(), obj_data.size());
+
+    {
+        std::lock_guard<std::mutex> lock(renderer.mutex);
+
+        const Mesh* mesh = vulkan_find_mesh(renderer, obj_path, content_hash);
+        if (mesh != nullptr)
+        {
+            return mesh;
+        }
+    }
+
+    RenderGeometry geometry;
+    std::string warn, err;
+    std::istringstream obj_stream(std::string(obj_data.begin(), obj_data.end()));
+    tinyobj::MaterialFileReader material_reader(std::filesystem::path(obj_path).parent_path().string() + "/");
+    if (!tinyobj::LoadObj(&geometry.attrib, &geometry.shapes, &geometry.materials, &warn, &err, &obj_stream, &material_reader))
+    {
+        throw std::runtime_error(warn + err);
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    glm::vec3 bounds_min, bounds_max;
+    vulkan_build_mesh_data(geometry, glm::vec3(0.0f), vertices, indices, bounds_min, bounds_max, renderer.custom_config.mesh_build_threads);
+
+    vulkan_optimize_mesh_data(renderer, vertices, indices);
+
+    mesh_cache_write(obj_path, content_hash, optimizer_options, vertices, indices, bounds_min, bounds_max);
+
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+    return vulkan_create_mesh(renderer, obj_path, content_hash, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()), bounds_min, bounds_max);
+}
+
+const ise::rendering::Mesh* ise::rendering::vulkan_get_or_create_mesh(VulkanRendererData& renderer, const std::string& source_path, const RenderGeometry& geometry)
+{
+    uint64_t content_hash = vulkan_hash_geometry(geometry);
+
+    {
+        std::lock_guard<std::mutex> lock(renderer.mutex);
+
+        const Mesh* mesh = vulkan_find_mesh(renderer, source_path, content_hash);
+        if (mesh != nullptr)
+        {
+            return mesh;
+        }
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    glm::vec3 bounds_min, bounds_max;
+    vulkan_build_mesh_data(geometry, glm::vec3(0.0f), vertices, indices, bounds_min, bounds_max, renderer.custom_config.mesh_build_threads);
+    vulkan_optimize_mesh_data(renderer, vertices, indices);
+
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+    return vulkan_create_mesh(renderer, source_path, content_hash, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()), bounds_min, bounds_max);
+}
+
+void ise::rendering::vulkan_set_render_object_mesh(VulkanRendererData& renderer, RenderObject& render_object, const Mesh* mesh)
+{
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+
+    if (render_object.mesh == nullptr)
+    {
+        vulkan_release_geometry(renderer, render_object.first_vertex, render_object.vertex_count, render_object.first_index, render_object.index_count, render_object.index_type);
+    }
+
+    render_object.mesh = mesh;
+    render_object.first_index = mesh->first_index;
+    render_object.index_count = mesh->index_count;
+    render_object.first_vertex = mesh->first_vertex;
+    render_object.vertex_count = mesh->vertex_count;
+    render_object.index_type = mesh->index_type;
+    render_object.vertex_offset = mesh->vertex_offset;
+    render_object.position_offset = mesh->position_offset;
+    render_object.position_scale = mesh->position_scale;
+    render_object.bounds_min = mesh->bounds_min;
+    render_object.bounds_max = mesh->bounds_max;
+
+    vulkan_invalidate_recorded_command_buffers(renderer);
+}
+
+bool ise::rendering::vulkan_destroy_mesh(VulkanRendererData& renderer, const Mesh* mesh)
+{
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+    return vulkan_destroy_mesh_unsafe(renderer, mesh);
+}
+
+bool ise::rendering::vulkan_destroy_mesh_unsafe(VulkanRendererData& renderer, const Mesh* mesh)
+{
+    if (mesh == nullptr)
+    {
+        return false;
+    }
+
+    for (const RenderObject* render_object : renderer.render_objects)
+    {
+        if (render_object->mesh == mesh)
+        {
+            return false;
+        }
+    }
+
+    auto it = renderer.meshes.find(vulkan_get_mesh_key(mesh->source_path, mesh->content_hash));
+    if (it == renderer.meshes.end() || it->second != mesh)
+    {
+        return false;
+    }
+    renderer.meshes.erase(it);
+
+    // Command buffers recorded before the last object switched away may still draw it
+    vulkan_release_geometry(renderer, mesh->first_vertex, mesh->vertex_count, mesh->first_index, mesh->index_count, mesh->index_type);
+    delete mesh;
+
+    return true;
+}
+
+void ise::rendering::vulkan_set_render_object_transform(VulkanRendererData& renderer, RenderObject& render_object, const glm::mat4& transform)
+{
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+
+    render_object.transform = transform;
+
+    // Transforms are baked into the recorded instance data and the culling bounds
+    vulkan_invalidate_recorded_command_buffers(renderer);
+}
+
+void ise::rendering::vulkan_draw_frame(VulkanRendererData& renderer)
+{
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+
+    VKRH(vkWaitForFences(renderer.device, 1, &renderer.in_flight_fences[renderer.current_frame], VK_TRUE, UINT64_MAX));
+
+    // The fence belongs to the frame submitted max_frames_in_flight frames ago, everything before it finished as well
+    vulkan_retire_uploads(renderer);
+    vulkan_retire_deletion_queue(renderer);
+    // Before recording, so a new render scale is recorded this frame
+    vulkan_update_dynamic_resolution(renderer);
+    // Before recording, so textures that became resident are drawn this frame
+    vulkan_process_texture_loads(renderer);
+    // Reads the feedback of the frame the fence belonged to and publishes the page table this frame samples
+    vulkan_process_virtual_textures(renderer);
+
+    uint32_t image_index;
+    VkResult result = VK_SUCCESS;
+    if (renderer.custom_config.headless)
+    {
+        // There is one offscreen image per frame in flight, so the fence above already guards it
+        image_index = renderer.current_frame;
+    }
+    else
+    {
+        result = vkAcquireNextImageKHR(renderer.device, renderer.swap_chain, UINT64_MAX, renderer.image_available_semaphores[renderer.current_frame], VK_NULL_HANDLE, &image_index);
+    }
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
         vulkan_recreate_swap_chain(renderer);
         return;
     }
@@ -987,31 +1595,60 @@ void ise::rendering::vulkan_draw_frame(VulkanRendererData& renderer)
 
     vulkan_update_uniform_buffer(renderer, renderer.current_frame);
 
+    if (!renderer.gpu_culling.enabled && renderer.custom_config.cpu_frustum_culling)
+    {
+        vulkan_cull_render_objects(renderer);
+    }
+
     VKRH(vkResetFences(renderer.device, 1, &renderer.in_flight_fences[renderer.current_frame]));
-    VKRH(vkResetCommandBuffer(renderer.command_buffers[renderer.current_frame], /*VkCommandBufferResetFlagBits*/ 0));
 
-    vulkan_record_command_buffer(renderer, renderer.command_buffers[renderer.current_frame], image_index);
+    // The fence above guarantees the previous submission of this command buffer finished, so it can be reused or re-recorded
+    size_t command_buffer_index = renderer.current_frame * renderer.swap_chain_images.size() + image_index;
+    VkCommandBuffer command_buffer = renderer.command_buffers[command_buffer_index];
+    if (renderer.command_buffers_scene_generation[command_buffer_index] != renderer.scene_generation ||
+        renderer.command_buffers_visibility_generation[command_buffer_index] != renderer.visibility_generation)
+    {
+        VKRH(vkResetCommandBuffer(command_buffer, /*VkCommandBufferResetFlagBits*/ 0));
+        vulkan_record_command_buffer(renderer, command_buffer_index, image_index);
+        renderer.command_buffers_scene_generation[command_buffer_index] = renderer.scene_generation;
+        renderer.command_buffers_visibility_generation[command_buffer_index] = renderer.visibility_generation;
+    }
+
+    // Uploads recorded since the last frame go out in one batch. Its graphics part is submitted ahead of this frame,
+    // so the acquire barriers order it before everything the frame reads without the host waiting.
+    vulkan_flush_uploads(renderer);
 
     VkSubmitInfo submit_info{};
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
     VkSemaphore wait_semaphores[] = { renderer.image_available_semaphores[renderer.current_frame] };
     VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submit_info.waitSemaphoreCount = 1;
+    submit_info.waitSemaphoreCount = renderer.custom_config.headless ? 0 : 1;
     submit_info.pWaitSemaphores = wait_semaphores;
     submit_info.pWaitDstStageMask = wait_stages;
 
     submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &renderer.command_buffers[renderer.current_frame];
+    submit_info.pCommandBuffers = &command_buffer;
 
     VkSemaphore signal_semaphores[] = { renderer.render_finished_semaphores[renderer.current_frame] };
-    submit_info.signalSemaphoreCount = 1;
+    submit_info.signalSemaphoreCount = renderer.custom_config.headless ? 0 : 1;
     submit_info.pSignalSemaphores = signal_semaphores;
 
     if (vkQueueSubmit(renderer.graphics_queue, 1, &submit_info, renderer.in_flight_fences[renderer.current_frame]) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
+    if (!renderer.dynamic_resolution.queries_submitted.empty())
+    {
+        renderer.dynamic_resolution.queries_submitted[renderer.current_frame] = true;
+    }
+    renderer.frame_number++;
+
+    if (renderer.custom_config.headless)
+    {
+        renderer.current_frame = (renderer.current_frame + 1) % renderer.custom_config.max_frames_in_flight;
+        return;
+    }
 
     VkPresentInfoKHR present_info{};
     present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1027,7 +1664,7 @@ void ise::rendering::vulkan_draw_frame(VulkanRendererData& renderer)
 
     result = vkQueuePresentKHR(renderer.present_queue, &present_info);
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || renderer.force_recreate_swapchain)
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
     {
         renderer.force_recreate_swapchain = false;
         vulkan_recreate_swap_chain(renderer);
@@ -1036,13 +1673,27 @@ void ise::rendering::vulkan_draw_frame(VulkanRendererData& renderer)
     {
         throw std::runtime_error("failed to present swap chain image!");
     }
+    else if (renderer.force_recreate_swapchain.exchange(false))
+    {
+        // A burst of resize events often ends at the size the swapchain already has
+        VkExtent2D extent = vulkan_get_surface_extent(renderer);
+        if (extent.width != renderer.swap_chain_extent.width || extent.height != renderer.swap_chain_extent.height)
+        {
+            vulkan_recreate_swap_chain(renderer);
+        }
+    }
 
     renderer.current_frame = (renderer.current_frame + 1) % renderer.custom_config.max_frames_in_flight;
 }
 
 void ise::rendering::vulkan_cleanup(VulkanRendererData& renderer)
 {
+    vulkan_finish_uploads(renderer);
     VKRH(vkDeviceWaitIdle(renderer.device));
+    vulkan_flush_deletion_queue(renderer);
+
+    vulkan_destroy_texture_loads(renderer);
+    vulkan_destroy_virtual_texturing_resources(renderer);
 
     vulkan_cleanup_swap_chain(renderer);
 
@@ -1053,22 +1704,23 @@ void ise::rendering::vulkan_cleanup(VulkanRendererData& renderer)
     for (size_t i = 0; i < renderer.custom_config.max_frames_in_flight; i++)
     {
         vkDestroyBuffer(renderer.device, renderer.uniform_buffers[i], nullptr);
-        vkFreeMemory(renderer.device, renderer.uniform_buffers_memory[i], nullptr);
+        vulkan_free_memory(renderer, renderer.uniform_buffers_memory[i]);
     }
 
     vkDestroyDescriptorPool(renderer.device, renderer.descriptor_pool, nullptr);
 
     for (auto render_texture : renderer.render_textures)
     {
-        vkDestroySampler(renderer.device, render_texture.second->sampler, nullptr);
-        vkDestroyImageView(renderer.device, render_texture.second->image_view, nullptr);
-
-        vkDestroyImage(renderer.device, render_texture.second->image, nullptr);
-        vkFreeMemory(renderer.device, render_texture.second->image_memory, nullptr);
+        if (!render_texture.second->placeholder)
+        {
+            vulkan_destroy_render_texture_image_unsafe(renderer, *render_texture.second);
+        }
 
         delete render_texture.second;
     }
     renderer.render_textures.clear();
+    vulkan_destroy_texture_samplers(renderer);
+    vulkan_destroy_bindless_textures(renderer);
 
     for (int i = 0; i < renderer.render_objects.size(); ++i)
     {
@@ -1076,14 +1728,30 @@ void ise::rendering::vulkan_cleanup(VulkanRendererData& renderer)
     }
     renderer.render_objects.clear();
 
+    for (auto mesh : renderer.meshes)
+    {
+        delete mesh.second;
+    }
+    renderer.meshes.clear();
+
     vkDestroyDescriptorSetLayout(renderer.device, renderer.descriptor_set_layout_uniform_buffers, nullptr);
     vkDestroyDescriptorSetLayout(renderer.device, renderer.descriptor_set_layout_textures, nullptr);
 
-    vkDestroyBuffer(renderer.device, renderer.index_buffer, nullptr);
-    vkFreeMemory(renderer.device, renderer.index_buffer_memory, nullptr);
+    if (renderer.index_buffer_capacity > 0)
+    {
+        vkDestroyBuffer(renderer.device, renderer.index_buffer, nullptr);
+        vulkan_free_memory(renderer, renderer.index_buffer_memory);
+    }
+    renderer.index_buffer_capacity = 0;
+    renderer.index_allocator.clear();
 
-    vkDestroyBuffer(renderer.device, renderer.vertex_buffer, nullptr);
-    vkFreeMemory(renderer.device, renderer.vertex_buffer_memory, nullptr);
+    if (renderer.vertex_buffer_capacity > 0)
+    {
+        vkDestroyBuffer(renderer.device, renderer.vertex_buffer, nullptr);
+        vulkan_free_memory(renderer, renderer.vertex_buffer_memory);
+    }
+    renderer.vertex_buffer_capacity = 0;
+    renderer.vertex_allocator.clear();
 
     for (size_t i = 0; i < renderer.custom_config.max_frames_in_flight; i++)
     {
@@ -1092,8 +1760,19 @@ void ise::rendering::vulkan_cleanup(VulkanRendererData& renderer)
         vkDestroyFence(renderer.device, renderer.in_flight_fences[i], nullptr);
     }
 
+    vulkan_destroy_gpu_culling_resources(renderer);
+    vulkan_destroy_dynamic_resolution_resources(renderer);
+    vulkan_destroy_recording_workers(renderer);
     vkDestroyCommandPool(renderer.device, renderer.command_pool, nullptr);
-
+    renderer.command_buffers.clear();
+    renderer.command_buffers_scene_generation.clear();
+    renderer.command_buffers_visibility_generation.clear();
+    vulkan_destroy_instance_buffers(renderer);
+
+    vulkan_destroy_staging_ring(renderer);
+    vulkan_destroy_upload_queue(renderer);
+    vulkan_destroy_pipeline_cache(renderer);
+    memory_allocator_destroy(renderer.memory_allocator);
     vkDestroyDevice(renderer.device, nullptr);
 
     if (renderer.custom_config.enable_validation_layers)
@@ -1105,10 +1784,84 @@ void ise::rendering::vulkan_cleanup(VulkanRendererData& renderer)
         }
     }
 
-    vkDestroySurfaceKHR(renderer.instance, renderer.surface, nullptr);
+    if (!renderer.custom_config.headless)
+    {
+        vkDestroySurfaceKHR(renderer.instance, renderer.surface, nullptr);
+    }
     vkDestroyInstance(renderer.instance, nullptr);
 }
 
+bool ise::rendering::vulkan_reconfigure(VulkanRendererData& renderer, const VulkanRendererConfig& config)
+{
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+
+    if (vulkan_reconfigure_needs_new_device(renderer, config))
+    {
+        return false;
+    }
+
+    // Nothing below may be in use, and the staging ring must be empty before it can be replaced
+    vulkan_finish_uploads(renderer);
+    VKRH(vkDeviceWaitIdle(renderer.device));
+    vulkan_flush_deletion_queue(renderer);
+
+    VulkanRendererConfig old_config = renderer.custom_config;
+    uint64_t old_sampler_key = vulkan_get_texture_sampler_key(vulkan_get_texture_sampler_info(renderer));
+    renderer.custom_config = config;
+
+    VkSampleCountFlagBits msaa_samples = vulkan_get_max_usable_sample_count(renderer);
+    bool msaa_changed = msaa_samples != renderer.msaa_samples;
+    // The render pass ends in the render target or in the swapchain image
+    bool render_pass_changed = msaa_changed || vulkan_check_dynamic_resolution_support(renderer) != renderer.dynamic_resolution.enabled;
+    // The render target is sized by max_render_scale, and the swapchain images need transfer dst to be blitted to
+    bool render_scale_changed = vulkan_get_min_render_scale(config) != vulkan_get_min_render_scale(old_config) ||
+        vulkan_get_max_render_scale(config) != vulkan_get_max_render_scale(old_config);
+    bool swap_chain_changed = render_pass_changed || render_scale_changed ||
+        (!config.headless && config.v_sync != old_config.v_sync) ||
+        (config.headless && (config.headless_width != old_config.headless_width || config.headless_height != old_config.headless_height));
+
+    if (config.recording_threads != old_config.recording_threads)
+    {
+        // The secondary command buffers live in the worker pools
+        vulkan_free_command_buffers(renderer);
+        vulkan_destroy_recording_workers(renderer);
+        vulkan_create_recording_workers(renderer);
+        vulkan_create_command_buffers(renderer);
+    }
+
+    if (swap_chain_changed)
+    {
+        // Still destroys the color image of the old sample count and the render target of the old render pass
+        vulkan_cleanup_swap_chain(renderer);
+
+        if (render_pass_changed)
+        {
+            renderer.msaa_samples = msaa_samples;
+
+            vkDestroyRenderPass(renderer.device, renderer.render_pass, nullptr);
+            vulkan_create_render_pass(renderer);
+            vulkan_recreate_graphics_pipelines(renderer);
+        }
+
+        vulkan_create_swap_chain_resources(renderer);
+    }
+
+    if (vulkan_get_texture_sampler_key(vulkan_get_texture_sampler_info(renderer)) != old_sampler_key)
+    {
+        vulkan_recreate_texture_samplers_unsafe(renderer);
+    }
+
+    if (config.staging_ring_size != old_config.staging_ring_size)
+    {
+        vulkan_destroy_staging_ring(renderer);
+        vulkan_create_staging_ring(renderer);
+    }
+
+    // Culling and projection settings are read by the next recording
+    vulkan_invalidate_recorded_command_buffers(renderer);
+    return true;
+}
+
 bool ise::rendering::vulkan_check_validation_layer_support(VulkanRendererData& renderer)
 {
     uint32_t layer_count;
@@ -1145,8 +1898,8 @@ bool ise::rendering::vulkan_is_device_suitable(VkPhysicalDevice device, VulkanRe
 
     bool extensions_supported = vulkan_check_device_extension_support(device, renderer);
 
-    bool swap_chain_adequate = false;
-    if (extensions_supported)
+    bool swap_chain_adequate = renderer.custom_config.headless;
+    if (extensions_supported && !renderer.custom_config.headless)
     {
         SwapChainSupportDetails swap_chain_support = vulkan_query_swap_chain_support(device, renderer);
         swap_chain_adequate = !swap_chain_support.formats.empty() && !swap_chain_support.present_modes.empty();
@@ -1155,7 +1908,20 @@ bool ise::rendering::vulkan_is_device_suitable(VkPhysicalDevice device, VulkanRe
     VkPhysicalDeviceFeatures supported_features;
     VKRH(vkGetPhysicalDeviceFeatures(device, &supported_features));
 
-    return indices.is_complete() && extensions_supported && swap_chain_adequate && supported_features.samplerAnisotropy;
+    // Upload completion is tracked with timeline semaphores, textures are bindless
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    VkPhysicalDeviceVulkan12Features vulkan12_features{};
+    vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    if (properties.apiVersion >= VK_API_VERSION_1_2)
+    {
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &vulkan12_features;
+        vkGetPhysicalDeviceFeatures2(device, &features);
+    }
+
+    return indices.is_complete() && extensions_supported && swap_chain_adequate && supported_features.samplerAnisotropy && vulkan12_features.timelineSemaphore && vulkan_check_bindless_texture_support(vulkan12_features);
 }
 
 ise::rendering::QueueFamilyIndices ise::rendering::vulkan_find_queue_families(VkPhysicalDevice device, VulkanRendererData& renderer)
@@ -1176,12 +1942,20 @@ ise::rendering::QueueFamilyIndices ise::rendering::vulkan_find_queue_families(Vk
             indices.graphics_family = i;
         }
 
-        VkBool32 present_support = false;
-        VKRH(vkGetPhysicalDeviceSurfaceSupportKHR(device, i, renderer.surface, &present_support));;
-
-        if (present_support)
+        if (renderer.custom_config.headless)
+        {
+            // Nothing is presented, the graphics queue stands in so the rest of the code does not need to care
+            indices.present_family = indices.graphics_family;
+        }
+        else
         {
-            indices.present_family = i;
+            VkBool32 present_support = false;
+            VKRH(vkGetPhysicalDeviceSurfaceSupportKHR(device, i, renderer.surface, &present_support));;
+
+            if (present_support)
+            {
+                indices.present_family = i;
+            }
         }
 
         if (indices.is_complete())
@@ -1192,9 +1966,58 @@ ise::rendering::QueueFamilyIndices ise::rendering::vulkan_find_queue_families(Vk
         i++;
     }
 
+    // Prefer a family without graphics and compute, those usually map to the copy engines
+    indices.transfer_family = indices.graphics_family;
+    if (renderer.custom_config.dedicated_transfer_queue)
+    {
+        int best_score = 0;
+        for (uint32_t family = 0; family < queue_family_count; family++)
+        {
+            VkQueueFlags flags = queue_families[family].queueFlags;
+            if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                continue;
+            }
+
+            int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+            if (score > best_score)
+            {
+                best_score = score;
+                indices.transfer_family = family;
+            }
+        }
+    }
+
     return indices;
 }
 
+VkFormat ise::rendering::vulkan_pick_compressed_texture_format(VulkanRendererData& renderer)
+{
+    if (renderer.custom_config.texture_compression == TEXTURE_COMPRESSION_NONE)
+    {
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(renderer.physical_device, &supported_features);
+    if (!supported_features.textureCompressionBC)
+    {
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    VkFormat format = texture_compression_get_format(renderer.custom_config.texture_compression);
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(renderer.physical_device, format, &format_properties);
+
+    VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    if ((format_properties.optimalTilingFeatures & required_features) != required_features)
+    {
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    return format;
+}
+
 bool ise::rendering::vulkan_check_device_extension_support(VkPhysicalDevice device, VulkanRendererData& renderer)
 {
     uint32_t extension_count;
@@ -1203,7 +2026,8 @@ bool ise::rendering::vulkan_check_device_extension_support(VkPhysicalDevice devi
     std::vector<VkExtensionProperties> available_extensions(extension_count);
     VKRH(vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data()));
 
-    std::set<std::string> required_extensions(renderer.device_extensions.begin(), renderer.device_extensions.end());
+    std::vector<const char*> device_extensions = vulkan_get_required_device_extensions(renderer);
+    std::set<std::string> required_extensions(device_extensions.begin(), device_extensions.end());
 
     for (const auto& extension : available_extensions)
     {
@@ -1213,6 +2037,23 @@ bool ise::rendering::vulkan_check_device_extension_support(VkPhysicalDevice devi
     return required_extensions.empty();
 }
 
+std::vector<const char*> ise::rendering::vulkan_get_required_device_extensions(VulkanRendererData& renderer)
+{
+    std::vector<const char*> extensions;
+
+    for (const char* extension : renderer.device_extensions)
+    {
+        if (renderer.custom_config.headless && strcmp(extension, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0)
+        {
+            continue;
+        }
+
+        extensions.push_back(extension);
+    }
+
+    return extensions;
+}
+
 ise::rendering::SwapChainSupportDetails ise::rendering::vulkan_query_swap_chain_support(VkPhysicalDevice device, VulkanRendererData& renderer)
 {
     SwapChainSupportDetails details;
@@ -1242,8 +2083,7 @@ ise::rendering::SwapChainSupportDetails ise::rendering::vulkan_query_swap_chain_
 
 VkSampleCountFlagBits ise::rendering::vulkan_get_max_usable_sample_count(VulkanRendererData& renderer)
 {
-    VkPhysicalDeviceProperties physical_device_properties;
-    vkGetPhysicalDeviceProperties(renderer.physical_device, &physical_device_properties);
+    const VkPhysicalDeviceProperties& physical_device_properties = renderer.physical_device_properties;
 
     uint32_t acceptable_sample_count = VK_SAMPLE_COUNT_1_BIT;
     uint32_t current_sample_count = VK_SAMPLE_COUNT_1_BIT;
@@ -1306,6 +2146,24 @@ VkPresentModeKHR ise::rendering::vulkan_choose_swap_present_mode(const std::vect
     return VK_PRESENT_MODE_IMMEDIATE_KHR;
 }
 
+VkExtent2D ise::rendering::vulkan_choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities, VulkanRendererData& renderer)
+{
+    if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+    {
+        return capabilities.currentExtent;
+    }
+
+    VkExtent2D extent = { renderer.window_width, renderer.window_height };
+    if (extent.width == 0 || extent.height == 0)
+    {
+        return { 0, 0 };
+    }
+
+    extent.width = std::clamp(extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+    extent.height = std::clamp(extent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+    return extent;
+}
+
 VkImageView ise::rendering::vulkan_create_image_view(VulkanRendererData& renderer, VkImage image, VkFormat format, VkImageAspectFlags aspect_flags, uint32_t mip_levels)
 {
     VkImageViewCreateInfo view_info{};
@@ -1348,12 +2206,27 @@ VkFormat ise::rendering::vulkan_find_supported_format(VulkanRendererData& render
     throw std::runtime_error("failed to find supported format!");
 }
 
-VkShaderModule ise::rendering::vulkan_create_shader_module(VulkanRendererData& renderer, const std::vector<char>& code)
+VkShaderModule ise::rendering::vulkan_create_shader_module(VulkanRendererData& renderer, const std::string& shader_file)
 {
+    const EmbeddedShader* shader = nullptr;
+    for (const EmbeddedShader& embedded_shader : EMBEDDED_SHADERS)
+    {
+        if (shader_file == embedded_shader.name)
+        {
+            shader = &embedded_shader;
+            break;
+        }
+    }
+
+    if (shader == nullptr)
+    {
+        throw std::runtime_error(std::format("failed to find embedded shader {0}!", shader_file));
+    }
+
     VkShaderModuleCreateInfo create_info{};
     create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    create_info.codeSize = code.size();
-    create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    create_info.codeSize = shader->size;
+    create_info.pCode = shader->code;
 
     VkShaderModule shader_module;
     if (vkCreateShaderModule(renderer.device, &create_info, nullptr, &shader_module) != VK_SUCCESS)
@@ -1364,7 +2237,7 @@ VkShaderModule ise::rendering::vulkan_create_shader_module(VulkanRendererData& r
     return shader_module;
 }
 
-void ise::rendering::vulkan_create_image(VulkanRendererData& renderer, uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits num_samples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& image_memory)
+void ise::rendering::vulkan_create_image(VulkanRendererData& renderer, uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits num_samples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& image_memory)
 {
     VkImageCreateInfo image_info{};
     image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -1389,34 +2262,18 @@ void ise::rendering::vulkan_create_image(VulkanRendererData& renderer, uint32_t
     VkMemoryRequirements mem_requirements;
     vkGetImageMemoryRequirements(renderer.device, image, &mem_requirements);
 
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = vulkan_find_memory_type(renderer, mem_requirements.memoryTypeBits, properties);
+    MemoryResourceKind resource_kind = tiling == VK_IMAGE_TILING_OPTIMAL ? MEMORY_RESOURCE_OPTIMAL : MEMORY_RESOURCE_LINEAR;
+    image_memory = memory_allocate(renderer.memory_allocator, mem_requirements, properties, MEMORY_USAGE_LONG_LIVED, resource_kind);
 
-    if (vkAllocateMemory(renderer.device, &alloc_info, nullptr, &image_memory) != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to allocate image memory!");
-    }
-
-    VKRH(vkBindImageMemory(renderer.device, image, image_memory, 0));
+    VKRH(vkBindImageMemory(renderer.device, image, image_memory.memory, image_memory.offset));
 }
 
 uint32_t ise::rendering::vulkan_find_memory_type(VulkanRendererData& renderer, uint32_t type_filter, VkMemoryPropertyFlags properties)
 {
-    VkPhysicalDeviceMemoryProperties mem_properties;
-    vkGetPhysicalDeviceMemoryProperties(renderer.physical_device, &mem_properties);
-
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-        if ((type_filter & (1 << i)) && (mem_properties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-
-    throw std::runtime_error("failed to find suitable memory type!");
+    return memory_find_type(renderer.memory_allocator, type_filter, properties);
 }
 
-void ise::rendering::vulkan_create_buffer(VulkanRendererData& renderer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory)
+void ise::rendering::vulkan_create_buffer(VulkanRendererData& renderer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& buffer_memory, MemoryUsage memory_usage)
 {
     VkBufferCreateInfo buffer_info{};
     buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -1432,23 +2289,18 @@ void ise::rendering::vulkan_create_buffer(VulkanRendererData& renderer, VkDevice
     VkMemoryRequirements mem_requirements;
     vkGetBufferMemoryRequirements(renderer.device, buffer, &mem_requirements);
 
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = vulkan_find_memory_type(renderer, mem_requirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(renderer.device, &alloc_info, nullptr, &buffer_memory) != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to allocate buffer memory!");
-    }
+    buffer_memory = memory_allocate(renderer.memory_allocator, mem_requirements, properties, memory_usage, MEMORY_RESOURCE_LINEAR);
 
-    VKRH(vkBindBufferMemory(renderer.device, buffer, buffer_memory, 0));
+    VKRH(vkBindBufferMemory(renderer.device, buffer, buffer_memory.memory, buffer_memory.offset));
 }
 
-void ise::rendering::vulkan_transition_image_layout(VulkanRendererData& renderer, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels)
+void ise::rendering::vulkan_free_memory(VulkanRendererData& renderer, MemoryAllocation& memory)
 {
-    VkCommandBuffer command_buffer = vulkan_begin_single_time_commands(renderer);
+    memory_free(renderer.memory_allocator, memory);
+}
 
+void ise::rendering::vulkan_transition_image_layout(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels)
+{
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = old_layout;
@@ -1494,35 +2346,29 @@ void ise::rendering::vulkan_transition_image_layout(VulkanRendererData& renderer
         0, nullptr,
         1, &barrier
     );
-
-    vulkan_end_single_time_commands(renderer, command_buffer);
 }
 
-void ise::rendering::vulkan_copy_buffer_to_image(VulkanRendererData& renderer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+void ise::rendering::vulkan_copy_buffer_to_image(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize buffer_offset, VkImage image, uint32_t mip_level, uint32_t width, uint32_t first_row, uint32_t row_count)
 {
-    VkCommandBuffer command_buffer = vulkan_begin_single_time_commands(renderer);
-
     VkBufferImageCopy region{};
-    region.bufferOffset = 0;
+    region.bufferOffset = buffer_offset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.mipLevel = mip_level;
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = 1;
-    region.imageOffset = { 0, 0, 0 };
+    region.imageOffset = { 0, static_cast<int32_t>(first_row), 0 };
     region.imageExtent = {
         width,
-        height,
+        row_count,
         1
     };
 
     vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-    vulkan_end_single_time_commands(renderer, command_buffer);
 }
 
-void ise::rendering::vulkan_generate_mipmaps(VulkanRendererData& renderer, VkImage image, VkFormat image_format, int32_t tex_width, int32_t tex_height, uint32_t mip_levels)
+void ise::rendering::vulkan_generate_mipmaps(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkImage image, VkFormat image_format, int32_t tex_width, int32_t tex_height, uint32_t mip_levels)
 {
     // Check if image format supports linear blitting
     VkFormatProperties format_properties;
@@ -1533,8 +2379,6 @@ void ise::rendering::vulkan_generate_mipmaps(VulkanRendererData& renderer, VkIma
         throw std::runtime_error("texture image format does not support linear blitting!");
     }
 
-    VkCommandBuffer command_buffer = vulkan_begin_single_time_commands(renderer);
-
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = image;
@@ -1608,19 +2452,22 @@ void ise::rendering::vulkan_generate_mipmaps(VulkanRendererData& renderer, VkIma
         0, nullptr,
         0, nullptr,
         1, &barrier);
-
-    vulkan_end_single_time_commands(renderer, command_buffer);
 }
 
-void ise::rendering::vulkan_copy_buffer(VulkanRendererData& renderer, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+void ise::rendering::vulkan_copy_buffer(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
 {
-    VkCommandBuffer commandBuffer = vulkan_begin_single_time_commands(renderer);
-
     VkBufferCopy copy_region{};
     copy_region.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copy_region);
+    vkCmdCopyBuffer(command_buffer, srcBuffer, dstBuffer, 1, &copy_region);
+}
 
-    vulkan_end_single_time_commands(renderer, commandBuffer);
+void ise::rendering::vulkan_copy_buffer_region(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize src_offset, VkDeviceSize dst_offset, VkDeviceSize size)
+{
+    VkBufferCopy copy_region{};
+    copy_region.srcOffset = src_offset;
+    copy_region.dstOffset = dst_offset;
+    copy_region.size = size;
+    vkCmdCopyBuffer(command_buffer, src_buffer, dst_buffer, 1, &copy_region);
 }
 
 void ise::rendering::vulkan_create_sync_objects(VulkanRendererData& renderer)
@@ -1647,17 +2494,60 @@ void ise::rendering::vulkan_create_sync_objects(VulkanRendererData& renderer)
     }
 }
 
+void ise::rendering::vulkan_create_offscreen_images(VulkanRendererData& renderer)
+{
+    renderer.swap_chain_image_format = vulkan_find_supported_format(
+        renderer,
+        { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM },
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT
+    );
+    renderer.swap_chain_extent = { renderer.custom_config.headless_width, renderer.custom_config.headless_height };
+
+    renderer.swap_chain_images.resize(renderer.custom_config.max_frames_in_flight);
+    renderer.offscreen_images_memory.resize(renderer.custom_config.max_frames_in_flight);
+
+    for (size_t i = 0; i < renderer.swap_chain_images.size(); i++)
+    {
+        vulkan_create_image(
+            renderer,
+            renderer.swap_chain_extent.width,
+            renderer.swap_chain_extent.height,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            renderer.swap_chain_image_format,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            renderer.swap_chain_images[i],
+            renderer.offscreen_images_memory[i]);
+    }
+}
+
+VkImageLayout ise::rendering::vulkan_get_presentable_image_layout(VulkanRendererData& renderer)
+{
+    // PRESENT_SRC_KHR is only valid with VK_KHR_swapchain, offscreen images are left ready to be read back
+    return renderer.custom_config.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+}
+
 void ise::rendering::vulkan_cleanup_swap_chain(VulkanRendererData& renderer)
 {
     vkDestroyImageView(renderer.device, renderer.depth_image_view, nullptr);
     vkDestroyImage(renderer.device, renderer.depth_image, nullptr);
-    vkFreeMemory(renderer.device, renderer.depth_image_memory, nullptr);
+    vulkan_free_memory(renderer, renderer.depth_image_memory);
 
     if (!(renderer.msaa_samples & VK_SAMPLE_COUNT_1_BIT))
     {
         vkDestroyImageView(renderer.device, renderer.color_image_view, nullptr);
         vkDestroyImage(renderer.device, renderer.color_image, nullptr);
-        vkFreeMemory(renderer.device, renderer.color_image_memory, nullptr);
+        vulkan_free_memory(renderer, renderer.color_image_memory);
+    }
+
+    if (renderer.dynamic_resolution.enabled)
+    {
+        vkDestroyImageView(renderer.device, renderer.dynamic_resolution.image_view, nullptr);
+        vkDestroyImage(renderer.device, renderer.dynamic_resolution.image, nullptr);
+        vulkan_free_memory(renderer, renderer.dynamic_resolution.image_memory);
     }
 
     for (auto frame_buffer : renderer.swap_chain_framebuffers)
@@ -1670,84 +2560,704 @@ void ise::rendering::vulkan_cleanup_swap_chain(VulkanRendererData& renderer)
         vkDestroyImageView(renderer.device, image_view, nullptr);
     }
 
-    vkDestroySwapchainKHR(renderer.device, renderer.swap_chain, nullptr);
-}
-
-void ise::rendering::vulkan_recreate_swap_chain(VulkanRendererData& renderer)
-{
-    VKRH(vkDeviceWaitIdle(renderer.device));
+    if (renderer.custom_config.headless)
+    {
+        for (size_t i = 0; i < renderer.swap_chain_images.size(); i++)
+        {
+            vkDestroyImage(renderer.device, renderer.swap_chain_images[i], nullptr);
+            vulkan_free_memory(renderer, renderer.offscreen_images_memory[i]);
+        }
+        renderer.swap_chain_images.clear();
+        renderer.offscreen_images_memory.clear();
+    }
+    else
+    {
+        vkDestroySwapchainKHR(renderer.device, renderer.swap_chain, nullptr);
+        renderer.swap_chain = VK_NULL_HANDLE;
+    }
+}
 
-    vulkan_cleanup_swap_chain(renderer);
+void ise::rendering::vulkan_recreate_swap_chain(VulkanRendererData& renderer)
+{
+    // A minimized window has no extent to create a swapchain with, the request waits until it is restored
+    VkExtent2D extent = vulkan_get_surface_extent(renderer);
+    if (extent.width == 0 || extent.height == 0)
+    {
+        renderer.force_recreate_swapchain = true;
+        return;
+    }
 
+    // Frames in flight keep their command buffers, framebuffers and attachments until they finished,
+    // so the new ones are created next to them instead of waiting for the device
+    SwapChainRelease release{};
+    if (renderer.custom_config.headless)
+    {
+        release.offscreen_images.swap(renderer.swap_chain_images);
+        release.offscreen_images_memory.swap(renderer.offscreen_images_memory);
+    }
+    else
+    {
+        // Stays in renderer.swap_chain until the new one replaced it, as its oldSwapchain
+        release.swap_chain = renderer.swap_chain;
+    }
+    release.image_views.swap(renderer.swap_chain_image_views);
+    release.framebuffers.swap(renderer.swap_chain_framebuffers);
+    if (!(renderer.msaa_samples & VK_SAMPLE_COUNT_1_BIT))
+    {
+        release.color_image = renderer.color_image;
+        release.color_image_view = renderer.color_image_view;
+        release.color_image_memory = renderer.color_image_memory;
+    }
+    release.depth_image = renderer.depth_image;
+    release.depth_image_view = renderer.depth_image_view;
+    release.depth_image_memory = renderer.depth_image_memory;
+    if (renderer.dynamic_resolution.enabled)
+    {
+        release.render_target = renderer.dynamic_resolution.image;
+        release.render_target_view = renderer.dynamic_resolution.image_view;
+        release.render_target_memory = renderer.dynamic_resolution.image_memory;
+    }
+
+    release.command_buffers.swap(renderer.command_buffers);
+    renderer.command_buffers_scene_generation.clear();
+    renderer.command_buffers_visibility_generation.clear();
+    for (RecordingWorker& worker : renderer.recording_workers)
+    {
+        release.secondary_command_buffers.emplace_back().swap(worker.secondary_command_buffers);
+    }
+    release.instance_buffers.swap(renderer.instance_buffers);
+
+    vulkan_defer_destroy(renderer, [release = std::move(release)](VulkanRendererData& renderer) mutable { swap_chain_release_destroy(renderer, release); });
+
+    vulkan_create_swap_chain_resources(renderer);
+}
+
+VkExtent2D ise::rendering::vulkan_get_surface_extent(VulkanRendererData& renderer)
+{
+    if (renderer.custom_config.headless)
+    {
+        return { renderer.custom_config.headless_width, renderer.custom_config.headless_height };
+    }
+
+    VkSurfaceCapabilitiesKHR capabilities;
+    VKRH(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(renderer.physical_device, renderer.surface, &capabilities));
+    return vulkan_choose_swap_extent(capabilities, renderer);
+}
+
+void ise::rendering::vulkan_create_swap_chain_resources(VulkanRendererData& renderer)
+{
     vulkan_create_swap_chain(renderer);
     vulkan_create_image_views(renderer);
+    vulkan_create_render_target(renderer);
     vulkan_create_color_resources(renderer);
     vulkan_create_depth_resources(renderer);
     vulkan_create_framebuffers(renderer);
+
+    // The image count may have changed, and every recorded buffer points at a destroyed framebuffer anyway
+    vulkan_free_command_buffers(renderer);
+    vulkan_create_command_buffers(renderer);
+    vulkan_invalidate_recorded_command_buffers(renderer);
 }
 
-void ise::rendering::vulkan_update_vertex_buffer(VulkanRendererData& renderer)
+bool ise::rendering::vulkan_reconfigure_needs_new_device(VulkanRendererData& renderer, const VulkanRendererConfig& config)
 {
-    VkDeviceSize new_buffer_size = sizeof(renderer.vertices[0]) * renderer.vertices.size();
-    if (renderer.vertex_buffer_size > 0)
+    const VulkanRendererConfig& current = renderer.custom_config;
+
+    // Instance layers, device features and queues
+    if (config.enable_validation_layers != current.enable_validation_layers ||
+        config.headless != current.headless ||
+        config.dedicated_transfer_queue != current.dedicated_transfer_queue ||
+        (config.max_anisotropy >= 1.0f && current.max_anisotropy < 1.0f))
     {
-        vkDestroyBuffer(renderer.device, renderer.vertex_buffer, nullptr);
-        vkFreeMemory(renderer.device, renderer.vertex_buffer_memory, nullptr);
+        return true;
+    }
+
+    // Per frame resources, descriptor layouts and the atlas are sized once
+    if (config.max_frames_in_flight != current.max_frames_in_flight ||
+        config.gpu_driven_culling != current.gpu_driven_culling ||
+        config.max_bindless_textures != current.max_bindless_textures ||
+        config.virtual_texture_atlas_pages != current.virtual_texture_atlas_pages)
+    {
+        return true;
     }
-    renderer.vertex_buffer_size = new_buffer_size;
 
-    if (new_buffer_size == 0)
+    // Geometry, cached textures and virtual pages already resident are in the old formats
+    if (config.vertex_format != current.vertex_format ||
+        config.compact_indices != current.compact_indices ||
+        config.texture_compression != current.texture_compression)
+    {
+        return true;
+    }
+
+    // Replacing the decode queue would drop the decodes still queued on it
+    return config.texture_decode_threads != current.texture_decode_threads && renderer.texture_decode_queue;
+}
+
+void ise::rendering::vulkan_recreate_graphics_pipelines(VulkanRendererData& renderer)
+{
+    vkDestroyPipeline(renderer.device, renderer.graphics_pipeline, nullptr);
+    renderer.graphics_pipeline = vulkan_create_graphics_pipeline_from_shaders(renderer, vulkan_get_vertex_shader_file(renderer.custom_config.vertex_format, "vert"), "frag.spv", renderer.pipeline_layout, true);
+
+    vulkan_recreate_gpu_culling_graphics_pipeline(renderer);
+    vulkan_recreate_virtual_texturing_pipelines(renderer);
+}
+
+void ise::rendering::vulkan_reserve_geometry_buffer(VulkanRendererData& renderer, VkBuffer& buffer, MemoryAllocation& buffer_memory, VkDeviceSize& capacity, VkDeviceSize used_size, VkDeviceSize required_size, VkBufferUsageFlags usage)
+{
+    if (required_size <= capacity)
     {
         return;
     }
 
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-    vulkan_create_buffer(renderer, new_buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
+    // Grow geometrically and carry the existing contents over on the device
+    VkDeviceSize new_capacity = std::max(required_size, capacity * 2);
 
-    void* data;
-    VKRH(vkMapMemory(renderer.device, staging_buffer_memory, 0, new_buffer_size, 0, &data));
-    memcpy(data, renderer.vertices.data(), (size_t)new_buffer_size);
-    vkUnmapMemory(renderer.device, staging_buffer_memory);
+    VkBuffer new_buffer;
+    MemoryAllocation new_buffer_memory;
+    vulkan_create_buffer(renderer, new_capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, new_buffer, new_buffer_memory);
+
+    if (capacity > 0)
+    {
+        if (used_size > 0)
+        {
+            // The old buffer belongs to the graphics family once uploaded, so the copy goes after the acquires of the open batch,
+            // behind every upload into the old buffer
+            VkCommandBuffer command_buffer = vulkan_get_upload_graphics_commands(renderer);
 
-    vulkan_create_buffer(renderer, new_buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, renderer.vertex_buffer, renderer.vertex_buffer_memory);
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 
-    vulkan_copy_buffer(renderer, staging_buffer, renderer.vertex_buffer, new_buffer_size);
+            vulkan_copy_buffer_region(renderer, command_buffer, buffer, new_buffer, 0, 0, used_size);
 
-    vkDestroyBuffer(renderer.device, staging_buffer, nullptr);
-    vkFreeMemory(renderer.device, staging_buffer_memory, nullptr);
+            // Later uploads into the new buffer and the frames reading it
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+            UploadQueue& uploads = renderer.uploads;
+            if (uploads.transfer_family != uploads.graphics_family)
+            {
+                // The transfer commands of a batch run before its graphics commands, so uploads into the new buffer go into
+                // the next batch, whose transfer submission waits for this one
+                vulkan_flush_uploads(renderer);
+                uploads.transfer_wait_value = renderer.upload_submitted_value;
+            }
+        }
+
+        // Frames in flight and the copy above still read the old buffer
+        vulkan_defer_destroy(renderer, [buffer, buffer_memory](VulkanRendererData& renderer) mutable
+        {
+            vkDestroyBuffer(renderer.device, buffer, nullptr);
+            vulkan_free_memory(renderer, buffer_memory);
+        });
+    }
+
+    buffer = new_buffer;
+    buffer_memory = new_buffer_memory;
+    capacity = new_capacity;
+}
+
+uint32_t ise::rendering::vulkan_get_vertex_stride(VertexFormat format)
+{
+    return format == VERTEX_FORMAT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+VkVertexInputBindingDescription ise::rendering::vulkan_get_vertex_binding_description(VertexFormat format)
+{
+    VkVertexInputBindingDescription binding_description{};
+    binding_description.binding = 0;
+    binding_description.stride = vulkan_get_vertex_stride(format);
+    binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    return binding_description;
 }
 
-void ise::rendering::vulkan_update_index_buffer(VulkanRendererData& renderer)
+std::vector<VkVertexInputAttributeDescription> ise::rendering::vulkan_get_vertex_attribute_descriptions(VertexFormat format)
 {
-    VkDeviceSize new_buffer_size = sizeof(renderer.indices[0]) * renderer.indices.size();
-    if (renderer.index_buffer_size > 0)
+    // Locations match the inputs of vert.glsl and vert_indirect.glsl, the packed variant has no color at location 1
+    if (format == VERTEX_FORMAT_PACKED)
     {
-        vkDestroyBuffer(renderer.device, renderer.index_buffer, nullptr);
-        vkFreeMemory(renderer.device, renderer.index_buffer_memory, nullptr);
+        return {
+            { 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, position) },
+            { 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, tex_coord) }
+        };
+    }
+
+    return {
+        { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos) },
+        { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) },
+        { 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, tex_coord) }
+    };
+}
+
+std::string ise::rendering::vulkan_get_vertex_shader_file(VertexFormat format, const std::string& shader_name)
+{
+    // The variants are compiled from the same source with ISE_VERTEX_FORMAT_PACKED defined, see CMakeLists.txt
+    return shader_name + (format == VERTEX_FORMAT_PACKED ? "_packed.spv" : ".spv");
+}
+
+void ise::rendering::vulkan_pack_vertices(const Vertex* vertices, uint32_t vertex_count, const glm::vec3& position_offset, const glm::vec3& position_scale, PackedVertex* packed_vertices)
+{
+    // A flat axis has a scale of 0, every position on it quantizes to 0
+    glm::vec3 quantization_scale(0.0f);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (position_scale[axis] > 0.0f)
+        {
+            quantization_scale[axis] = 65535.0f / position_scale[axis];
+        }
     }
-    renderer.index_buffer_size = new_buffer_size;
 
-    if (new_buffer_size == 0)
+    for (uint32_t i = 0; i < vertex_count; i++)
+    {
+        glm::vec3 quantized = glm::clamp((vertices[i].pos - position_offset) * quantization_scale + 0.5f, glm::vec3(0.0f), glm::vec3(65535.0f));
+
+        PackedVertex& packed_vertex = packed_vertices[i];
+        packed_vertex.position[0] = static_cast<uint16_t>(quantized.x);
+        packed_vertex.position[1] = static_cast<uint16_t>(quantized.y);
+        packed_vertex.position[2] = static_cast<uint16_t>(quantized.z);
+        packed_vertex.position[3] = 0;
+        packed_vertex.tex_coord[0] = glm::packHalf1x16(vertices[i].tex_coord.x);
+        packed_vertex.tex_coord[1] = glm::packHalf1x16(vertices[i].tex_coord.y);
+    }
+}
+
+uint32_t ise::rendering::vulkan_upload_vertices(VulkanRendererData& renderer, const Vertex* vertices, uint32_t vertex_count, const glm::vec3& position_offset, const glm::vec3& position_scale)
+{
+    if (vertex_count == 0)
+    {
+        return 0;
+    }
+
+    VertexFormat format = renderer.custom_config.vertex_format;
+    VkDeviceSize stride = vulkan_get_vertex_stride(format);
+    VkDeviceSize upload_size = stride * VkDeviceSize(vertex_count);
+    VkDeviceSize offset = vulkan_allocate_geometry_range(renderer, renderer.vertex_allocator, renderer.vertex_buffer, renderer.vertex_buffer_memory, renderer.vertex_buffer_capacity, upload_size, stride, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+    // Read by the draws and by the copy growing the buffer
+    vulkan_upload_buffer_data(renderer, renderer.vertex_buffer, offset, stride, vertex_count, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT, [&](void* data, VkDeviceSize first_vertex, VkDeviceSize count)
+    {
+        if (format == VERTEX_FORMAT_PACKED)
+        {
+            vulkan_pack_vertices(vertices + first_vertex, static_cast<uint32_t>(count), position_offset, position_scale, static_cast<PackedVertex*>(data));
+        }
+        else
+        {
+            memcpy(data, vertices + first_vertex, static_cast<size_t>(count * stride));
+        }
+    });
+
+    return static_cast<uint32_t>(offset / stride);
+}
+
+uint32_t ise::rendering::vulkan_upload_indices(VulkanRendererData& renderer, const uint32_t* indices, uint32_t index_count, VkIndexType index_type, uint32_t base_vertex)
+{
+    // Both index types share the buffer, which is always bound at offset 0, so every range starts aligned to its own index size
+    if (index_count == 0)
+    {
+        return 0;
+    }
+
+    VkDeviceSize index_size = index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    VkDeviceSize upload_size = index_size * VkDeviceSize(index_count);
+    VkDeviceSize offset = vulkan_allocate_geometry_range(renderer, renderer.index_allocator, renderer.index_buffer, renderer.index_buffer_memory, renderer.index_buffer_capacity, upload_size, index_size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    // Indices are stored relative to their mesh and rebased or narrowed while being written to the staging memory
+    vulkan_upload_buffer_data(renderer, renderer.index_buffer, offset, index_size, index_count, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT, [&](void* data, VkDeviceSize first_index, VkDeviceSize count)
+    {
+        if (index_type == VK_INDEX_TYPE_UINT16)
+        {
+            uint16_t* staging_indices = static_cast<uint16_t*>(data);
+            for (VkDeviceSize i = 0; i < count; i++)
+            {
+                staging_indices[i] = static_cast<uint16_t>(indices[first_index + i] + base_vertex);
+            }
+        }
+        else
+        {
+            uint32_t* staging_indices = static_cast<uint32_t*>(data);
+            for (VkDeviceSize i = 0; i < count; i++)
+            {
+                staging_indices[i] = indices[first_index + i] + base_vertex;
+            }
+        }
+    });
+
+    return static_cast<uint32_t>(offset / index_size);
+}
+
+VkDeviceSize ise::rendering::vulkan_allocate_geometry_range(VulkanRendererData& renderer, ise::util::RangeAllocator& allocator, VkBuffer& buffer, MemoryAllocation& buffer_memory, VkDeviceSize& capacity, VkDeviceSize size, VkDeviceSize alignment, VkBufferUsageFlags usage)
+{
+    VkDeviceSize offset = allocator.allocate(size, alignment);
+    if (offset != ise::util::RangeAllocator::INVALID_OFFSET)
+    {
+        return offset;
+    }
+
+    // Live ranges keep their offsets, so the whole old buffer is carried over. The new space is merged
+    // with a free range at the old end, which then fits size even after aligning its start.
+    VkDeviceSize old_capacity = capacity;
+    vulkan_reserve_geometry_buffer(renderer, buffer, buffer_memory, capacity, old_capacity, old_capacity + size + alignment - 1, usage);
+    allocator.grow(capacity);
+
+    offset = allocator.allocate(size, alignment);
+    if (offset == ise::util::RangeAllocator::INVALID_OFFSET)
+    {
+        throw std::runtime_error("failed to allocate geometry range!");
+    }
+
+    return offset;
+}
+
+void ise::rendering::vulkan_release_geometry(VulkanRendererData& renderer, uint32_t first_vertex, uint32_t vertex_count, uint32_t first_index, uint32_t index_count, VkIndexType index_type)
+{
+    if (vertex_count == 0 && index_count == 0)
     {
         return;
     }
 
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-    vulkan_create_buffer(renderer, new_buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
+    VkDeviceSize stride = vulkan_get_vertex_stride(renderer.custom_config.vertex_format);
+    VkDeviceSize index_size = index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
 
-    void* data;
-    VKRH(vkMapMemory(renderer.device, staging_buffer_memory, 0, new_buffer_size, 0, &data));
-    memcpy(data, renderer.indices.data(), (size_t)new_buffer_size);
-    vkUnmapMemory(renderer.device, staging_buffer_memory);
+    VkDeviceSize vertex_offset = stride * first_vertex;
+    VkDeviceSize vertex_size = stride * vertex_count;
+    VkDeviceSize index_offset = index_size * first_index;
+    VkDeviceSize index_bytes = index_size * index_count;
 
-    vulkan_create_buffer(renderer, new_buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, renderer.index_buffer, renderer.index_buffer_memory);
+    // Frames in flight may still read the ranges
+    vulkan_defer_destroy(renderer, [vertex_offset, vertex_size, index_offset, index_bytes](VulkanRendererData& renderer)
+    {
+        renderer.vertex_allocator.free(vertex_offset, vertex_size);
+        renderer.index_allocator.free(index_offset, index_bytes);
+    });
+}
 
-    vulkan_copy_buffer(renderer, staging_buffer, renderer.index_buffer, new_buffer_size);
+void ise::rendering::vulkan_upload_mesh_data(VulkanRendererData& renderer, const Vertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, Mesh& mesh)
+{
+    mesh.position_offset = glm::vec3(0.0f);
+    mesh.position_scale = glm::vec3(1.0f);
+    if (renderer.custom_config.vertex_format == VERTEX_FORMAT_PACKED && vertex_count > 0)
+    {
+        glm::vec3 position_min = vertices[0].pos;
+        glm::vec3 position_max = vertices[0].pos;
+        for (uint32_t i = 1; i < vertex_count; i++)
+        {
+            position_min = glm::min(position_min, vertices[i].pos);
+            position_max = glm::max(position_max, vertices[i].pos);
+        }
+
+        mesh.position_offset = position_min;
+        mesh.position_scale = position_max - position_min;
+    }
 
-    vkDestroyBuffer(renderer.device, staging_buffer, nullptr);
-    vkFreeMemory(renderer.device, staging_buffer_memory, nullptr);
+    mesh.first_vertex = vulkan_upload_vertices(renderer, vertices, vertex_count, mesh.position_offset, mesh.position_scale);
+    mesh.vertex_count = vertex_count;
+
+    // Primitive restart is disabled, so 0xFFFF is an ordinary index and 65536 vertices still fit
+    if (renderer.custom_config.compact_indices && vertex_count <= 65536)
+    {
+        mesh.index_type = VK_INDEX_TYPE_UINT16;
+        mesh.vertex_offset = static_cast<int32_t>(mesh.first_vertex);
+        mesh.first_index = vulkan_upload_indices(renderer, indices, index_count, VK_INDEX_TYPE_UINT16, 0);
+    }
+    else
+    {
+        mesh.index_type = VK_INDEX_TYPE_UINT32;
+        mesh.vertex_offset = 0;
+        mesh.first_index = vulkan_upload_indices(renderer, indices, index_count, VK_INDEX_TYPE_UINT32, mesh.first_vertex);
+    }
+    mesh.index_count = index_count;
+}
+
+void ise::rendering::vulkan_build_mesh_data(const RenderGeometry& geometry, const glm::vec3& offset, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, glm::vec3& bounds_min, glm::vec3& bounds_max, uint32_t thread_count)
+{
+    std::vector<MeshBuildChunk> chunks;
+    size_t index_count = 0;
+    for (size_t shape = 0; shape < geometry.shapes.size(); shape++)
+    {
+        size_t shape_index_count = geometry.shapes[shape].mesh.indices.size();
+        for (size_t first = 0; first < shape_index_count; first += MESH_BUILD_CHUNK_INDICES)
+        {
+            MeshBuildChunk chunk{};
+            chunk.shape = shape;
+            chunk.first = first;
+            chunk.count = std::min(MESH_BUILD_CHUNK_INDICES, shape_index_count - first);
+            chunk.first_output_index = index_count;
+            chunks.push_back(std::move(chunk));
+
+            index_count += chunks.back().count;
+        }
+    }
+
+    auto build_chunk = [&](MeshBuildChunk& chunk)
+    {
+        const auto& shape_indices = geometry.shapes[chunk.shape].mesh.indices;
+
+        VertexIndexMap unique_vertices;
+        unique_vertices.reserve(chunk.count);
+        chunk.local_indices.reserve(chunk.count);
+        chunk.bounds_min = glm::vec3(std::numeric_limits<float>::max());
+        chunk.bounds_max = glm::vec3(std::numeric_limits<float>::lowest());
+
+        for (size_t i = chunk.first; i < chunk.first + chunk.count; i++)
+        {
+            const auto& index = shape_indices[i];
+            Vertex vertex{};
+
+            vertex.pos = {
+                geometry.attrib.vertices[3 * index.vertex_index + 0] + offset.x,
+                geometry.attrib.vertices[3 * index.vertex_index + 1] + offset.y,
+                geometry.attrib.vertices[3 * index.vertex_index + 2] + offset.z
+            };
+
+            vertex.tex_coord = {
+                geometry.attrib.texcoords[2 * index.texcoord_index + 0],
+                1.0f - geometry.attrib.texcoords[2 * index.texcoord_index + 1]
+            };
+
+            vertex.color = { 1.0f, 1.0f, 1.0f };
+
+            chunk.bounds_min = glm::min(chunk.bounds_min, vertex.pos);
+            chunk.bounds_max = glm::max(chunk.bounds_max, vertex.pos);
+
+            auto [local_index, inserted] = unique_vertices.try_emplace(vertex, static_cast<uint32_t>(chunk.unique_vertices.size()));
+            if (inserted)
+            {
+                chunk.unique_vertices.push_back(vertex);
+            }
+            chunk.local_indices.push_back(*local_index);
+        }
+    };
+
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t worker_count = std::min<size_t>(thread_count, chunks.size());
+
+    // Chunks are handed out dynamically, but every chunk owns its result, so the output does not depend on scheduling
+    std::unique_ptr<ise::util::ThreadPool> thread_pool;
+    std::atomic<size_t> next_chunk{ 0 };
+    auto run_chunks = [&](const std::function<void(MeshBuildChunk&)>& task)
+    {
+        if (!thread_pool)
+        {
+            for (MeshBuildChunk& chunk : chunks)
+            {
+                task(chunk);
+            }
+            return;
+        }
+
+        next_chunk = 0;
+        thread_pool->run_on_workers(worker_count, [&](size_t)
+        {
+            for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++)
+            {
+                task(chunks[i]);
+            }
+        });
+    };
+
+    if (worker_count > 1)
+    {
+        thread_pool = std::make_unique<ise::util::ThreadPool>(worker_count);
+    }
+
+    run_chunks(build_chunk);
+
+    // Merging in chunk order keeps the first occurrence order of a single sequential pass
+    size_t chunk_vertex_count = 0;
+    for (const MeshBuildChunk& chunk : chunks)
+    {
+        chunk_vertex_count += chunk.unique_vertices.size();
+    }
+
+    VertexIndexMap unique_vertices;
+    unique_vertices.reserve(chunk_vertex_count);
+    vertices.reserve(vertices.size() + chunk_vertex_count);
+
+    bounds_min = glm::vec3(std::numeric_limits<float>::max());
+    bounds_max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    for (MeshBuildChunk& chunk : chunks)
+    {
+        chunk.remap.resize(chunk.unique_vertices.size());
+        for (size_t i = 0; i < chunk.unique_vertices.size(); i++)
+        {
+            auto [index, inserted] = unique_vertices.try_emplace(chunk.unique_vertices[i], static_cast<uint32_t>(vertices.size()));
+            if (inserted)
+            {
+                vertices.push_back(chunk.unique_vertices[i]);
+            }
+            chunk.remap[i] = *index;
+        }
+
+        bounds_min = glm::min(bounds_min, chunk.bounds_min);
+        bounds_max = glm::max(bounds_max, chunk.bounds_max);
+    }
+
+    size_t first_output_index = indices.size();
+    indices.resize(first_output_index + index_count);
+    run_chunks([&](MeshBuildChunk& chunk)
+    {
+        uint32_t* output = indices.data() + first_output_index + chunk.first_output_index;
+        for (size_t i = 0; i < chunk.count; i++)
+        {
+            output[i] = chunk.remap[chunk.local_indices[i]];
+        }
+    });
+
+    if (index_count == 0)
+    {
+        bounds_min = glm::vec3(0.0f);
+        bounds_max = glm::vec3(0.0f);
+    }
+}
+
+void ise::rendering::vulkan_optimize_mesh_data(VulkanRendererData& renderer, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    if (renderer.custom_config.optimize_meshes)
+    {
+        mesh_optimize(vertices, indices, renderer.custom_config.mesh_optimizer_options);
+    }
+}
+
+uint64_t ise::rendering::vulkan_hash_bytes(const void* data, size_t size, uint64_t hash)
+{
+    return ise::util::hash_bytes(data, size, hash);
+}
+
+uint64_t ise::rendering::vulkan_hash_geometry(const RenderGeometry& geometry)
+{
+    // Only what vulkan_build_mesh_data reads is part of the hash
+    uint64_t hash = vulkan_hash_bytes(geometry.attrib.vertices.data(), geometry.attrib.vertices.size() * sizeof(float));
+    hash = vulkan_hash_bytes(geometry.attrib.texcoords.data(), geometry.attrib.texcoords.size() * sizeof(float), hash);
+    for (const auto& shape : geometry.shapes)
+    {
+        for (const auto& index : shape.mesh.indices)
+        {
+            hash = vulkan_hash_bytes(&index.vertex_index, sizeof(index.vertex_index), hash);
+            hash = vulkan_hash_bytes(&index.texcoord_index, sizeof(index.texcoord_index), hash);
+        }
+    }
+
+    return hash;
+}
+
+std::string ise::rendering::vulkan_get_mesh_key(const std::string& source_path, uint64_t content_hash)
+{
+    return std::format("{}#{:016x}", source_path, content_hash);
+}
+
+const ise::rendering::Mesh* ise::rendering::vulkan_find_mesh(VulkanRendererData& renderer, const std::string& source_path, uint64_t content_hash)
+{
+    auto it = renderer.meshes.find(vulkan_get_mesh_key(source_path, content_hash));
+    return it != renderer.meshes.end() ? it->second : nullptr;
+}
+
+const ise::rendering::Mesh* ise::rendering::vulkan_create_mesh(VulkanRendererData& renderer, const std::string& source_path, uint64_t content_hash, const Vertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, const glm::vec3& bounds_min, const glm::vec3& bounds_max)
+{
+    // Another thread may have loaded the same mesh while this one was parsing
+    const Mesh* existing_mesh = vulkan_find_mesh(renderer, source_path, content_hash);
+    if (existing_mesh != nullptr)
+    {
+        return existing_mesh;
+    }
+
+    Mesh* mesh = new Mesh;
+    mesh->source_path = source_path;
+    mesh->content_hash = content_hash;
+    mesh->id = renderer.next_mesh_id++;
+    mesh->bounds_min = bounds_min;
+    mesh->bounds_max = bounds_max;
+    mesh->vertex_cache_statistics = mesh_analyze_vertex_cache(indices, index_count, vertex_count);
+    vulkan_upload_mesh_data(renderer, vertices, vertex_count, indices, index_count, *mesh);
+    renderer.meshes[vulkan_get_mesh_key(source_path, content_hash)] = mesh;
+
+    vulkan_invalidate_recorded_command_buffers(renderer);
+    return mesh;
+}
+
+void ise::rendering::vulkan_invalidate_recorded_command_buffers(VulkanRendererData& renderer)
+{
+    renderer.scene_generation++;
+}
+
+void ise::rendering::vulkan_free_command_buffers(VulkanRendererData& renderer)
+{
+    for (RecordingWorker& worker : renderer.recording_workers)
+    {
+        if (!worker.secondary_command_buffers.empty())
+        {
+            vkFreeCommandBuffers(renderer.device, worker.command_pool, static_cast<uint32_t>(worker.secondary_command_buffers.size()), worker.secondary_command_buffers.data());
+        }
+        worker.secondary_command_buffers.clear();
+    }
+
+    if (!renderer.command_buffers.empty())
+    {
+        vkFreeCommandBuffers(renderer.device, renderer.command_pool, static_cast<uint32_t>(renderer.command_buffers.size()), renderer.command_buffers.data());
+    }
+    renderer.command_buffers.clear();
+    renderer.command_buffers_scene_generation.clear();
+    renderer.command_buffers_visibility_generation.clear();
+
+    vulkan_destroy_instance_buffers(renderer);
+}
+
+void ise::rendering::vulkan_upload_draw_instances(VulkanRendererData& renderer, size_t command_buffer_index)
+{
+    InstanceBuffer& instance_buffer = renderer.instance_buffers[command_buffer_index];
+
+    // Always at least one instance, so there is a buffer to bind even for an empty draw list
+    uint32_t instance_count = std::max<uint32_t>(static_cast<uint32_t>(renderer.draw_instances.size()), 1);
+    if (instance_count > instance_buffer.capacity)
+    {
+        if (instance_buffer.capacity > 0)
+        {
+            vkDestroyBuffer(renderer.device, instance_buffer.buffer, nullptr);
+            vulkan_free_memory(renderer, instance_buffer.memory);
+        }
+
+        instance_buffer.capacity = std::max(instance_count, instance_buffer.capacity * 2);
+        VkDeviceSize buffer_size = sizeof(InstanceData) * instance_buffer.capacity;
+
+        vulkan_create_buffer(renderer, buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, instance_buffer.buffer, instance_buffer.memory);
+        instance_buffer.mapped = instance_buffer.memory.mapped;
+    }
+
+    if (!renderer.draw_instances.empty())
+    {
+        memcpy(instance_buffer.mapped, renderer.draw_instances.data(), sizeof(InstanceData) * renderer.draw_instances.size());
+    }
+}
+
+void ise::rendering::vulkan_destroy_instance_buffers(VulkanRendererData& renderer)
+{
+    for (InstanceBuffer& instance_buffer : renderer.instance_buffers)
+    {
+        if (instance_buffer.capacity > 0)
+        {
+            vkDestroyBuffer(renderer.device, instance_buffer.buffer, nullptr);
+            vulkan_free_memory(renderer, instance_buffer.memory);
+        }
+    }
+    renderer.instance_buffers.clear();
+}
+
+void ise::rendering::vulkan_destroy_recording_workers(VulkanRendererData& renderer)
+{
+    renderer.recording_thread_pool.reset();
+
+    for (RecordingWorker& worker : renderer.recording_workers)
+    {
+        vkDestroyCommandPool(renderer.device, worker.command_pool, nullptr);
+    }
+    renderer.recording_workers.clear();
 }
 
 VkCommandBuffer ise::rendering::vulkan_begin_single_time_commands(VulkanRendererData& renderer)
@@ -1835,11 +3345,34 @@ void ise::rendering::vulkan_update_uniform_buffer(VulkanRendererData& renderer,
 
     ubo.proj[1][1] *= -1;
 
+    renderer.frustum_planes = vulkan_extract_frustum_planes(ubo.proj * ubo.view * ubo.model);
+    std::copy(renderer.frustum_planes.begin(), renderer.frustum_planes.end(), ubo.frustum_planes);
+
     memcpy(renderer.uniform_buffers_mapped[current_image], &ubo, sizeof(ubo));
 }
 
-void ise::rendering::vulkan_record_command_buffer(VulkanRendererData& renderer, VkCommandBuffer command_buffer, uint32_t image_index)
+void ise::rendering::vulkan_record_command_buffer(VulkanRendererData& renderer, size_t command_buffer_index, uint32_t image_index)
 {
+    VkCommandBuffer command_buffer = renderer.command_buffers[command_buffer_index];
+
+    // With GPU driven culling the draw list is built by the compute pass, everything is recorded inline
+    size_t draw_count = 0;
+    size_t worker_count = 0;
+    if (!renderer.gpu_culling.enabled)
+    {
+        vulkan_build_draw_commands(renderer);
+        vulkan_upload_draw_instances(renderer, command_buffer_index);
+
+        // Small scenes are not worth the secondary command buffer overhead
+        draw_count = renderer.draw_commands.size();
+        worker_count = renderer.recording_workers.size();
+        if (renderer.custom_config.min_draws_per_recording_thread > 0)
+        {
+            worker_count = std::min(worker_count, draw_count / renderer.custom_config.min_draws_per_recording_thread);
+        }
+    }
+    bool use_secondary_command_buffers = worker_count > 1;
+
     VkCommandBufferBeginInfo begin_info{};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
@@ -1848,12 +3381,19 @@ void ise::rendering::vulkan_record_command_buffer(VulkanRendererData& renderer,
         throw std::runtime_error("failed to begin recording command buffer!");
     }
 
+    vulkan_record_frame_timestamp(renderer, command_buffer, false);
+
+    if (renderer.gpu_culling.enabled)
+    {
+        vulkan_record_gpu_culling(renderer, command_buffer);
+    }
+
     VkRenderPassBeginInfo render_pass_info{};
     render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     render_pass_info.renderPass = renderer.render_pass;
     render_pass_info.framebuffer = renderer.swap_chain_framebuffers[image_index];
     render_pass_info.renderArea.offset = { 0, 0 };
-    render_pass_info.renderArea.extent = renderer.swap_chain_extent;
+    render_pass_info.renderArea.extent = vulkan_get_render_extent(renderer);
 
     std::array<VkClearValue, 2> clear_values{};
     clear_values[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
@@ -1862,44 +3402,308 @@ void ise::rendering::vulkan_record_command_buffer(VulkanRendererData& renderer,
     render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
     render_pass_info.pClearValues = clear_values.data();
 
-    vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(command_buffer, &render_pass_info, use_secondary_command_buffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+
+    if (renderer.gpu_culling.enabled)
+    {
+        vulkan_record_gpu_culled_draws(renderer, command_buffer);
+    }
+    else if (use_secondary_command_buffers)
+    {
+        std::vector<VkCommandBuffer> secondary_command_buffers(worker_count);
+
+        // Each worker only touches its own command pool, so no synchronization is needed besides the join
+        renderer.recording_thread_pool->run_on_workers(worker_count, [&](size_t worker_index)
+        {
+            VkCommandBuffer secondary_command_buffer = renderer.recording_workers[worker_index].secondary_command_buffers[command_buffer_index];
+            size_t first_draw = draw_count * worker_index / worker_count;
+            size_t last_draw = draw_count * (worker_index + 1) / worker_count;
+
+            VkCommandBufferInheritanceInfo inheritance_info{};
+            inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritance_info.renderPass = renderer.render_pass;
+            inheritance_info.subpass = 0;
+            inheritance_info.framebuffer = renderer.swap_chain_framebuffers[image_index];
+
+            VkCommandBufferBeginInfo secondary_begin_info{};
+            secondary_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            secondary_begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            secondary_begin_info.pInheritanceInfo = &inheritance_info;
+
+            if (vkBeginCommandBuffer(secondary_command_buffer, &secondary_begin_info) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to begin recording secondary command buffer!");
+            }
+
+            vulkan_record_draw_commands(renderer, secondary_command_buffer, command_buffer_index, first_draw, last_draw - first_draw);
+
+            if (vkEndCommandBuffer(secondary_command_buffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to record secondary command buffer!");
+            }
+
+            secondary_command_buffers[worker_index] = secondary_command_buffer;
+        });
+
+        vkCmdExecuteCommands(command_buffer, static_cast<uint32_t>(secondary_command_buffers.size()), secondary_command_buffers.data());
+    }
+    else
+    {
+        vulkan_record_draw_commands(renderer, command_buffer, command_buffer_index, 0, draw_count);
+    }
+
+    vkCmdEndRenderPass(command_buffer);
+
+    vulkan_record_render_target_blit(renderer, command_buffer, image_index);
+    vulkan_record_virtual_texture_feedback_barrier(renderer, command_buffer);
+    vulkan_record_frame_timestamp(renderer, command_buffer, true);
+
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
+
+void ise::rendering::vulkan_build_culling_bounds(VulkanRendererData& renderer)
+{
+    renderer.culling_bounds.clear();
+    renderer.culling_bounds_render_objects.clear();
+    renderer.culling_bounds.reserve(renderer.render_objects.size());
+    renderer.culling_bounds_render_objects.reserve(renderer.render_objects.size());
+
+    for (uint32_t i = 0; i < renderer.render_objects.size(); i++)
+    {
+        const RenderObject* render_object = renderer.render_objects[i];
+        if (render_object->index_count == 0 || render_object->texture_description_set == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        // Box of the transformed corners, so the bounds are in the same space as the frustum planes
+        glm::vec3 bounds_min(std::numeric_limits<float>::max());
+        glm::vec3 bounds_max(std::numeric_limits<float>::lowest());
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            glm::vec3 local(
+                (corner & 1) ? render_object->bounds_max.x : render_object->bounds_min.x,
+                (corner & 2) ? render_object->bounds_max.y : render_object->bounds_min.y,
+                (corner & 4) ? render_object->bounds_max.z : render_object->bounds_min.z);
+            glm::vec3 transformed = glm::vec3(render_object->transform * glm::vec4(local, 1.0f));
+            bounds_min = glm::min(bounds_min, transformed);
+            bounds_max = glm::max(bounds_max, transformed);
+        }
+
+        renderer.culling_bounds.push_back(bounds_min, bounds_max);
+        renderer.culling_bounds_render_objects.push_back(i);
+    }
+
+    renderer.culling_bounds_scene_generation = renderer.scene_generation;
+}
+
+void ise::rendering::vulkan_cull_render_objects(VulkanRendererData& renderer)
+{
+    if (renderer.culling_bounds_scene_generation != renderer.scene_generation)
+    {
+        vulkan_build_culling_bounds(renderer);
+    }
+
+    renderer.culling_visible_bounds.clear();
+    frustum_cull_aabbs(renderer.culling_bounds, renderer.frustum_planes, renderer.culling_visible_bounds);
+
+    // Only a different visible set needs the command buffers to be recorded again
+    bool changed = renderer.culling_visible_bounds.size() != renderer.visible_render_objects.size();
+    for (size_t i = 0; i < renderer.culling_visible_bounds.size(); i++)
+    {
+        uint32_t render_object_index = renderer.culling_bounds_render_objects[renderer.culling_visible_bounds[i]];
+        changed = changed || renderer.visible_render_objects[i] != render_object_index;
+        renderer.culling_visible_bounds[i] = render_object_index;
+    }
+
+    if (changed)
+    {
+        renderer.visible_render_objects.swap(renderer.culling_visible_bounds);
+        renderer.visibility_generation++;
+    }
+}
+
+void ise::rendering::vulkan_build_draw_commands(VulkanRendererData& renderer)
+{
+    renderer.draw_commands.clear();
+    renderer.draw_instances.clear();
+
+    // Without culling every object is a candidate, with it only the ones that passed the last vulkan_cull_render_objects
+    bool use_visibility = !renderer.gpu_culling.enabled && renderer.custom_config.cpu_frustum_culling;
+    size_t candidate_count = use_visibility ? renderer.visible_render_objects.size() : renderer.render_objects.size();
+
+    std::vector<uint64_t> sort_keys;
+    std::vector<uint32_t> render_object_indices;
+    sort_keys.reserve(candidate_count);
+    render_object_indices.reserve(candidate_count);
 
+    for (uint32_t candidate = 0; candidate < candidate_count; candidate++)
+    {
+        uint32_t i = use_visibility ? renderer.visible_render_objects[candidate] : candidate;
+        const RenderObject* render_object = renderer.render_objects[i];
+        if (render_object->index_count == 0 || render_object->texture_description_set == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        sort_keys.push_back(vulkan_get_draw_sort_key(*render_object));
+        render_object_indices.push_back(i);
+    }
+
+    ise::util::radix_sort(sort_keys, render_object_indices);
+
+    for (size_t i = 0; i < sort_keys.size(); i++)
+    {
+        const RenderObject* render_object = renderer.render_objects[render_object_indices[i]];
+        glm::mat4 instance_transform = vulkan_get_instance_transform(*render_object);
+
+        if (!renderer.draw_commands.empty() && (renderer.draw_commands.back().sort_key >> 32) == (sort_keys[i] >> 32))
+        {
+            DrawCommand& previous = renderer.draw_commands.back();
+
+            // Same state and same index range is another instance of the same mesh, whatever its texture. The sort keeps
+            // those next to each other, so their instances stay contiguous.
+            if (previous.first_index == render_object->first_index && previous.index_count == render_object->index_count)
+            {
+                previous.instance_count++;
+                renderer.draw_instances.push_back({ instance_transform, render_object->texture_index });
+                continue;
+            }
+
+            // Same state, contiguous indices, the same vertex offset, transform and texture means the previous draw can simply be extended
+            if (previous.instance_count == 1 &&
+                previous.first_index + previous.index_count == render_object->first_index &&
+                previous.vertex_offset == render_object->vertex_offset &&
+                renderer.draw_instances.back().transform == instance_transform &&
+                renderer.draw_instances.back().texture_index == render_object->texture_index)
+            {
+                previous.index_count += render_object->index_count;
+                continue;
+            }
+        }
+
+        DrawCommand draw_command{};
+        draw_command.sort_key = sort_keys[i];
+        draw_command.index_count = render_object->index_count;
+        draw_command.first_index = render_object->first_index;
+        draw_command.vertex_offset = render_object->vertex_offset;
+        draw_command.index_type = render_object->index_type;
+        draw_command.instance_count = 1;
+        draw_command.first_instance = static_cast<uint32_t>(renderer.draw_instances.size());
+        draw_command.texture_description_set = render_object->texture_description_set;
+        draw_command.virtual_texture = render_object->virtual_texture;
+        renderer.draw_commands.push_back(draw_command);
+        renderer.draw_instances.push_back({ instance_transform, render_object->texture_index });
+    }
+}
+
+uint64_t ise::rendering::vulkan_get_draw_sort_key(const RenderObject& render_object)
+{
+    // The type selects the pipeline, QUAD_WITH_VIRTUAL_TEXTURE sorts last so the pipeline is switched once
+    uint64_t pipeline = static_cast<uint64_t>(render_object.type) & 0xFF;
+    // first_index counts in units of the index type, so the type has to be part of the key to keep ranges apart
+    uint64_t index_type = render_object.index_type == VK_INDEX_TYPE_UINT16 ? 1 : 0;
+    // Every bindless object shares id 0, only virtual textures still split batches by set
+    uint64_t texture_description_set = static_cast<uint64_t>(render_object.texture_description_set_id) & 0x7FFFFF;
+
+    return (pipeline << 56) | (index_type << 55) | (texture_description_set << 32) | render_object.first_index;
+}
+
+glm::mat4 ise::rendering::vulkan_get_instance_transform(const RenderObject& render_object)
+{
+    return glm::scale(glm::translate(render_object.transform, render_object.position_offset), render_object.position_scale);
+}
+
+void ise::rendering::vulkan_record_draw_commands(VulkanRendererData& renderer, VkCommandBuffer command_buffer, size_t command_buffer_index, size_t first_draw, size_t draw_count)
+{
+    if (draw_count == 0)
+    {
+        return;
+    }
+
+    // Secondary command buffers inherit no state at all, so everything is bound again here
     vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.graphics_pipeline);
 
+    VkExtent2D render_extent = vulkan_get_render_extent(renderer);
+
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
-    viewport.width = (float)renderer.swap_chain_extent.width;
-    viewport.height = (float)renderer.swap_chain_extent.height;
+    viewport.width = (float)render_extent.width;
+    viewport.height = (float)render_extent.height;
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
     vkCmdSetViewport(command_buffer, 0, 1, &viewport);
 
     VkRect2D scissor{};
     scissor.offset = { 0, 0 };
-    scissor.extent = renderer.swap_chain_extent;
+    scissor.extent = render_extent;
     vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-    VkBuffer vertex_buffers[] = { renderer.vertex_buffer };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
+    VkBuffer vertex_buffers[] = { renderer.vertex_buffer, renderer.instance_buffers[command_buffer_index].buffer };
+    VkDeviceSize offsets[] = { 0, 0 };
+    vkCmdBindVertexBuffers(command_buffer, 0, 2, vertex_buffers, offsets);
 
-    vkCmdBindIndexBuffer(command_buffer, renderer.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.pipeline_layout, 0, 1, &renderer.uniform_buffers_descriptor_sets[renderer.current_frame], 0, nullptr);
 
-    std::vector<VkDescriptorSet> descriptor_sets;
-    descriptor_sets.push_back(renderer.uniform_buffers_descriptor_sets[renderer.current_frame]);
-    descriptor_sets.push_back(renderer.render_objects[0]->texture_description_set);
+    // The sort key groups draws by index type, so the index buffer is rebound at most a few times
+    VkIndexType bound_index_type = VK_INDEX_TYPE_MAX_ENUM;
+    VkDescriptorSet bound_texture_description_set = VK_NULL_HANDLE;
+    VkPipelineLayout bound_pipeline_layout = renderer.pipeline_layout;
+    for (size_t i = first_draw; i < first_draw + draw_count; i++)
+    {
+        const DrawCommand& draw_command = renderer.draw_commands[i];
 
-    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.pipeline_layout, 0, descriptor_sets.size(), descriptor_sets.data(), 0, nullptr);
+        if (draw_command.index_type != bound_index_type)
+        {
+            vkCmdBindIndexBuffer(command_buffer, renderer.index_buffer, 0, draw_command.index_type);
+            bound_index_type = draw_command.index_type;
+        }
 
-    vkCmdDrawIndexed(command_buffer, static_cast<uint32_t>(renderer.indices.size()), 1, 0, 0, 0);
+        // Virtual textures sort last, once they start the rest of the range uses their pipeline
+        if (draw_command.virtual_texture != nullptr && bound_pipeline_layout != renderer.virtual_texturing.pipeline_layout)
+        {
+            bound_pipeline_layout = renderer.virtual_texturing.pipeline_layout;
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.virtual_texturing.graphics_pipeline);
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bound_pipeline_layout, 0, 1, &renderer.uniform_buffers_descriptor_sets[renderer.current_frame], 0, nullptr);
+            bound_texture_description_set = VK_NULL_HANDLE;
+        }
 
-    vkCmdEndRenderPass(command_buffer);
+        // The page table and feedback of a virtual texture are per frame, its own set stands in for the frame's one
+        VkDescriptorSet texture_description_set = draw_command.virtual_texture != nullptr ? draw_command.virtual_texture->frames[renderer.current_frame].descriptor_set : draw_command.texture_description_set;
+        if (texture_description_set != bound_texture_description_set)
+        {
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bound_pipeline_layout, 1, 1, &texture_description_set, 0, nullptr);
+            bound_texture_description_set = texture_description_set;
+        }
 
-    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+        vkCmdDrawIndexed(command_buffer, draw_command.index_count, draw_command.instance_count, draw_command.first_index, draw_command.vertex_offset, draw_command.first_instance);
+    }
+}
+
+std::array<glm::vec4, 6> ise::rendering::vulkan_extract_frustum_planes(const glm::mat4& view_projection)
+{
+    // Gribb/Hartmann, with a [0, 1] clip space depth range the near plane is just the third row
+    glm::mat4 m = glm::transpose(view_projection);
+
+    std::array<glm::vec4, 6> planes = {
+        m[3] + m[0], // left
+        m[3] - m[0], // right
+        m[3] + m[1], // bottom
+        m[3] - m[1], // top
+        m[2],        // near
+        m[3] - m[2]  // far
+    };
+
+    for (glm::vec4& plane : planes)
     {
-        throw std::runtime_error("failed to record command buffer!");
+        plane /= glm::length(glm::vec3(plane));
     }
+
+    return planes;
 }
 
 void ise::rendering::vulkan_handle_vk_result(VkResult result)
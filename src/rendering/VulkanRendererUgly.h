@@ -15,6 +15,12 @@
 #include <optional>
 #include <set>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <functional>
+#include <atomic>
+#include <future>
 
 #include <vulkan/vulkan.h>
 
@@ -29,8 +35,15 @@
 
 #include <tiny_obj_loader.h>
 
-#define STRINGIFY2(X) #X
-#define STRINGIFY(X) STRINGIFY2(X)
+#include "FrustumCulling.h"
+#include "MeshOptimizer.h"
+#include "TextureCompression.h"
+#include "VirtualTextureFile.h"
+#include "VulkanMemory.h"
+#include "../util/RadixSort.hpp"
+#include "../util/RangeAllocator.hpp"
+#include "../util/TaskQueue.hpp"
+#include "../util/ThreadPool.hpp"
 
 #ifdef _WIN32
     #define VK_USE_PLATFORM_WIN32_KHR
@@ -45,6 +58,8 @@ namespace ise
         {
             std::optional<uint32_t> graphics_family;
             std::optional<uint32_t> present_family;
+            // A transfer only family when the device has one, graphics_family otherwise
+            std::optional<uint32_t> transfer_family;
 
             bool is_complete()
             {
@@ -64,50 +79,75 @@ namespace ise
             alignas(16) glm::mat4 model;
             alignas(16) glm::mat4 view;
             alignas(16) glm::mat4 proj;
+            // Extracted from proj * view * model, so they cull in the space objects are placed in
+            alignas(16) glm::vec4 frustum_planes[6];
         };
 
+        // Selects the layout geometry is stored in on the device and the vertex shader variant reading it.
+        // Meshes are always built as Vertex and converted while uploading.
+        typedef enum VertexFormat
+        {
+            VERTEX_FORMAT_FLOAT = 0,
+            VERTEX_FORMAT_PACKED = 1
+        } VertexFormat;
+
         struct Vertex
         {
             glm::vec3 pos;
             glm::vec3 color;
             glm::vec2 tex_coord;
 
+            bool operator==(const Vertex& other) const
+            {
+                return pos == other.pos && color == other.color && tex_coord == other.tex_coord;
+            }
+        };
+
+        // 12 instead of 32 bytes. The position is unorm16 relative to the bounds of its mesh, the dequantization is folded into the
+        // instance transform. w only pads to a 4 component format, 3 component 16 bit vertex formats are rarely supported.
+        // Texture coordinates are half floats since they may tile outside [0, 1]. The constant vertex color is dropped.
+        struct PackedVertex
+        {
+            uint16_t position[4];
+            uint16_t tex_coord[2];
+        };
+
+        // Per instance data, the second vertex binding next to the vertices
+        struct InstanceData
+        {
+            glm::mat4 transform;
+            uint32_t texture_index; // slot in the bindless texture array
+
             static VkVertexInputBindingDescription get_binding_description()
             {
                 VkVertexInputBindingDescription bindingDescription{};
-                bindingDescription.binding = 0;
-                bindingDescription.stride = sizeof(Vertex);
-                bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+                bindingDescription.binding = 1;
+                bindingDescription.stride = sizeof(InstanceData);
+                bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 
                 return bindingDescription;
             }
 
-            static std::array<VkVertexInputAttributeDescription, 3> get_attribute_descriptions()
+            // A mat4 takes one location per column
+            static std::array<VkVertexInputAttributeDescription, 5> get_attribute_descriptions()
             {
-                std::array<VkVertexInputAttributeDescription, 3> attribute_descriptions{};
-
-                attribute_descriptions[0].binding = 0;
-                attribute_descriptions[0].location = 0;
-                attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-                attribute_descriptions[0].offset = offsetof(Vertex, pos);
+                std::array<VkVertexInputAttributeDescription, 5> attribute_descriptions{};
 
-                attribute_descriptions[1].binding = 0;
-                attribute_descriptions[1].location = 1;
-                attribute_descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-                attribute_descriptions[1].offset = offsetof(Vertex, color);
+                for (uint32_t column = 0; column < 4; column++)
+                {
+                    attribute_descriptions[column].binding = 1;
+                    attribute_descriptions[column].location = 3 + column;
+                    attribute_descriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+                    attribute_descriptions[column].offset = offsetof(InstanceData, transform) + sizeof(glm::vec4) * column;
+                }
 
-                attribute_descriptions[2].binding = 0;
-                attribute_descriptions[2].location = 2;
-                attribute_descriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-                attribute_descriptions[2].offset = offsetof(Vertex, tex_coord);
+                attribute_descriptions[4].binding = 1;
+                attribute_descriptions[4].location = 7;
+                attribute_descriptions[4].format = VK_FORMAT_R32_UINT;
+                attribute_descriptions[4].offset = offsetof(InstanceData, texture_index);
 
                 return attribute_descriptions;
             }
-
-            bool operator==(const Vertex& other) const
-            {
-                return pos == other.pos && color == other.color && tex_coord == other.tex_coord;
-            }
         };
 
         typedef enum RenderObjectType
@@ -116,7 +156,8 @@ namespace ise
             QUAD = 1,
             QUAD_WITH_STATIC_TEXTURE = 2,
             QUAD_WITH_DYNAMIC_TEXTURE = 3,
-            OBJ_WITH_STATIC_TEXTURE = 4
+            OBJ_WITH_STATIC_TEXTURE = 4,
+            QUAD_WITH_VIRTUAL_TEXTURE = 5 // sampled through the page table of RenderObject::virtual_texture
         } RenderObjectType;
 
         struct RenderTextureRaw
@@ -127,17 +168,197 @@ namespace ise
             stbi_uc* pixels;
         };
 
+        const uint32_t BINDLESS_TEXTURE_NONE = UINT32_MAX;
+
         struct RenderTexture
         {
             uint32_t mip_levels;
             VkImage image;
-            VkDeviceMemory image_memory;
+            MemoryAllocation image_memory;
             VkImageView image_view;
-            VkSampler sampler;
+            VkSampler sampler; // shared, see vulkan_create_texture_sampler_unsafe
+            // image_view and sampler belong to the placeholder texture until the asynchronous load of this one is resident
+            bool placeholder = false;
+            // Slot in the bindless texture array, assigned on first use, see vulkan_register_bindless_texture
+            uint32_t bindless_index = BINDLESS_TEXTURE_NONE;
 
             RenderTextureRaw raw_texture;
         };
 
+        struct TextureSampler
+        {
+            VkSampler sampler;
+            uint32_t reference_count; // textures using it, destroyed at 0
+        };
+
+        typedef enum TextureLoadState
+        {
+            TEXTURE_LOAD_DECODING = 0,
+            TEXTURE_LOAD_DECODED = 1, // waiting for the frame loop to upload it
+            TEXTURE_LOAD_UPLOADING = 2, // the placeholder stays bound until upload_value completed
+            TEXTURE_LOAD_RESIDENT = 3,
+            TEXTURE_LOAD_FAILED = 4
+        } TextureLoadState;
+
+        // Shared by the caller, the decode worker and the frame loop, see vulkan_load_texture_async
+        struct TextureLoad
+        {
+            std::string key;
+            std::string path;
+            std::atomic<TextureLoadState> state = TEXTURE_LOAD_DECODING;
+            // Resolves to TEXTURE_LOAD_RESIDENT or TEXTURE_LOAD_FAILED, error says why it failed. Never wait on it from the render thread.
+            std::promise<TextureLoadState> promise;
+            std::shared_future<TextureLoadState> future = promise.get_future().share();
+            std::string error;
+
+            // Written by the decode worker before it publishes the state
+            RenderTextureRaw raw_texture{};
+            std::string decode_error;
+
+            // Decoded mip chain instead of raw_texture when the renderer uses a compressed_texture_format
+            CompressedTexture compressed;
+            std::future<void> decode_task; // holds what the decode worker threw, see vulkan_process_texture_loads
+
+            // Image, view and sampler while uploading, handed to render_textures[key] once upload_value completed
+            RenderTexture texture{};
+            uint64_t upload_value = 0;
+
+            ~TextureLoad()
+            {
+                if (raw_texture.pixels != nullptr)
+                {
+                    stbi_image_free(raw_texture.pixels);
+                }
+            }
+        };
+
+        typedef std::shared_ptr<TextureLoad> TextureLoadHandle;
+
+        typedef enum VirtualTextureState
+        {
+            VIRTUAL_TEXTURE_BUILDING = 0, // the tile file is opened or built on a decode worker
+            VIRTUAL_TEXTURE_READY = 1, // pages stream in as the feedback asks for them
+            VIRTUAL_TEXTURE_FAILED = 2 // drawn grey, error says why
+        } VirtualTextureState;
+
+        // Shared by the caller, the decode worker opening the tile file and the frame loop. The worker publishes file
+        // and error before the state.
+        struct VirtualTextureBuild
+        {
+            std::atomic<VirtualTextureState> state = VIRTUAL_TEXTURE_BUILDING;
+            std::shared_ptr<VirtualTextureFile> file;
+            std::string error;
+            std::future<void> task; // holds what the worker threw, see vulkan_process_virtual_textures
+
+            // Resolves to VIRTUAL_TEXTURE_READY or VIRTUAL_TEXTURE_FAILED once the frame loop saw the build finish, error
+            // says why it failed. Never wait on it from the render thread.
+            std::promise<VirtualTextureState> promise;
+            std::shared_future<VirtualTextureState> future = promise.get_future().share();
+        };
+
+        // One page copied out of the mapping by a decode worker, so its page faults never stall the frame loop
+        struct VirtualTexturePageRead
+        {
+            std::shared_ptr<VirtualTextureFile> file;
+            uint32_t tile = 0;
+            std::vector<uint8_t> data;
+            std::atomic<bool> done = false;
+        };
+
+        typedef enum VirtualTextureTileState
+        {
+            VIRTUAL_TEXTURE_TILE_ABSENT = 0,
+            VIRTUAL_TEXTURE_TILE_READING = 1,
+            VIRTUAL_TEXTURE_TILE_UPLOADING = 2, // copied into its page, published once the upload completed
+            VIRTUAL_TEXTURE_TILE_RESIDENT = 3
+        } VirtualTextureTileState;
+
+        struct VirtualTextureTile
+        {
+            VirtualTextureTileState state = VIRTUAL_TEXTURE_TILE_ABSENT;
+            uint32_t page = 0; // in VirtualTexturingData::pages while uploading or resident
+        };
+
+        // The host writes the page table of a frame right before submitting it and reads its feedback once its fence
+        // signaled, so neither buffer is ever touched while the device uses it
+        struct VirtualTextureFrame
+        {
+            VkBuffer page_table_buffer;
+            MemoryAllocation page_table_memory;
+            uint64_t page_table_generation = 0;
+            VkBuffer feedback_buffer;
+            MemoryAllocation feedback_memory;
+            VkDescriptorSet descriptor_set;
+        };
+
+        // An image of any size split into a pyramid of tiles on disk, of which only the pages the last frames sampled
+        // are resident in the atlas. See VulkanVirtualTextures.cpp.
+        struct VirtualTexture
+        {
+            std::string key;
+            std::string path;
+            uint32_t id = 0; // shares the texture description set ids, orders draws
+            std::vector<VirtualTextureLevel> levels;
+            uint32_t tile_count = 0;
+
+            std::shared_ptr<VirtualTextureBuild> build; // build->future reports whether the tile file opened
+            std::vector<VirtualTextureTile> tiles;
+            std::vector<std::shared_ptr<VirtualTexturePageRead>> reads; // not copied out of the file yet
+
+            // Host copy of PageTable in frag_virtual.glsl, copied to a frame whenever its generation is behind
+            std::vector<uint32_t> page_table;
+            uint64_t page_table_generation = 0;
+            bool page_table_dirty = true; // a tile became resident or was evicted since the last rebuild
+
+            VkDescriptorPool descriptor_pool;
+            std::vector<VirtualTextureFrame> frames; // one per frame in flight
+        };
+
+        // A page of the atlas, numbered row by row
+        struct VirtualTexturePage
+        {
+            VirtualTexture* texture = nullptr; // nullptr while free
+            uint32_t tile = 0;
+            uint64_t last_used_frame = 0; // frame_number the feedback last asked for the tile or one of its descendants
+            uint64_t upload_value = 0;
+        };
+
+        // Pages frames in flight may still sample through their page table, see vulkan_evict_virtual_texture_pages
+        struct VirtualTexturePageRelease
+        {
+            uint64_t frame_number = 0; // free once this many frames were submitted
+            uint32_t page = 0;
+        };
+
+        struct VirtualTexturingData
+        {
+            // Needs fragmentStoresAndAtomics for the feedback and single page copies on the transfer queue
+            bool supported = false;
+            VkFormat page_format = VK_FORMAT_UNDEFINED;
+
+            VkDescriptorSetLayout descriptor_set_layout;
+            VkPipelineLayout pipeline_layout;
+            VkPipeline graphics_pipeline;
+            // Only with gpu_culling, the indirect vertex shader needs the culling set as well
+            VkPipelineLayout indirect_pipeline_layout = VK_NULL_HANDLE;
+            VkPipeline indirect_graphics_pipeline = VK_NULL_HANDLE;
+
+            // Created with the first virtual texture. Shared by both queue families and always in GENERAL, so the transfer
+            // queue copies into free pages while frames sample the others.
+            uint32_t atlas_pages_per_side = 0;
+            VkImage atlas_image;
+            MemoryAllocation atlas_memory;
+            VkImageView atlas_image_view;
+            VkSampler atlas_sampler;
+
+            std::vector<VirtualTexturePage> pages;
+            std::vector<uint32_t> free_pages;
+            std::vector<VirtualTexturePageRelease> page_releases;
+            std::vector<uint32_t> uploading_pages;
+
+            std::unordered_map<std::string, VirtualTexture*> textures;
+        };
+
         struct RenderGeometry
         {
             tinyobj::attrib_t attrib;
@@ -151,14 +372,263 @@ namespace ise
         //    VkDescriptorSet texture_description_set;
         //};
 
+        // Geometry uploaded once and shared by every render object drawing it
+        struct Mesh
+        {
+            std::string source_path;
+            uint64_t content_hash = 0;
+            uint32_t id = 0;
+
+            // Ranges inside the shared index and vertex buffers, first_index counts in units of index_type
+            uint32_t first_index = 0;
+            uint32_t index_count = 0;
+            uint32_t first_vertex = 0;
+            uint32_t vertex_count = 0;
+
+            // 16 bit indices are relative to first_vertex and drawn with it as vertex offset, 32 bit ones are absolute
+            VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+            int32_t vertex_offset = 0;
+
+            // Object space position = position_offset + position_scale * stored position, identity unless the vertices are packed
+            glm::vec3 position_offset = glm::vec3(0.0f);
+            glm::vec3 position_scale = glm::vec3(1.0f);
+
+            glm::vec3 bounds_min = glm::vec3(0.0f);
+            glm::vec3 bounds_max = glm::vec3(0.0f);
+
+            VertexCacheStatistics vertex_cache_statistics;
+        };
+
         struct RenderObject
         {
             RenderObjectType type;
 
+            // Only the first texture is sampled
             std::vector<std::string> textures;
-            VkDescriptorSet texture_description_set;
+            // The bindless texture set once described, VK_NULL_HANDLE objects are not drawn
+            VkDescriptorSet texture_description_set = VK_NULL_HANDLE;
+            uint32_t texture_description_set_id = 0;
+            // Bindless slot of textures[0], follows the texture as it finishes loading or is replaced, see vulkan_update_texture_users
+            uint32_t texture_index = 0;
 
             RenderGeometry geometry;
+
+            // Ranges inside the shared index and vertex buffers, owned by the object when written by vulkan_load_model_geometry
+            // or copied from the mesh, see Mesh. Neighbouring objects sharing state and vertex offset can be merged into one draw.
+            uint32_t first_index = 0;
+            uint32_t index_count = 0;
+            uint32_t first_vertex = 0;
+            uint32_t vertex_count = 0;
+            VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+            int32_t vertex_offset = 0;
+            glm::vec3 position_offset = glm::vec3(0.0f);
+            glm::vec3 position_scale = glm::vec3(1.0f);
+
+            // Set by vulkan_set_render_object_mesh, the ranges above then point into the shared mesh
+            const Mesh* mesh = nullptr;
+
+            // Set by vulkan_set_render_object_virtual_texture, texture_description_set then only marks the object as drawable
+            VirtualTexture* virtual_texture = nullptr;
+
+            glm::mat4 transform = glm::mat4(1.0f);
+            glm::vec3 bounds_min = glm::vec3(0.0f);
+            glm::vec3 bounds_max = glm::vec3(0.0f);
+        };
+
+        // Part of the staging ring read by the upload submission with the given upload value
+        struct StagingRegion
+        {
+            VkDeviceSize end = 0;
+            uint64_t upload_value = 0;
+        };
+
+        // One persistently mapped buffer every upload is staged through. Slices are handed out in order from head and
+        // come back at tail once the upload submission reading them completed, see vulkan_staging_allocate.
+        struct StagingRing
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            MemoryAllocation memory;
+            VkDeviceSize size = 0;
+            VkDeviceSize head = 0;
+            VkDeviceSize tail = 0;
+            std::deque<StagingRegion> regions; // oldest first
+        };
+
+        struct StagingSlice
+        {
+            VkBuffer buffer;
+            VkDeviceSize offset;
+            void* mapped;
+        };
+
+        // Commands of one upload submission, recorded until vulkan_flush_uploads
+        struct UploadBatch
+        {
+            VkCommandBuffer transfer_command_buffer = VK_NULL_HANDLE;
+            // Acquires what the transfer queue released and runs graphics only work like mipmap generation.
+            // The same command buffer as transfer_command_buffer when both queues are of the same family.
+            VkCommandBuffer graphics_command_buffer = VK_NULL_HANDLE;
+            uint64_t upload_value = 0;
+        };
+
+        // Uploads are recorded into one open batch, submitted to the transfer queue once per frame or when the staging ring
+        // runs full, and handed over to the graphics queue with queue family ownership transfers. Nothing waits for them on the host
+        // unless staging memory or a resource being destroyed is still in use.
+        struct UploadQueue
+        {
+            uint32_t transfer_family = 0;
+            uint32_t graphics_family = 0;
+            VkExtent3D image_granularity = { 1, 1, 1 }; // minImageTransferGranularity of the transfer family
+            VkCommandPool transfer_command_pool = VK_NULL_HANDLE;
+            VkCommandPool graphics_command_pool = VK_NULL_HANDLE; // transfer_command_pool when the families match
+            // Timeline semaphores, both count upload values. The transfer one is only signaled when the families differ.
+            VkSemaphore transfer_semaphore = VK_NULL_HANDLE;
+            VkSemaphore upload_semaphore = VK_NULL_HANDLE;
+
+            bool recording = false;
+            UploadBatch batch;
+            std::deque<UploadBatch> submitted_batches; // oldest first, their command buffers are freed once completed
+            // Upload value the next transfer submission waits for, when graphics work of that batch has to land first. 0 for none.
+            uint64_t transfer_wait_value = 0;
+        };
+
+        struct VulkanRendererData;
+
+        // Something the device may still use, destroyed or given back once both points passed, see vulkan_defer_destroy
+        struct DeletionQueueEntry
+        {
+            uint64_t frame_number = 0; // frames that have to be submitted first
+            uint64_t upload_value = 0; // upload batch that has to complete first
+            std::function<void(VulkanRendererData& renderer)> destroy;
+        };
+
+        // One update after bind array of combined image samplers holding every texture, bound as set 1 once per frame
+        struct BindlessTextureData
+        {
+            uint32_t capacity = 0; // descriptor count of the binding, see vulkan_get_bindless_texture_capacity
+            VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+            VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+            uint32_t next_slot = 0; // slots from here on were never used
+            std::vector<uint32_t> free_slots;
+        };
+
+        struct DrawCommand
+        {
+            // Packed as pipeline (8 bits) | 16 bit indices (1 bit) | texture description set id (23 bits) | first index (32 bits)
+            uint64_t sort_key;
+            uint32_t index_count;
+            uint32_t first_index;
+            int32_t vertex_offset;
+            VkIndexType index_type;
+            // Range inside VulkanRendererData::draw_instances
+            uint32_t instance_count;
+            uint32_t first_instance;
+            VkDescriptorSet texture_description_set;
+            // Bound with the set of the frame being recorded and the virtual texture pipeline instead
+            const VirtualTexture* virtual_texture;
+        };
+
+        // Host visible, written when the command buffer using it is recorded
+        struct InstanceBuffer
+        {
+            uint32_t capacity = 0;
+            VkBuffer buffer;
+            MemoryAllocation memory;
+            void* mapped;
+        };
+
+        // Mirrors ObjectData in cull.glsl and vert_indirect.glsl (std430)
+        struct GpuObjectData
+        {
+            glm::mat4 transform;
+            glm::vec4 bounding_sphere; // xyz center, w radius, both in object space
+            glm::vec4 position_offset; // Dequantization of packed vertices, see Mesh
+            glm::vec4 position_scale;
+            uint32_t first_index;
+            uint32_t index_count;
+            int32_t vertex_offset;
+            uint32_t draw_group;
+            uint32_t command_offset;
+            uint32_t texture_index;
+            uint32_t padding[2];
+        };
+
+        // Objects sharing a texture description set and index type are drawn by one vkCmdDrawIndexedIndirectCount
+        struct GpuDrawGroup
+        {
+            VkDescriptorSet texture_description_set;
+            const VirtualTexture* virtual_texture;
+            VkIndexType index_type;
+            uint32_t command_offset;
+            uint32_t capacity;
+        };
+
+        // Everything the culling dispatch writes is per frame in flight, so frames never race each other
+        struct GpuCullingFrame
+        {
+            uint64_t scene_generation = 0;
+            uint32_t object_capacity = 0;
+            uint32_t group_capacity = 0;
+
+            VkBuffer object_buffer;
+            MemoryAllocation object_buffer_memory;
+            void* object_buffer_mapped;
+            VkBuffer indirect_buffer;
+            MemoryAllocation indirect_buffer_memory;
+            VkBuffer count_buffer;
+            MemoryAllocation count_buffer_memory;
+
+            VkDescriptorSet descriptor_set;
+        };
+
+        struct GpuCullingData
+        {
+            bool enabled = false;
+            uint64_t scene_generation = 0;
+
+            VkDescriptorSetLayout descriptor_set_layout;
+            VkDescriptorPool descriptor_pool;
+            VkPipelineLayout compute_pipeline_layout;
+            VkPipeline compute_pipeline;
+            VkPipelineLayout graphics_pipeline_layout;
+            VkPipeline graphics_pipeline;
+
+            std::vector<GpuObjectData> objects;
+            std::vector<GpuDrawGroup> draw_groups;
+            std::vector<GpuCullingFrame> frames;
+        };
+
+        // The scene is rendered into image at scale times the swapchain extent and blitted up after the render pass.
+        // The scale follows the GPU frame time measured with timestamp queries, see VulkanDynamicResolution.cpp
+        struct DynamicResolutionData
+        {
+            bool enabled = false; // decided with the render pass, see vulkan_check_dynamic_resolution_support
+            float scale = 1.0f;
+            VkExtent2D render_extent{}; // part of image drawn to
+            VkExtent2D target_extent{}; // allocated at max_render_scale, so a new scale needs no new images
+
+            VkImage image = VK_NULL_HANDLE;
+            MemoryAllocation image_memory{};
+            VkImageView image_view = VK_NULL_HANDLE;
+
+            // Two timestamps per frame in flight around its command buffer, null when the graphics queue has none
+            VkQueryPool query_pool = VK_NULL_HANDLE;
+            double timestamp_period_ms = 0.0;
+            uint64_t timestamp_mask = 0;
+            std::vector<bool> queries_submitted;
+
+            double gpu_frame_time_ms = 0.0; // moving average, 0 until the first frame was measured
+            uint32_t over_budget_frames = 0;
+            double under_budget_ms = 0.0; // wall time since the frame time went below the headroom
+            std::chrono::steady_clock::time_point last_measured_time{}; // of the previous frame time, unset after a scale change
+            uint64_t settle_frame_number = 0; // frames before it still ran at the previous scale
+        };
+
+        struct RecordingWorker
+        {
+            VkCommandPool command_pool;
+            // One secondary command buffer per primary, so cached primaries keep their own secondaries alive
+            std::vector<VkCommandBuffer> secondary_command_buffers;
         };
 
         typedef enum ProjectionType
@@ -176,6 +646,7 @@ namespace ise
             TRILINEAR = 4
         } TextureFilteringType;
 
+        // vulkan_reconfigure applies most fields to a running renderer, see vulkan_reconfigure_needs_new_device for the rest
         struct VulkanRendererConfig
         {
             #ifdef _DEBUG
@@ -196,6 +667,61 @@ namespace ise
             float perspective_vertical_fov = 60.0f;
 
             float orthographic_scale_factor = 2.0f;
+
+            // Skips objects outside the view frustum before building the draw list, ignored with gpu_driven_culling
+            bool cpu_frustum_culling = true;
+
+            // Culls on the GPU with a compute pass and draws with vkCmdDrawIndexedIndirectCount.
+            // Needs Vulkan 1.2 drawIndirectCount, falls back to the CPU draw list when unsupported.
+            bool gpu_driven_culling = false;
+
+            uint32_t recording_threads = 0; // 0 uses every core
+            uint32_t min_draws_per_recording_thread = 64; // Fewer draws than this are recorded inline by the render thread
+
+            uint32_t mesh_build_threads = 0; // 0 uses every core, vertex deduplication of loaded meshes
+
+            // Both are fixed once the first geometry is uploaded
+            VertexFormat vertex_format = VERTEX_FORMAT_PACKED;
+            bool compact_indices = true; // 16 bit indices for meshes with at most 65536 vertices
+
+            // Reorders loaded meshes for the post transform cache, overdraw and vertex fetch, see mesh_optimize
+            bool optimize_meshes = true;
+            MeshOptimizerOptions mesh_optimizer_options;
+
+            // Uploads larger than half the ring are split into chunks
+            VkDeviceSize staging_ring_size = 32ull * 1024 * 1024;
+            // Copies on a transfer only queue family when there is one, so uploads run next to rendering
+            bool dedicated_transfer_queue = true;
+
+            uint32_t texture_decode_threads = 0; // 0 uses every core, asynchronous texture loads
+            // Decoded bytes the frame loop uploads per frame, at least one texture
+            VkDeviceSize texture_upload_budget = 16ull * 1024 * 1024;
+            // Asynchronous loads are transcoded once on the decode threads and cached next to the source, see TextureCache.h.
+            // Falls back to TEXTURE_COMPRESSION_NONE when the device cannot sample the format.
+            TextureCompression texture_compression = TEXTURE_COMPRESSION_BC7;
+            // Textures that can exist at once, clamped to the update after bind limits of the device
+            uint32_t max_bindless_textures = 16384;
+
+            // Pages per side of the atlas every virtual texture streams into, 32 is 1024 pages or 16 MiB with BC7.
+            // Clamped to maxImageDimension2D and 256. Pages not sampled for the longest time are evicted first.
+            uint32_t virtual_texture_atlas_pages = 32;
+            uint32_t virtual_texture_uploads_per_frame = 32; // pages copied into the atlas per frame
+            uint32_t virtual_texture_reads_in_flight = 64; // pages being read from disk at once, over every virtual texture
+
+            // The scene is rendered at a scale of the swapchain extent within these bounds and blitted up, both at 1 renders
+            // straight into the swapchain. Clamped to [0.25, 1]. The scale drops once the GPU frame time stays above
+            // target_gpu_frame_time_ms and slowly comes back while there is headroom.
+            float min_render_scale = 1.0f;
+            float max_render_scale = 1.0f;
+            float target_gpu_frame_time_ms = 1000.0f / 60.0f;
+
+            // Headless renders into device local images instead of a swapchain, so no window or surface is needed
+            bool headless = false;
+            uint32_t headless_width = 1280;
+            uint32_t headless_height = 720;
+
+            // Loaded when the device is created and written back at cleanup, see PipelineCache.h. Empty keeps it in memory only.
+            std::string pipeline_cache_path = "pipeline_cache.bin";
         };
 
         struct VulkanRendererData
@@ -212,57 +738,121 @@ namespace ise
 
             VulkanRendererConfig custom_config;
             bool can_accept_new_frames = true;
-            bool force_recreate_swapchain = false;
+            // Set by resize events from another thread. However many arrive, the frame loop recreates the swapchain at most once
+            // per frame and only when the surface size actually differs, see vulkan_draw_frame.
+            std::atomic<bool> force_recreate_swapchain = false;
+            // Drawable size of the window in pixels, kept up to date by whoever created the surface. Some surfaces (Wayland)
+            // leave the extent to the swapchain, see vulkan_choose_swap_extent.
+            std::atomic<uint32_t> window_width = 0;
+            std::atomic<uint32_t> window_height = 0;
             uint32_t current_frame = 0;
+            uint64_t frame_number = 0; // frames submitted so far
+            // Bumped whenever anything a recorded command buffer depends on changes (objects, geometry, textures, swapchain)
+            uint64_t scene_generation = 1;
 
             VkInstance instance;
             VkDebugUtilsMessengerEXT debug_messenger;
             VkSurfaceKHR surface;
 
             VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+            VkPhysicalDeviceProperties physical_device_properties{}; // queried once the device is picked
             VkSampleCountFlagBits msaa_samples = VK_SAMPLE_COUNT_1_BIT;
             VkDevice device;
+            // Every buffer and image is suballocated from here, see VulkanMemory.h
+            MemoryAllocator memory_allocator;
 
             VkQueue graphics_queue;
             VkQueue present_queue;
+            VkQueue transfer_queue; // graphics_queue when there is no transfer only family
 
-            VkSwapchainKHR swap_chain;
+            VkSwapchainKHR swap_chain = VK_NULL_HANDLE;
             std::vector<VkImage> swap_chain_images;
             VkFormat swap_chain_image_format;
             VkExtent2D swap_chain_extent;
             std::vector<VkImageView> swap_chain_image_views;
             std::vector<VkFramebuffer> swap_chain_framebuffers;
+            std::vector<MemoryAllocation> offscreen_images_memory; // only used when headless
 
             VkRenderPass render_pass;
+            // Every pipeline is created through it, so recreating the renderer skips the shader compile
+            VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
             VkDescriptorSetLayout descriptor_set_layout_uniform_buffers;
             VkDescriptorSetLayout descriptor_set_layout_textures;
             VkPipelineLayout pipeline_layout;
             VkPipeline graphics_pipeline;
 
             VkCommandPool command_pool;
+            // One pre-recorded command buffer per frame in flight and swapchain image, indexed by current_frame * image count + image_index
             std::vector<VkCommandBuffer> command_buffers;
+            std::vector<uint64_t> command_buffers_scene_generation;
+            std::vector<uint64_t> command_buffers_visibility_generation;
+            // One per command buffer, a cached command buffer keeps reading the instances it was recorded with
+            std::vector<InstanceBuffer> instance_buffers;
+
+            std::unique_ptr<ise::util::ThreadPool> recording_thread_pool;
+            std::vector<RecordingWorker> recording_workers;
+            std::vector<DrawCommand> draw_commands;
+            std::vector<InstanceData> draw_instances;
+            GpuCullingData gpu_culling;
+            DynamicResolutionData dynamic_resolution;
+
+            UploadQueue uploads;
+            StagingRing staging_ring;
+            // Every upload batch gets the next value, everything up to upload_completed_value finished on the device.
+            // The open batch is upload_submitted_value + 1.
+            uint64_t upload_submitted_value = 0;
+            uint64_t upload_completed_value = 0;
+            // Oldest first, frame_number and upload_value only grow along it
+            std::deque<DeletionQueueEntry> deletion_queue;
+
+            // Planes of the last uniform buffer update, in the space the object bounds are in
+            std::array<glm::vec4, 6> frustum_planes{};
+            CullingBounds culling_bounds;
+            std::vector<uint32_t> culling_bounds_render_objects; // render object index of every culling_bounds entry
+            uint64_t culling_bounds_scene_generation = 0;
+            std::vector<uint32_t> culling_visible_bounds;
+            std::vector<uint32_t> visible_render_objects;
+            // Bumped whenever visible_render_objects changes, recorded command buffers depend on it as well
+            uint64_t visibility_generation = 1;
 
             VkImage color_image;
-            VkDeviceMemory color_image_memory;
+            MemoryAllocation color_image_memory;
             VkImageView color_image_view;
 
             VkImage depth_image;
-            VkDeviceMemory depth_image_memory;
+            MemoryAllocation depth_image_memory;
             VkImageView depth_image_view;
 
             std::unordered_map<std::string, RenderTexture*> render_textures;
+            // Keyed by the sampler state, see vulkan_get_texture_sampler_key. Stays as small as the number of filtering setups in use.
+            std::unordered_map<uint64_t, TextureSampler> texture_samplers;
+            // Format asynchronous loads are encoded to, VK_FORMAT_UNDEFINED uploads RGBA8 and blits the mipmaps
+            VkFormat compressed_texture_format = VK_FORMAT_UNDEFINED;
+            // Bound in place of textures still loading, slot 0 of the bindless texture array
+            RenderTexture* placeholder_texture = nullptr;
+            std::unique_ptr<ise::util::TaskQueue> texture_decode_queue;
+            std::vector<TextureLoadHandle> texture_loads; // not resident or failed yet
+            VirtualTexturingData virtual_texturing;
             std::vector<RenderObject*> render_objects;
-            std::vector<Vertex> vertices;
-            std::vector<uint32_t> indices;
-            VkDeviceSize vertex_buffer_size = 0;
+            // Keyed by source path and content hash, see vulkan_get_mesh_key
+            std::unordered_map<std::string, Mesh*> meshes;
+            uint32_t next_mesh_id = 0;
+            BindlessTextureData bindless_textures;
+            uint32_t next_texture_description_set_id = 1; // 0 is the bindless texture set
+            // Geometry only lives on the device. Every upload copies just its own bytes through a staging buffer into a range
+            // suballocated from these heaps, which grow geometrically on the device when no free range fits.
+            // The index buffer holds 16 and 32 bit indices, each aligned to its own size
+            ise::util::RangeAllocator vertex_allocator; // bytes, ranges aligned to the vertex stride
+            ise::util::RangeAllocator index_allocator; // bytes
+            VkDeviceSize vertex_buffer_capacity = 0;
             VkBuffer vertex_buffer;
-            VkDeviceMemory vertex_buffer_memory;
-            VkDeviceSize index_buffer_size = 0;
+            MemoryAllocation vertex_buffer_memory;
+            VkDeviceSize index_buffer_capacity = 0;
             VkBuffer index_buffer;
-            VkDeviceMemory index_buffer_memory;
+            MemoryAllocation index_buffer_memory;
 
             std::vector<VkBuffer> uniform_buffers;
-            std::vector<VkDeviceMemory> uniform_buffers_memory;
+            std::vector<MemoryAllocation> uniform_buffers_memory;
             std::vector<void*> uniform_buffers_mapped;
 
             VkDescriptorPool descriptor_pool;
@@ -278,22 +868,34 @@ namespace ise
         void vulkan_setup_debug_messenger(VulkanRendererData& renderer);
         // Before continuing, you MUST create a surface by yourself and store it inside renderer.surface
         // This is intended to not make this file dependable on SDL
+        // When custom_config.headless is set no surface is needed
         void vulkan_pick_physical_device(VulkanRendererData& renderer);
         void vulkan_create_logical_device(VulkanRendererData& renderer);
-        void vulkan_create_swap_chain(VulkanRendererData& renderer);
+        void vulkan_create_swap_chain(VulkanRendererData& renderer); // Creates offscreen images instead when headless
         void vulkan_create_image_views(VulkanRendererData& renderer);
         void vulkan_create_render_pass(VulkanRendererData& renderer);
         void vulkan_create_descriptor_set_layout(VulkanRendererData& renderer);
         void vulkan_create_graphics_pipeline(VulkanRendererData& renderer);
+        void vulkan_create_pipeline_cache(VulkanRendererData& renderer);
+        bool vulkan_save_pipeline_cache(VulkanRendererData& renderer);
+        void vulkan_destroy_pipeline_cache(VulkanRendererData& renderer);
         void vulkan_create_command_pool(VulkanRendererData& renderer);
+        void vulkan_create_upload_queue(VulkanRendererData& renderer);
+        void vulkan_create_staging_ring(VulkanRendererData& renderer);
+        void vulkan_create_recording_workers(VulkanRendererData& renderer);
+        void vulkan_create_render_target(VulkanRendererData& renderer); // nothing unless dynamic resolution is enabled
         void vulkan_create_color_resources(VulkanRendererData& renderer);
         void vulkan_create_depth_resources(VulkanRendererData& renderer);
         void vulkan_create_framebuffers(VulkanRendererData& renderer);
         void vulkan_create_uniform_buffers(VulkanRendererData& renderer);
         void vulkan_create_descriptor_pool(VulkanRendererData& renderer);
         void vulkan_create_uniform_buffers_descriptor_sets(VulkanRendererData& renderer);
+        void vulkan_create_bindless_textures(VulkanRendererData& renderer);
         void vulkan_create_command_buffers(VulkanRendererData& renderer);
         void vulkan_create_sync_objects(VulkanRendererData& renderer);
+        void vulkan_create_gpu_culling_resources(VulkanRendererData& renderer);
+        void vulkan_create_virtual_texturing_resources(VulkanRendererData& renderer);
+        void vulkan_create_dynamic_resolution_resources(VulkanRendererData& renderer);
 
         // Public 
         RenderTexture* vulkan_create_render_texture(std::string key, VulkanRendererData& renderer);
@@ -301,41 +903,239 @@ namespace ise
         bool vulkan_destroy_render_texture_unsafe(std::string key, VulkanRendererData& renderer);
         RenderObject* vulkan_create_render_object(VulkanRendererData& renderer);
         void vulkan_create_texture_image(VulkanRendererData& renderer, RenderTexture& render_texture);
+        void vulkan_create_texture_image_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture);
+        // Uploads every level as is, no blits, the image is sampled straight from the precomputed mip chain
+        void vulkan_create_compressed_texture_image_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture, const CompressedTexture& texture);
         void vulkan_create_texture_sampler(VulkanRendererData& renderer, RenderTexture& render_texture);
+        void vulkan_create_texture_sampler_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture);
+        VkSamplerCreateInfo vulkan_get_texture_sampler_info(VulkanRendererData& renderer);
+        uint64_t vulkan_get_texture_sampler_key(const VkSamplerCreateInfo& sampler_info);
+        void vulkan_destroy_texture_sampler_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture);
+        void vulkan_destroy_texture_samplers(VulkanRendererData& renderer);
+        // Destroys image, view and memory and drops the sampler reference right away, see vulkan_defer_destroy
+        void vulkan_destroy_render_texture_image_unsafe(VulkanRendererData& renderer, RenderTexture& render_texture);
+        // Registers key right away with the placeholder texture bound, decodes path on a worker thread and uploads it from
+        // vulkan_draw_frame. Objects are switched over to its bindless slot once the upload completed. See VulkanTextureLoads.cpp.
+        TextureLoadHandle vulkan_load_texture_async(VulkanRendererData& renderer, const std::string& key, const std::string& path);
+        // Points the object at the bindless slot of textures[0], the placeholder's when there is no such texture yet
         void vulkan_create_textures_description_set(VulkanRendererData& renderer, RenderObject& render_object);
+        // Registers key right away and drawn grey until its pages arrive. The tile file next to path is built on a decode worker
+        // the first time, see VirtualTextureFile.h. Throws when the device has no virtual texturing support.
+        VirtualTexture* vulkan_create_virtual_texture(VulkanRendererData& renderer, const std::string& key, const std::string& path);
+        bool vulkan_destroy_virtual_texture(VulkanRendererData& renderer, const std::string& key);
+        bool vulkan_destroy_virtual_texture_unsafe(VulkanRendererData& renderer, const std::string& key);
+        // Also sets the type to QUAD_WITH_VIRTUAL_TEXTURE, the texture list of the object is ignored from then on
+        void vulkan_set_render_object_virtual_texture(VulkanRendererData& renderer, RenderObject& render_object, const std::string& key);
         void vulkan_load_model_geometry(VulkanRendererData& renderer, RenderObject& render_object, std::vector<float> offset);
+        // Parses and uploads the OBJ only the first time a path and content pair is seen.
+        // The deduplicated result is cached next to the OBJ, see MeshCache.h.
+        const Mesh* vulkan_load_mesh(VulkanRendererData& renderer, const std::string& obj_path);
+        const Mesh* vulkan_get_or_create_mesh(VulkanRendererData& renderer, const std::string& source_path, const RenderGeometry& geometry);
+        void vulkan_set_render_object_mesh(VulkanRendererData& renderer, RenderObject& render_object, const Mesh* mesh);
+        // Frees the mesh and its geometry ranges, returns false while render objects still use it
+        bool vulkan_destroy_mesh(VulkanRendererData& renderer, const Mesh* mesh);
+        bool vulkan_destroy_mesh_unsafe(VulkanRendererData& renderer, const Mesh* mesh);
+        void vulkan_set_render_object_transform(VulkanRendererData& renderer, RenderObject& render_object, const glm::mat4& transform);
         void vulkan_draw_frame(VulkanRendererData& renderer);
         void vulkan_cleanup(VulkanRendererData& renderer);
+        // Applies config to the running renderer. Only what the changed fields reach is rebuilt (swapchain, render pass,
+        // attachments, pipelines, samplers, recording workers, staging ring), textures, geometry and descriptor sets stay.
+        // Returns false and changes nothing when a changed field needs a new device.
+        bool vulkan_reconfigure(VulkanRendererData& renderer, const VulkanRendererConfig& config);
 
         // Low level helper functions. DON'T USE!
         bool vulkan_check_validation_layer_support(VulkanRendererData& renderer);
         bool vulkan_is_device_suitable(VkPhysicalDevice device, VulkanRendererData& renderer);
         QueueFamilyIndices vulkan_find_queue_families(VkPhysicalDevice device, VulkanRendererData& renderer);
         bool vulkan_check_device_extension_support(VkPhysicalDevice device, VulkanRendererData& renderer);
+        // custom_config.texture_compression when the physical device samples it with linear filtering, else VK_FORMAT_UNDEFINED
+        VkFormat vulkan_pick_compressed_texture_format(VulkanRendererData& renderer);
+        std::vector<const char*> vulkan_get_required_device_extensions(VulkanRendererData& renderer);
         SwapChainSupportDetails vulkan_query_swap_chain_support(VkPhysicalDevice device, VulkanRendererData& renderer);
         VkSampleCountFlagBits vulkan_get_max_usable_sample_count(VulkanRendererData& renderer);
         VkSurfaceFormatKHR vulkan_choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats);
         VkPresentModeKHR vulkan_choose_swap_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes, VulkanRendererData& renderer);
+        // currentExtent, or the window size clamped to what the surface supports when currentExtent is UINT32_MAX. 0x0 while minimized.
+        VkExtent2D vulkan_choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities, VulkanRendererData& renderer);
         VkImageView vulkan_create_image_view(VulkanRendererData& renderer, VkImage image, VkFormat format, VkImageAspectFlags aspect_flags, uint32_t mip_levels);
         VkFormat vulkan_find_supported_format(VulkanRendererData& renderer, const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-        VkShaderModule vulkan_create_shader_module(VulkanRendererData& renderer, const std::vector<char>& code);
-        void vulkan_create_image(VulkanRendererData& renderer, uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits num_samples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& image_memory);
+        // The SPIR-V is embedded at build time, shader_file is the name glslc gave it, e.g. frag.spv
+        VkShaderModule vulkan_create_shader_module(VulkanRendererData& renderer, const std::string& shader_file);
+        VkPipeline vulkan_create_graphics_pipeline_from_shaders(VulkanRendererData& renderer, const std::string& vertex_shader, const std::string& fragment_shader, VkPipelineLayout pipeline_layout, bool instance_binding);
+        void vulkan_create_image(VulkanRendererData& renderer, uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits num_samples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& image_memory);
         uint32_t vulkan_find_memory_type(VulkanRendererData& renderer, uint32_t type_filter, VkMemoryPropertyFlags properties);
-        void vulkan_create_buffer(VulkanRendererData& renderer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory);
-        void vulkan_transition_image_layout(VulkanRendererData& renderer, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels);
-        void vulkan_copy_buffer_to_image(VulkanRendererData& renderer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-        void vulkan_generate_mipmaps(VulkanRendererData& renderer, VkImage image, VkFormat image_format, int32_t tex_width, int32_t tex_height, uint32_t mip_levels);
-        void vulkan_copy_buffer(VulkanRendererData& renderer, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        void vulkan_create_buffer(VulkanRendererData& renderer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& buffer_memory, MemoryUsage memory_usage = MEMORY_USAGE_LONG_LIVED);
+        void vulkan_free_memory(VulkanRendererData& renderer, MemoryAllocation& memory);
+        // The recording helpers below only record into command_buffer, see vulkan_get_upload_transfer_commands
+        void vulkan_transition_image_layout(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels);
+        void vulkan_copy_buffer_to_image(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize buffer_offset, VkImage image, uint32_t mip_level, uint32_t width, uint32_t first_row, uint32_t row_count);
+        // Needs a graphics queue command buffer for the blits
+        void vulkan_generate_mipmaps(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkImage image, VkFormat image_format, int32_t tex_width, int32_t tex_height, uint32_t mip_levels);
+        void vulkan_copy_buffer(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        void vulkan_create_offscreen_images(VulkanRendererData& renderer);
+        VkImageLayout vulkan_get_presentable_image_layout(VulkanRendererData& renderer);
+        // Destroys right away, the device must be idle
         void vulkan_cleanup_swap_chain(VulkanRendererData& renderer);
+        // Without waiting for the device, the new swapchain is created from the old one and everything the frames in flight
+        // still use goes through the deletion queue. Does nothing while the window is minimized.
         void vulkan_recreate_swap_chain(VulkanRendererData& renderer);
-        void vulkan_update_vertex_buffer(VulkanRendererData& renderer);
-        void vulkan_update_index_buffer(VulkanRendererData& renderer);
+        VkExtent2D vulkan_get_surface_extent(VulkanRendererData& renderer); // the swapchain extent when headless
+        // Everything vulkan_cleanup_swap_chain destroys, plus the command buffers recorded against it
+        void vulkan_create_swap_chain_resources(VulkanRendererData& renderer);
+        // Device features, queues, per frame resources and layouts sized at creation
+        bool vulkan_reconfigure_needs_new_device(VulkanRendererData& renderer, const VulkanRendererConfig& config);
+        // After a render pass or sample count change, every pipeline layout stays
+        void vulkan_recreate_graphics_pipelines(VulkanRendererData& renderer);
+        // Moves every texture to the sampler of the current filtering config and rewrites its bindless slot. Nothing may be in flight.
+        void vulkan_recreate_texture_samplers_unsafe(VulkanRendererData& renderer);
+        void vulkan_copy_buffer_region(VulkanRendererData& renderer, VkCommandBuffer command_buffer, VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize src_offset, VkDeviceSize dst_offset, VkDeviceSize size);
+        // Copies over within the upload batches and retires the old buffer through vulkan_defer_destroy, never waits
+        void vulkan_reserve_geometry_buffer(VulkanRendererData& renderer, VkBuffer& buffer, MemoryAllocation& buffer_memory, VkDeviceSize& capacity, VkDeviceSize used_size, VkDeviceSize required_size, VkBufferUsageFlags usage);
+        uint32_t vulkan_get_vertex_stride(VertexFormat format);
+        VkVertexInputBindingDescription vulkan_get_vertex_binding_description(VertexFormat format);
+        std::vector<VkVertexInputAttributeDescription> vulkan_get_vertex_attribute_descriptions(VertexFormat format);
+        // Every vertex shader is compiled once per VertexFormat, shader_name without extension
+        std::string vulkan_get_vertex_shader_file(VertexFormat format, const std::string& shader_name);
+        void vulkan_pack_vertices(const Vertex* vertices, uint32_t vertex_count, const glm::vec3& position_offset, const glm::vec3& position_scale, PackedVertex* packed_vertices);
+        // Converts to custom_config.vertex_format on the way into the staging buffer
+        uint32_t vulkan_upload_vertices(VulkanRendererData& renderer, const Vertex* vertices, uint32_t vertex_count, const glm::vec3& position_offset, const glm::vec3& position_scale);
+        // Returns the first index in units of index_type
+        uint32_t vulkan_upload_indices(VulkanRendererData& renderer, const uint32_t* indices, uint32_t index_count, VkIndexType index_type, uint32_t base_vertex);
+        // Suballocates size bytes, growing the buffer and the allocator when no free range fits
+        VkDeviceSize vulkan_allocate_geometry_range(VulkanRendererData& renderer, ise::util::RangeAllocator& allocator, VkBuffer& buffer, MemoryAllocation& buffer_memory, VkDeviceSize& capacity, VkDeviceSize size, VkDeviceSize alignment, VkBufferUsageFlags usage);
+        // Ranges are only reused after every frame submitted until now finished, see vulkan_defer_destroy
+        void vulkan_release_geometry(VulkanRendererData& renderer, uint32_t first_vertex, uint32_t vertex_count, uint32_t first_index, uint32_t index_count, VkIndexType index_type);
+        void vulkan_upload_mesh_data(VulkanRendererData& renderer, const Vertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, Mesh& mesh);
+        // Deduplicates vertices by their exact bytes, in parallel over chunks of the index lists when thread_count is not 1 (0 uses every core).
+        // The output is identical for every thread count.
+        void vulkan_build_mesh_data(const RenderGeometry& geometry, const glm::vec3& offset, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, glm::vec3& bounds_min, glm::vec3& bounds_max, uint32_t thread_count = 1);
+        void vulkan_optimize_mesh_data(VulkanRendererData& renderer, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+        uint64_t vulkan_hash_bytes(const void* data, size_t size, uint64_t hash = 0);
+        uint64_t vulkan_hash_geometry(const RenderGeometry& geometry);
+        std::string vulkan_get_mesh_key(const std::string& source_path, uint64_t content_hash);
+        const Mesh* vulkan_find_mesh(VulkanRendererData& renderer, const std::string& source_path, uint64_t content_hash);
+        const Mesh* vulkan_create_mesh(VulkanRendererData& renderer, const std::string& source_path, uint64_t content_hash, const Vertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, const glm::vec3& bounds_min, const glm::vec3& bounds_max);
+        void vulkan_invalidate_recorded_command_buffers(VulkanRendererData& renderer);
+        void vulkan_free_command_buffers(VulkanRendererData& renderer);
+        void vulkan_upload_draw_instances(VulkanRendererData& renderer, size_t command_buffer_index);
+        void vulkan_destroy_instance_buffers(VulkanRendererData& renderer);
+        void vulkan_destroy_recording_workers(VulkanRendererData& renderer);
+
+        // Bindless textures, see VulkanBindlessTextures.cpp
+        bool vulkan_check_bindless_texture_support(const VkPhysicalDeviceVulkan12Features& features);
+        // custom_config.max_bindless_textures clamped to the device limits
+        uint32_t vulkan_get_bindless_texture_capacity(VulkanRendererData& renderer);
+        // Writes the texture into a free slot the first time, returns its slot
+        uint32_t vulkan_register_bindless_texture(VulkanRendererData& renderer, RenderTexture& render_texture);
+        // Rewrites the slot of a registered texture, frames in flight must not sample it
+        void vulkan_write_bindless_texture(VulkanRendererData& renderer, const RenderTexture& render_texture);
+        // The slot is only reused after every frame submitted until now finished
+        void vulkan_release_bindless_texture(VulkanRendererData& renderer, RenderTexture& render_texture);
+        // Points every described object sampling key at its current slot, slot 0 once key is gone
+        void vulkan_update_texture_users(VulkanRendererData& renderer, const std::string& key);
+        void vulkan_destroy_bindless_textures(VulkanRendererData& renderer);
+
+        // Deferred destruction, see VulkanDeletionQueue.cpp
+        // Runs destroy once every frame submitted and every upload recorded until now finished, without waiting for either
+        void vulkan_defer_destroy(VulkanRendererData& renderer, std::function<void(VulkanRendererData& renderer)> destroy);
+        // Called by vulkan_draw_frame after the fence wait
+        void vulkan_retire_deletion_queue(VulkanRendererData& renderer);
+        // Runs everything left, the device must be idle and the uploads finished
+        void vulkan_flush_deletion_queue(VulkanRendererData& renderer);
+
+        // Asynchronous texture loads
+        RenderTexture* vulkan_get_placeholder_texture(VulkanRendererData& renderer);
+        // Uploads decoded textures within custom_config.texture_upload_budget and switches completed ones over, never waits
+        void vulkan_process_texture_loads(VulkanRendererData& renderer);
+        void vulkan_cancel_texture_loads(VulkanRendererData& renderer, const std::string& key);
+        void vulkan_destroy_texture_loads(VulkanRendererData& renderer);
+        // Created with the first asynchronous load or virtual texture
+        ise::util::TaskQueue& vulkan_get_texture_decode_queue(VulkanRendererData& renderer);
+
+        // Virtual textures, see VulkanVirtualTextures.cpp
+        bool vulkan_check_virtual_texturing_support(VulkanRendererData& renderer);
+        void vulkan_create_virtual_texture_atlas(VulkanRendererData& renderer);
+        // Reads the feedback of the frame whose fence was just waited for, streams pages in within the per frame limits and
+        // writes the page table of the frame about to be recorded. Never waits.
+        void vulkan_process_virtual_textures(VulkanRendererData& renderer);
+        // Frees pages no frame asked for recently until count pages are free or on their way back
+        void vulkan_evict_virtual_texture_pages(VulkanRendererData& renderer, uint32_t count);
+        void vulkan_update_virtual_texture_page_table(VulkanRendererData& renderer, VirtualTexture& virtual_texture);
+        // Makes the feedback written by the frame visible to the host once its fence signaled
+        void vulkan_record_virtual_texture_feedback_barrier(VulkanRendererData& renderer, VkCommandBuffer command_buffer);
+        void vulkan_recreate_virtual_texturing_pipelines(VulkanRendererData& renderer);
+        void vulkan_destroy_virtual_texturing_resources(VulkanRendererData& renderer);
+
+        // Uploads, see UploadQueue and VulkanUploads.cpp. Every upload is staged through renderer.staging_ring.
+        // Both return the open batch, beginning a new one when needed
+        VkCommandBuffer vulkan_get_upload_transfer_commands(VulkanRendererData& renderer);
+        VkCommandBuffer vulkan_get_upload_graphics_commands(VulkanRendererData& renderer);
+        // Hands a range written by the transfer commands over to the graphics queue, dst_stage and dst_access being its first use there
+        void vulkan_transfer_buffer_ownership(VulkanRendererData& renderer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+        // Same for every mip level of a color image, transitioning it from old_layout to new_layout on the way
+        void vulkan_transfer_image_ownership(VulkanRendererData& renderer, VkImage image, uint32_t mip_levels, VkImageLayout old_layout, VkImageLayout new_layout, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+        // Submits the open batch, does not wait. Called by vulkan_draw_frame before every frame.
+        void vulkan_flush_uploads(VulkanRendererData& renderer);
+        // Frees finished batches and their staging memory without waiting
+        void vulkan_retire_uploads(VulkanRendererData& renderer);
+        // Flushes first when upload_value is the open batch
+        void vulkan_wait_for_upload(VulkanRendererData& renderer, uint64_t upload_value);
+        void vulkan_finish_uploads(VulkanRendererData& renderer);
+        void vulkan_destroy_upload_queue(VulkanRendererData& renderer);
+        // size must not exceed the ring. Waits for older uploads when the ring is full.
+        StagingSlice vulkan_staging_allocate(VulkanRendererData& renderer, VkDeviceSize size, VkDeviceSize alignment);
+        void vulkan_staging_retire(VulkanRendererData& renderer);
+        void vulkan_destroy_staging_ring(VulkanRendererData& renderer);
+        // write fills the staging memory of element_count elements starting at first_element, called once per chunk.
+        // The written range is handed over to the graphics queue for dst_stage and dst_access.
+        void vulkan_upload_buffer_data(VulkanRendererData& renderer, VkBuffer buffer, VkDeviceSize buffer_offset, VkDeviceSize element_size, VkDeviceSize element_count, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access, const std::function<void(void* data, VkDeviceSize first_element, VkDeviceSize element_count)>& write);
+        // Tightly packed blocks of format, see texture_format_get_block_size. The level must be in TRANSFER_DST_OPTIMAL.
+        // Large levels are copied a few block rows at a time.
+        void vulkan_upload_image_data(VulkanRendererData& renderer, VkImage image, uint32_t mip_level, uint32_t width, uint32_t height, VkFormat format, const void* pixels);
 
         // Low level command buffers stuff
+        // Submits to the graphics queue and waits for it to be idle, only for rare work like growing the geometry buffers
         VkCommandBuffer vulkan_begin_single_time_commands(VulkanRendererData& renderer);
         void vulkan_end_single_time_commands(VulkanRendererData& renderer, VkCommandBuffer command_buffer);
         void vulkan_update_uniform_buffer(VulkanRendererData& renderer, uint32_t current_image);
-        void vulkan_record_command_buffer(VulkanRendererData& renderer, VkCommandBuffer command_buffer, uint32_t image_index);
+        void vulkan_record_command_buffer(VulkanRendererData& renderer, size_t command_buffer_index, uint32_t image_index);
+        void vulkan_build_culling_bounds(VulkanRendererData& renderer);
+        void vulkan_cull_render_objects(VulkanRendererData& renderer);
+        void vulkan_build_draw_commands(VulkanRendererData& renderer);
+        uint64_t vulkan_get_draw_sort_key(const RenderObject& render_object);
+        // The object transform with the dequantization of packed positions folded in
+        glm::mat4 vulkan_get_instance_transform(const RenderObject& render_object);
+        void vulkan_record_draw_commands(VulkanRendererData& renderer, VkCommandBuffer command_buffer, size_t command_buffer_index, size_t first_draw, size_t draw_count);
+
+        std::array<glm::vec4, 6> vulkan_extract_frustum_planes(const glm::mat4& view_projection);
+
+        // GPU driven culling, see VulkanGpuCulling.cpp
+        bool vulkan_check_gpu_driven_culling_support(VkPhysicalDevice device);
+        void vulkan_build_gpu_culling_objects(VulkanRendererData& renderer);
+        void vulkan_update_gpu_culling_frame(VulkanRendererData& renderer, GpuCullingFrame& frame);
+        void vulkan_record_gpu_culling(VulkanRendererData& renderer, VkCommandBuffer command_buffer);
+        void vulkan_record_gpu_culled_draws(VulkanRendererData& renderer, VkCommandBuffer command_buffer);
+        void vulkan_recreate_gpu_culling_graphics_pipeline(VulkanRendererData& renderer);
+        void vulkan_destroy_gpu_culling_resources(VulkanRendererData& renderer);
+
+        // Dynamic resolution, see VulkanDynamicResolution.cpp
+        // Both bounds of the config, clamped
+        float vulkan_get_min_render_scale(const VulkanRendererConfig& config);
+        float vulkan_get_max_render_scale(const VulkanRendererConfig& config);
+        // Whether the render pass should end in the render target, needs a scale below 1 and blits to the swapchain format
+        bool vulkan_check_dynamic_resolution_support(VulkanRendererData& renderer);
+        // Size of the framebuffers and their attachments, the render target when enabled
+        VkExtent2D vulkan_get_framebuffer_extent(VulkanRendererData& renderer);
+        // Render area, viewport and scissor of the scene
+        VkExtent2D vulkan_get_render_extent(VulkanRendererData& renderer);
+        // Clamps scale to the bounds and re-records the command buffers when the render extent changed
+        void vulkan_set_render_scale(VulkanRendererData& renderer, float scale);
+        // Reads the timestamps of the frame whose fence was just waited for and moves the scale when the budget calls for it
+        void vulkan_update_dynamic_resolution(VulkanRendererData& renderer);
+        void vulkan_record_frame_timestamp(VulkanRendererData& renderer, VkCommandBuffer command_buffer, bool end);
+        // Scales the rendered part of the render target up to the swapchain image and leaves it presentable
+        void vulkan_record_render_target_blit(VulkanRendererData& renderer, VkCommandBuffer command_buffer, uint32_t image_index);
+        void vulkan_destroy_dynamic_resolution_resources(VulkanRendererData& renderer);
 
         void vulkan_handle_vk_result(VkResult result);
 
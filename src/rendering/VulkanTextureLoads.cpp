@@ -0,0 +1,307 @@
+#include "VulkanRendererUgly.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "TextureCache.h"
+#include "../util/FileReader.h"
+
+namespace
+{
+    bool texture_load_finished(const ise::rendering::TextureLoadHandle& load)
+    {
+        return load->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // Only ever called with renderer.mutex held, so the promise is set exactly once
+    void texture_load_finish(ise::rendering::TextureLoad& load, ise::rendering::TextureLoadState state, const std::string& error)
+    {
+        load.state = state;
+        load.error = error;
+        load.promise.set_value(state);
+    }
+
+    // Decodes and encodes to compressed_format once, later loads read the cached mip chain
+    bool texture_load_decode_compressed(ise::rendering::TextureLoad& load, VkFormat compressed_format)
+    {
+        if (ise::rendering::texture_cache_read(load.path, compressed_format, load.compressed))
+        {
+            return true;
+        }
+
+        std::vector<char> source_data = ise::util::readFile(load.path);
+
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(source_data.data()), static_cast<int>(source_data.size()), &width, &height, &channels, STBI_rgb_alpha);
+        if (pixels == nullptr)
+        {
+            const char* reason = stbi_failure_reason();
+            load.decode_error = std::format("failed to load texture image {0}: {1}", load.path, reason != nullptr ? reason : "unknown error");
+            return false;
+        }
+
+        ise::rendering::texture_compress(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height), compressed_format, load.compressed);
+        stbi_image_free(pixels);
+
+        ise::rendering::texture_cache_write(load.path, ise::rendering::vulkan_hash_bytes(source_data.data(), source_data.size()), load.compressed);
+        return true;
+    }
+
+    bool texture_load_decode_raw(ise::rendering::TextureLoad& load)
+    {
+        ise::rendering::RenderTextureRaw& raw_texture = load.raw_texture;
+        raw_texture.pixels = stbi_load(load.path.c_str(), &raw_texture.width, &raw_texture.height, &raw_texture.channels, STBI_rgb_alpha);
+        if (raw_texture.pixels == nullptr)
+        {
+            const char* reason = stbi_failure_reason();
+            load.decode_error = std::format("failed to load texture image {0}: {1}", load.path, reason != nullptr ? reason : "unknown error");
+            return false;
+        }
+
+        return true;
+    }
+
+    void texture_load_decode(const ise::rendering::TextureLoadHandle& load, VkFormat compressed_format)
+    {
+        // Destroyed while still queued
+        if (load->state != ise::rendering::TEXTURE_LOAD_DECODING)
+        {
+            return;
+        }
+
+        bool decoded = compressed_format != VK_FORMAT_UNDEFINED ? texture_load_decode_compressed(*load, compressed_format) : texture_load_decode_raw(*load);
+
+        // Loses against vulkan_cancel_texture_loads, the pixels are then freed with the last handle
+        ise::rendering::TextureLoadState expected = ise::rendering::TEXTURE_LOAD_DECODING;
+        load->state.compare_exchange_strong(expected, decoded ? ise::rendering::TEXTURE_LOAD_DECODED : ise::rendering::TEXTURE_LOAD_FAILED);
+    }
+
+    // A decode that threw never leaves TEXTURE_LOAD_DECODING, what it threw is in the future of its task
+    bool texture_load_decode_threw(ise::rendering::TextureLoad& load)
+    {
+        if (!load.decode_task.valid() || load.decode_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return false;
+        }
+
+        try
+        {
+            load.decode_task.get();
+            return false;
+        }
+        catch (const std::exception& exception)
+        {
+            load.decode_error = std::format("failed to load texture image {0}: {1}", load.path, exception.what());
+            return true;
+        }
+    }
+
+    VkDeviceSize texture_load_get_upload_size(const ise::rendering::TextureLoad& load)
+    {
+        if (load.compressed.format != VK_FORMAT_UNDEFINED)
+        {
+            return load.compressed.data.size();
+        }
+
+        return static_cast<VkDeviceSize>(load.raw_texture.width) * load.raw_texture.height * 4;
+    }
+
+    void texture_load_upload(ise::rendering::VulkanRendererData& renderer, ise::rendering::TextureLoad& load)
+    {
+        if (load.compressed.format != VK_FORMAT_UNDEFINED)
+        {
+            ise::rendering::vulkan_create_compressed_texture_image_unsafe(renderer, load.texture, load.compressed);
+        }
+        else
+        {
+            load.texture.raw_texture = load.raw_texture;
+            ise::rendering::vulkan_create_texture_image_unsafe(renderer, load.texture);
+        }
+        ise::rendering::vulkan_create_texture_sampler_unsafe(renderer, load.texture);
+
+        // The staging ring holds a copy now
+        stbi_image_free(load.raw_texture.pixels);
+        load.raw_texture.pixels = nullptr;
+        load.texture.raw_texture.pixels = nullptr;
+        load.compressed = ise::rendering::CompressedTexture{};
+
+        // The image ends in the open batch, whatever the staging ring flushed on the way
+        load.upload_value = renderer.upload_submitted_value + 1;
+        load.state = ise::rendering::TEXTURE_LOAD_UPLOADING;
+    }
+
+    void texture_load_make_resident(ise::rendering::VulkanRendererData& renderer, ise::rendering::TextureLoad& load)
+    {
+        // Destroying the texture cancels its loads, so the key still holds the placeholder
+        ise::rendering::RenderTexture* render_texture = renderer.render_textures[load.key];
+        *render_texture = load.texture;
+        render_texture->placeholder = false;
+        load.texture = ise::rendering::RenderTexture{};
+
+        // Frames in flight may still sample the placeholder's slot, so the texture gets a slot of its own and its users
+        // are pointed at it. Draw order does not change, the sort key does not hold the index.
+        ise::rendering::vulkan_register_bindless_texture(renderer, *render_texture);
+        ise::rendering::vulkan_update_texture_users(renderer, load.key);
+        texture_load_finish(load, ise::rendering::TEXTURE_LOAD_RESIDENT, "");
+    }
+}
+
+ise::rendering::TextureLoadHandle ise::rendering::vulkan_load_texture_async(VulkanRendererData& renderer, const std::string& key, const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+
+    ise::util::TaskQueue& decode_queue = vulkan_get_texture_decode_queue(renderer);
+    RenderTexture* placeholder_texture = vulkan_get_placeholder_texture(renderer);
+
+    // Also cancels a load of the same key still in flight
+    vulkan_destroy_render_texture_unsafe(key, renderer);
+
+    RenderTexture* render_texture = new RenderTexture{};
+    render_texture->mip_levels = placeholder_texture->mip_levels;
+    render_texture->image = VK_NULL_HANDLE;
+    render_texture->image_view = placeholder_texture->image_view;
+    render_texture->sampler = placeholder_texture->sampler;
+    render_texture->placeholder = true;
+    render_texture->bindless_index = placeholder_texture->bindless_index;
+    renderer.render_textures[key] = render_texture;
+
+    // Objects already pointing at the key sample the placeholder until the load finished
+    vulkan_update_texture_users(renderer, key);
+
+    TextureLoadHandle load = std::make_shared<TextureLoad>();
+    load->key = key;
+    load->path = path;
+    renderer.texture_loads.push_back(load);
+
+    VkFormat compressed_format = renderer.compressed_texture_format;
+    load->decode_task = decode_queue.push([load, compressed_format]() { texture_load_decode(load, compressed_format); });
+
+    return load;
+}
+
+ise::util::TaskQueue& ise::rendering::vulkan_get_texture_decode_queue(VulkanRendererData& renderer)
+{
+    if (!renderer.texture_decode_queue)
+    {
+        uint32_t thread_count = renderer.custom_config.texture_decode_threads;
+        if (thread_count == 0)
+        {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        renderer.texture_decode_queue = std::make_unique<ise::util::TaskQueue>(thread_count);
+    }
+
+    return *renderer.texture_decode_queue;
+}
+
+ise::rendering::RenderTexture* ise::rendering::vulkan_get_placeholder_texture(VulkanRendererData& renderer)
+{
+    if (renderer.placeholder_texture != nullptr)
+    {
+        return renderer.placeholder_texture;
+    }
+
+    // Mid grey, lit surfaces still read as such while their texture loads
+    stbi_uc pixel[4] = { 128, 128, 128, 255 };
+
+    RenderTexture* placeholder_texture = new RenderTexture{};
+    placeholder_texture->raw_texture = { 1, 1, 4, pixel };
+    vulkan_create_texture_image_unsafe(renderer, *placeholder_texture);
+    vulkan_create_texture_sampler_unsafe(renderer, *placeholder_texture);
+    placeholder_texture->raw_texture.pixels = nullptr;
+
+    renderer.placeholder_texture = placeholder_texture;
+    return placeholder_texture;
+}
+
+void ise::rendering::vulkan_process_texture_loads(VulkanRendererData& renderer)
+{
+    if (renderer.texture_loads.empty())
+    {
+        return;
+    }
+
+    VkDeviceSize uploaded_bytes = 0;
+    for (const TextureLoadHandle& load : renderer.texture_loads)
+    {
+        TextureLoadState state = load->state;
+        if (state == TEXTURE_LOAD_DECODED)
+        {
+            // Whatever does not fit waits for the next frame, so a folder of images does not stall a single one
+            VkDeviceSize size = texture_load_get_upload_size(*load);
+            if (uploaded_bytes > 0 && uploaded_bytes + size > renderer.custom_config.texture_upload_budget)
+            {
+                continue;
+            }
+
+            uploaded_bytes += size;
+            texture_load_upload(renderer, *load);
+        }
+        else if (state == TEXTURE_LOAD_UPLOADING && load->upload_value <= renderer.upload_completed_value)
+        {
+            texture_load_make_resident(renderer, *load);
+        }
+        else if (state == TEXTURE_LOAD_DECODING && texture_load_decode_threw(*load))
+        {
+            // Loses against vulkan_cancel_texture_loads like the worker does, the next frame finishes it either way
+            TextureLoadState expected = TEXTURE_LOAD_DECODING;
+            load->state.compare_exchange_strong(expected, TEXTURE_LOAD_FAILED);
+        }
+        else if (state == TEXTURE_LOAD_FAILED)
+        {
+            // Failed to decode, the placeholder stays bound
+            texture_load_finish(*load, TEXTURE_LOAD_FAILED, load->decode_error);
+        }
+    }
+
+    std::erase_if(renderer.texture_loads, texture_load_finished);
+}
+
+void ise::rendering::vulkan_cancel_texture_loads(VulkanRendererData& renderer, const std::string& key)
+{
+    for (const TextureLoadHandle& load : renderer.texture_loads)
+    {
+        if (load->key != key)
+        {
+            continue;
+        }
+
+        // Its upload may not even be submitted yet, the image goes once it landed
+        if (load->state.exchange(TEXTURE_LOAD_FAILED) == TEXTURE_LOAD_UPLOADING)
+        {
+            vulkan_defer_destroy(renderer, [texture = load->texture](VulkanRendererData& renderer) mutable { vulkan_destroy_render_texture_image_unsafe(renderer, texture); });
+            load->texture = RenderTexture{};
+        }
+        texture_load_finish(*load, TEXTURE_LOAD_FAILED, "texture was destroyed before it became resident");
+    }
+
+    std::erase_if(renderer.texture_loads, texture_load_finished);
+}
+
+void ise::rendering::vulkan_destroy_texture_loads(VulkanRendererData& renderer)
+{
+    // Waits for the decodes already running, queued ones are dropped
+    renderer.texture_decode_queue.reset();
+
+    for (const TextureLoadHandle& load : renderer.texture_loads)
+    {
+        if (load->state.exchange(TEXTURE_LOAD_FAILED) == TEXTURE_LOAD_UPLOADING)
+        {
+            vulkan_destroy_render_texture_image_unsafe(renderer, load->texture);
+        }
+        texture_load_finish(*load, TEXTURE_LOAD_FAILED, "renderer was destroyed before the texture became resident");
+    }
+    renderer.texture_loads.clear();
+
+    if (renderer.placeholder_texture != nullptr)
+    {
+        vulkan_destroy_render_texture_image_unsafe(renderer, *renderer.placeholder_texture);
+        delete renderer.placeholder_texture;
+        renderer.placeholder_texture = nullptr;
+    }
+}
@@ -0,0 +1,463 @@
+#include "VulkanRendererUgly.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace
+{
+    VkSemaphore upload_create_timeline_semaphore(ise::rendering::VulkanRendererData& renderer, uint64_t initial_value)
+    {
+        VkSemaphoreTypeCreateInfo type_info{};
+        type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        type_info.initialValue = initial_value;
+
+        VkSemaphoreCreateInfo semaphore_info{};
+        semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphore_info.pNext = &type_info;
+
+        VkSemaphore semaphore;
+        if (vkCreateSemaphore(renderer.device, &semaphore_info, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload timeline semaphore!");
+        }
+
+        return semaphore;
+    }
+
+    VkCommandBuffer upload_begin_command_buffer(ise::rendering::VulkanRendererData& renderer, VkCommandPool command_pool)
+    {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandPool = command_pool;
+        alloc_info.commandBufferCount = 1;
+
+        VkCommandBuffer command_buffer;
+        ise::rendering::vulkan_handle_vk_result(vkAllocateCommandBuffers(renderer.device, &alloc_info, &command_buffer));
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        ise::rendering::vulkan_handle_vk_result(vkBeginCommandBuffer(command_buffer, &begin_info));
+
+        return command_buffer;
+    }
+
+    ise::rendering::UploadBatch& upload_get_batch(ise::rendering::VulkanRendererData& renderer)
+    {
+        ise::rendering::UploadQueue& uploads = renderer.uploads;
+        if (!uploads.recording)
+        {
+            uploads.batch.transfer_command_buffer = upload_begin_command_buffer(renderer, uploads.transfer_command_pool);
+            uploads.batch.graphics_command_buffer = uploads.transfer_family == uploads.graphics_family ? uploads.batch.transfer_command_buffer : upload_begin_command_buffer(renderer, uploads.graphics_command_pool);
+            uploads.batch.upload_value = renderer.upload_submitted_value + 1;
+            uploads.recording = true;
+        }
+
+        return uploads.batch;
+    }
+
+    void upload_free_batch(ise::rendering::VulkanRendererData& renderer, ise::rendering::UploadBatch& batch)
+    {
+        ise::rendering::UploadQueue& uploads = renderer.uploads;
+        vkFreeCommandBuffers(renderer.device, uploads.transfer_command_pool, 1, &batch.transfer_command_buffer);
+        if (batch.graphics_command_buffer != batch.transfer_command_buffer)
+        {
+            vkFreeCommandBuffers(renderer.device, uploads.graphics_command_pool, 1, &batch.graphics_command_buffer);
+        }
+        batch = ise::rendering::UploadBatch{};
+    }
+}
+
+void ise::rendering::vulkan_create_upload_queue(VulkanRendererData& renderer)
+{
+    UploadQueue& uploads = renderer.uploads;
+    QueueFamilyIndices indices = vulkan_find_queue_families(renderer.physical_device, renderer);
+    uploads.graphics_family = indices.graphics_family.value();
+    uploads.transfer_family = indices.transfer_family.value();
+
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(renderer.physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(renderer.physical_device, &queue_family_count, queue_families.data());
+    uploads.image_granularity = queue_families[uploads.transfer_family].minImageTransferGranularity;
+
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = uploads.transfer_family;
+
+    if (vkCreateCommandPool(renderer.device, &pool_info, nullptr, &uploads.transfer_command_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create transfer command pool!");
+    }
+
+    uploads.graphics_command_pool = uploads.transfer_command_pool;
+    if (uploads.graphics_family != uploads.transfer_family)
+    {
+        pool_info.queueFamilyIndex = uploads.graphics_family;
+        if (vkCreateCommandPool(renderer.device, &pool_info, nullptr, &uploads.graphics_command_pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload graphics command pool!");
+        }
+    }
+
+    // A recreated renderer keeps counting where the previous device stopped
+    renderer.upload_completed_value = renderer.upload_submitted_value;
+    uploads.transfer_semaphore = upload_create_timeline_semaphore(renderer, renderer.upload_submitted_value);
+    uploads.upload_semaphore = upload_create_timeline_semaphore(renderer, renderer.upload_submitted_value);
+
+    uploads.recording = false;
+    uploads.batch = UploadBatch{};
+    uploads.submitted_batches.clear();
+    uploads.transfer_wait_value = 0;
+}
+
+VkCommandBuffer ise::rendering::vulkan_get_upload_transfer_commands(VulkanRendererData& renderer)
+{
+    return upload_get_batch(renderer).transfer_command_buffer;
+}
+
+VkCommandBuffer ise::rendering::vulkan_get_upload_graphics_commands(VulkanRendererData& renderer)
+{
+    return upload_get_batch(renderer).graphics_command_buffer;
+}
+
+void ise::rendering::vulkan_transfer_buffer_ownership(VulkanRendererData& renderer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    UploadQueue& uploads = renderer.uploads;
+    UploadBatch& batch = upload_get_batch(renderer);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    if (uploads.transfer_family == uploads.graphics_family)
+    {
+        // One queue, an ordinary barrier makes the copy visible to the frames submitted after the batch
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstAccessMask = dst_access;
+        vkCmdPipelineBarrier(batch.transfer_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        return;
+    }
+
+    // Released by the transfer queue, acquired by the graphics submission waiting for it
+    barrier.srcQueueFamilyIndex = uploads.transfer_family;
+    barrier.dstQueueFamilyIndex = uploads.graphics_family;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(batch.transfer_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = dst_access;
+    vkCmdPipelineBarrier(batch.graphics_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dst_stage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void ise::rendering::vulkan_transfer_image_ownership(VulkanRendererData& renderer, VkImage image, uint32_t mip_levels, VkImageLayout old_layout, VkImageLayout new_layout, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    UploadQueue& uploads = renderer.uploads;
+    UploadBatch& batch = upload_get_batch(renderer);
+
+    // Release and acquire carry the same transition, which then happens once between them
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mip_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    if (uploads.transfer_family == uploads.graphics_family)
+    {
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstAccessMask = dst_access;
+        vkCmdPipelineBarrier(batch.transfer_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        return;
+    }
+
+    barrier.srcQueueFamilyIndex = uploads.transfer_family;
+    barrier.dstQueueFamilyIndex = uploads.graphics_family;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(batch.transfer_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = dst_access;
+    vkCmdPipelineBarrier(batch.graphics_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void ise::rendering::vulkan_flush_uploads(VulkanRendererData& renderer)
+{
+    UploadQueue& uploads = renderer.uploads;
+    if (!uploads.recording)
+    {
+        return;
+    }
+
+    UploadBatch& batch = uploads.batch;
+    vulkan_handle_vk_result(vkEndCommandBuffer(batch.transfer_command_buffer));
+    if (batch.graphics_command_buffer != batch.transfer_command_buffer)
+    {
+        vulkan_handle_vk_result(vkEndCommandBuffer(batch.graphics_command_buffer));
+    }
+
+    VkTimelineSemaphoreSubmitInfo transfer_timeline_info{};
+    transfer_timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    transfer_timeline_info.signalSemaphoreValueCount = 1;
+    transfer_timeline_info.pSignalSemaphoreValues = &batch.upload_value;
+
+    VkSubmitInfo transfer_submit_info{};
+    transfer_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    transfer_submit_info.pNext = &transfer_timeline_info;
+    transfer_submit_info.commandBufferCount = 1;
+    transfer_submit_info.pCommandBuffers = &batch.transfer_command_buffer;
+    transfer_submit_info.signalSemaphoreCount = 1;
+
+    VkPipelineStageFlags transfer_wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    if (uploads.transfer_wait_value > 0)
+    {
+        transfer_timeline_info.waitSemaphoreValueCount = 1;
+        transfer_timeline_info.pWaitSemaphoreValues = &uploads.transfer_wait_value;
+        transfer_submit_info.waitSemaphoreCount = 1;
+        transfer_submit_info.pWaitSemaphores = &uploads.upload_semaphore;
+        transfer_submit_info.pWaitDstStageMask = &transfer_wait_stage;
+    }
+
+    if (uploads.transfer_family == uploads.graphics_family)
+    {
+        // Everything was recorded into the one command buffer
+        transfer_submit_info.pSignalSemaphores = &uploads.upload_semaphore;
+        vulkan_handle_vk_result(vkQueueSubmit(renderer.transfer_queue, 1, &transfer_submit_info, VK_NULL_HANDLE));
+    }
+    else
+    {
+        transfer_submit_info.pSignalSemaphores = &uploads.transfer_semaphore;
+        vulkan_handle_vk_result(vkQueueSubmit(renderer.transfer_queue, 1, &transfer_submit_info, VK_NULL_HANDLE));
+
+        // Only the acquires and the graphics only work wait for the copies, on the device
+        VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkTimelineSemaphoreSubmitInfo graphics_timeline_info{};
+        graphics_timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        graphics_timeline_info.waitSemaphoreValueCount = 1;
+        graphics_timeline_info.pWaitSemaphoreValues = &batch.upload_value;
+        graphics_timeline_info.signalSemaphoreValueCount = 1;
+        graphics_timeline_info.pSignalSemaphoreValues = &batch.upload_value;
+
+        VkSubmitInfo graphics_submit_info{};
+        graphics_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        graphics_submit_info.pNext = &graphics_timeline_info;
+        graphics_submit_info.waitSemaphoreCount = 1;
+        graphics_submit_info.pWaitSemaphores = &uploads.transfer_semaphore;
+        graphics_submit_info.pWaitDstStageMask = &wait_stage;
+        graphics_submit_info.commandBufferCount = 1;
+        graphics_submit_info.pCommandBuffers = &batch.graphics_command_buffer;
+        graphics_submit_info.signalSemaphoreCount = 1;
+        graphics_submit_info.pSignalSemaphores = &uploads.upload_semaphore;
+        vulkan_handle_vk_result(vkQueueSubmit(renderer.graphics_queue, 1, &graphics_submit_info, VK_NULL_HANDLE));
+    }
+
+    renderer.upload_submitted_value = batch.upload_value;
+    uploads.transfer_wait_value = 0;
+    uploads.submitted_batches.push_back(batch);
+    uploads.batch = UploadBatch{};
+    uploads.recording = false;
+}
+
+void ise::rendering::vulkan_retire_uploads(VulkanRendererData& renderer)
+{
+    UploadQueue& uploads = renderer.uploads;
+    if (!uploads.submitted_batches.empty())
+    {
+        uint64_t completed_value = 0;
+        vulkan_handle_vk_result(vkGetSemaphoreCounterValue(renderer.device, uploads.upload_semaphore, &completed_value));
+        renderer.upload_completed_value = std::max(renderer.upload_completed_value, completed_value);
+    }
+
+    while (!uploads.submitted_batches.empty() && uploads.submitted_batches.front().upload_value <= renderer.upload_completed_value)
+    {
+        upload_free_batch(renderer, uploads.submitted_batches.front());
+        uploads.submitted_batches.pop_front();
+    }
+
+    vulkan_staging_retire(renderer);
+}
+
+void ise::rendering::vulkan_wait_for_upload(VulkanRendererData& renderer, uint64_t upload_value)
+{
+    if (upload_value <= renderer.upload_completed_value)
+    {
+        return;
+    }
+
+    if (upload_value > renderer.upload_submitted_value)
+    {
+        vulkan_flush_uploads(renderer);
+        upload_value = std::min(upload_value, renderer.upload_submitted_value);
+    }
+
+    VkSemaphoreWaitInfo wait_info{};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &renderer.uploads.upload_semaphore;
+    wait_info.pValues = &upload_value;
+    vulkan_handle_vk_result(vkWaitSemaphores(renderer.device, &wait_info, UINT64_MAX));
+
+    vulkan_retire_uploads(renderer);
+}
+
+void ise::rendering::vulkan_finish_uploads(VulkanRendererData& renderer)
+{
+    vulkan_flush_uploads(renderer);
+    vulkan_wait_for_upload(renderer, renderer.upload_submitted_value);
+}
+
+void ise::rendering::vulkan_destroy_upload_queue(VulkanRendererData& renderer)
+{
+    UploadQueue& uploads = renderer.uploads;
+
+    // Destroying the pools frees whatever command buffers are left
+    vkDestroySemaphore(renderer.device, uploads.upload_semaphore, nullptr);
+    vkDestroySemaphore(renderer.device, uploads.transfer_semaphore, nullptr);
+    if (uploads.graphics_command_pool != uploads.transfer_command_pool)
+    {
+        vkDestroyCommandPool(renderer.device, uploads.graphics_command_pool, nullptr);
+    }
+    vkDestroyCommandPool(renderer.device, uploads.transfer_command_pool, nullptr);
+
+    uploads = UploadQueue{};
+}
+
+void ise::rendering::vulkan_create_staging_ring(VulkanRendererData& renderer)
+{
+    StagingRing& ring = renderer.staging_ring;
+    ring.size = renderer.custom_config.staging_ring_size;
+    ring.head = 0;
+    ring.tail = 0;
+    ring.regions.clear();
+
+    vulkan_create_buffer(renderer, ring.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, ring.buffer, ring.memory);
+}
+
+ise::rendering::StagingSlice ise::rendering::vulkan_staging_allocate(VulkanRendererData& renderer, VkDeviceSize size, VkDeviceSize alignment)
+{
+    StagingRing& ring = renderer.staging_ring;
+    if (size > ring.size)
+    {
+        throw std::runtime_error("failed to allocate staging memory, the upload is larger than the ring!");
+    }
+
+    while (true)
+    {
+        vulkan_staging_retire(renderer);
+
+        if (ring.regions.empty())
+        {
+            ring.head = 0;
+            ring.tail = 0;
+        }
+
+        // Free space is [head, size) and [0, tail) while head is ahead of tail, [head, tail) once it wrapped around
+        VkDeviceSize offset = (ring.head + alignment - 1) / alignment * alignment;
+        bool fits = false;
+        if (ring.regions.empty() || ring.head > ring.tail)
+        {
+            if (offset + size <= ring.size)
+            {
+                fits = true;
+            }
+            else if (size <= ring.tail)
+            {
+                offset = 0;
+                fits = true;
+            }
+        }
+        else
+        {
+            fits = offset + size <= ring.tail;
+        }
+
+        if (fits)
+        {
+            // Read by the next upload submission
+            ring.head = offset + size;
+            ring.regions.push_back({ ring.head, renderer.upload_submitted_value + 1 });
+            return { ring.buffer, offset, static_cast<char*>(ring.memory.mapped) + offset };
+        }
+
+        // The whole ring is still being read, the oldest region is the first to come back
+        vulkan_wait_for_upload(renderer, ring.regions.front().upload_value);
+    }
+}
+
+void ise::rendering::vulkan_staging_retire(VulkanRendererData& renderer)
+{
+    StagingRing& ring = renderer.staging_ring;
+    while (!ring.regions.empty() && ring.regions.front().upload_value <= renderer.upload_completed_value)
+    {
+        ring.tail = ring.regions.front().end;
+        ring.regions.pop_front();
+    }
+}
+
+void ise::rendering::vulkan_destroy_staging_ring(VulkanRendererData& renderer)
+{
+    StagingRing& ring = renderer.staging_ring;
+    if (ring.buffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(renderer.device, ring.buffer, nullptr);
+        vulkan_free_memory(renderer, ring.memory);
+    }
+    ring = StagingRing{};
+}
+
+void ise::rendering::vulkan_upload_buffer_data(VulkanRendererData& renderer, VkBuffer buffer, VkDeviceSize buffer_offset, VkDeviceSize element_size, VkDeviceSize element_count, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access, const std::function<void(void* data, VkDeviceSize first_element, VkDeviceSize element_count)>& write)
+{
+    // Half the ring, so the next chunk can be written while the previous one is still being copied
+    VkDeviceSize chunk_elements = std::max<VkDeviceSize>(renderer.staging_ring.size / 2 / element_size, 1);
+    for (VkDeviceSize first_element = 0; first_element < element_count; first_element += chunk_elements)
+    {
+        VkDeviceSize count = std::min(chunk_elements, element_count - first_element);
+        // May flush the open batch to make room, so every chunk is handed over by the batch copying it
+        StagingSlice slice = vulkan_staging_allocate(renderer, count * element_size, element_size);
+        write(slice.mapped, first_element, count);
+        vulkan_copy_buffer_region(renderer, vulkan_get_upload_transfer_commands(renderer), slice.buffer, buffer, slice.offset, buffer_offset + first_element * element_size, count * element_size);
+        vulkan_transfer_buffer_ownership(renderer, buffer, buffer_offset + first_element * element_size, count * element_size, dst_stage, dst_access);
+    }
+}
+
+void ise::rendering::vulkan_upload_image_data(VulkanRendererData& renderer, VkImage image, uint32_t mip_level, uint32_t width, uint32_t height, VkFormat format, const void* pixels)
+{
+    // Rows below are rows of blocks, which are single texels for uncompressed formats
+    const VkDeviceSize block_size = texture_format_get_block_size(format);
+    const uint32_t block_extent = texture_format_get_block_extent(format);
+    uint32_t block_rows = (height + block_extent - 1) / block_extent;
+    VkDeviceSize row_size = block_size * ((width + block_extent - 1) / block_extent);
+    // Transfer only families may only copy whole blocks of minImageTransferGranularity rows, 0 meaning the whole image at once.
+    // For compressed formats the granularity is in blocks already.
+    uint32_t row_granularity = std::max(renderer.uploads.image_granularity.height == 0 ? block_rows : renderer.uploads.image_granularity.height, 1u);
+    uint32_t chunk_rows = static_cast<uint32_t>(std::max<VkDeviceSize>(renderer.staging_ring.size / 2 / row_size, 1));
+    chunk_rows = std::max(chunk_rows / row_granularity * row_granularity, row_granularity);
+    for (uint32_t first_row = 0; first_row < block_rows; first_row += chunk_rows)
+    {
+        uint32_t row_count = std::min(chunk_rows, block_rows - first_row);
+        // bufferOffset of a copy to a color image must be a multiple of the block size
+        StagingSlice slice = vulkan_staging_allocate(renderer, row_size * row_count, block_size);
+        memcpy(slice.mapped, static_cast<const char*>(pixels) + row_size * first_row, static_cast<size_t>(row_size * row_count));
+        // The last block row may extend past the bottom edge, the copy then ends at the edge
+        uint32_t first_texel_row = first_row * block_extent;
+        uint32_t texel_row_count = std::min(row_count * block_extent, height - first_texel_row);
+        vulkan_copy_buffer_to_image(renderer, vulkan_get_upload_transfer_commands(renderer), slice.buffer, slice.offset, image, mip_level, width, first_texel_row, texel_row_count);
+    }
+}
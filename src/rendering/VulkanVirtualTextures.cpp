@@ -0,0 +1,915 @@
+#include "VulkanRendererUgly.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "VirtualTextureFile.h"
+
+// Virtual textures sample a single atlas of VIRTUAL_TEXTURE_PAGE_SIZE pages through a page table per texture. The fragment
+// shader marks the tile it wanted in a feedback bitfield, once the frame finished the host reads the bits back, copies the
+// missing tiles out of the tile file on a decode worker and uploads them into free pages. Until a tile is resident the page
+// table points at its closest resident ancestor, so the image sharpens as pages arrive instead of popping in.
+// Pages no frame asked for recently are evicted first, the coarsest tile of every texture is never evicted.
+
+namespace
+{
+    // uvec4 info and uvec4 levels[VIRTUAL_TEXTURE_MAX_LEVELS] ahead of the entries, see PageTable in frag_virtual.glsl
+    const uint32_t PAGE_TABLE_HEADER_SIZE = 4 + 4 * ise::rendering::VIRTUAL_TEXTURE_MAX_LEVELS;
+    const uint32_t PAGE_TABLE_ENTRY_RESIDENT = 1u << 31;
+
+    void virtual_texture_build(const std::shared_ptr<ise::rendering::VirtualTextureBuild>& build, const std::string& path, VkFormat format, uint32_t thread_count)
+    {
+        std::shared_ptr<ise::rendering::VirtualTextureFile> file = std::make_shared<ise::rendering::VirtualTextureFile>();
+        if (!ise::rendering::virtual_texture_file_open(path, format, *file))
+        {
+            if (!ise::rendering::virtual_texture_file_build(path, format, thread_count, build->error))
+            {
+                build->state = ise::rendering::VIRTUAL_TEXTURE_FAILED;
+                return;
+            }
+
+            if (!ise::rendering::virtual_texture_file_open(path, format, *file))
+            {
+                build->error = std::format("failed to open virtual texture tiles {0}", ise::rendering::virtual_texture_file_get_path(path));
+                build->state = ise::rendering::VIRTUAL_TEXTURE_FAILED;
+                return;
+            }
+        }
+
+        build->file = file;
+        build->state = ise::rendering::VIRTUAL_TEXTURE_READY;
+    }
+
+    void virtual_texture_read_page(const std::shared_ptr<ise::rendering::VirtualTexturePageRead>& read)
+    {
+        const ise::rendering::VirtualTextureFileTile& tile = read->file->tiles[read->tile];
+        const uint8_t* data = static_cast<const uint8_t*>(read->file->mapping.data()) + tile.offset;
+        read->data.assign(data, data + tile.size);
+        read->done = true;
+    }
+
+    uint32_t virtual_texture_get_tile_level(const ise::rendering::VirtualTexture& virtual_texture, uint32_t tile)
+    {
+        uint32_t level = 0;
+        while (level + 1 < virtual_texture.levels.size() && virtual_texture.levels[level + 1].first_tile <= tile)
+        {
+            level++;
+        }
+        return level;
+    }
+
+    uint32_t virtual_texture_get_parent_tile(const ise::rendering::VirtualTexture& virtual_texture, uint32_t level, uint32_t tile)
+    {
+        const ise::rendering::VirtualTextureLevel& tile_level = virtual_texture.levels[level];
+        const ise::rendering::VirtualTextureLevel& parent_level = virtual_texture.levels[level + 1];
+        uint32_t tile_x = (tile - tile_level.first_tile) % tile_level.tiles_x;
+        uint32_t tile_y = (tile - tile_level.first_tile) / tile_level.tiles_x;
+        return parent_level.first_tile + (tile_y / 2) * parent_level.tiles_x + tile_x / 2;
+    }
+
+    bool virtual_texture_is_pinned(const ise::rendering::VirtualTexture& virtual_texture, uint32_t tile)
+    {
+        return tile == virtual_texture.tile_count - 1;
+    }
+
+    struct VirtualTextureRequest
+    {
+        uint32_t level;
+        ise::rendering::VirtualTexture* virtual_texture;
+        uint32_t tile;
+    };
+
+    // Keeps the tile and every ancestor the page table may fall back to alive, requesting the absent ones
+    void virtual_texture_use_tile(ise::rendering::VulkanRendererData& renderer, ise::rendering::VirtualTexture& virtual_texture, uint32_t tile, std::vector<VirtualTextureRequest>& requests)
+    {
+        uint32_t level = virtual_texture_get_tile_level(virtual_texture, tile);
+        while (true)
+        {
+            ise::rendering::VirtualTextureTile& virtual_texture_tile = virtual_texture.tiles[tile];
+            if (virtual_texture_tile.state == ise::rendering::VIRTUAL_TEXTURE_TILE_ABSENT)
+            {
+                requests.push_back({ level, &virtual_texture, tile });
+            }
+            else if (virtual_texture_tile.state != ise::rendering::VIRTUAL_TEXTURE_TILE_READING)
+            {
+                ise::rendering::VirtualTexturePage& page = renderer.virtual_texturing.pages[virtual_texture_tile.page];
+                // Ancestors of a tile used this frame were already walked
+                if (page.last_used_frame == renderer.frame_number)
+                {
+                    return;
+                }
+                page.last_used_frame = renderer.frame_number;
+            }
+
+            if (level + 1 == virtual_texture.levels.size())
+            {
+                return;
+            }
+            tile = virtual_texture_get_parent_tile(virtual_texture, level, tile);
+            level++;
+        }
+    }
+
+    void virtual_texture_read_feedback(ise::rendering::VulkanRendererData& renderer, ise::rendering::VirtualTexture& virtual_texture, std::vector<VirtualTextureRequest>& requests)
+    {
+        // The frame that wrote it is the one whose fence vulkan_draw_frame just waited for
+        ise::rendering::VirtualTextureFrame& frame = virtual_texture.frames[renderer.current_frame];
+        uint32_t* feedback = static_cast<uint32_t*>(frame.feedback_memory.mapped);
+        bool ready = virtual_texture.build->state == ise::rendering::VIRTUAL_TEXTURE_READY;
+
+        uint32_t word_count = (virtual_texture.tile_count + 31) / 32;
+        for (uint32_t word = 0; word < word_count; word++)
+        {
+            uint32_t bits = feedback[word];
+            if (bits == 0)
+            {
+                continue;
+            }
+            feedback[word] = 0;
+
+            while (ready && bits != 0)
+            {
+                uint32_t bit = static_cast<uint32_t>(std::countr_zero(bits));
+                bits &= bits - 1;
+                virtual_texture_use_tile(renderer, virtual_texture, word * 32 + bit, requests);
+            }
+        }
+
+        // Whatever is on screen, the coarsest tile is what every other tile falls back to
+        if (ready)
+        {
+            virtual_texture_use_tile(renderer, virtual_texture, virtual_texture.tile_count - 1, requests);
+        }
+    }
+
+    // The atlas is shared by both queue families, so a page only has to be made visible to the frames, it has no owner to
+    // hand it over from
+    void virtual_texture_make_page_visible(ise::rendering::VulkanRendererData& renderer)
+    {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        if (renderer.uploads.transfer_family == renderer.uploads.graphics_family)
+        {
+            vkCmdPipelineBarrier(ise::rendering::vulkan_get_upload_transfer_commands(renderer), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+            return;
+        }
+
+        // The graphics part of the batch waits for the copies, this orders the frames submitted after it behind that wait
+        barrier.srcAccessMask = 0;
+        vkCmdPipelineBarrier(ise::rendering::vulkan_get_upload_graphics_commands(renderer), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    void virtual_texture_upload_page(ise::rendering::VulkanRendererData& renderer, ise::rendering::VirtualTexture& virtual_texture, const ise::rendering::VirtualTexturePageRead& read, uint32_t page_index)
+    {
+        ise::rendering::VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+
+        // bufferOffset of a copy to a color image must be a multiple of the block size
+        ise::rendering::StagingSlice slice = ise::rendering::vulkan_staging_allocate(renderer, read.data.size(), ise::rendering::texture_format_get_block_size(virtual_texturing.page_format));
+        memcpy(slice.mapped, read.data.data(), read.data.size());
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = slice.offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { static_cast<int32_t>(page_index % virtual_texturing.atlas_pages_per_side * ise::rendering::VIRTUAL_TEXTURE_PAGE_SIZE), static_cast<int32_t>(page_index / virtual_texturing.atlas_pages_per_side * ise::rendering::VIRTUAL_TEXTURE_PAGE_SIZE), 0 };
+        region.imageExtent = { ise::rendering::VIRTUAL_TEXTURE_PAGE_SIZE, ise::rendering::VIRTUAL_TEXTURE_PAGE_SIZE, 1 };
+
+        // Allocating may have flushed the open batch, the copy and its barrier go into the one that is open now
+        vkCmdCopyBufferToImage(ise::rendering::vulkan_get_upload_transfer_commands(renderer), slice.buffer, virtual_texturing.atlas_image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+        virtual_texture_make_page_visible(renderer);
+
+        ise::rendering::VirtualTexturePage& page = virtual_texturing.pages[page_index];
+        page.texture = &virtual_texture;
+        page.tile = read.tile;
+        page.last_used_frame = renderer.frame_number;
+        page.upload_value = renderer.upload_submitted_value + 1;
+        virtual_texture.tiles[read.tile] = { ise::rendering::VIRTUAL_TEXTURE_TILE_UPLOADING, page_index };
+        virtual_texturing.uploading_pages.push_back(page_index);
+    }
+
+    void virtual_texture_destroy_frames(ise::rendering::VulkanRendererData& renderer, ise::rendering::VirtualTexture& virtual_texture)
+    {
+        for (ise::rendering::VirtualTextureFrame& frame : virtual_texture.frames)
+        {
+            vkDestroyBuffer(renderer.device, frame.page_table_buffer, nullptr);
+            ise::rendering::vulkan_free_memory(renderer, frame.page_table_memory);
+            vkDestroyBuffer(renderer.device, frame.feedback_buffer, nullptr);
+            ise::rendering::vulkan_free_memory(renderer, frame.feedback_memory);
+        }
+        virtual_texture.frames.clear();
+
+        vkDestroyDescriptorPool(renderer.device, virtual_texture.descriptor_pool, nullptr);
+    }
+
+    void virtual_texture_create_frames(ise::rendering::VulkanRendererData& renderer, ise::rendering::VirtualTexture& virtual_texture)
+    {
+        ise::rendering::VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+        uint32_t frame_count = renderer.custom_config.max_frames_in_flight;
+
+        // Every texture has its own small pool, so destroying one gives its sets back
+        std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+        pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        pool_sizes[0].descriptorCount = frame_count;
+        pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_sizes[1].descriptorCount = 2 * frame_count;
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+        pool_info.pPoolSizes = pool_sizes.data();
+        pool_info.maxSets = frame_count;
+
+        if (vkCreateDescriptorPool(renderer.device, &pool_info, nullptr, &virtual_texture.descriptor_pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create descriptor pool for a virtual texture!");
+        }
+
+        std::vector<VkDescriptorSetLayout> layouts(frame_count, virtual_texturing.descriptor_set_layout);
+        std::vector<VkDescriptorSet> descriptor_sets(frame_count);
+
+        VkDescriptorSetAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorPool = virtual_texture.descriptor_pool;
+        alloc_info.descriptorSetCount = frame_count;
+        alloc_info.pSetLayouts = layouts.data();
+
+        if (vkAllocateDescriptorSets(renderer.device, &alloc_info, descriptor_sets.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate descriptor sets for a virtual texture!");
+        }
+
+        VkDeviceSize page_table_size = sizeof(uint32_t) * (PAGE_TABLE_HEADER_SIZE + virtual_texture.tile_count);
+        VkDeviceSize feedback_size = sizeof(uint32_t) * ((virtual_texture.tile_count + 31) / 32);
+
+        virtual_texture.frames.resize(frame_count);
+        for (uint32_t i = 0; i < frame_count; i++)
+        {
+            ise::rendering::VirtualTextureFrame& frame = virtual_texture.frames[i];
+            frame.descriptor_set = descriptor_sets[i];
+
+            ise::rendering::vulkan_create_buffer(renderer, page_table_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.page_table_buffer, frame.page_table_memory);
+            ise::rendering::vulkan_create_buffer(renderer, feedback_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.feedback_buffer, frame.feedback_memory);
+            memset(frame.feedback_memory.mapped, 0, static_cast<size_t>(feedback_size));
+
+            VkDescriptorImageInfo image_info{};
+            image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            image_info.imageView = virtual_texturing.atlas_image_view;
+            image_info.sampler = virtual_texturing.atlas_sampler;
+
+            std::array<VkDescriptorBufferInfo, 2> buffer_infos{};
+            buffer_infos[0] = { frame.page_table_buffer, 0, VK_WHOLE_SIZE };
+            buffer_infos[1] = { frame.feedback_buffer, 0, VK_WHOLE_SIZE };
+
+            std::array<VkWriteDescriptorSet, 3> descriptor_writes{};
+            for (uint32_t binding = 0; binding < descriptor_writes.size(); binding++)
+            {
+                descriptor_writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptor_writes[binding].dstSet = frame.descriptor_set;
+                descriptor_writes[binding].dstBinding = binding;
+                descriptor_writes[binding].dstArrayElement = 0;
+                descriptor_writes[binding].descriptorCount = 1;
+            }
+            descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            descriptor_writes[0].pImageInfo = &image_info;
+            descriptor_writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptor_writes[1].pBufferInfo = &buffer_infos[0];
+            descriptor_writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptor_writes[2].pBufferInfo = &buffer_infos[1];
+
+            vkUpdateDescriptorSets(renderer.device, static_cast<uint32_t>(descriptor_writes.size()), descriptor_writes.data(), 0, nullptr);
+        }
+    }
+}
+
+bool ise::rendering::vulkan_check_virtual_texturing_support(VulkanRendererData& renderer)
+{
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(renderer.physical_device, &supported_features);
+    if (!supported_features.fragmentStoresAndAtomics)
+    {
+        return false;
+    }
+
+    // Pages use the format asynchronous loads are encoded to, so the tile files are built by the same encoders
+    VkFormat page_format = renderer.compressed_texture_format != VK_FORMAT_UNDEFINED ? renderer.compressed_texture_format : VK_FORMAT_R8G8B8A8_SRGB;
+
+    const VkPhysicalDeviceProperties& properties = renderer.physical_device_properties;
+    if (properties.limits.maxImageDimension2D < VIRTUAL_TEXTURE_PAGE_SIZE)
+    {
+        return false;
+    }
+
+    // Pages are copied one at a time, so the transfer family has to copy regions of a page. The granularity of compressed
+    // formats is in blocks.
+    QueueFamilyIndices indices = vulkan_find_queue_families(renderer.physical_device, renderer);
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(renderer.physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(renderer.physical_device, &queue_family_count, queue_families.data());
+
+    VkExtent3D granularity = queue_families[indices.transfer_family.value()].minImageTransferGranularity;
+    uint32_t page_blocks = VIRTUAL_TEXTURE_PAGE_SIZE / texture_format_get_block_extent(page_format);
+    if (granularity.width == 0 || granularity.height == 0 || page_blocks % granularity.width != 0 || page_blocks % granularity.height != 0)
+    {
+        return false;
+    }
+
+    renderer.virtual_texturing.page_format = page_format;
+    return true;
+}
+
+void ise::rendering::vulkan_create_virtual_texturing_resources(VulkanRendererData& renderer)
+{
+    VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+    if (!virtual_texturing.supported)
+    {
+        return;
+    }
+
+    // binding 0: page atlas, binding 1: page table, binding 2: feedback
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); i++)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(renderer.device, &layout_info, nullptr, &virtual_texturing.descriptor_set_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set layout for virtual textures!");
+    }
+
+    // Set 1 takes the place of the texture set, set 0 stays the regular uniform buffer
+    std::array<VkDescriptorSetLayout, 2> set_layouts = { renderer.descriptor_set_layout_uniform_buffers, virtual_texturing.descriptor_set_layout };
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+    pipeline_layout_info.pSetLayouts = set_layouts.data();
+
+    if (vkCreatePipelineLayout(renderer.device, &pipeline_layout_info, nullptr, &virtual_texturing.pipeline_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create pipeline layout for virtual textures!");
+    }
+
+    virtual_texturing.graphics_pipeline = vulkan_create_graphics_pipeline_from_shaders(renderer, vulkan_get_vertex_shader_file(renderer.custom_config.vertex_format, "vert"), "frag_virtual.spv", virtual_texturing.pipeline_layout, true);
+
+    if (!renderer.gpu_culling.enabled)
+    {
+        return;
+    }
+
+    std::array<VkDescriptorSetLayout, 3> indirect_set_layouts = { renderer.descriptor_set_layout_uniform_buffers, virtual_texturing.descriptor_set_layout, renderer.gpu_culling.descriptor_set_layout };
+
+    VkPipelineLayoutCreateInfo indirect_layout_info{};
+    indirect_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    indirect_layout_info.setLayoutCount = static_cast<uint32_t>(indirect_set_layouts.size());
+    indirect_layout_info.pSetLayouts = indirect_set_layouts.data();
+
+    if (vkCreatePipelineLayout(renderer.device, &indirect_layout_info, nullptr, &virtual_texturing.indirect_pipeline_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create pipeline layout for gpu culled virtual textures!");
+    }
+
+    virtual_texturing.indirect_graphics_pipeline = vulkan_create_graphics_pipeline_from_shaders(renderer, vulkan_get_vertex_shader_file(renderer.custom_config.vertex_format, "vert_indirect"), "frag_virtual.spv", virtual_texturing.indirect_pipeline_layout, false);
+}
+
+void ise::rendering::vulkan_recreate_virtual_texturing_pipelines(VulkanRendererData& renderer)
+{
+    VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+    if (!virtual_texturing.supported)
+    {
+        return;
+    }
+
+    vkDestroyPipeline(renderer.device, virtual_texturing.graphics_pipeline, nullptr);
+    virtual_texturing.graphics_pipeline = vulkan_create_graphics_pipeline_from_shaders(renderer, vulkan_get_vertex_shader_file(renderer.custom_config.vertex_format, "vert"), "frag_virtual.spv", virtual_texturing.pipeline_layout, true);
+
+    if (virtual_texturing.indirect_graphics_pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(renderer.device, virtual_texturing.indirect_graphics_pipeline, nullptr);
+        virtual_texturing.indirect_graphics_pipeline = vulkan_create_graphics_pipeline_from_shaders(renderer, vulkan_get_vertex_shader_file(renderer.custom_config.vertex_format, "vert_indirect"), "frag_virtual.spv", virtual_texturing.indirect_pipeline_layout, false);
+    }
+}
+
+void ise::rendering::vulkan_create_virtual_texture_atlas(VulkanRendererData& renderer)
+{
+    VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+
+    const VkPhysicalDeviceProperties& properties = renderer.physical_device_properties;
+    // Page table entries keep the page in 16 bits
+    uint32_t max_pages_per_side = std::min(properties.limits.maxImageDimension2D / VIRTUAL_TEXTURE_PAGE_SIZE, 256u);
+    uint32_t pages_per_side = std::clamp(renderer.custom_config.virtual_texture_atlas_pages, 1u, max_pages_per_side);
+    uint32_t atlas_size = pages_per_side * VIRTUAL_TEXTURE_PAGE_SIZE;
+
+    std::array<uint32_t, 2> queue_families = { renderer.uploads.graphics_family, renderer.uploads.transfer_family };
+
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.extent = { atlas_size, atlas_size, 1 };
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.format = virtual_texturing.page_format;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (queue_families[0] != queue_families[1])
+    {
+        // Pages are written by the transfer queue while the graphics queue samples the others
+        image_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        image_info.queueFamilyIndexCount = static_cast<uint32_t>(queue_families.size());
+        image_info.pQueueFamilyIndices = queue_families.data();
+    }
+
+    if (vkCreateImage(renderer.device, &image_info, nullptr, &virtual_texturing.atlas_image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create virtual texture atlas!");
+    }
+
+    VkMemoryRequirements mem_requirements;
+    vkGetImageMemoryRequirements(renderer.device, virtual_texturing.atlas_image, &mem_requirements);
+    virtual_texturing.atlas_memory = memory_allocate(renderer.memory_allocator, mem_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MEMORY_USAGE_LONG_LIVED, MEMORY_RESOURCE_OPTIMAL);
+    vulkan_handle_vk_result(vkBindImageMemory(renderer.device, virtual_texturing.atlas_image, virtual_texturing.atlas_memory.memory, virtual_texturing.atlas_memory.offset));
+
+    virtual_texturing.atlas_image_view = vulkan_create_image_view(renderer, virtual_texturing.atlas_image, virtual_texturing.page_format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+    // Pages have no mip levels of their own, frag_virtual.glsl picks the level and samples it with lod 0
+    VkSamplerCreateInfo sampler_info{};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_LINEAR;
+    sampler_info.minFilter = VK_FILTER_LINEAR;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.anisotropyEnable = VK_FALSE;
+    sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    sampler_info.unnormalizedCoordinates = VK_FALSE;
+    sampler_info.compareEnable = VK_FALSE;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.minLod = 0.0f;
+    sampler_info.maxLod = 0.0f;
+
+    if (vkCreateSampler(renderer.device, &sampler_info, nullptr, &virtual_texturing.atlas_sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create virtual texture atlas sampler!");
+    }
+
+    // Stays in GENERAL for good, the copies and the sampling never need a transition in between. Only happens once.
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = virtual_texturing.atlas_image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    VkCommandBuffer command_buffer = vulkan_begin_single_time_commands(renderer);
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vulkan_end_single_time_commands(renderer, command_buffer);
+
+    virtual_texturing.atlas_pages_per_side = pages_per_side;
+    uint32_t page_count = pages_per_side * pages_per_side;
+    virtual_texturing.pages.assign(page_count, VirtualTexturePage{});
+    virtual_texturing.free_pages.clear();
+    for (uint32_t i = page_count; i > 0; i--)
+    {
+        virtual_texturing.free_pages.push_back(i - 1);
+    }
+}
+
+ise::rendering::VirtualTexture* ise::rendering::vulkan_create_virtual_texture(VulkanRendererData& renderer, const std::string& key, const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+
+    VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+    if (!virtual_texturing.supported)
+    {
+        throw std::runtime_error("failed to create virtual texture, the device cannot write feedback from fragment shaders!");
+    }
+
+    // Only the header is read here, the pixels are decoded by the worker building the tiles
+    int width, height, channels;
+    if (!stbi_info(path.c_str(), &width, &height, &channels))
+    {
+        const char* reason = stbi_failure_reason();
+        throw std::runtime_error(std::format("failed to read virtual texture image {0}: {1}", path, reason != nullptr ? reason : "unknown error"));
+    }
+
+    VirtualTexture* virtual_texture = new VirtualTexture{};
+    virtual_texture->tile_count = virtual_texture_get_levels(static_cast<uint32_t>(width), static_cast<uint32_t>(height), virtual_texture->levels);
+    if (virtual_texture->tile_count == 0)
+    {
+        delete virtual_texture;
+        throw std::runtime_error(std::format("failed to create virtual texture {0}, the image is {1}x{2}, larger than {3}x{3}", path, width, height, VIRTUAL_TEXTURE_MAX_SOURCE_SIZE));
+    }
+
+    vulkan_destroy_virtual_texture_unsafe(renderer, key);
+
+    if (virtual_texturing.atlas_pages_per_side == 0)
+    {
+        vulkan_create_virtual_texture_atlas(renderer);
+    }
+
+    virtual_texture->key = key;
+    virtual_texture->path = path;
+    virtual_texture->id = renderer.next_texture_description_set_id++;
+    virtual_texture->tiles.resize(virtual_texture->tile_count);
+    virtual_texture_create_frames(renderer, *virtual_texture);
+    vulkan_update_virtual_texture_page_table(renderer, *virtual_texture);
+
+    std::shared_ptr<VirtualTextureBuild> build = std::make_shared<VirtualTextureBuild>();
+    virtual_texture->build = build;
+    VkFormat page_format = virtual_texturing.page_format;
+    uint32_t thread_count = renderer.custom_config.texture_decode_threads;
+    build->task = vulkan_get_texture_decode_queue(renderer).push([build, path, page_format, thread_count]() { virtual_texture_build(build, path, page_format, thread_count); });
+
+    virtual_texturing.textures[key] = virtual_texture;
+    // The recorded command buffers need the feedback barrier from now on
+    vulkan_invalidate_recorded_command_buffers(renderer);
+    return virtual_texture;
+}
+
+bool ise::rendering::vulkan_destroy_virtual_texture(VulkanRendererData& renderer, const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+    return vulkan_destroy_virtual_texture_unsafe(renderer, key);
+}
+
+bool ise::rendering::vulkan_destroy_virtual_texture_unsafe(VulkanRendererData& renderer, const std::string& key)
+{
+    VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+    auto it = virtual_texturing.textures.find(key);
+    if (it == virtual_texturing.textures.end())
+    {
+        return false;
+    }
+
+    VirtualTexture* virtual_texture = it->second;
+    virtual_texturing.textures.erase(it);
+
+    for (RenderObject* render_object : renderer.render_objects)
+    {
+        if (render_object->virtual_texture == virtual_texture)
+        {
+            render_object->virtual_texture = nullptr;
+            render_object->texture_description_set = VK_NULL_HANDLE;
+        }
+    }
+    vulkan_invalidate_recorded_command_buffers(renderer);
+
+    std::vector<uint32_t> page_indices;
+    for (uint32_t page_index = 0; page_index < virtual_texturing.pages.size(); page_index++)
+    {
+        VirtualTexturePage& page = virtual_texturing.pages[page_index];
+        if (page.texture == virtual_texture)
+        {
+            page = VirtualTexturePage{};
+            page_indices.push_back(page_index);
+        }
+    }
+    std::erase_if(virtual_texturing.uploading_pages, [&virtual_texturing](uint32_t page_index) { return virtual_texturing.pages[page_index].texture == nullptr; });
+
+    // Frames in flight bind its sets and buffers and sample the pages, which may also still be copied to on the transfer queue.
+    // Reads still queued keep the file mapped until they ran.
+    vulkan_defer_destroy(renderer, [virtual_texture, page_indices](VulkanRendererData& renderer)
+    {
+        std::vector<uint32_t>& free_pages = renderer.virtual_texturing.free_pages;
+        free_pages.insert(free_pages.end(), page_indices.begin(), page_indices.end());
+
+        virtual_texture_destroy_frames(renderer, *virtual_texture);
+        delete virtual_texture;
+    });
+
+    return true;
+}
+
+void ise::rendering::vulkan_set_render_object_virtual_texture(VulkanRendererData& renderer, RenderObject& render_object, const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+
+    auto it = renderer.virtual_texturing.textures.find(key);
+    if (it == renderer.virtual_texturing.textures.end())
+    {
+        throw std::runtime_error(std::format("failed to find virtual texture {0}!", key));
+    }
+
+    // The set of the frame being recorded is bound instead, any non null set keeps the object in the draw list
+    render_object.type = QUAD_WITH_VIRTUAL_TEXTURE;
+    render_object.virtual_texture = it->second;
+    render_object.texture_description_set = it->second->frames[0].descriptor_set;
+    render_object.texture_description_set_id = it->second->id;
+    vulkan_invalidate_recorded_command_buffers(renderer);
+}
+
+void ise::rendering::vulkan_process_virtual_textures(VulkanRendererData& renderer)
+{
+    VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+    if (virtual_texturing.textures.empty())
+    {
+        return;
+    }
+
+    // Pages evicted max_frames_in_flight frames ago are no longer in any page table a frame in flight reads
+    size_t pending_count = 0;
+    for (const VirtualTexturePageRelease& release : virtual_texturing.page_releases)
+    {
+        if (release.frame_number > renderer.frame_number)
+        {
+            virtual_texturing.page_releases[pending_count++] = release;
+            continue;
+        }
+        virtual_texturing.free_pages.push_back(release.page);
+    }
+    virtual_texturing.page_releases.resize(pending_count);
+
+    // Published once the copy completed, frames recorded from now on may sample them
+    std::erase_if(virtual_texturing.uploading_pages, [&renderer, &virtual_texturing](uint32_t page_index)
+    {
+        VirtualTexturePage& page = virtual_texturing.pages[page_index];
+        if (page.upload_value > renderer.upload_completed_value)
+        {
+            return false;
+        }
+
+        page.texture->tiles[page.tile].state = VIRTUAL_TEXTURE_TILE_RESIDENT;
+        page.texture->page_table_dirty = true;
+        return true;
+    });
+
+    std::vector<VirtualTextureRequest> requests;
+    uint32_t reads_in_flight = 0;
+    uint32_t reads_done = 0;
+    for (auto& [key, virtual_texture] : virtual_texturing.textures)
+    {
+        virtual_texture_read_feedback(renderer, *virtual_texture, requests);
+
+        // A build that threw never leaves VIRTUAL_TEXTURE_BUILDING, what it threw is in the future of its task
+        VirtualTextureBuild& build = *virtual_texture->build;
+        if (build.state == VIRTUAL_TEXTURE_BUILDING && build.task.valid() && build.task.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            try
+            {
+                build.task.get();
+            }
+            catch (const std::exception& exception)
+            {
+                build.error = std::format("failed to build virtual texture {0}: {1}", virtual_texture->path, exception.what());
+                build.state = VIRTUAL_TEXTURE_FAILED;
+            }
+        }
+
+        // Only ever resolved here with renderer.mutex held, so the promise is set exactly once
+        VirtualTextureState build_state = build.state;
+        if (build_state != VIRTUAL_TEXTURE_BUILDING && build.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            build.promise.set_value(build_state);
+        }
+
+        for (const std::shared_ptr<VirtualTexturePageRead>& read : virtual_texture->reads)
+        {
+            reads_in_flight++;
+            reads_done += read->done ? 1 : 0;
+        }
+    }
+
+    // Room for what arrived from disk, within what may be copied this frame
+    uint32_t upload_count = std::min(reads_done, renderer.custom_config.virtual_texture_uploads_per_frame);
+    if (upload_count > virtual_texturing.free_pages.size())
+    {
+        vulkan_evict_virtual_texture_pages(renderer, upload_count - static_cast<uint32_t>(virtual_texturing.free_pages.size()));
+    }
+
+    uint32_t uploaded_count = 0;
+    for (auto& entry : virtual_texturing.textures)
+    {
+        VirtualTexture* virtual_texture = entry.second;
+        std::erase_if(virtual_texture->reads, [&](const std::shared_ptr<VirtualTexturePageRead>& read)
+        {
+            if (!read->done || uploaded_count == renderer.custom_config.virtual_texture_uploads_per_frame || virtual_texturing.free_pages.empty())
+            {
+                return false;
+            }
+
+            uint32_t page_index = virtual_texturing.free_pages.back();
+            virtual_texturing.free_pages.pop_back();
+            virtual_texture_upload_page(renderer, *virtual_texture, *read, page_index);
+            uploaded_count++;
+            reads_in_flight--;
+            return true;
+        });
+    }
+
+    // Coarse tiles first, every finer tile falls back to them
+    std::sort(requests.begin(), requests.end(), [](const VirtualTextureRequest& a, const VirtualTextureRequest& b)
+    {
+        return a.level > b.level;
+    });
+
+    ise::util::TaskQueue& decode_queue = vulkan_get_texture_decode_queue(renderer);
+    for (const VirtualTextureRequest& request : requests)
+    {
+        if (reads_in_flight >= renderer.custom_config.virtual_texture_reads_in_flight)
+        {
+            break;
+        }
+
+        // Requested twice when two tiles share an ancestor
+        VirtualTextureTile& tile = request.virtual_texture->tiles[request.tile];
+        if (tile.state != VIRTUAL_TEXTURE_TILE_ABSENT)
+        {
+            continue;
+        }
+        tile.state = VIRTUAL_TEXTURE_TILE_READING;
+
+        std::shared_ptr<VirtualTexturePageRead> read = std::make_shared<VirtualTexturePageRead>();
+        read->file = request.virtual_texture->build->file;
+        read->tile = request.tile;
+        request.virtual_texture->reads.push_back(read);
+        decode_queue.push([read]() { virtual_texture_read_page(read); });
+        reads_in_flight++;
+    }
+
+    // The frame about to be recorded reads its own copy, the one of the frame before may still be in use
+    for (auto& [key, virtual_texture] : virtual_texturing.textures)
+    {
+        if (virtual_texture->page_table_dirty)
+        {
+            vulkan_update_virtual_texture_page_table(renderer, *virtual_texture);
+        }
+
+        VirtualTextureFrame& frame = virtual_texture->frames[renderer.current_frame];
+        if (frame.page_table_generation != virtual_texture->page_table_generation)
+        {
+            memcpy(frame.page_table_memory.mapped, virtual_texture->page_table.data(), sizeof(uint32_t) * virtual_texture->page_table.size());
+            frame.page_table_generation = virtual_texture->page_table_generation;
+        }
+    }
+}
+
+void ise::rendering::vulkan_evict_virtual_texture_pages(VulkanRendererData& renderer, uint32_t count)
+{
+    VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+
+    // Pages on their way back count as well, evicting more would only throw away tiles that are still good
+    uint32_t returning_count = static_cast<uint32_t>(virtual_texturing.page_releases.size());
+    if (returning_count >= count)
+    {
+        return;
+    }
+    count -= returning_count;
+
+    // Pages the last feedback asked for are on screen, evicting them would only bring them back next frame
+    std::vector<uint32_t> candidates;
+    for (uint32_t page_index = 0; page_index < virtual_texturing.pages.size(); page_index++)
+    {
+        const VirtualTexturePage& page = virtual_texturing.pages[page_index];
+        if (page.texture != nullptr &&
+            page.texture->tiles[page.tile].state == VIRTUAL_TEXTURE_TILE_RESIDENT &&
+            page.last_used_frame < renderer.frame_number &&
+            !virtual_texture_is_pinned(*page.texture, page.tile))
+        {
+            candidates.push_back(page_index);
+        }
+    }
+
+    count = std::min(count, static_cast<uint32_t>(candidates.size()));
+    std::nth_element(candidates.begin(), candidates.begin() + count, candidates.end(), [&virtual_texturing](uint32_t a, uint32_t b)
+    {
+        return virtual_texturing.pages[a].last_used_frame < virtual_texturing.pages[b].last_used_frame;
+    });
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        VirtualTexturePage& page = virtual_texturing.pages[candidates[i]];
+        page.texture->tiles[page.tile] = VirtualTextureTile{};
+        page.texture->page_table_dirty = true;
+        page = VirtualTexturePage{};
+
+        // Page tables of frames already submitted may still point at it
+        virtual_texturing.page_releases.push_back({ renderer.frame_number + renderer.custom_config.max_frames_in_flight, candidates[i] });
+    }
+}
+
+void ise::rendering::vulkan_update_virtual_texture_page_table(VulkanRendererData& renderer, VirtualTexture& virtual_texture)
+{
+    std::vector<uint32_t>& page_table = virtual_texture.page_table;
+    page_table.assign(PAGE_TABLE_HEADER_SIZE + virtual_texture.tile_count, 0);
+
+    uint32_t level_count = static_cast<uint32_t>(virtual_texture.levels.size());
+    page_table[0] = level_count;
+    page_table[1] = renderer.virtual_texturing.atlas_pages_per_side;
+
+    for (uint32_t level = 0; level < level_count; level++)
+    {
+        const VirtualTextureLevel& virtual_texture_level = virtual_texture.levels[level];
+        uint32_t* level_info = page_table.data() + 4 + 4 * level;
+        level_info[0] = virtual_texture_level.width;
+        level_info[1] = virtual_texture_level.height;
+        level_info[2] = virtual_texture_level.tiles_x | (virtual_texture_level.tiles_y << 16);
+        level_info[3] = virtual_texture_level.first_tile;
+    }
+
+    // Coarsest first, so a tile that is not resident simply copies the entry of its parent
+    uint32_t* entries = page_table.data() + PAGE_TABLE_HEADER_SIZE;
+    for (uint32_t level = level_count; level > 0; level--)
+    {
+        const VirtualTextureLevel& virtual_texture_level = virtual_texture.levels[level - 1];
+        for (uint32_t tile = virtual_texture_level.first_tile; tile < virtual_texture_level.first_tile + virtual_texture_level.tiles_x * virtual_texture_level.tiles_y; tile++)
+        {
+            const VirtualTextureTile& virtual_texture_tile = virtual_texture.tiles[tile];
+            if (virtual_texture_tile.state == VIRTUAL_TEXTURE_TILE_RESIDENT)
+            {
+                entries[tile] = PAGE_TABLE_ENTRY_RESIDENT | ((level - 1) << 16) | virtual_texture_tile.page;
+            }
+            else if (level < level_count)
+            {
+                entries[tile] = entries[virtual_texture_get_parent_tile(virtual_texture, level - 1, tile)];
+            }
+        }
+    }
+
+    virtual_texture.page_table_generation++;
+    virtual_texture.page_table_dirty = false;
+}
+
+void ise::rendering::vulkan_record_virtual_texture_feedback_barrier(VulkanRendererData& renderer, VkCommandBuffer command_buffer)
+{
+    if (renderer.virtual_texturing.textures.empty())
+    {
+        return;
+    }
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void ise::rendering::vulkan_destroy_virtual_texturing_resources(VulkanRendererData& renderer)
+{
+    VirtualTexturingData& virtual_texturing = renderer.virtual_texturing;
+    if (!virtual_texturing.supported)
+    {
+        return;
+    }
+
+    // The device is idle and the decode queue is gone, nothing uses the textures anymore
+    for (auto& [key, virtual_texture] : virtual_texturing.textures)
+    {
+        virtual_texture_destroy_frames(renderer, *virtual_texture);
+        delete virtual_texture;
+    }
+    virtual_texturing.textures.clear();
+
+    if (virtual_texturing.atlas_pages_per_side > 0)
+    {
+        vkDestroySampler(renderer.device, virtual_texturing.atlas_sampler, nullptr);
+        vkDestroyImageView(renderer.device, virtual_texturing.atlas_image_view, nullptr);
+        vkDestroyImage(renderer.device, virtual_texturing.atlas_image, nullptr);
+        vulkan_free_memory(renderer, virtual_texturing.atlas_memory);
+    }
+
+    if (virtual_texturing.indirect_graphics_pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(renderer.device, virtual_texturing.indirect_graphics_pipeline, nullptr);
+        vkDestroyPipelineLayout(renderer.device, virtual_texturing.indirect_pipeline_layout, nullptr);
+    }
+    vkDestroyPipeline(renderer.device, virtual_texturing.graphics_pipeline, nullptr);
+    vkDestroyPipelineLayout(renderer.device, virtual_texturing.pipeline_layout, nullptr);
+    vkDestroyDescriptorSetLayout(renderer.device, virtual_texturing.descriptor_set_layout, nullptr);
+
+    virtual_texturing = VirtualTexturingData{};
+}
@@ -0,0 +1,78 @@
+#version 450
+
+#pragma shader_stage(compute)
+
+layout(local_size_x = 64) in;
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    vec4 frustumPlanes[6];
+} ubo;
+
+struct ObjectData {
+    mat4 transform;
+    vec4 boundingSphere;
+    vec4 positionOffset;
+    vec4 positionScale;
+    uint firstIndex;
+    uint indexCount;
+    int vertexOffset;
+    uint drawGroup;
+    uint commandOffset;
+    uint textureIndex;
+};
+
+struct DrawIndexedIndirectCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+};
+
+layout(std430, set = 1, binding = 1) writeonly buffer CommandBuffer {
+    DrawIndexedIndirectCommand commands[];
+};
+
+layout(std430, set = 1, binding = 2) buffer CountBuffer {
+    uint counts[];
+};
+
+layout(push_constant) uniform PushConstants {
+    uint objectCount;
+} pushConstants;
+
+void main() {
+    uint objectIndex = gl_GlobalInvocationID.x;
+    if (objectIndex >= pushConstants.objectCount) {
+        return;
+    }
+
+    ObjectData object = objects[objectIndex];
+
+    vec3 center = (object.transform * vec4(object.boundingSphere.xyz, 1.0)).xyz;
+    float scale = max(max(length(object.transform[0].xyz), length(object.transform[1].xyz)), length(object.transform[2].xyz));
+    float radius = object.boundingSphere.w * scale;
+
+    for (int i = 0; i < 6; i++) {
+        if (dot(ubo.frustumPlanes[i].xyz, center) + ubo.frustumPlanes[i].w < -radius) {
+            return;
+        }
+    }
+
+    uint slot = atomicAdd(counts[object.drawGroup], 1);
+
+    DrawIndexedIndirectCommand command;
+    command.indexCount = object.indexCount;
+    command.instanceCount = 1;
+    command.firstIndex = object.firstIndex;
+    command.vertexOffset = object.vertexOffset;
+    command.firstInstance = objectIndex;
+    commands[object.commandOffset + slot] = command;
+}
@@ -2,13 +2,18 @@
 
 #pragma shader_stage(fragment)
 
-layout(set = 1, binding = 0) uniform sampler2D texSampler;
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Every texture of the scene, see VulkanBindlessTextures.cpp
+layout(set = 1, binding = 0) uniform sampler2D textures[];
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTextureIndex;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+    // Instances of one draw can use different textures
+    outColor = texture(textures[nonuniformEXT(fragTextureIndex)], fragTexCoord);
 }
\ No newline at end of file
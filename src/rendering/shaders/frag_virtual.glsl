@@ -0,0 +1,74 @@
+#version 450
+
+#pragma shader_stage(fragment)
+
+// Mirrors VirtualTextureFile.h
+const uint PAGE_SIZE = 128;
+const uint PAGE_BORDER = 4;
+const uint TILE_SIZE = PAGE_SIZE - 2 * PAGE_BORDER;
+const uint MAX_LEVELS = 16;
+const uint ENTRY_RESIDENT = 0x80000000u;
+
+layout(set = 1, binding = 0) uniform sampler2D pageAtlas;
+
+// Written by vulkan_update_virtual_texture_page_table. An entry is the page of the tile or of its closest resident
+// ancestor: page | level << 16 | ENTRY_RESIDENT, 0 while nothing is resident yet.
+layout(std430, set = 1, binding = 1) readonly buffer PageTable {
+    uvec4 info; // level count, atlas pages per side
+    uvec4 levels[MAX_LEVELS]; // width, height, tiles_x | tiles_y << 16, first tile
+    uint entries[];
+} pageTable;
+
+// One bit per tile, read back by vulkan_process_virtual_textures once the frame finished
+layout(std430, set = 1, binding = 2) buffer Feedback {
+    uint requests[];
+} feedback;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+uvec2 tileOf(uint level, vec2 uv) {
+    uvec4 levelInfo = pageTable.levels[level];
+    uvec2 tiles = uvec2(levelInfo.z & 0xFFFFu, levelInfo.z >> 16);
+    return min(uvec2(uv * vec2(levelInfo.xy)) / TILE_SIZE, tiles - 1u);
+}
+
+void main() {
+    vec2 uv = clamp(fragTexCoord, vec2(0.0), vec2(1.0));
+    uint levelCount = pageTable.info.x;
+
+    // The level a mip chain of the whole image would have sampled
+    vec2 texel = fragTexCoord * vec2(pageTable.levels[0].xy);
+    float footprint = max(length(dFdx(texel)), length(dFdy(texel)));
+    uint level = uint(clamp(round(log2(max(footprint, 1.0))), 0.0, float(levelCount - 1u)));
+
+    uvec2 tile = tileOf(level, uv);
+    uvec4 levelInfo = pageTable.levels[level];
+    uint tileIndex = levelInfo.w + tile.y * (levelInfo.z & 0xFFFFu) + tile.x;
+
+    // Every fourth pixel in both directions is plenty to find the tiles on screen and keeps the atomics rare
+    uvec2 pixel = uvec2(gl_FragCoord.xy);
+    if ((pixel.x & 3u) == 0u && (pixel.y & 3u) == 0u) {
+        uint bit = 1u << (tileIndex & 31u);
+        if ((feedback.requests[tileIndex >> 5] & bit) == 0u) {
+            atomicOr(feedback.requests[tileIndex >> 5], bit);
+        }
+    }
+
+    uint entry = pageTable.entries[tileIndex];
+    if ((entry & ENTRY_RESIDENT) == 0u) {
+        outColor = vec4(0.5, 0.5, 0.5, 1.0);
+        return;
+    }
+
+    // The entry may belong to an ancestor, so the texel is looked up at the level of the page
+    uint page = entry & 0xFFFFu;
+    uint pageLevel = (entry >> 16) & 0x7FFFu;
+    vec2 pageTexel = uv * vec2(pageTable.levels[pageLevel].xy) - vec2(tileOf(pageLevel, uv) * TILE_SIZE);
+
+    uint pagesPerSide = pageTable.info.y;
+    vec2 atlasTexel = vec2(uvec2(page % pagesPerSide, page / pagesPerSide) * PAGE_SIZE) + float(PAGE_BORDER) + pageTexel;
+    outColor = textureLod(pageAtlas, atlasTexel / float(pagesPerSide * PAGE_SIZE), 0.0);
+}
@@ -8,15 +8,30 @@ layout(binding = 0) uniform UniformBufferObject {
     mat4 proj;
 } ubo;
 
+#ifdef ISE_VERTEX_FORMAT_PACKED
+// unorm16 relative to the mesh bounds, the instance transform includes the dequantization
+layout(location = 0) in vec4 inPosition;
+layout(location = 2) in vec2 inTexCoord;
+#else
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
+#endif
+layout(location = 3) in mat4 inInstanceTransform;
+layout(location = 7) in uint inTextureIndex;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTextureIndex;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+#ifdef ISE_VERTEX_FORMAT_PACKED
+    gl_Position = ubo.proj * ubo.view * ubo.model * inInstanceTransform * vec4(inPosition.xyz, 1.0);
+    fragColor = vec3(1.0);
+#else
+    gl_Position = ubo.proj * ubo.view * ubo.model * inInstanceTransform * vec4(inPosition, 1.0);
     fragColor = inColor;
+#endif
     fragTexCoord = inTexCoord;
+    fragTextureIndex = inTextureIndex;
 }
\ No newline at end of file
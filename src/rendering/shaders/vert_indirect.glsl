@@ -0,0 +1,55 @@
+#version 450
+
+#pragma shader_stage(vertex)
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+struct ObjectData {
+    mat4 transform;
+    vec4 boundingSphere;
+    vec4 positionOffset;
+    vec4 positionScale;
+    uint firstIndex;
+    uint indexCount;
+    int vertexOffset;
+    uint drawGroup;
+    uint commandOffset;
+    uint textureIndex;
+};
+
+// firstInstance of every indirect command is the index of the object it was generated from
+layout(std430, set = 2, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+};
+
+#ifdef ISE_VERTEX_FORMAT_PACKED
+// unorm16 relative to the mesh bounds
+layout(location = 0) in vec4 inPosition;
+layout(location = 2) in vec2 inTexCoord;
+#else
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+#endif
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTextureIndex;
+
+void main() {
+    // The transform is also used for culling, so the dequantization is applied separately here
+    ObjectData object = objects[gl_InstanceIndex];
+    vec3 position = object.positionOffset.xyz + object.positionScale.xyz * inPosition.xyz;
+    gl_Position = ubo.proj * ubo.view * ubo.model * object.transform * vec4(position, 1.0);
+#ifdef ISE_VERTEX_FORMAT_PACKED
+    fragColor = vec3(1.0);
+#else
+    fragColor = inColor;
+#endif
+    fragTexCoord = inTexCoord;
+    fragTextureIndex = object.textureIndex;
+}
@@ -1,7 +1,16 @@
 #include "FileReader.h"
 
 #include <vector>
+#include <atomic>
+#include <filesystem>
 #include <fstream>
+#include <system_error>
+
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
 
 std::vector<char> ise::util::readFile(const std::string& filename) {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
@@ -19,4 +28,58 @@ std::vector<char> ise::util::readFile(const std::string& filename) {
     file.close();
 
     return buffer;
+}
+
+bool ise::util::get_file_stat(const std::string& filename, uint64_t& size, int64_t& mtime)
+{
+    std::error_code error;
+    size = std::filesystem::file_size(filename, error);
+    if (error)
+    {
+        return false;
+    }
+
+    auto write_time = std::filesystem::last_write_time(filename, error);
+    if (error)
+    {
+        return false;
+    }
+
+    mtime = static_cast<int64_t>(write_time.time_since_epoch().count());
+    return true;
+}
+
+bool ise::util::write_file_replacing(const std::string& filename, const std::function<void(std::ostream& stream)>& write)
+{
+    // Unique per process and call, so concurrent writers of the same file never share a temporary one
+    static std::atomic<uint32_t> counter = 0;
+#ifdef _WIN32
+    int process_id = _getpid();
+#else
+    int process_id = static_cast<int>(getpid());
+#endif
+    std::string temporary_filename = filename + "." + std::to_string(process_id) + "." + std::to_string(counter++) + ".tmp";
+    bool written = false;
+    {
+        std::ofstream file(temporary_filename, std::ios::binary | std::ios::trunc);
+        if (file.is_open())
+        {
+            write(file);
+            file.flush();
+            written = file.good();
+        }
+    }
+
+    std::error_code error;
+    if (written)
+    {
+        std::filesystem::rename(temporary_filename, filename, error);
+        if (!error)
+        {
+            return true;
+        }
+    }
+
+    std::filesystem::remove(temporary_filename, error);
+    return false;
 }
\ No newline at end of file
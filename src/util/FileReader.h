@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -8,5 +11,15 @@ namespace ise
     namespace util
     {
         std::vector<char> readFile(const std::string& filename);
+
+        // Size and last write time, what the on disk caches identify their source by. Returns false when the file
+        // does not exist or cannot be read.
+        bool get_file_stat(const std::string& filename, uint64_t& size, int64_t& mtime);
+
+        // Replaces filename with what write puts into the stream. Written next to the final name and renamed, so a
+        // crash never leaves a truncated file behind. Returns false when the stream went bad or the rename failed,
+        // the temporary file is then removed. Best effort for the caches, a read only asset or working directory only
+        // means the next launch builds them again.
+        bool write_file_replacing(const std::string& filename, const std::function<void(std::ostream& stream)>& write);
     }
 }
\ No newline at end of file
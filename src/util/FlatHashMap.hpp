@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace ise
+{
+    namespace util
+    {
+        // Open addressing hash map with linear probing over flat arrays. Insert and lookup only, there is no erase,
+        // which keeps probing trivial. Keys and values must be default constructible and cheap to copy.
+        template<typename Key, typename Value, typename Hash, typename Equal = std::equal_to<Key>>
+        class FlatHashMap
+        {
+        private:
+            // 0 marks an empty slot, otherwise the top 7 bits of the hash with the high bit set,
+            // so most mismatching slots are rejected without comparing keys
+            std::vector<uint8_t> m_control;
+            std::vector<Key> m_keys;
+            std::vector<Value> m_values;
+            size_t m_size = 0;
+            size_t m_mask = 0;
+            Hash m_hash;
+            Equal m_equal;
+
+            static uint8_t control_byte(size_t hash)
+            {
+                return static_cast<uint8_t>((static_cast<uint64_t>(hash) >> 57) | 0x80);
+            }
+
+            void rehash(size_t capacity)
+            {
+                std::vector<uint8_t> old_control = std::move(m_control);
+                std::vector<Key> old_keys = std::move(m_keys);
+                std::vector<Value> old_values = std::move(m_values);
+
+                m_control.assign(capacity, 0);
+                m_keys.resize(capacity);
+                m_values.resize(capacity);
+                m_mask = capacity - 1;
+
+                for (size_t i = 0; i < old_control.size(); i++)
+                {
+                    if (old_control[i] == 0)
+                    {
+                        continue;
+                    }
+
+                    size_t slot = m_hash(old_keys[i]) & m_mask;
+                    while (m_control[slot] != 0)
+                    {
+                        slot = (slot + 1) & m_mask;
+                    }
+                    m_control[slot] = old_control[i];
+                    m_keys[slot] = std::move(old_keys[i]);
+                    m_values[slot] = std::move(old_values[i]);
+                }
+            }
+
+        public:
+            size_t size() const
+            {
+                return m_size;
+            }
+
+            void clear()
+            {
+                m_control.assign(m_control.size(), 0);
+                m_size = 0;
+            }
+
+            // Makes room for count elements without rehashing, the load factor stays at or below 1/2
+            void reserve(size_t count)
+            {
+                size_t capacity = 16;
+                while (capacity < count * 2)
+                {
+                    capacity *= 2;
+                }
+
+                if (capacity > m_control.size())
+                {
+                    rehash(capacity);
+                }
+            }
+
+            Value* find(const Key& key)
+            {
+                if (m_size == 0)
+                {
+                    return nullptr;
+                }
+
+                size_t hash = m_hash(key);
+                uint8_t control = control_byte(hash);
+                for (size_t slot = hash & m_mask; m_control[slot] != 0; slot = (slot + 1) & m_mask)
+                {
+                    if (m_control[slot] == control && m_equal(m_keys[slot], key))
+                    {
+                        return &m_values[slot];
+                    }
+                }
+
+                return nullptr;
+            }
+
+            // Returns the value stored for key and whether it was inserted by this call.
+            // The pointer is invalidated by the next insertion.
+            std::pair<Value*, bool> try_emplace(const Key& key, const Value& value)
+            {
+                if ((m_size + 1) * 2 > m_control.size())
+                {
+                    reserve(m_size + 1);
+                }
+
+                size_t hash = m_hash(key);
+                uint8_t control = control_byte(hash);
+                size_t slot = hash & m_mask;
+                for (; m_control[slot] != 0; slot = (slot + 1) & m_mask)
+                {
+                    if (m_control[slot] == control && m_equal(m_keys[slot], key))
+                    {
+                        return { &m_values[slot], false };
+                    }
+                }
+
+                m_control[slot] = control;
+                m_keys[slot] = key;
+                m_values[slot] = value;
+                m_size++;
+                return { &m_values[slot], true };
+            }
+        };
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ise
+{
+    namespace util
+    {
+        // splitmix64 finalizer, every input bit affects every output bit
+        inline uint64_t hash_mix(uint64_t value)
+        {
+            value ^= value >> 30;
+            value *= 0xbf58476d1ce4e5b9ull;
+            value ^= value >> 27;
+            value *= 0x94d049bb133111ebull;
+            value ^= value >> 31;
+            return value;
+        }
+
+        // 64 bit hash over raw bytes, 8 bytes per round. Meant for hash tables and content checks, not for security.
+        inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            uint64_t hash = seed ^ (static_cast<uint64_t>(size) * 0x9e3779b97f4a7c15ull);
+
+            size_t offset = 0;
+            for (; offset + 8 <= size; offset += 8)
+            {
+                uint64_t word;
+                memcpy(&word, bytes + offset, sizeof(word));
+
+                word *= 0xc2b2ae3d27d4eb4full;
+                word = (word << 31) | (word >> 33);
+                hash ^= word * 0x9e3779b185ebca87ull;
+                hash = ((hash << 27) | (hash >> 37)) * 0x9e3779b185ebca87ull + 0x85ebca77c2b2ae63ull;
+            }
+
+            if (offset < size)
+            {
+                uint64_t tail = 0;
+                memcpy(&tail, bytes + offset, size - offset);
+                hash ^= tail * 0x27d4eb2f165667c5ull;
+            }
+
+            return hash_mix(hash);
+        }
+    }
+}
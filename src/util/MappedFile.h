@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ise
+{
+    namespace util
+    {
+        // Read only memory mapping of a whole file. The mapping lives as long as the object.
+        class MappedFile
+        {
+        private:
+            const void* m_data = nullptr;
+            size_t m_size = 0;
+#ifdef _WIN32
+            void* m_file = nullptr;
+            void* m_mapping = nullptr;
+#else
+            int m_file = -1;
+#endif
+
+        public:
+            MappedFile() = default;
+            ~MappedFile();
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            // Returns false when the file does not exist or cannot be mapped, empty files included
+            bool open(const std::string& filename);
+            void close();
+
+            const void* data() const { return m_data; }
+            size_t size() const { return m_size; }
+            bool is_open() const { return m_data != nullptr; }
+        };
+    }
+}
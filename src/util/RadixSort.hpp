@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ise
+{
+    namespace util
+    {
+        // Stable LSD radix sort of 64 bit keys carrying a 32 bit value along, 8 bits per pass.
+        // Passes where every key shares the same digit are skipped, so keys that only use
+        // a few of their bits cost only a few passes.
+        inline void radix_sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values)
+        {
+            const size_t count = keys.size();
+            if (count < 2)
+            {
+                return;
+            }
+
+            std::array<std::array<uint32_t, 256>, 8> histograms{};
+            for (uint64_t key : keys)
+            {
+                for (size_t pass = 0; pass < 8; pass++)
+                {
+                    histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+                }
+            }
+
+            std::vector<uint64_t> keys_scratch(count);
+            std::vector<uint32_t> values_scratch(count);
+
+            for (size_t pass = 0; pass < 8; pass++)
+            {
+                std::array<uint32_t, 256>& histogram = histograms[pass];
+                const size_t shift = pass * 8;
+
+                if (histogram[(keys[0] >> shift) & 0xFF] == count)
+                {
+                    continue;
+                }
+
+                uint32_t offset = 0;
+                for (uint32_t& bucket : histogram)
+                {
+                    uint32_t bucket_count = bucket;
+                    bucket = offset;
+                    offset += bucket_count;
+                }
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    uint32_t destination = histogram[(keys[i] >> shift) & 0xFF]++;
+                    keys_scratch[destination] = keys[i];
+                    values_scratch[destination] = values[i];
+                }
+
+                keys.swap(keys_scratch);
+                values.swap(values_scratch);
+            }
+        }
+    }
+}
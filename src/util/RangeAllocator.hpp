@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+namespace ise
+{
+    namespace util
+    {
+        // Hands out aligned [offset, offset + size) ranges of a growable address space, e.g. a buffer.
+        // Free ranges are kept by offset, to merge neighbours on free, and by size, for best fit allocation.
+        // Only bookkeeping, the memory itself is managed by the caller.
+        class RangeAllocator
+        {
+        public:
+            static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+            uint64_t capacity() const { return m_capacity; }
+            uint64_t used() const { return m_used; }
+            size_t free_range_count() const { return m_free_ranges.size(); }
+            uint64_t largest_free_range() const { return m_free_sizes.empty() ? 0 : m_free_sizes.rbegin()->first; }
+
+            // Appends [capacity, new_capacity) as free space, merged with a free range ending at the old capacity
+            void grow(uint64_t new_capacity)
+            {
+                if (new_capacity <= m_capacity)
+                {
+                    return;
+                }
+
+                uint64_t old_capacity = m_capacity;
+                m_capacity = new_capacity;
+                m_used += new_capacity - old_capacity;
+                free(old_capacity, new_capacity - old_capacity);
+            }
+
+            // Smallest free range that still fits size after aligning its start. Returns INVALID_OFFSET when none does,
+            // the caller is expected to grow and try again. size must not be 0.
+            uint64_t allocate(uint64_t size, uint64_t alignment = 1)
+            {
+                for (auto it = m_free_sizes.lower_bound(size); it != m_free_sizes.end(); ++it)
+                {
+                    uint64_t range_offset = it->second;
+                    uint64_t range_size = it->first;
+                    uint64_t offset = (range_offset + alignment - 1) / alignment * alignment;
+                    if (offset + size > range_offset + range_size)
+                    {
+                        continue;
+                    }
+
+                    erase_free_range(range_offset, range_size);
+
+                    // The alignment padding and the tail stay free
+                    if (offset > range_offset)
+                    {
+                        insert_free_range(range_offset, offset - range_offset);
+                    }
+                    if (offset + size < range_offset + range_size)
+                    {
+                        insert_free_range(offset + size, range_offset + range_size - offset - size);
+                    }
+
+                    m_used += size;
+                    return offset;
+                }
+
+                return INVALID_OFFSET;
+            }
+
+            void free(uint64_t offset, uint64_t size)
+            {
+                if (size == 0)
+                {
+                    return;
+                }
+
+                m_used -= size;
+
+                auto next = m_free_ranges.lower_bound(offset);
+                if (next != m_free_ranges.begin())
+                {
+                    auto previous = std::prev(next);
+                    if (previous->first + previous->second == offset)
+                    {
+                        offset = previous->first;
+                        size += previous->second;
+                        erase_free_range(previous->first, previous->second);
+                    }
+                }
+
+                next = m_free_ranges.lower_bound(offset);
+                if (next != m_free_ranges.end() && offset + size == next->first)
+                {
+                    size += next->second;
+                    erase_free_range(next->first, next->second);
+                }
+
+                insert_free_range(offset, size);
+            }
+
+            void clear()
+            {
+                m_free_ranges.clear();
+                m_free_sizes.clear();
+                m_capacity = 0;
+                m_used = 0;
+            }
+
+        private:
+            void insert_free_range(uint64_t offset, uint64_t size)
+            {
+                m_free_ranges.emplace(offset, size);
+                m_free_sizes.emplace(size, offset);
+            }
+
+            void erase_free_range(uint64_t offset, uint64_t size)
+            {
+                m_free_ranges.erase(offset);
+
+                auto [first, last] = m_free_sizes.equal_range(size);
+                for (auto it = first; it != last; ++it)
+                {
+                    if (it->second == offset)
+                    {
+                        m_free_sizes.erase(it);
+                        break;
+                    }
+                }
+            }
+
+            std::map<uint64_t, uint64_t> m_free_ranges; // offset -> size
+            std::multimap<uint64_t, uint64_t> m_free_sizes; // size -> offset
+            uint64_t m_capacity = 0;
+            uint64_t m_used = 0;
+        };
+    }
+}
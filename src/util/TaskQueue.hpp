@@ -0,0 +1,116 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ise
+{
+    namespace util
+    {
+        // Worker threads taking independent tasks from one queue in submission order, for fire and forget work like
+        // decoding files. Unlike ThreadPool nobody waits for a task, so tasks report their results themselves, the future
+        // push returns holds what a task threw. Tasks still queued when the queue is destroyed are dropped, their futures
+        // then hold a broken promise. Running ones are waited for.
+        class TaskQueue
+        {
+        private:
+            // Unlike a packaged_task the function is destroyed with the task, not kept alive by the future. Tasks often
+            // capture the handle their future is stored in.
+            struct Task
+            {
+                std::function<void()> function;
+                std::promise<void> promise;
+            };
+
+            std::vector<std::thread> m_threads;
+            std::mutex m_mutex;
+            std::condition_variable m_task_available;
+            std::deque<Task> m_tasks;
+            bool m_stopping = false;
+
+            void worker_loop()
+            {
+                while (true)
+                {
+                    Task task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_task_available.wait(lock, [&] { return m_stopping || !m_tasks.empty(); });
+
+                        if (m_stopping)
+                        {
+                            return;
+                        }
+
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop_front();
+                    }
+
+                    // Stored in the future instead of letting it terminate the program
+                    try
+                    {
+                        task.function();
+                        task.promise.set_value();
+                    }
+                    catch (...)
+                    {
+                        task.promise.set_exception(std::current_exception());
+                    }
+                }
+            }
+        public:
+            explicit TaskQueue(size_t thread_count)
+            {
+                if (thread_count == 0)
+                {
+                    thread_count = 1;
+                }
+
+                for (size_t i = 0; i < thread_count; i++)
+                {
+                    m_threads.emplace_back(&TaskQueue::worker_loop, this);
+                }
+            }
+
+            ~TaskQueue()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stopping = true;
+                    m_tasks.clear();
+                }
+                m_task_available.notify_all();
+
+                for (std::thread& thread : m_threads)
+                {
+                    thread.join();
+                }
+            }
+
+            TaskQueue(const TaskQueue&) = delete;
+            TaskQueue& operator=(const TaskQueue&) = delete;
+
+            size_t size() const
+            {
+                return m_threads.size();
+            }
+
+            std::future<void> push(std::function<void()> task)
+            {
+                std::promise<void> promise;
+                std::future<void> future = promise.get_future();
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_tasks.push_back({ std::move(task), std::move(promise) });
+                }
+                m_task_available.notify_one();
+                return future;
+            }
+        };
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ise
+{
+    namespace util
+    {
+        // Fixed set of worker threads that run the same task once each. Worker indexes are stable,
+        // so callers can keep per worker resources (like command pools) without any locking.
+        class ThreadPool
+        {
+        private:
+            std::vector<std::thread> m_threads;
+            std::mutex m_mutex;
+            std::condition_variable m_work_available;
+            std::condition_variable m_work_finished;
+            std::function<void(size_t)> m_task;
+            std::exception_ptr m_exception;
+            uint64_t m_generation = 0;
+            size_t m_active_workers = 0;
+            size_t m_pending_workers = 0;
+            bool m_stopping = false;
+
+            void worker_loop(size_t worker_index)
+            {
+                uint64_t seen_generation = 0;
+
+                while (true)
+                {
+                    std::function<void(size_t)> task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_work_available.wait(lock, [&] { return m_stopping || m_generation != seen_generation; });
+
+                        if (m_stopping)
+                        {
+                            return;
+                        }
+
+                        seen_generation = m_generation;
+                        if (worker_index >= m_active_workers)
+                        {
+                            continue;
+                        }
+                        task = m_task;
+                    }
+
+                    std::exception_ptr exception;
+                    try
+                    {
+                        task(worker_index);
+                    }
+                    catch (...)
+                    {
+                        exception = std::current_exception();
+                    }
+
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (exception && !m_exception)
+                    {
+                        m_exception = exception;
+                    }
+                    if (--m_pending_workers == 0)
+                    {
+                        m_work_finished.notify_all();
+                    }
+                }
+            }
+        public:
+            explicit ThreadPool(size_t thread_count)
+            {
+                if (thread_count == 0)
+                {
+                    thread_count = 1;
+                }
+
+                for (size_t i = 0; i < thread_count; i++)
+                {
+                    m_threads.emplace_back(&ThreadPool::worker_loop, this, i);
+                }
+            }
+
+            ~ThreadPool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stopping = true;
+                }
+                m_work_available.notify_all();
+
+                for (std::thread& thread : m_threads)
+                {
+                    thread.join();
+                }
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            size_t size() const
+            {
+                return m_threads.size();
+            }
+
+            // Runs task(worker_index) on the first worker_count workers and blocks until all of them return.
+            // The first exception thrown by a worker is rethrown here.
+            void run_on_workers(size_t worker_count, const std::function<void(size_t)>& task)
+            {
+                if (worker_count > m_threads.size())
+                {
+                    worker_count = m_threads.size();
+                }
+                if (worker_count == 0)
+                {
+                    return;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_task = task;
+                m_exception = nullptr;
+                m_active_workers = worker_count;
+                m_pending_workers = worker_count;
+                m_generation++;
+                m_work_available.notify_all();
+
+                m_work_finished.wait(lock, [&] { return m_pending_workers == 0; });
+
+                m_task = nullptr;
+                if (m_exception)
+                {
+                    std::rethrow_exception(m_exception);
+                }
+            }
+        };
+    }
+}
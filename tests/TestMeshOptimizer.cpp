@@ -0,0 +1,28 @@
+// Cuts two disjoint triangles, each missing the vertex cache with all three vertices, and checks the overdraw pass sees
+// them as separate clusters. A warm simulated cache used to merge the whole mesh into one
+//
+// Usage: test_mesh_optimizer, exits with 1 on failure
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "rendering/MeshOptimizer.h"
+
+int main()
+{
+    using namespace ise::rendering;
+
+    std::vector<uint32_t> indices = { 0, 1, 2, 3, 4, 5 };
+
+    // Threshold 0 leaves only the cold starts, so the soft cuts cannot hide a missing one
+    std::vector<uint32_t> clusters = mesh_find_overdraw_clusters(indices, 6, MESH_OPTIMIZER_CACHE_SIZE, 0.0f);
+
+    if (clusters.size() != 2 || clusters[0] != 0 || clusters[1] != 1)
+    {
+        std::cerr << "disjoint triangles cut into " << clusters.size() << " clusters, expected 2" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Encodes a red/green checker block, anti-correlated channels the endpoint fit used to collapse to a flat block,
+// and checks the decoded block still has both colors
+//
+// Usage: test_texture_compression, exits with 1 on failure
+
+#include <cstdint>
+#include <iostream>
+
+#include "rendering/TextureCompression.h"
+
+namespace
+{
+    void test_unpack_565(uint16_t packed, int color[3])
+    {
+        int r = (packed >> 11) & 31;
+        int g = (packed >> 5) & 63;
+        int b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // Plain BC1 decoder, opaque and 3 color blocks alike
+    void test_decode_bc1_block(const uint8_t block[8], int texels[16][3])
+    {
+        uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+        uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+        uint32_t indices = uint32_t(block[4]) | (uint32_t(block[5]) << 8) | (uint32_t(block[6]) << 16) | (uint32_t(block[7]) << 24);
+
+        int palette[4][3];
+        test_unpack_565(color0, palette[0]);
+        test_unpack_565(color1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            if (color0 > color1)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            uint32_t index = (indices >> (i * 2)) & 3;
+            for (int c = 0; c < 3; c++)
+            {
+                texels[i][c] = palette[index][c];
+            }
+        }
+    }
+}
+
+int main()
+{
+    using namespace ise::rendering;
+
+    uint8_t rgba[4 * 4 * 4];
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        bool red = ((i % 4) + (i / 4)) % 2 == 0;
+        rgba[i * 4 + 0] = red ? 255 : 0;
+        rgba[i * 4 + 1] = red ? 0 : 255;
+        rgba[i * 4 + 2] = 0;
+        rgba[i * 4 + 3] = 255;
+    }
+
+    uint8_t block[8] = {};
+    texture_encode_bc1_block(rgba, 4, 4, 0, 0, block);
+
+    int texels[16][3];
+    test_decode_bc1_block(block, texels);
+
+    bool all_equal = true;
+    for (int i = 1; i < 16; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            all_equal = all_equal && texels[i][c] == texels[0][c];
+        }
+    }
+
+    if (all_equal)
+    {
+        std::cerr << "red/green checker encoded to a flat block" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Builds tile files from tiny TGA images: one within VIRTUAL_TEXTURE_MAX_SOURCE_SIZE that must build and open again, and
+// one whose header claims a larger image that must be rejected before any pixel is decoded
+//
+// Usage: test_virtual_texture_file, exits with 1 on failure
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "rendering/VirtualTextureFile.h"
+
+namespace
+{
+    // Uncompressed 24 bit TGA, pixels holds width * height BGR texels or nothing for a header only file
+    void test_write_tga(const std::string& path, uint16_t width, uint16_t height, const std::vector<uint8_t>& pixels)
+    {
+        uint8_t header[18] = {};
+        header[2] = 2; // uncompressed true color
+        header[12] = static_cast<uint8_t>(width & 0xff);
+        header[13] = static_cast<uint8_t>(width >> 8);
+        header[14] = static_cast<uint8_t>(height & 0xff);
+        header[15] = static_cast<uint8_t>(height >> 8);
+        header[16] = 24;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    }
+
+    bool test_check(bool condition, const char* message)
+    {
+        if (!condition)
+        {
+            std::cerr << message << std::endl;
+        }
+        return condition;
+    }
+}
+
+int main()
+{
+    using namespace ise::rendering;
+
+    std::vector<VirtualTextureLevel> levels;
+    bool passed = test_check(virtual_texture_get_levels(VIRTUAL_TEXTURE_MAX_SOURCE_SIZE, VIRTUAL_TEXTURE_MAX_SOURCE_SIZE, levels) != 0, "the largest source has no levels");
+    passed &= test_check(virtual_texture_get_levels(VIRTUAL_TEXTURE_MAX_SOURCE_SIZE + 1, 1, levels) == 0, "a source wider than the limit has levels");
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string small_path = (directory / "test_virtual_texture_file_small.tga").string();
+    std::string large_path = (directory / "test_virtual_texture_file_large.tga").string();
+
+    std::string error;
+    test_write_tga(small_path, 1, 1, { 0, 0, 255 });
+    passed &= test_check(virtual_texture_file_build(small_path, VK_FORMAT_R8G8B8A8_SRGB, 1, error), "a 1x1 image failed to build");
+    VirtualTextureFile file;
+    passed &= test_check(virtual_texture_file_open(small_path, VK_FORMAT_R8G8B8A8_SRGB, file) && file.tile_count == 1, "the built tile file does not open");
+    file.mapping.close();
+
+    // Only a header, decoding it would fail on the missing pixels instead of the size
+    uint16_t large_size = static_cast<uint16_t>(VIRTUAL_TEXTURE_MAX_SOURCE_SIZE + 1);
+    test_write_tga(large_path, large_size, large_size, {});
+    error.clear();
+    passed &= test_check(!virtual_texture_file_build(large_path, VK_FORMAT_R8G8B8A8_SRGB, 1, error), "an image over the limit was built");
+    passed &= test_check(error.find("larger than") != std::string::npos, "an image over the limit was not rejected for its size");
+    passed &= test_check(!std::filesystem::exists(virtual_texture_file_get_path(large_path)), "an image over the limit left a tile file");
+
+    std::error_code filesystem_error;
+    std::filesystem::remove(small_path, filesystem_error);
+    std::filesystem::remove(virtual_texture_file_get_path(small_path), filesystem_error);
+    std::filesystem::remove(large_path, filesystem_error);
+
+    return passed ? 0 : 1;
+}